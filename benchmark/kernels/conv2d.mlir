@@ -0,0 +1,43 @@
+// Copyright HeteroCL authors. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+// 2D convolution: 16 input channels, 16 output channels, 64x64 output
+// feature map, 3x3 kernel, no padding.
+// Schedules are inserted at the @SCHEDULE marker by run_kernels.py.
+module {
+  memref.global "private" @In : memref<16x66x66xf32> = dense<1.0>
+  memref.global "private" @W : memref<16x16x3x3xf32> = dense<0.5>
+  memref.global "private" @Out : memref<16x64x64xf32> = dense<0.0>
+  func.func @top() -> () {
+    %In = memref.get_global @In : memref<16x66x66xf32>
+    %W = memref.get_global @W : memref<16x16x3x3xf32>
+    %Out = memref.get_global @Out : memref<16x64x64xf32>
+    %s = hcl.create_op_handle "s"
+    %loc = hcl.create_loop_handle %s, "oc"
+    %ly = hcl.create_loop_handle %s, "y"
+    %lx = hcl.create_loop_handle %s, "x"
+    %lic = hcl.create_loop_handle %s, "ic"
+    %lr = hcl.create_loop_handle %s, "r"
+    %ls = hcl.create_loop_handle %s, "c"
+    affine.for %oc = 0 to 16 {
+      affine.for %y = 0 to 64 {
+        affine.for %x = 0 to 64 {
+          affine.for %ic = 0 to 16 {
+            affine.for %r = 0 to 3 {
+              affine.for %c = 0 to 3 {
+                %a = affine.load %In[%ic, %y + %r, %x + %c] : memref<16x66x66xf32>
+                %w = affine.load %W[%oc, %ic, %r, %c] : memref<16x16x3x3xf32>
+                %o = affine.load %Out[%oc, %y, %x] : memref<16x64x64xf32>
+                %prod = arith.mulf %a, %w : f32
+                %sum = arith.addf %prod, %o : f32
+                affine.store %sum, %Out[%oc, %y, %x] : memref<16x64x64xf32>
+              } {loop_name = "c"}
+            } {loop_name = "r"}
+          } {loop_name = "ic"}
+        } {loop_name = "x"}
+      } {loop_name = "y"}
+    } {loop_name = "oc", op_name = "s"}
+    // @SCHEDULE
+    return
+  }
+}
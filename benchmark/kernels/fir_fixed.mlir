@@ -0,0 +1,31 @@
+// Copyright HeteroCL authors. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+// 32-tap FIR filter over 65536 samples in Fixed<16, 12> arithmetic:
+// y[n] += h[k] * x[n + k].
+// Schedules are inserted at the @SCHEDULE marker by run_kernels.py.
+module {
+  memref.global "private" @x : memref<65568xi64> = dense<2048>
+  memref.global "private" @h : memref<32xi64> = dense<1024>
+  memref.global "private" @y : memref<65536xi64> = dense<0>
+  func.func @top() -> () {
+    %x = hcl.get_global_fixed @x : memref<65568x!hcl.Fixed<16, 12>>
+    %h = hcl.get_global_fixed @h : memref<32x!hcl.Fixed<16, 12>>
+    %y = hcl.get_global_fixed @y : memref<65536x!hcl.Fixed<16, 12>>
+    %s = hcl.create_op_handle "s"
+    %ln = hcl.create_loop_handle %s, "n"
+    %lk = hcl.create_loop_handle %s, "k"
+    affine.for %n = 0 to 65536 {
+      affine.for %k = 0 to 32 {
+        %a = affine.load %x[%n + %k] : memref<65568x!hcl.Fixed<16, 12>>
+        %b = affine.load %h[%k] : memref<32x!hcl.Fixed<16, 12>>
+        %c = affine.load %y[%n] : memref<65536x!hcl.Fixed<16, 12>>
+        %prod = "hcl.mul_fixed"(%a, %b) : (!hcl.Fixed<16, 12>, !hcl.Fixed<16, 12>) -> !hcl.Fixed<16, 12>
+        %sum = "hcl.add_fixed"(%prod, %c) : (!hcl.Fixed<16, 12>, !hcl.Fixed<16, 12>) -> !hcl.Fixed<16, 12>
+        affine.store %sum, %y[%n] : memref<65536x!hcl.Fixed<16, 12>>
+      } {loop_name = "k"}
+    } {loop_name = "n", op_name = "s"}
+    // @SCHEDULE
+    return
+  }
+}
@@ -0,0 +1,33 @@
+// Copyright HeteroCL authors. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+// GEMM: C[i, j] += A[i, k] * B[k, j] with N = 256.
+// Schedules are inserted at the @SCHEDULE marker by run_kernels.py.
+module {
+  memref.global "private" @A : memref<256x256xf32> = dense<1.0>
+  memref.global "private" @B : memref<256x256xf32> = dense<0.5>
+  memref.global "private" @C : memref<256x256xf32> = dense<0.0>
+  func.func @top() -> () {
+    %A = memref.get_global @A : memref<256x256xf32>
+    %B = memref.get_global @B : memref<256x256xf32>
+    %C = memref.get_global @C : memref<256x256xf32>
+    %s = hcl.create_op_handle "s"
+    %li = hcl.create_loop_handle %s, "i"
+    %lj = hcl.create_loop_handle %s, "j"
+    %lk = hcl.create_loop_handle %s, "k"
+    affine.for %i = 0 to 256 {
+      affine.for %j = 0 to 256 {
+        affine.for %k = 0 to 256 {
+          %a = affine.load %A[%i, %k] : memref<256x256xf32>
+          %b = affine.load %B[%k, %j] : memref<256x256xf32>
+          %c = affine.load %C[%i, %j] : memref<256x256xf32>
+          %prod = arith.mulf %a, %b : f32
+          %sum = arith.addf %prod, %c : f32
+          affine.store %sum, %C[%i, %j] : memref<256x256xf32>
+        } {loop_name = "k"}
+      } {loop_name = "j"}
+    } {loop_name = "i", op_name = "s"}
+    // @SCHEDULE
+    return
+  }
+}
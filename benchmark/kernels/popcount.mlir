@@ -0,0 +1,29 @@
+// Copyright HeteroCL authors. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+// Bit manipulation: per-word population count of 262144 32-bit words
+// computed with hcl.get_bit.
+// Schedules are inserted at the @SCHEDULE marker by run_kernels.py.
+module {
+  memref.global "private" @X : memref<262144xi32> = dense<1431655765>
+  memref.global "private" @C : memref<262144xi32> = dense<0>
+  func.func @top() -> () {
+    %X = memref.get_global @X : memref<262144xi32>
+    %C = memref.get_global @C : memref<262144xi32>
+    %s = hcl.create_op_handle "s"
+    %li = hcl.create_loop_handle %s, "i"
+    %lb = hcl.create_loop_handle %s, "b"
+    affine.for %i = 0 to 262144 {
+      affine.for %b = 0 to 32 {
+        %x = affine.load %X[%i] : memref<262144xi32>
+        %bit = hcl.get_bit(%x : i32, %b) -> i1
+        %ext = arith.extui %bit : i1 to i32
+        %c = affine.load %C[%i] : memref<262144xi32>
+        %sum = arith.addi %c, %ext : i32
+        affine.store %sum, %C[%i] : memref<262144xi32>
+      } {loop_name = "b"}
+    } {loop_name = "i", op_name = "s"}
+    // @SCHEDULE
+    return
+  }
+}
@@ -0,0 +1,66 @@
+// Copyright HeteroCL authors. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+// Row-wise softmax over a 1024x1024 matrix in three stages: row maximum,
+// exponentiation with row sums, and normalization.
+// Schedules are inserted at the @SCHEDULE marker by run_kernels.py.
+module {
+  memref.global "private" @X : memref<1024x1024xf32> = dense<0.5>
+  memref.global "private" @Y : memref<1024x1024xf32> = dense<0.0>
+  func.func @top() -> () {
+    %X = memref.get_global @X : memref<1024x1024xf32>
+    %Y = memref.get_global @Y : memref<1024x1024xf32>
+    %E = memref.alloc() : memref<1024x1024xf32>
+    %M = memref.alloc() : memref<1024xf32>
+    %S = memref.alloc() : memref<1024xf32>
+    %ninf = arith.constant 0xFF800000 : f32
+    %zero = arith.constant 0.0 : f32
+    %s0 = hcl.create_op_handle "row_max"
+    %li0 = hcl.create_loop_handle %s0, "i0"
+    %lj0 = hcl.create_loop_handle %s0, "j0"
+    %s1 = hcl.create_op_handle "row_exp"
+    %li1 = hcl.create_loop_handle %s1, "i1"
+    %lj1 = hcl.create_loop_handle %s1, "j1"
+    %s2 = hcl.create_op_handle "normalize"
+    %li2 = hcl.create_loop_handle %s2, "i2"
+    %lj2 = hcl.create_loop_handle %s2, "j2"
+    affine.for %i = 0 to 1024 {
+      affine.store %ninf, %M[%i] : memref<1024xf32>
+      affine.store %zero, %S[%i] : memref<1024xf32>
+    } {loop_name = "i", op_name = "init"}
+    affine.for %i = 0 to 1024 {
+      affine.for %j = 0 to 1024 {
+        %x = affine.load %X[%i, %j] : memref<1024x1024xf32>
+        %m = affine.load %M[%i] : memref<1024xf32>
+        %gt = arith.cmpf ogt, %x, %m : f32
+        %max = arith.select %gt, %x, %m : f32
+        affine.store %max, %M[%i] : memref<1024xf32>
+      } {loop_name = "j0"}
+    } {loop_name = "i0", op_name = "row_max"}
+    affine.for %i = 0 to 1024 {
+      affine.for %j = 0 to 1024 {
+        %x = affine.load %X[%i, %j] : memref<1024x1024xf32>
+        %m = affine.load %M[%i] : memref<1024xf32>
+        %d = arith.subf %x, %m : f32
+        %e = math.exp %d : f32
+        affine.store %e, %E[%i, %j] : memref<1024x1024xf32>
+        %s = affine.load %S[%i] : memref<1024xf32>
+        %acc = arith.addf %s, %e : f32
+        affine.store %acc, %S[%i] : memref<1024xf32>
+      } {loop_name = "j1"}
+    } {loop_name = "i1", op_name = "row_exp"}
+    affine.for %i = 0 to 1024 {
+      affine.for %j = 0 to 1024 {
+        %e = affine.load %E[%i, %j] : memref<1024x1024xf32>
+        %s = affine.load %S[%i] : memref<1024xf32>
+        %y = arith.divf %e, %s : f32
+        affine.store %y, %Y[%i, %j] : memref<1024x1024xf32>
+      } {loop_name = "j2"}
+    } {loop_name = "i2", op_name = "normalize"}
+    // @SCHEDULE
+    memref.dealloc %E : memref<1024x1024xf32>
+    memref.dealloc %M : memref<1024xf32>
+    memref.dealloc %S : memref<1024xf32>
+    return
+  }
+}
@@ -0,0 +1,34 @@
+// Copyright HeteroCL authors. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+// 5-point Jacobi stencil on a 1024x1024 grid with a one-element halo.
+// Schedules are inserted at the @SCHEDULE marker by run_kernels.py.
+module {
+  memref.global "private" @In : memref<1026x1026xf32> = dense<1.0>
+  memref.global "private" @Out : memref<1024x1024xf32> = dense<0.0>
+  func.func @top() -> () {
+    %In = memref.get_global @In : memref<1026x1026xf32>
+    %Out = memref.get_global @Out : memref<1024x1024xf32>
+    %cst = arith.constant 0.2 : f32
+    %s = hcl.create_op_handle "s"
+    %li = hcl.create_loop_handle %s, "i"
+    %lj = hcl.create_loop_handle %s, "j"
+    affine.for %i = 0 to 1024 {
+      affine.for %j = 0 to 1024 {
+        %c = affine.load %In[%i + 1, %j + 1] : memref<1026x1026xf32>
+        %n = affine.load %In[%i, %j + 1] : memref<1026x1026xf32>
+        %so = affine.load %In[%i + 2, %j + 1] : memref<1026x1026xf32>
+        %w = affine.load %In[%i + 1, %j] : memref<1026x1026xf32>
+        %e = affine.load %In[%i + 1, %j + 2] : memref<1026x1026xf32>
+        %0 = arith.addf %c, %n : f32
+        %1 = arith.addf %0, %so : f32
+        %2 = arith.addf %1, %w : f32
+        %3 = arith.addf %2, %e : f32
+        %4 = arith.mulf %3, %cst : f32
+        affine.store %4, %Out[%i, %j] : memref<1024x1024xf32>
+      } {loop_name = "j"}
+    } {loop_name = "i", op_name = "s"}
+    // @SCHEDULE
+    return
+  }
+}
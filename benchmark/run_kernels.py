@@ -0,0 +1,234 @@
+# Copyright HeteroCL authors. All Rights Reserved.
+# SPDX-License-Identifier: Apache-2.0
+
+"""End-to-end kernel benchmarks for the HeteroCL JIT.
+
+Each kernel in kernels/ is a complete module with a no-argument @top
+function. The schedule ops of every variant are inserted at the
+`// @SCHEDULE` marker, the result is compiled and run through
+`hcl-opt -jit`, and the per-iteration time reported by
+`-jit-bench-iters` is converted into GFLOP/s or GB/s.
+
+Usage:
+    python run_kernels.py [--hcl-opt PATH] [--iters N] [--kernels a,b]
+                          [--json OUT] [--baseline FILE] [--tolerance 0.1]
+
+hcl-opt needs LLVM_BUILD_DIR and HCL_DIALECT_BUILD_DIR in the environment
+to locate the runtime libraries, as for any other -jit run.
+"""
+
+import argparse
+import json
+import os
+import re
+import shutil
+import subprocess
+import sys
+import tempfile
+
+KERNEL_DIR = os.path.join(os.path.dirname(os.path.abspath(__file__)), "kernels")
+
+# Each kernel lists the hcl-opt flags it needs, the unit it is measured in,
+# the amount of work per invocation in that unit, and its schedule variants.
+# "naive" is always the unscheduled module and serves as the speedup base.
+KERNELS = {
+    "gemm": {
+        "file": "gemm.mlir",
+        "flags": [],
+        "metric": "GFLOP/s",
+        "work": 2 * 256**3,
+        "schedules": {
+            "naive": "",
+            "reorder": "hcl.reorder (%lk, %lj)",
+            "reorder_split": "hcl.reorder (%lk, %lj)\n"
+            "    %lj_out, %lj_in = hcl.split (%lj, 8)\n"
+            "    hcl.unroll (%lj_in, 8)",
+        },
+    },
+    "conv2d": {
+        "file": "conv2d.mlir",
+        "flags": [],
+        "metric": "GFLOP/s",
+        "work": 2 * 16 * 16 * 64 * 64 * 9,
+        "schedules": {
+            "naive": "",
+            "reorder": "hcl.reorder (%lic, %lr, %ls, %ly, %lx)",
+        },
+    },
+    "jacobi": {
+        "file": "stencil.mlir",
+        "flags": [],
+        "metric": "GB/s",
+        # Five loads and one store of f32 per output point.
+        "work": 6 * 4 * 1024 * 1024,
+        "schedules": {
+            "naive": "",
+            "tile": "%li_out, %li_in, %lj_out, %lj_in = hcl.tile (%li, %lj, 32, 256)",
+        },
+    },
+    "softmax": {
+        "file": "softmax.mlir",
+        "flags": [],
+        "metric": "GB/s",
+        # Three passes over the matrix: read X twice, write and read E,
+        # write Y.
+        "work": 5 * 4 * 1024 * 1024,
+        "schedules": {
+            "naive": "",
+            "fuse": "%l0 = hcl.fuse (%li0, %lj0)\n"
+            "    %l1 = hcl.fuse (%li1, %lj1)\n"
+            "    %l2 = hcl.fuse (%li2, %lj2)",
+        },
+    },
+    "fir_fixed": {
+        "file": "fir_fixed.mlir",
+        "flags": ["-fixed-to-integer"],
+        "metric": "GFLOP/s",
+        "work": 2 * 65536 * 32,
+        "schedules": {
+            "naive": "",
+            "reorder": "hcl.reorder (%lk, %ln)",
+        },
+    },
+    "popcount": {
+        "file": "popcount.mlir",
+        "flags": [],
+        "metric": "GB/s",
+        # One 32-bit read and one 32-bit write per word.
+        "work": 2 * 4 * 262144,
+        "schedules": {
+            "naive": "",
+            "reorder": "hcl.reorder (%lb, %li)",
+            "unroll": "hcl.unroll (%lb, 32)",
+        },
+    },
+}
+
+BENCH_RE = re.compile(
+    r"\[hcl-jit\] top: ([0-9.]+) ms/iter \(min ([0-9.]+) ms, (\d+) iters\)"
+)
+
+
+def render(kernel, schedule):
+    with open(os.path.join(KERNEL_DIR, kernel["file"]), "r") as f:
+        src = f.read()
+    if "// @SCHEDULE" not in src:
+        raise RuntimeError(f"{kernel['file']} has no @SCHEDULE marker")
+    return src.replace("// @SCHEDULE", schedule)
+
+
+def run_variant(hcl_opt, kernel, schedule, iters, opt_level):
+    with tempfile.NamedTemporaryFile("w", suffix=".mlir", delete=False) as f:
+        f.write(render(kernel, schedule))
+        path = f.name
+    try:
+        cmd = (
+            [hcl_opt, path, "-opt"]
+            + kernel["flags"]
+            + [
+                "-jit",
+                f"-jit-opt-level={opt_level}",
+                f"-jit-bench-iters={iters}",
+                "-o",
+                os.devnull,
+            ]
+        )
+        proc = subprocess.run(cmd, capture_output=True, text=True, check=False)
+    finally:
+        os.remove(path)
+    if proc.returncode != 0:
+        raise RuntimeError(
+            f"{' '.join(cmd)} exited with {proc.returncode}:\n{proc.stderr}"
+        )
+    match = BENCH_RE.search(proc.stdout)
+    if not match:
+        raise RuntimeError(f"no timing line in hcl-opt output:\n{proc.stdout}")
+    return float(match.group(1)), float(match.group(2))
+
+
+def throughput(kernel, ms):
+    # Work per second, scaled to giga-units.
+    return kernel["work"] / (ms * 1e-3) / 1e9
+
+
+def compare(results, baseline, tolerance):
+    """Returns a list of variants slower than the baseline by > tolerance."""
+    regressions = []
+    for name, variants in results.items():
+        for variant, res in variants.items():
+            ref = baseline.get(name, {}).get(variant)
+            if ref is None:
+                continue
+            if res["throughput"] < ref["throughput"] * (1.0 - tolerance):
+                regressions.append(
+                    f"{name}/{variant}: {res['throughput']:.3f} "
+                    f"< {ref['throughput']:.3f} {res['metric']}"
+                )
+    return regressions
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument(
+        "--hcl-opt", default=shutil.which("hcl-opt") or "hcl-opt", help="hcl-opt binary"
+    )
+    parser.add_argument("--iters", type=int, default=10, help="timed iterations")
+    parser.add_argument("--opt-level", type=int, default=3, help="JIT opt level")
+    parser.add_argument(
+        "--kernels", default="", help="comma-separated kernels (default: all)"
+    )
+    parser.add_argument("--json", default="", help="write results to this file")
+    parser.add_argument("--baseline", default="", help="results to compare against")
+    parser.add_argument(
+        "--tolerance",
+        type=float,
+        default=0.1,
+        help="allowed throughput drop relative to the baseline",
+    )
+    args = parser.parse_args()
+
+    names = [k for k in args.kernels.split(",") if k] or list(KERNELS)
+    for name in names:
+        if name not in KERNELS:
+            parser.error(f"unknown kernel '{name}'")
+
+    results = {}
+    print(f"{'kernel':<12}{'schedule':<16}{'ms/iter':>12}{'throughput':>18}{'speedup':>10}")
+    for name in names:
+        kernel = KERNELS[name]
+        results[name] = {}
+        base_ms = None
+        for variant, schedule in kernel["schedules"].items():
+            _, min_ms = run_variant(
+                args.hcl_opt, kernel, schedule, args.iters, args.opt_level
+            )
+            if base_ms is None:
+                base_ms = min_ms
+            tput = throughput(kernel, min_ms)
+            results[name][variant] = {
+                "ms": min_ms,
+                "throughput": tput,
+                "metric": kernel["metric"],
+                "speedup": base_ms / min_ms,
+            }
+            print(
+                f"{name:<12}{variant:<16}{min_ms:>12.3f}"
+                f"{tput:>10.3f} {kernel['metric']:<7}{base_ms / min_ms:>9.2f}x"
+            )
+
+    if args.json:
+        with open(args.json, "w") as f:
+            json.dump(results, f, indent=2)
+
+    if args.baseline:
+        with open(args.baseline, "r") as f:
+            baseline = json.load(f)
+        regressions = compare(results, baseline, args.tolerance)
+        for r in regressions:
+            print(f"REGRESSION {r}", file=sys.stderr)
+        if regressions:
+            sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
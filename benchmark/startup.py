@@ -0,0 +1,125 @@
+# Copyright HeteroCL authors. All Rights Reserved.
+# SPDX-License-Identifier: Apache-2.0
+
+"""Startup-latency benchmark for hcl-opt and hcl-translate.
+
+The frontend invokes the tools once per design, so on small designs their
+run time is dominated by process startup and dialect registration. Each
+case below runs a tool on a tiny module --runs times and reports the mean
+and minimum wall-clock time of one invocation.
+
+Usage:
+    python startup.py [--hcl-opt PATH] [--hcl-translate PATH] [--runs N]
+                      [--json OUT] [--baseline FILE] [--tolerance 0.2]
+"""
+
+import argparse
+import json
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+
+TINY_MODULE = """
+module {
+  func.func @top(%A: memref<16xi32>, %B: memref<16xi32>) {
+    affine.for %i = 0 to 16 {
+      %a = affine.load %A[%i] : memref<16xi32>
+      %b = arith.addi %a, %a : i32
+      affine.store %b, %B[%i] : memref<16xi32>
+    } {loop_name = "i", op_name = "s"}
+    return
+  }
+}
+"""
+
+# Each case names the tool it runs and the flags it passes before the input.
+CASES = {
+    "opt-parse": ("hcl-opt", []),
+    "opt-loop-opt": ("hcl-opt", ["-opt"]),
+    "opt-lower-to-llvm": ("hcl-opt", ["-lower-to-llvm"]),
+    "translate-vivado-hls": ("hcl-translate", ["-emit-vivado-hls"]),
+}
+
+
+def time_case(tool, flags, path, runs):
+    cmd = [tool] + flags + [path, "-o", os.devnull]
+    times = []
+    for _ in range(runs):
+        start = time.perf_counter()
+        proc = subprocess.run(cmd, capture_output=True, text=True, check=False)
+        times.append((time.perf_counter() - start) * 1e3)
+        if proc.returncode != 0:
+            raise RuntimeError(
+                f"{' '.join(cmd)} exited with {proc.returncode}:\n{proc.stderr}"
+            )
+    return sum(times) / len(times), min(times)
+
+
+def compare(results, baseline, tolerance):
+    """Returns a list of cases slower than the baseline by > tolerance."""
+    regressions = []
+    for name, res in results.items():
+        ref = baseline.get(name)
+        if ref is None:
+            continue
+        if res["min_ms"] > ref["min_ms"] * (1.0 + tolerance):
+            regressions.append(
+                f"{name}: {res['min_ms']:.2f} > {ref['min_ms']:.2f} ms"
+            )
+    return regressions
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument(
+        "--hcl-opt", default=shutil.which("hcl-opt") or "hcl-opt", help="hcl-opt binary"
+    )
+    parser.add_argument(
+        "--hcl-translate",
+        default=shutil.which("hcl-translate") or "hcl-translate",
+        help="hcl-translate binary",
+    )
+    parser.add_argument("--runs", type=int, default=20, help="runs per case")
+    parser.add_argument("--json", default="", help="write results to this file")
+    parser.add_argument("--baseline", default="", help="results to compare against")
+    parser.add_argument(
+        "--tolerance",
+        type=float,
+        default=0.2,
+        help="allowed slowdown relative to the baseline",
+    )
+    args = parser.parse_args()
+    tools = {"hcl-opt": args.hcl_opt, "hcl-translate": args.hcl_translate}
+
+    with tempfile.NamedTemporaryFile("w", suffix=".mlir", delete=False) as f:
+        f.write(TINY_MODULE)
+        path = f.name
+    results = {}
+    try:
+        print(f"{'case':<24}{'mean ms':>10}{'min ms':>10}")
+        for name, (tool, flags) in CASES.items():
+            mean_ms, min_ms = time_case(tools[tool], flags, path, args.runs)
+            results[name] = {"mean_ms": mean_ms, "min_ms": min_ms}
+            print(f"{name:<24}{mean_ms:>10.2f}{min_ms:>10.2f}")
+    finally:
+        os.remove(path)
+
+    if args.json:
+        with open(args.json, "w") as f:
+            json.dump(results, f, indent=2)
+
+    if args.baseline:
+        with open(args.baseline, "r") as f:
+            baseline = json.load(f)
+        regressions = compare(results, baseline, args.tolerance)
+        for r in regressions:
+            print(f"REGRESSION {r}", file=sys.stderr)
+        if regressions:
+            sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
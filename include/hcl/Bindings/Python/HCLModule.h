@@ -8,12 +8,35 @@
 
 // #include "PybindUtils.h"
 #include "mlir/Bindings/Python/PybindAdaptors.h"
+#include "mlir/IR/MLIRContext.h"
+
+#include <mutex>
 
 namespace mlir {
 namespace python {
 
+/// Returns the mutex guarding the IR owned by `context`.
+std::mutex &getContextMutex(MLIRContext *context);
+
+/// Releases the GIL and holds the lock of `context` for the lifetime of the
+/// object. Entry points that read or transform IR use this so that designs in
+/// different contexts are processed in parallel.
+class ContextLock {
+public:
+  explicit ContextLock(MLIRContext *context)
+      : lock(getContextMutex(context)) {}
+
+private:
+  // The GIL is released before blocking on the context mutex, so a thread
+  // holding the mutex can always reacquire the GIL, e.g. to write to a
+  // Python file object.
+  pybind11::gil_scoped_release release;
+  std::lock_guard<std::mutex> lock;
+};
+
 void populateHCLIRTypes(pybind11::module &m);
 void populateHCLAttributes(pybind11::module &m);
+void populateHCLExecutable(pybind11::module &m);
 
 } // namespace python
 } // namespace mlir
@@ -0,0 +1,116 @@
+# Copyright HeteroCL authors. All Rights Reserved.
+# SPDX-License-Identifier: Apache-2.0
+
+"""Client of the hcl-opt compile server.
+
+`hcl-opt -serve=<socket>` keeps MLIR contexts with their dialects loaded and
+caches its results, so compiling a design through it costs neither a process
+start nor dialect loading. Messages are JSON objects, each preceded by its
+size as an 8-byte little-endian integer.
+
+Usage as a command line client:
+    python -m hcl_mlir.server --socket PATH [--translate emit-vivado-hls]
+                              [-o OUT] input.mlir [hcl-opt flags...]
+    python -m hcl_mlir.server --socket PATH --stats
+    python -m hcl_mlir.server --socket PATH --shutdown
+"""
+
+import argparse
+import json
+import socket
+import struct
+import sys
+
+from .exceptions import HCLException
+
+
+class CompileServerError(HCLException):
+    """A request the compile server rejected or failed to compile."""
+
+
+class Client:
+    """A connection to a compile server, which may send many requests."""
+
+    def __init__(self, path):
+        self.sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        self.sock.connect(path)
+
+    def close(self):
+        self.sock.close()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *args):
+        self.close()
+
+    def _recv_exact(self, size):
+        data = bytearray()
+        while len(data) < size:
+            chunk = self.sock.recv(size - len(data))
+            if not chunk:
+                raise CompileServerError("connection closed by the server")
+            data += chunk
+        return bytes(data)
+
+    def request(self, message):
+        """Sends a request and returns the response, both as dicts."""
+        body = json.dumps(message).encode()
+        self.sock.sendall(struct.pack("<Q", len(body)) + body)
+        (size,) = struct.unpack("<Q", self._recv_exact(8))
+        return json.loads(self._recv_exact(size))
+
+    def compile(self, module, flags=(), translate=None):
+        """Runs the hcl-opt pipeline selected by `flags` on the module text and
+        returns the printed module, or its translation, e.g. with
+        translate="emit-vivado-hls"."""
+        message = {"module": str(module), "flags": list(flags)}
+        if translate:
+            message["translate"] = translate
+        response = self.request(message)
+        if not response["ok"]:
+            raise CompileServerError(response["diagnostics"])
+        return response["output"]
+
+    def stats(self):
+        """Returns the number of requests, cache hits and cached results."""
+        return self.request({"stats": True})
+
+    def shutdown(self):
+        """Stops the server once the requests being compiled are done."""
+        self.request({"shutdown": True})
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--socket", required=True, help="socket of the server")
+    parser.add_argument("--translate", default="", help="translation to emit")
+    parser.add_argument("-o", dest="output", default="-", help="output file")
+    parser.add_argument("--stats", action="store_true", help="print statistics")
+    parser.add_argument("--shutdown", action="store_true", help="stop the server")
+    parser.add_argument("input", nargs="?", help="input file")
+    parser.add_argument("flags", nargs=argparse.REMAINDER, help="hcl-opt flags")
+    args = parser.parse_args()
+
+    with Client(args.socket) as client:
+        if args.stats:
+            print(json.dumps(client.stats()))
+        if args.input:
+            with open(args.input, "r") as f:
+                module = f.read()
+            try:
+                output = client.compile(module, args.flags, args.translate)
+            except CompileServerError as e:
+                print(e, file=sys.stderr)
+                sys.exit(1)
+            if args.output == "-":
+                sys.stdout.write(output)
+            else:
+                with open(args.output, "w") as f:
+                    f.write(output)
+        if args.shutdown:
+            client.shutdown()
+
+
+if __name__ == "__main__":
+    main()
@@ -6,10 +6,19 @@
 #ifndef HCL_CONVERSION_PASSES_H
 #define HCL_CONVERSION_PASSES_H
 
+#include "mlir/Dialect/Affine/IR/AffineOps.h"
+#include "mlir/Dialect/Arith/IR/Arith.h"
+#include "mlir/Dialect/ControlFlow/IR/ControlFlow.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/Dialect/LLVMIR/LLVMDialect.h"
+#include "mlir/Dialect/Math/IR/Math.h"
+#include "mlir/Dialect/MemRef/IR/MemRef.h"
+#include "mlir/Dialect/SCF/IR/SCF.h"
 #include "mlir/IR/BuiltinOps.h"
 #include "mlir/Pass/Pass.h"
 #include "mlir/Pass/PassRegistry.h"
 
+#include "hcl/Dialect/HeteroCLDialect.h"
 #include "hcl/Dialect/HeteroCLOps.h"
 
 namespace mlir {
@@ -18,15 +27,23 @@ namespace hcl {
 // HeteroCL Dialect -> LLVM Dialect
 std::unique_ptr<OperationPass<ModuleOp>> createHCLToLLVMLoweringPass();
 std::unique_ptr<OperationPass<ModuleOp>> createFixedPointToIntegerPass();
+std::unique_ptr<OperationPass<ModuleOp>>
+createFixedPointToIntegerPass(bool simd);
 std::unique_ptr<OperationPass<ModuleOp>> createLowerCompositeTypePass();
+std::unique_ptr<OperationPass<ModuleOp>>
+createLowerCompositeTypePass(bool packed);
 std::unique_ptr<OperationPass<ModuleOp>> createLowerBitOpsPass();
 std::unique_ptr<OperationPass<ModuleOp>> createLowerPrintOpsPass();
+std::unique_ptr<OperationPass<ModuleOp>> createLowerLogicOpsPass();
+std::unique_ptr<OperationPass<ModuleOp>>
+createLowerLogicOpsPass(unsigned maxSpeculatedOps);
 
 bool applyHCLToLLVMLoweringPass(ModuleOp &module, MLIRContext &context);
-bool applyFixedPointToInteger(ModuleOp &module);
-bool applyLowerCompositeType(ModuleOp &module);
+bool applyFixedPointToInteger(ModuleOp &module, bool simd = false);
+bool applyLowerCompositeType(ModuleOp &module, bool packed = false);
 bool applyLowerBitOps(ModuleOp &module);
 bool applyLowerPrintOps(ModuleOp &module);
+bool applyLowerLogicOps(ModuleOp &module, unsigned maxSpeculatedOps = 8);
 
 /// Registers all HCL conversion passes
 void registerHCLConversionPasses();
@@ -6,7 +6,7 @@
 #ifndef MLIR_DIALECT_TRANSFORMOPS_HCLTRANSFORMOPS_H
 #define MLIR_DIALECT_TRANSFORMOPS_HCLTRANSFORMOPS_H
 
-#include "mlir/Dialect/PDL/IR/PDLTypes.h"
+#include "hcl/Dialect/HeteroCLAttrs.h"
 #include "mlir/Dialect/Transform/IR/TransformInterfaces.h"
 #include "mlir/Dialect/Transform/IR/MatchInterfaces.h"
 #include "mlir/Dialect/Transform/IR/TransformAttrs.h"
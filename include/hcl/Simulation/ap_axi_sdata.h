@@ -0,0 +1,36 @@
+/*
+ * Copyright HeteroCL authors. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//===----------------------------------------------------------------------===//
+// Header-only replacement for the Vivado HLS ap_axi_sdata.h. Side-channel
+// widths of zero are kept as one-bit fields, as in the vendor header.
+//===----------------------------------------------------------------------===//
+
+#ifndef HCL_SIMULATION_AP_AXI_SDATA_H
+#define HCL_SIMULATION_AP_AXI_SDATA_H
+
+#include "ap_int.h"
+
+template <int D, int U, int TI, int TD> struct ap_axis {
+  ap_int<D> data;
+  ap_uint<(D + 7) / 8> keep;
+  ap_uint<(D + 7) / 8> strb;
+  ap_uint<(U > 0 ? U : 1)> user;
+  ap_uint<1> last;
+  ap_uint<(TI > 0 ? TI : 1)> id;
+  ap_uint<(TD > 0 ? TD : 1)> dest;
+};
+
+template <int D, int U, int TI, int TD> struct ap_axiu {
+  ap_uint<D> data;
+  ap_uint<(D + 7) / 8> keep;
+  ap_uint<(D + 7) / 8> strb;
+  ap_uint<(U > 0 ? U : 1)> user;
+  ap_uint<1> last;
+  ap_uint<(TI > 0 ? TI : 1)> id;
+  ap_uint<(TD > 0 ? TD : 1)> dest;
+};
+
+#endif // HCL_SIMULATION_AP_AXI_SDATA_H
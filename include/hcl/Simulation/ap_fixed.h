@@ -0,0 +1,596 @@
+/*
+ * Copyright HeteroCL authors. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//===----------------------------------------------------------------------===//
+// Header-only, bit-accurate replacement for the Vivado HLS ap_fixed.h.
+//
+// An ap_fixed<W, I> holds a W-bit raw integer with F = W - I fractional bits.
+// Arithmetic produces a wider type that holds the exact result, and the
+// quantization and overflow modes are applied only when a value is converted
+// to a narrower type. With the default AP_TRN/AP_WRAP modes this is what
+// --fixed-to-integer generates for !hcl.Fixed and !hcl.UFixed:
+//   - add/sub are integer add/sub truncated to the result width,
+//   - mul is a wide multiply followed by an arithmetic shift right by F,
+//   - div shifts the dividend left by F and divides, truncating to zero.
+// One difference: the pass converts floating point to fixed with fptosi,
+// which truncates towards zero. That is AP_TRN_ZERO here; AP_TRN floors.
+//===----------------------------------------------------------------------===//
+
+#ifndef HCL_SIMULATION_AP_FIXED_H
+#define HCL_SIMULATION_AP_FIXED_H
+
+#include "ap_int.h"
+
+#include <cstdio>
+
+namespace hcl_ap {
+namespace detail {
+
+/// Rounds t / 2^n to an integer according to the quantization mode.
+template <int WT, ap_q_mode Q>
+inline ap_int_base<WT, true> quantize(const ap_int_base<WT, true> &t, int n) {
+  if (n <= 0)
+    return t << -n;
+  bool negative = t.sign();
+  if (n >= WT) {
+    // Every significant bit is below the rounding point and |t| < 2^(WT-1),
+    // so the value is strictly less than half an ulp in magnitude.
+    return (Q == AP_TRN && negative) ? ap_int_base<WT, true>(-1)
+                                     : ap_int_base<WT, true>(0);
+  }
+  ap_int_base<WT, true> q = t >> n;
+  if (Q == AP_TRN)
+    return q;
+  bool half = t.get_bit(n - 1);
+  bool below = false;
+  for (int i = 0; i < (n - 1) / 64 + 1 && !below; ++i) {
+    int bits = n - 1 - 64 * i;
+    uint64_t mask = bits >= 64 ? ~0ULL : (1ULL << bits) - 1;
+    below = (t.V[i] & mask) != 0;
+  }
+  bool up = false;
+  switch (Q) {
+  case AP_TRN_ZERO:
+    up = negative && (half || below);
+    break;
+  case AP_RND:
+    up = half;
+    break;
+  case AP_RND_ZERO:
+    up = half && (below || negative);
+    break;
+  case AP_RND_MIN_INF:
+    up = half && below;
+    break;
+  case AP_RND_INF:
+    up = half && (below || !negative);
+    break;
+  case AP_RND_CONV:
+    up = half && (below || q.get_bit(0));
+    break;
+  default:
+    break;
+  }
+  if (up)
+    q += 1;
+  return q;
+}
+
+/// Narrows t to a W-bit raw value according to the overflow mode.
+template <int W, bool S, ap_o_mode O, int WT>
+inline ap_int_base<W, S> overflow(const ap_int_base<WT, true> &t) {
+  ap_int_base<W, S> r(t);
+  bool fits = r == t;
+  if (O == AP_WRAP || O == AP_WRAP_SM)
+    return r;
+  ap_int_base<W, S> maxv, minv;
+  for (int i = 0; i < W - S; ++i)
+    maxv.set_bit(i, true);
+  if (S)
+    minv.set_bit(W - 1, true);
+  if (O == AP_SAT_SYM && S) {
+    minv = ~maxv;
+    minv.set_bit(0, true);
+    if (fits && r == ap_int_base<W, S>(~maxv))
+      return minv;
+  }
+  if (fits)
+    return r;
+  if (O == AP_SAT_ZERO)
+    return ap_int_base<W, S>(0);
+  return t.sign() ? minv : maxv;
+}
+
+} // namespace detail
+} // namespace hcl_ap
+
+template <int _AP_W, int _AP_I, bool _AP_S = true, ap_q_mode _AP_Q = AP_TRN,
+          ap_o_mode _AP_O = AP_WRAP, int _AP_N = 0>
+struct ap_fixed_base {
+  static_assert(_AP_W > 0, "ap_fixed bit width must be positive");
+  static const int width = _AP_W;
+  static const int iwidth = _AP_I;
+  static const int fwidth = _AP_W - _AP_I;
+  static const bool sign_flag = _AP_S;
+  static const ap_q_mode qmode = _AP_Q;
+  static const ap_o_mode omode = _AP_O;
+
+  /// Exact result types of binary operators, as in Vivado HLS.
+  template <int _AP_W2, int _AP_I2, bool _AP_S2> struct RType {
+    static constexpr int F = _AP_W - _AP_I, F2 = _AP_W2 - _AP_I2;
+    static constexpr int mult_w = _AP_W + _AP_W2;
+    static constexpr int mult_i = _AP_I + _AP_I2;
+    static constexpr bool mult_s = _AP_S || _AP_S2;
+    static constexpr int logic_i = hcl_ap::detail::maxw(
+        _AP_I + (_AP_S2 && !_AP_S), _AP_I2 + (_AP_S && !_AP_S2));
+    static constexpr int logic_w = logic_i + hcl_ap::detail::maxw(F, F2);
+    static constexpr bool logic_s = _AP_S || _AP_S2;
+    static constexpr int plus_w = logic_w + 1;
+    static constexpr int plus_i = logic_i + 1;
+    static constexpr bool plus_s = _AP_S || _AP_S2;
+    static constexpr int div_w =
+        _AP_W + hcl_ap::detail::maxw(F2, 0) + _AP_S2;
+    static constexpr int div_i = _AP_I + F2 + _AP_S2;
+    static constexpr bool div_s = _AP_S || _AP_S2;
+
+    typedef ap_fixed_base<mult_w, mult_i, mult_s> mult;
+    typedef ap_fixed_base<plus_w, plus_i, plus_s> plus;
+    typedef ap_fixed_base<plus_w, plus_i, true> minus;
+    typedef ap_fixed_base<logic_w, logic_i, logic_s> logic;
+    typedef ap_fixed_base<div_w, div_i, div_s> div;
+  };
+
+  /// The raw bits; the value is V * 2^-F.
+  ap_int_base<_AP_W, _AP_S> V;
+
+  //===--------------------------------------------------------------------===//
+  // Constructors
+  //===--------------------------------------------------------------------===//
+
+  ap_fixed_base() = default;
+  ap_fixed_base(const ap_fixed_base &) = default;
+  ap_fixed_base &operator=(const ap_fixed_base &) = default;
+
+  template <int _AP_W2, int _AP_I2, bool _AP_S2, ap_q_mode _AP_Q2,
+            ap_o_mode _AP_O2, int _AP_N2>
+  ap_fixed_base(const ap_fixed_base<_AP_W2, _AP_I2, _AP_S2, _AP_Q2, _AP_O2,
+                                    _AP_N2> &op) {
+    setRaw<_AP_W2 - _AP_I2>(op.V);
+  }
+
+  template <int _AP_W2, bool _AP_S2>
+  ap_fixed_base(const ap_int_base<_AP_W2, _AP_S2> &op) {
+    setRaw<0>(op);
+  }
+
+  template <typename T, hcl_ap::enable_if_int_t<T> = 0> ap_fixed_base(T op) {
+    setRaw<0>(typename hcl_ap::ctype<T>::type(op));
+  }
+
+  template <typename T, hcl_ap::enable_if_float_t<T> = 0>
+  ap_fixed_base(T op) {
+    setDouble((double)op);
+  }
+
+  template <int _AP_W2, bool _AP_S2>
+  ap_fixed_base(const ap_bit_ref<_AP_W2, _AP_S2> &op)
+      : ap_fixed_base((bool)op) {}
+
+  template <int _AP_W2, bool _AP_S2>
+  ap_fixed_base(const ap_range_ref<_AP_W2, _AP_S2> &op)
+      : ap_fixed_base(op.get()) {}
+
+  /// Builds a value from its raw bits.
+  static ap_fixed_base fromRaw(const ap_int_base<_AP_W, _AP_S> &raw) {
+    ap_fixed_base r;
+    r.V = raw;
+    return r;
+  }
+
+  //===--------------------------------------------------------------------===//
+  // Conversions
+  //===--------------------------------------------------------------------===//
+
+  double to_double() const {
+    return std::ldexp(V.to_double(), -(_AP_W - _AP_I));
+  }
+  float to_float() const { return (float)to_double(); }
+  operator double() const { return to_double(); }
+
+  /// The integer part, truncated towards zero as in C.
+  ap_int_base<hcl_ap::detail::maxw(_AP_I, 1), _AP_S> to_ap_int_base() const {
+    constexpr int F = _AP_W - _AP_I;
+    typedef ap_int_base<hcl_ap::detail::maxw(_AP_I, 1), _AP_S> R;
+    if constexpr (F <= 0) {
+      return R(V) << -F;
+    } else {
+      ap_int_base<_AP_W + 1, true> t(V);
+      bool fraction;
+      if constexpr (F >= _AP_W + 1)
+        fraction = !t.iszero();
+      else
+        fraction = !(t << (_AP_W + 1 - F)).iszero();
+      t >>= F;
+      if (t.sign() && fraction)
+        t += 1;
+      return R(t);
+    }
+  }
+  int to_int() const { return to_ap_int_base().to_int(); }
+  unsigned to_uint() const { return to_ap_int_base().to_uint(); }
+  long to_long() const { return to_ap_int_base().to_long(); }
+  unsigned long to_ulong() const { return to_ap_int_base().to_ulong(); }
+  int64_t to_int64() const { return to_ap_int_base().to_int64(); }
+  uint64_t to_uint64() const { return to_ap_int_base().to_uint64(); }
+  bool to_bool() const { return !V.iszero(); }
+
+  int length() const { return _AP_W; }
+  bool iszero() const { return V.iszero(); }
+  bool is_zero() const { return V.iszero(); }
+  bool sign() const { return V.sign(); }
+
+  std::string to_string(int radix = 10) const {
+    if (radix != 10)
+      return V.to_string(radix, false);
+    char buf[64];
+    std::snprintf(buf, sizeof(buf), "%.17g", to_double());
+    return buf;
+  }
+
+  //===--------------------------------------------------------------------===//
+  // Bit access on the raw bits
+  //===--------------------------------------------------------------------===//
+
+  ap_bit_ref<_AP_W, _AP_S> operator[](int index) { return V[index]; }
+  bool operator[](int index) const { return V.get_bit(index); }
+  ap_bit_ref<_AP_W, _AP_S> bit(int index) { return V[index]; }
+  bool get_bit(int index) const { return V.get_bit(index); }
+  void set_bit(int index, bool val) { V.set_bit(index, val); }
+
+  ap_range_ref<_AP_W, _AP_S> operator()(int hi, int lo) { return V(hi, lo); }
+  ap_int_base<_AP_W, false> operator()(int hi, int lo) const {
+    return V.get_range(hi, lo);
+  }
+  ap_range_ref<_AP_W, _AP_S> range(int hi, int lo) { return V(hi, lo); }
+  ap_int_base<_AP_W, false> range(int hi, int lo) const {
+    return V.get_range(hi, lo);
+  }
+  ap_range_ref<_AP_W, _AP_S> range() { return V.range(); }
+  ap_int_base<_AP_W, false> range() const { return V.range(); }
+
+  //===--------------------------------------------------------------------===//
+  // Assignment and unary operators
+  //===--------------------------------------------------------------------===//
+
+#define HCL_AF_ASSIGN_OP(Sym, Op)                                              \
+  template <int _AP_W2, int _AP_I2, bool _AP_S2, ap_q_mode _AP_Q2,             \
+            ap_o_mode _AP_O2, int _AP_N2>                                      \
+  ap_fixed_base &operator Sym(const ap_fixed_base<_AP_W2, _AP_I2, _AP_S2,      \
+                                                  _AP_Q2, _AP_O2, _AP_N2> &op) { \
+    return *this = *this Op op;                                                \
+  }                                                                            \
+  template <int _AP_W2, bool _AP_S2>                                           \
+  ap_fixed_base &operator Sym(const ap_int_base<_AP_W2, _AP_S2> &op) {         \
+    return *this = *this Op ap_fixed_base<_AP_W2, _AP_W2, _AP_S2>(op);         \
+  }                                                                            \
+  template <typename T, hcl_ap::enable_if_int_t<T> = 0>                        \
+  ap_fixed_base &operator Sym(T op) {                                          \
+    return *this Sym typename hcl_ap::ctype<T>::type(op);                      \
+  }                                                                            \
+  template <typename T, hcl_ap::enable_if_float_t<T> = 0>                      \
+  ap_fixed_base &operator Sym(T op) {                                          \
+    return *this = ap_fixed_base(to_double() Op (double)op);                   \
+  }
+
+  HCL_AF_ASSIGN_OP(+=, +)
+  HCL_AF_ASSIGN_OP(-=, -)
+  HCL_AF_ASSIGN_OP(*=, *)
+  HCL_AF_ASSIGN_OP(/=, /)
+#undef HCL_AF_ASSIGN_OP
+
+  ap_fixed_base &operator&=(const ap_fixed_base &op) {
+    V &= op.V;
+    return *this;
+  }
+  ap_fixed_base &operator|=(const ap_fixed_base &op) {
+    V |= op.V;
+    return *this;
+  }
+  ap_fixed_base &operator^=(const ap_fixed_base &op) {
+    V ^= op.V;
+    return *this;
+  }
+
+  // Shifts keep the type and move the raw bits, as in Vivado HLS.
+  ap_fixed_base &operator<<=(int sh) {
+    V <<= sh;
+    return *this;
+  }
+  ap_fixed_base &operator>>=(int sh) {
+    V >>= sh;
+    return *this;
+  }
+  ap_fixed_base operator<<(int sh) const { return fromRaw(V << sh); }
+  ap_fixed_base operator>>(int sh) const { return fromRaw(V >> sh); }
+  template <int _AP_W2, bool _AP_S2>
+  ap_fixed_base operator<<(const ap_int_base<_AP_W2, _AP_S2> &sh) const {
+    return *this << sh.to_int();
+  }
+  template <int _AP_W2, bool _AP_S2>
+  ap_fixed_base operator>>(const ap_int_base<_AP_W2, _AP_S2> &sh) const {
+    return *this >> sh.to_int();
+  }
+
+  ap_fixed_base &operator++() { return *this += 1; }
+  ap_fixed_base &operator--() { return *this -= 1; }
+  ap_fixed_base operator++(int) {
+    ap_fixed_base t = *this;
+    *this += 1;
+    return t;
+  }
+  ap_fixed_base operator--(int) {
+    ap_fixed_base t = *this;
+    *this -= 1;
+    return t;
+  }
+
+  ap_fixed_base operator+() const { return *this; }
+  ap_fixed_base<_AP_W + 1, _AP_I + 1, true> operator-() const {
+    return ap_fixed_base<_AP_W + 1, _AP_I + 1, true>::fromRaw(-V);
+  }
+  ap_fixed_base operator~() const { return fromRaw(~V); }
+  bool operator!() const { return V.iszero(); }
+
+  //===--------------------------------------------------------------------===//
+  // Quantization and overflow
+  //===--------------------------------------------------------------------===//
+
+  /// Assigns raw * 2^-F2, rounding and saturating as the modes require.
+  template <int F2, int _AP_W2, bool _AP_S2>
+  void setRaw(const ap_int_base<_AP_W2, _AP_S2> &raw) {
+    constexpr int F = _AP_W - _AP_I;
+    constexpr int sh = F - F2;
+    if constexpr (sh >= 0) {
+      // Exact left shift; one spare bit keeps unsigned sources positive.
+      constexpr int WT = _AP_W2 + sh + 1;
+      ap_int_base<WT, true> t(raw);
+      t <<= sh;
+      V = hcl_ap::detail::overflow<_AP_W, _AP_S, _AP_O>(t);
+    } else {
+      // Two spare bits absorb the rounding carry.
+      constexpr int WT = _AP_W2 + 2;
+      ap_int_base<WT, true> t(raw);
+      V = hcl_ap::detail::overflow<_AP_W, _AP_S, _AP_O>(
+          hcl_ap::detail::quantize<WT, _AP_Q>(t, -sh));
+    }
+  }
+
+  /// Assigns a double by splitting it into an exact 53-bit mantissa and a
+  /// binary exponent, so no precision is lost before quantization.
+  void setDouble(double d) {
+    V = 0;
+    if (d == 0 || !std::isfinite(d))
+      return;
+    constexpr int F = _AP_W - _AP_I;
+    int exp;
+    double frac = std::frexp(d, &exp);
+    ap_int_base<54, true> m((int64_t)std::ldexp(frac, 53));
+    int sh = F + exp - 53;
+    // Room for the mantissa shifted by up to W bits.
+    constexpr int WT = _AP_W + 56;
+    if (sh >= _AP_W) {
+      // |raw| >= 2^(52+W) overflows any mode, and wrapping keeps only the
+      // zero low bits of the shifted mantissa.
+      ap_int_base<WT, true> big;
+      big.set_bit(WT - 2, true);
+      if (d < 0)
+        big = -big;
+      V = hcl_ap::detail::overflow<_AP_W, _AP_S, _AP_O>(big);
+      return;
+    }
+    if (sh >= 0) {
+      ap_int_base<WT, true> t(m);
+      t <<= sh;
+      V = hcl_ap::detail::overflow<_AP_W, _AP_S, _AP_O>(t);
+    } else {
+      ap_int_base<WT, true> t(m);
+      V = hcl_ap::detail::overflow<_AP_W, _AP_S, _AP_O>(
+          hcl_ap::detail::quantize<WT, _AP_Q>(t, -sh));
+    }
+  }
+};
+
+template <int _AP_W, bool _AP_S>
+template <int _AP_W2, int _AP_I2, bool _AP_S2, ap_q_mode _AP_Q2,
+          ap_o_mode _AP_O2, int _AP_N2>
+ap_int_base<_AP_W, _AP_S>::ap_int_base(
+    const ap_fixed_base<_AP_W2, _AP_I2, _AP_S2, _AP_Q2, _AP_O2, _AP_N2> &op)
+    : ap_int_base(op.to_ap_int_base()) {}
+
+//===----------------------------------------------------------------------===//
+// Binary operators
+//===----------------------------------------------------------------------===//
+
+namespace hcl_ap {
+namespace detail {
+
+/// Raw bits of a fixed value rescaled to F fractional bits in type R.
+template <typename R, int F, int _AP_W, int _AP_I, bool _AP_S, ap_q_mode _AP_Q,
+          ap_o_mode _AP_O, int _AP_N>
+inline R align(
+    const ap_fixed_base<_AP_W, _AP_I, _AP_S, _AP_Q, _AP_O, _AP_N> &op) {
+  R r(op.V);
+  return r << (F - (_AP_W - _AP_I));
+}
+
+} // namespace detail
+} // namespace hcl_ap
+
+#define HCL_AF_TPARAMS                                                         \
+  int _AP_W, int _AP_I, bool _AP_S, ap_q_mode _AP_Q, ap_o_mode _AP_O,          \
+      int _AP_N, int _AP_W2, int _AP_I2, bool _AP_S2, ap_q_mode _AP_Q2,        \
+      ap_o_mode _AP_O2, int _AP_N2
+#define HCL_AF_LHS ap_fixed_base<_AP_W, _AP_I, _AP_S, _AP_Q, _AP_O, _AP_N>
+#define HCL_AF_RHS                                                             \
+  ap_fixed_base<_AP_W2, _AP_I2, _AP_S2, _AP_Q2, _AP_O2, _AP_N2>
+#define HCL_AF_RTYPE(RTy)                                                      \
+  typename HCL_AF_LHS::template RType<_AP_W2, _AP_I2, _AP_S2>::RTy
+
+// Add, subtract and bitwise ops align both operands to the finer scale in
+// the exact result type and then operate on the raw bits.
+#define HCL_AF_ALIGNED_OP(Sym, RTy)                                            \
+  template <HCL_AF_TPARAMS>                                                    \
+  inline HCL_AF_RTYPE(RTy) operator Sym(const HCL_AF_LHS &op,                  \
+                                        const HCL_AF_RHS &op2) {               \
+    typedef HCL_AF_RTYPE(RTy) R;                                               \
+    typedef ap_int_base<R::width, R::sign_flag> Raw;                           \
+    constexpr int F = R::fwidth;                                               \
+    Raw lhs = hcl_ap::detail::align<Raw, F>(op);                               \
+    lhs Sym## = hcl_ap::detail::align<Raw, F>(op2);                            \
+    return R::fromRaw(lhs);                                                    \
+  }
+
+HCL_AF_ALIGNED_OP(+, plus)
+HCL_AF_ALIGNED_OP(-, minus)
+HCL_AF_ALIGNED_OP(&, logic)
+HCL_AF_ALIGNED_OP(|, logic)
+HCL_AF_ALIGNED_OP(^, logic)
+#undef HCL_AF_ALIGNED_OP
+
+template <HCL_AF_TPARAMS>
+inline HCL_AF_RTYPE(mult) operator*(const HCL_AF_LHS &op,
+                                    const HCL_AF_RHS &op2) {
+  typedef HCL_AF_RTYPE(mult) R;
+  ap_int_base<R::width, R::sign_flag> lhs(op.V);
+  lhs *= op2.V;
+  return R::fromRaw(lhs);
+}
+
+template <HCL_AF_TPARAMS>
+inline HCL_AF_RTYPE(div) operator/(const HCL_AF_LHS &op,
+                                   const HCL_AF_RHS &op2) {
+  typedef HCL_AF_RTYPE(div) R;
+  constexpr int F2 = _AP_W2 - _AP_I2;
+  constexpr int sh = F2 > 0 ? F2 : 0;
+  ap_int_base<_AP_W + sh, _AP_S> lhs(op.V);
+  lhs <<= sh;
+  return R::fromRaw(lhs / op2.V);
+}
+
+#define HCL_AF_CMP_OP(Sym)                                                     \
+  template <HCL_AF_TPARAMS>                                                    \
+  inline bool operator Sym(const HCL_AF_LHS &op, const HCL_AF_RHS &op2) {      \
+    typedef HCL_AF_RTYPE(logic) R;                                             \
+    typedef ap_int_base<R::width, R::sign_flag> Raw;                           \
+    constexpr int F = R::fwidth;                                               \
+    return hcl_ap::detail::align<Raw, F>(op) Sym                               \
+        hcl_ap::detail::align<Raw, F>(op2);                                    \
+  }
+
+HCL_AF_CMP_OP(==)
+HCL_AF_CMP_OP(!=)
+HCL_AF_CMP_OP(<)
+HCL_AF_CMP_OP(<=)
+HCL_AF_CMP_OP(>)
+HCL_AF_CMP_OP(>=)
+#undef HCL_AF_CMP_OP
+
+#undef HCL_AF_TPARAMS
+#undef HCL_AF_LHS
+#undef HCL_AF_RHS
+#undef HCL_AF_RTYPE
+
+// Integers behave as ap_fixed<W, W> of their own width; floating-point
+// operands turn the whole expression into floating point.
+#define HCL_AF_TPARAMS1                                                        \
+  int _AP_W, int _AP_I, bool _AP_S, ap_q_mode _AP_Q, ap_o_mode _AP_O, int _AP_N
+#define HCL_AF_TYPE1 ap_fixed_base<_AP_W, _AP_I, _AP_S, _AP_Q, _AP_O, _AP_N>
+
+#define HCL_AF_BIN_OP_WITH_INT(Sym)                                            \
+  template <HCL_AF_TPARAMS1, typename T, hcl_ap::enable_if_int_t<T> = 0>       \
+  inline auto operator Sym(const HCL_AF_TYPE1 &op, T op2) {                    \
+    typedef hcl_ap::ctype<T> C;                                                \
+    return op Sym ap_fixed_base<C::width, C::width, C::sign>(op2);             \
+  }                                                                            \
+  template <HCL_AF_TPARAMS1, typename T, hcl_ap::enable_if_int_t<T> = 0>       \
+  inline auto operator Sym(T op, const HCL_AF_TYPE1 &op2) {                    \
+    typedef hcl_ap::ctype<T> C;                                                \
+    return ap_fixed_base<C::width, C::width, C::sign>(op) Sym op2;             \
+  }                                                                            \
+  template <HCL_AF_TPARAMS1, int _AP_W2, bool _AP_S2>                          \
+  inline auto operator Sym(const HCL_AF_TYPE1 &op,                             \
+                           const ap_int_base<_AP_W2, _AP_S2> &op2) {           \
+    return op Sym ap_fixed_base<_AP_W2, _AP_W2, _AP_S2>(op2);                  \
+  }                                                                            \
+  template <HCL_AF_TPARAMS1, int _AP_W2, bool _AP_S2>                          \
+  inline auto operator Sym(const ap_int_base<_AP_W2, _AP_S2> &op,              \
+                           const HCL_AF_TYPE1 &op2) {                          \
+    return ap_fixed_base<_AP_W2, _AP_W2, _AP_S2>(op) Sym op2;                  \
+  }
+
+#define HCL_AF_BIN_OP_WITH_FLOAT(Sym)                                          \
+  template <HCL_AF_TPARAMS1, typename T, hcl_ap::enable_if_float_t<T> = 0>     \
+  inline auto operator Sym(const HCL_AF_TYPE1 &op, T op2) {                    \
+    return (T)op.to_double() Sym op2;                                          \
+  }                                                                            \
+  template <HCL_AF_TPARAMS1, typename T, hcl_ap::enable_if_float_t<T> = 0>     \
+  inline auto operator Sym(T op, const HCL_AF_TYPE1 &op2) {                    \
+    return op Sym(T) op2.to_double();                                          \
+  }
+
+HCL_AF_BIN_OP_WITH_INT(+)
+HCL_AF_BIN_OP_WITH_INT(-)
+HCL_AF_BIN_OP_WITH_INT(*)
+HCL_AF_BIN_OP_WITH_INT(/)
+HCL_AF_BIN_OP_WITH_INT(==)
+HCL_AF_BIN_OP_WITH_INT(!=)
+HCL_AF_BIN_OP_WITH_INT(<)
+HCL_AF_BIN_OP_WITH_INT(<=)
+HCL_AF_BIN_OP_WITH_INT(>)
+HCL_AF_BIN_OP_WITH_INT(>=)
+HCL_AF_BIN_OP_WITH_FLOAT(+)
+HCL_AF_BIN_OP_WITH_FLOAT(-)
+HCL_AF_BIN_OP_WITH_FLOAT(*)
+HCL_AF_BIN_OP_WITH_FLOAT(/)
+HCL_AF_BIN_OP_WITH_FLOAT(==)
+HCL_AF_BIN_OP_WITH_FLOAT(!=)
+HCL_AF_BIN_OP_WITH_FLOAT(<)
+HCL_AF_BIN_OP_WITH_FLOAT(<=)
+HCL_AF_BIN_OP_WITH_FLOAT(>)
+HCL_AF_BIN_OP_WITH_FLOAT(>=)
+#undef HCL_AF_BIN_OP_WITH_INT
+#undef HCL_AF_BIN_OP_WITH_FLOAT
+
+template <HCL_AF_TPARAMS1>
+inline std::ostream &operator<<(std::ostream &os, const HCL_AF_TYPE1 &op) {
+  return os << op.to_double();
+}
+
+#undef HCL_AF_TPARAMS1
+#undef HCL_AF_TYPE1
+
+//===----------------------------------------------------------------------===//
+// ap_fixed / ap_ufixed
+//===----------------------------------------------------------------------===//
+
+template <int _AP_W, int _AP_I, ap_q_mode _AP_Q = AP_TRN,
+          ap_o_mode _AP_O = AP_WRAP, int _AP_N = 0>
+struct ap_fixed : ap_fixed_base<_AP_W, _AP_I, true, _AP_Q, _AP_O, _AP_N> {
+  typedef ap_fixed_base<_AP_W, _AP_I, true, _AP_Q, _AP_O, _AP_N> Base;
+  using Base::Base;
+  ap_fixed() = default;
+  ap_fixed(const Base &op) : Base(op) {}
+};
+
+template <int _AP_W, int _AP_I, ap_q_mode _AP_Q = AP_TRN,
+          ap_o_mode _AP_O = AP_WRAP, int _AP_N = 0>
+struct ap_ufixed : ap_fixed_base<_AP_W, _AP_I, false, _AP_Q, _AP_O, _AP_N> {
+  typedef ap_fixed_base<_AP_W, _AP_I, false, _AP_Q, _AP_O, _AP_N> Base;
+  using Base::Base;
+  ap_ufixed() = default;
+  ap_ufixed(const Base &op) : Base(op) {}
+};
+
+#endif // HCL_SIMULATION_AP_FIXED_H
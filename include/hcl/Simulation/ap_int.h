@@ -0,0 +1,1011 @@
+/*
+ * Copyright HeteroCL authors. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//===----------------------------------------------------------------------===//
+// Header-only, bit-accurate replacement for the Vivado HLS ap_int.h. It lets
+// the output of `hcl-translate -emit-vivado-hls` be compiled and simulated by
+// any C++17 host compiler without a vendor installation.
+//
+// Values are stored as little-endian 64-bit limbs in two's complement, kept
+// sign- or zero-extended above bit W. For W <= 64 there is a single limb and
+// every operation reduces to one native instruction plus a normalization,
+// which is a plain integer cast for the 8/16/32/64-bit widths.
+//===----------------------------------------------------------------------===//
+
+#ifndef HCL_SIMULATION_AP_INT_H
+#define HCL_SIMULATION_AP_INT_H
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <type_traits>
+
+enum ap_q_mode {
+  AP_RND,         // Round half towards plus infinity.
+  AP_RND_ZERO,    // Round half towards zero.
+  AP_RND_MIN_INF, // Round half towards minus infinity.
+  AP_RND_INF,     // Round half away from zero.
+  AP_RND_CONV,    // Round half to even.
+  AP_TRN,         // Truncate towards minus infinity.
+  AP_TRN_ZERO     // Truncate towards zero.
+};
+
+enum ap_o_mode {
+  AP_SAT,      // Saturate to the minimum or maximum value.
+  AP_SAT_ZERO, // Set to zero on overflow.
+  AP_SAT_SYM,  // Saturate symmetrically around zero.
+  AP_WRAP,     // Wrap around.
+  AP_WRAP_SM   // Sign-magnitude wrap; simulated as AP_WRAP.
+};
+
+template <int _AP_W, bool _AP_S> struct ap_int_base;
+template <int _AP_W, bool _AP_S> struct ap_bit_ref;
+template <int _AP_W, bool _AP_S> struct ap_range_ref;
+template <int _AP_W, int _AP_I, bool _AP_S, ap_q_mode _AP_Q, ap_o_mode _AP_O,
+          int _AP_N>
+struct ap_fixed_base;
+
+namespace hcl_ap {
+namespace detail {
+
+constexpr int limbs(int w) { return (w + 63) / 64; }
+constexpr int maxw(int a, int b) { return a > b ? a : b; }
+constexpr int minw(int a, int b) { return a < b ? a : b; }
+
+/// Sign- or zero-extends the top limb of a W-bit value above bit W.
+template <int W, bool S> inline void normalize(uint64_t *v) {
+  constexpr int n = limbs(W);
+  constexpr int r = W - 64 * (n - 1);
+  uint64_t &top = v[n - 1];
+  if constexpr (r == 64) {
+    return;
+  } else if constexpr (S) {
+    if constexpr (r == 8)
+      top = (uint64_t)(int64_t)(int8_t)top;
+    else if constexpr (r == 16)
+      top = (uint64_t)(int64_t)(int16_t)top;
+    else if constexpr (r == 32)
+      top = (uint64_t)(int64_t)(int32_t)top;
+    else
+      top = (uint64_t)((int64_t)(top << (64 - r)) >> (64 - r));
+  } else {
+    if constexpr (r == 8)
+      top = (uint8_t)top;
+    else if constexpr (r == 16)
+      top = (uint16_t)top;
+    else if constexpr (r == 32)
+      top = (uint32_t)top;
+    else
+      top &= ~0ULL >> (64 - r);
+  }
+}
+
+inline bool isNegative(const uint64_t *v, int n, bool sgn) {
+  return sgn && (int64_t)v[n - 1] < 0;
+}
+
+/// Copies an ns-limb value into nd limbs, filling with its sign.
+inline void extend(const uint64_t *s, int ns, bool sgn, uint64_t *d, int nd) {
+  uint64_t fill = isNegative(s, ns, sgn) ? ~0ULL : 0;
+  for (int i = 0; i < nd; ++i)
+    d[i] = i < ns ? s[i] : fill;
+}
+
+template <int N>
+inline void add(const uint64_t *a, const uint64_t *b, uint64_t *r) {
+  if constexpr (N == 1) {
+    r[0] = a[0] + b[0];
+  } else {
+    uint64_t c = 0;
+    for (int i = 0; i < N; ++i) {
+      uint64_t s = a[i] + c;
+      uint64_t c1 = s < c;
+      uint64_t t = s + b[i];
+      c = c1 | (t < s);
+      r[i] = t;
+    }
+  }
+}
+
+template <int N>
+inline void sub(const uint64_t *a, const uint64_t *b, uint64_t *r) {
+  if constexpr (N == 1) {
+    r[0] = a[0] - b[0];
+  } else {
+    uint64_t br = 0;
+    for (int i = 0; i < N; ++i) {
+      uint64_t ai = a[i], bi = b[i];
+      uint64_t d = ai - bi;
+      uint64_t b1 = ai < bi;
+      r[i] = d - br;
+      br = b1 | (d < br);
+    }
+  }
+}
+
+template <int N> inline void neg(const uint64_t *a, uint64_t *r) {
+  uint64_t zero[N] = {};
+  sub<N>(zero, a, r);
+}
+
+inline void mul64(uint64_t a, uint64_t b, uint64_t &lo, uint64_t &hi) {
+#ifdef __SIZEOF_INT128__
+  __extension__ typedef unsigned __int128 uint128_t;
+  uint128_t p = (uint128_t)a * b;
+  lo = (uint64_t)p;
+  hi = (uint64_t)(p >> 64);
+#else
+  uint64_t al = a & 0xffffffffULL, ah = a >> 32;
+  uint64_t bl = b & 0xffffffffULL, bh = b >> 32;
+  uint64_t ll = al * bl, lh = al * bh, hl = ah * bl, hh = ah * bh;
+  uint64_t mid = (ll >> 32) + (lh & 0xffffffffULL) + (hl & 0xffffffffULL);
+  lo = (ll & 0xffffffffULL) | (mid << 32);
+  hi = hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+#endif
+}
+
+/// r = a * b mod 2^(64N). Two's complement makes this sign-agnostic.
+template <int N>
+inline void mul(const uint64_t *a, const uint64_t *b, uint64_t *r) {
+  if constexpr (N == 1) {
+    r[0] = a[0] * b[0];
+  } else {
+    uint64_t t[N] = {};
+    for (int i = 0; i < N; ++i) {
+      if (a[i] == 0)
+        continue;
+      uint64_t carry = 0;
+      for (int j = 0; i + j < N; ++j) {
+        uint64_t lo, hi;
+        mul64(a[i], b[j], lo, hi);
+        uint64_t s = t[i + j] + lo;
+        uint64_t c1 = s < lo;
+        uint64_t s2 = s + carry;
+        uint64_t c2 = s2 < carry;
+        t[i + j] = s2;
+        carry = hi + c1 + c2;
+      }
+    }
+    for (int i = 0; i < N; ++i)
+      r[i] = t[i];
+  }
+}
+
+template <int N> inline void shl(const uint64_t *a, int sh, uint64_t *r) {
+  if (sh >= 64 * N) {
+    for (int i = 0; i < N; ++i)
+      r[i] = 0;
+    return;
+  }
+  if constexpr (N == 1) {
+    r[0] = a[0] << sh;
+  } else {
+    int ls = sh / 64, bs = sh % 64;
+    for (int i = N - 1; i >= 0; --i) {
+      uint64_t v = 0;
+      if (i - ls >= 0) {
+        v = a[i - ls] << bs;
+        if (bs && i - ls - 1 >= 0)
+          v |= a[i - ls - 1] >> (64 - bs);
+      }
+      r[i] = v;
+    }
+  }
+}
+
+template <int N>
+inline void shr(const uint64_t *a, int sh, bool arith, uint64_t *r) {
+  uint64_t fill = (arith && (int64_t)a[N - 1] < 0) ? ~0ULL : 0;
+  if (sh >= 64 * N) {
+    for (int i = 0; i < N; ++i)
+      r[i] = fill;
+    return;
+  }
+  if constexpr (N == 1) {
+    r[0] = arith ? (uint64_t)((int64_t)a[0] >> sh) : a[0] >> sh;
+  } else {
+    int ls = sh / 64, bs = sh % 64;
+    for (int i = 0; i < N; ++i) {
+      uint64_t lo = i + ls < N ? a[i + ls] : fill;
+      uint64_t hi = i + ls + 1 < N ? a[i + ls + 1] : fill;
+      r[i] = bs ? (lo >> bs) | (hi << (64 - bs)) : lo;
+    }
+  }
+}
+
+template <int N>
+inline int cmp(const uint64_t *a, const uint64_t *b, bool sgn) {
+  if (sgn) {
+    int64_t x = (int64_t)a[N - 1], y = (int64_t)b[N - 1];
+    if (x != y)
+      return x < y ? -1 : 1;
+  } else if (a[N - 1] != b[N - 1]) {
+    return a[N - 1] < b[N - 1] ? -1 : 1;
+  }
+  for (int i = N - 2; i >= 0; --i)
+    if (a[i] != b[i])
+      return a[i] < b[i] ? -1 : 1;
+  return 0;
+}
+
+/// Unsigned restoring division. Callers keep at least one spare top bit in
+/// the operands so the shifted remainder never overflows N limbs.
+template <int N>
+inline void udivmod(const uint64_t *a, const uint64_t *b, uint64_t *q,
+                    uint64_t *r) {
+  uint64_t qq[N] = {}, rr[N] = {};
+  int top = 64 * N - 1;
+  while (top >= 0 && !((a[top / 64] >> (top % 64)) & 1))
+    --top;
+  for (int i = top; i >= 0; --i) {
+    shl<N>(rr, 1, rr);
+    rr[0] |= (a[i / 64] >> (i % 64)) & 1;
+    if (cmp<N>(rr, b, false) >= 0) {
+      sub<N>(rr, b, rr);
+      qq[i / 64] |= 1ULL << (i % 64);
+    }
+  }
+  for (int i = 0; i < N; ++i) {
+    q[i] = qq[i];
+    r[i] = rr[i];
+  }
+}
+
+/// C-style division: the quotient truncates towards zero and the remainder
+/// takes the sign of the dividend.
+template <int N>
+inline void divmod(const uint64_t *a, const uint64_t *b, bool sgn, uint64_t *q,
+                   uint64_t *r) {
+  if constexpr (N == 1) {
+    if (sgn) {
+      int64_t x = (int64_t)a[0], y = (int64_t)b[0];
+      q[0] = (uint64_t)(x / y);
+      r[0] = (uint64_t)(x % y);
+    } else {
+      q[0] = a[0] / b[0];
+      r[0] = a[0] % b[0];
+    }
+  } else {
+    bool na = isNegative(a, N, sgn), nb = isNegative(b, N, sgn);
+    uint64_t ua[N], ub[N];
+    for (int i = 0; i < N; ++i) {
+      ua[i] = a[i];
+      ub[i] = b[i];
+    }
+    if (na)
+      neg<N>(ua, ua);
+    if (nb)
+      neg<N>(ub, ub);
+    udivmod<N>(ua, ub, q, r);
+    if (na != nb)
+      neg<N>(q, q);
+    if (na)
+      neg<N>(r, r);
+  }
+}
+
+/// Divides the unsigned value in place by a small divisor and returns the
+/// remainder. Works on 32-bit halves so no 128-bit type is required.
+template <int N> inline uint32_t divSmall(uint64_t *v, uint32_t d) {
+  uint64_t rem = 0;
+  for (int i = N - 1; i >= 0; --i) {
+    uint64_t hi = (rem << 32) | (v[i] >> 32);
+    uint64_t qh = hi / d;
+    rem = hi % d;
+    uint64_t lo = (rem << 32) | (v[i] & 0xffffffffULL);
+    uint64_t ql = lo / d;
+    rem = lo % d;
+    v[i] = (qh << 32) | ql;
+  }
+  return (uint32_t)rem;
+}
+
+template <int N> inline bool isZero(const uint64_t *v) {
+  for (int i = 0; i < N; ++i)
+    if (v[i])
+      return false;
+  return true;
+}
+
+template <int N> inline double toDouble(const uint64_t *v, bool sgn) {
+  if constexpr (N == 1) {
+    return sgn ? (double)(int64_t)v[0] : (double)v[0];
+  } else {
+    uint64_t m[N];
+    bool negative = isNegative(v, N, sgn);
+    for (int i = 0; i < N; ++i)
+      m[i] = v[i];
+    if (negative)
+      neg<N>(m, m);
+    double d = 0;
+    for (int i = N - 1; i >= 0; --i)
+      d = d * 18446744073709551616.0 + (double)m[i];
+    return negative ? -d : d;
+  }
+}
+
+/// Converts a double to an integer, truncating towards zero and wrapping
+/// modulo 2^(64N) like a C conversion to a wide unsigned type.
+template <int N> inline void fromDouble(double d, uint64_t *v) {
+  for (int i = 0; i < N; ++i)
+    v[i] = 0;
+  if (!std::isfinite(d))
+    return;
+  bool negative = d < 0;
+  double m = std::trunc(std::fabs(d));
+  for (int i = 0; i < N && m > 0; ++i) {
+    double q = std::floor(std::ldexp(m, -64));
+    v[i] = (uint64_t)(m - std::ldexp(q, 64));
+    m = q;
+  }
+  if (negative)
+    neg<N>(v, v);
+}
+
+template <typename T> constexpr bool isNegative(T v) {
+  if constexpr (std::is_signed<T>::value)
+    return v < 0;
+  else
+    return false;
+}
+
+} // namespace detail
+
+/// Maps a native integer type onto the ap_int_base it behaves as.
+template <typename T> struct ctype {
+  static constexpr int width =
+      std::is_same<T, bool>::value ? 1 : (int)sizeof(T) * 8;
+  static constexpr bool sign = std::is_signed<T>::value;
+  typedef ap_int_base<width, sign> type;
+};
+
+template <typename T>
+using enable_if_int_t =
+    typename std::enable_if<std::is_integral<T>::value, int>::type;
+template <typename T>
+using enable_if_float_t =
+    typename std::enable_if<std::is_floating_point<T>::value, int>::type;
+
+} // namespace hcl_ap
+
+//===----------------------------------------------------------------------===//
+// ap_int_base
+//===----------------------------------------------------------------------===//
+
+template <int _AP_W, bool _AP_S> struct ap_int_base {
+  static_assert(_AP_W > 0, "ap_int bit width must be positive");
+  static const int width = _AP_W;
+  static const bool sign_flag = _AP_S;
+  static constexpr int N = hcl_ap::detail::limbs(_AP_W);
+
+  /// Result types of binary operators, following the Vivado HLS rules: the
+  /// result is always wide enough to hold the exact value.
+  template <int _AP_W2, bool _AP_S2> struct RType {
+    static constexpr int logic_w =
+        hcl_ap::detail::maxw(_AP_W + (_AP_S2 && !_AP_S),
+                             _AP_W2 + (_AP_S && !_AP_S2));
+    static constexpr int mult_w = _AP_W + _AP_W2;
+    static constexpr bool mult_s = _AP_S || _AP_S2;
+    static constexpr int plus_w = logic_w + 1;
+    static constexpr bool plus_s = _AP_S || _AP_S2;
+    static constexpr int minus_w = logic_w + 1;
+    static constexpr bool minus_s = true;
+    static constexpr int div_w = _AP_W + _AP_S2;
+    static constexpr bool div_s = _AP_S || _AP_S2;
+    static constexpr int mod_w =
+        hcl_ap::detail::minw(_AP_W, _AP_W2 + (!_AP_S2 && _AP_S));
+    static constexpr bool mod_s = _AP_S;
+    static constexpr bool logic_s = _AP_S || _AP_S2;
+
+    typedef ap_int_base<mult_w, mult_s> mult;
+    typedef ap_int_base<plus_w, plus_s> plus;
+    typedef ap_int_base<minus_w, minus_s> minus;
+    typedef ap_int_base<logic_w, logic_s> logic;
+    typedef ap_int_base<div_w, div_s> div;
+    typedef ap_int_base<mod_w, mod_s> mod;
+    // Division and comparison are evaluated in a type with two spare bits.
+    typedef ap_int_base<logic_w + 2, logic_s> wide;
+  };
+
+  typedef typename std::conditional<_AP_S, long long, unsigned long long>::type
+      RetType;
+
+  uint64_t V[N];
+
+  void normalize() { hcl_ap::detail::normalize<_AP_W, _AP_S>(V); }
+
+  //===--------------------------------------------------------------------===//
+  // Constructors
+  //===--------------------------------------------------------------------===//
+
+  ap_int_base() : V() {}
+  ap_int_base(const ap_int_base &) = default;
+  ap_int_base &operator=(const ap_int_base &) = default;
+
+  template <int _AP_W2, bool _AP_S2>
+  ap_int_base(const ap_int_base<_AP_W2, _AP_S2> &op) {
+    hcl_ap::detail::extend(op.V, ap_int_base<_AP_W2, _AP_S2>::N, _AP_S2, V, N);
+    normalize();
+  }
+
+  template <typename T, hcl_ap::enable_if_int_t<T> = 0> ap_int_base(T op) {
+    V[0] = (uint64_t)op;
+    for (int i = 1; i < N; ++i)
+      V[i] = hcl_ap::detail::isNegative(op) ? ~0ULL : 0;
+    normalize();
+  }
+
+  template <typename T, hcl_ap::enable_if_float_t<T> = 0> ap_int_base(T op) {
+    hcl_ap::detail::fromDouble<N>((double)op, V);
+    normalize();
+  }
+
+  template <int _AP_W2, bool _AP_S2>
+  ap_int_base(const ap_bit_ref<_AP_W2, _AP_S2> &ref)
+      : ap_int_base((bool)ref) {}
+
+  template <int _AP_W2, bool _AP_S2>
+  ap_int_base(const ap_range_ref<_AP_W2, _AP_S2> &ref)
+      : ap_int_base(ref.get()) {}
+
+  // Defined in ap_fixed.h.
+  template <int _AP_W2, int _AP_I2, bool _AP_S2, ap_q_mode _AP_Q2,
+            ap_o_mode _AP_O2, int _AP_N2>
+  ap_int_base(
+      const ap_fixed_base<_AP_W2, _AP_I2, _AP_S2, _AP_Q2, _AP_O2, _AP_N2> &op);
+
+  /// Parses a string in the given radix. A radix of 0 accepts the 0b, 0o and
+  /// 0x prefixes and defaults to decimal.
+  explicit ap_int_base(const char *str, signed char radix = 0) : V() {
+    bool negative = false;
+    if (*str == '-' || *str == '+')
+      negative = *str++ == '-';
+    if (radix == 0) {
+      radix = 10;
+      if (str[0] == '0' && (str[1] == 'b' || str[1] == 'B'))
+        radix = 2;
+      else if (str[0] == '0' && (str[1] == 'o' || str[1] == 'O'))
+        radix = 8;
+      else if (str[0] == '0' && (str[1] == 'x' || str[1] == 'X'))
+        radix = 16;
+      if (radix != 10)
+        str += 2;
+    }
+    ap_int_base<_AP_W + 8, false> acc, base(radix);
+    for (; *str; ++str) {
+      int digit;
+      if (*str >= '0' && *str <= '9')
+        digit = *str - '0';
+      else if (*str >= 'a' && *str <= 'z')
+        digit = *str - 'a' + 10;
+      else if (*str >= 'A' && *str <= 'Z')
+        digit = *str - 'A' + 10;
+      else
+        continue;
+      if (digit >= radix)
+        break;
+      acc *= base;
+      acc += digit;
+    }
+    *this = acc;
+    if (negative)
+      *this = -*this;
+  }
+
+  //===--------------------------------------------------------------------===//
+  // Conversions
+  //===--------------------------------------------------------------------===//
+
+  operator RetType() const { return (RetType)V[0]; }
+
+  bool to_bool() const { return !hcl_ap::detail::isZero<N>(V); }
+  int to_int() const { return (int)V[0]; }
+  unsigned to_uint() const { return (unsigned)V[0]; }
+  long to_long() const { return (long)V[0]; }
+  unsigned long to_ulong() const { return (unsigned long)V[0]; }
+  int64_t to_int64() const { return (int64_t)V[0]; }
+  uint64_t to_uint64() const { return V[0]; }
+  double to_double() const { return hcl_ap::detail::toDouble<N>(V, _AP_S); }
+  float to_float() const { return (float)to_double(); }
+
+  int length() const { return _AP_W; }
+  bool iszero() const { return hcl_ap::detail::isZero<N>(V); }
+  bool is_zero() const { return iszero(); }
+  bool sign() const { return hcl_ap::detail::isNegative(V, N, _AP_S); }
+  bool isNegative() const { return sign(); }
+
+  /// Formats the value like Vivado: radix 2, 8 and 16 print all bits with a
+  /// 0b/0o/0x prefix, radix 10 prints a signed decimal.
+  std::string to_string(int radix = 2, bool sign = _AP_S) const {
+    static const char digits[] = "0123456789abcdef";
+    std::string s;
+    if (radix == 10) {
+      uint64_t m[N];
+      bool negative = sign && hcl_ap::detail::isNegative(V, N, true);
+      for (int i = 0; i < N; ++i)
+        m[i] = V[i];
+      if (negative)
+        hcl_ap::detail::neg<N>(m, m);
+      if (!sign && _AP_S)
+        hcl_ap::detail::normalize<_AP_W, false>(m);
+      do {
+        s.insert(s.begin(), digits[hcl_ap::detail::divSmall<N>(m, 10)]);
+      } while (!hcl_ap::detail::isZero<N>(m));
+      return negative ? "-" + s : s;
+    }
+    int bits = radix == 16 ? 4 : radix == 8 ? 3 : 1;
+    for (int i = 0; i < _AP_W; i += bits) {
+      int digit = 0;
+      for (int b = 0; b < bits && i + b < _AP_W; ++b)
+        digit |= get_bit(i + b) << b;
+      s.insert(s.begin(), digits[digit]);
+    }
+    return (radix == 16 ? "0x" : radix == 8 ? "0o" : "0b") + s;
+  }
+
+  //===--------------------------------------------------------------------===//
+  // Bit access
+  //===--------------------------------------------------------------------===//
+
+  bool get_bit(int index) const { return (V[index / 64] >> (index % 64)) & 1; }
+  bool test(int index) const { return get_bit(index); }
+
+  void set_bit(int index, bool val) {
+    uint64_t mask = 1ULL << (index % 64);
+    if (val)
+      V[index / 64] |= mask;
+    else
+      V[index / 64] &= ~mask;
+    normalize();
+  }
+  void set(int index) { set_bit(index, true); }
+  void clear(int index) { set_bit(index, false); }
+  void invert(int index) { set_bit(index, !get_bit(index)); }
+
+  ap_bit_ref<_AP_W, _AP_S> operator[](int index) {
+    return ap_bit_ref<_AP_W, _AP_S>(*this, index);
+  }
+  bool operator[](int index) const { return get_bit(index); }
+  ap_bit_ref<_AP_W, _AP_S> bit(int index) { return (*this)[index]; }
+  bool bit(int index) const { return get_bit(index); }
+
+  /// Bits hi..lo as an unsigned value. hi < lo yields the bits reversed.
+  ap_int_base<_AP_W, false> get_range(int hi, int lo) const {
+    ap_int_base<_AP_W, false> r;
+    if (hi < lo) {
+      for (int i = lo; i >= hi; --i)
+        r.V[(lo - i) / 64] |= (uint64_t)get_bit(i) << ((lo - i) % 64);
+      return r;
+    }
+    hcl_ap::detail::shr<N>(V, lo, false, r.V);
+    int len = hi - lo + 1;
+    for (int i = 0; i < N; ++i) {
+      int keep = len - 64 * i;
+      if (keep <= 0)
+        r.V[i] = 0;
+      else if (keep < 64)
+        r.V[i] &= ~0ULL >> (64 - keep);
+    }
+    r.normalize();
+    return r;
+  }
+
+  template <int _AP_W2, bool _AP_S2>
+  void set_range(int hi, int lo, const ap_int_base<_AP_W2, _AP_S2> &val) {
+    if (hi < lo) {
+      for (int i = lo; i >= hi; --i)
+        set_bit(i, val.get_bit(lo - i));
+      return;
+    }
+    ap_int_base<_AP_W, false> src(val);
+    for (int i = lo; i <= hi; ++i)
+      V[i / 64] = (V[i / 64] & ~(1ULL << (i % 64))) |
+                  ((uint64_t)src.get_bit(i - lo) << (i % 64));
+    normalize();
+  }
+
+  ap_range_ref<_AP_W, _AP_S> operator()(int hi, int lo) {
+    return ap_range_ref<_AP_W, _AP_S>(*this, hi, lo);
+  }
+  ap_int_base<_AP_W, false> operator()(int hi, int lo) const {
+    return get_range(hi, lo);
+  }
+  ap_range_ref<_AP_W, _AP_S> range(int hi, int lo) { return (*this)(hi, lo); }
+  ap_int_base<_AP_W, false> range(int hi, int lo) const {
+    return get_range(hi, lo);
+  }
+  ap_range_ref<_AP_W, _AP_S> range() { return (*this)(_AP_W - 1, 0); }
+  ap_int_base<_AP_W, false> range() const { return get_range(_AP_W - 1, 0); }
+
+  /// Reverses the bit order in place, as the Vivado method does.
+  ap_int_base &reverse() {
+    ap_int_base r;
+    for (int i = 0; i < _AP_W; ++i)
+      if (get_bit(i))
+        r.V[(_AP_W - 1 - i) / 64] |= 1ULL << ((_AP_W - 1 - i) % 64);
+    r.normalize();
+    return *this = r;
+  }
+
+  bool and_reduce() const {
+    ap_int_base<_AP_W, false> u(*this);
+    return ~u == 0;
+  }
+  bool or_reduce() const { return !iszero(); }
+  bool xor_reduce() const {
+    ap_int_base<_AP_W, false> u(*this);
+    uint64_t v = 0;
+    for (int i = 0; i < N; ++i)
+      v ^= u.V[i];
+    for (int sh = 32; sh > 0; sh >>= 1)
+      v ^= v >> sh;
+    return v & 1;
+  }
+  bool nand_reduce() const { return !and_reduce(); }
+  bool nor_reduce() const { return !or_reduce(); }
+  bool xnor_reduce() const { return !xor_reduce(); }
+
+  //===--------------------------------------------------------------------===//
+  // Assignment operators
+  //===--------------------------------------------------------------------===//
+
+  // These wrap modulo 2^W, which matches assigning the full-width result.
+#define HCL_AP_ASSIGN_MODULAR(Sym, Fn)                                         \
+  template <int _AP_W2, bool _AP_S2>                                           \
+  ap_int_base &operator Sym(const ap_int_base<_AP_W2, _AP_S2> &op) {           \
+    ap_int_base t(op);                                                         \
+    Fn;                                                                        \
+    normalize();                                                               \
+    return *this;                                                              \
+  }                                                                            \
+  template <typename T, hcl_ap::enable_if_int_t<T> = 0>                        \
+  ap_int_base &operator Sym(T op) {                                            \
+    return *this Sym ap_int_base(op);                                          \
+  }
+
+  HCL_AP_ASSIGN_MODULAR(+=, (hcl_ap::detail::add<N>(V, t.V, V)))
+  HCL_AP_ASSIGN_MODULAR(-=, (hcl_ap::detail::sub<N>(V, t.V, V)))
+  HCL_AP_ASSIGN_MODULAR(*=, (hcl_ap::detail::mul<N>(V, t.V, V)))
+  HCL_AP_ASSIGN_MODULAR(&=, for (int i = 0; i < N; ++i) V[i] &= t.V[i])
+  HCL_AP_ASSIGN_MODULAR(|=, for (int i = 0; i < N; ++i) V[i] |= t.V[i])
+  HCL_AP_ASSIGN_MODULAR(^=, for (int i = 0; i < N; ++i) V[i] ^= t.V[i])
+#undef HCL_AP_ASSIGN_MODULAR
+
+#define HCL_AP_ASSIGN_FULL(Sym, Op)                                            \
+  template <int _AP_W2, bool _AP_S2>                                           \
+  ap_int_base &operator Sym(const ap_int_base<_AP_W2, _AP_S2> &op) {           \
+    return *this = *this Op op;                                                \
+  }                                                                            \
+  template <typename T, hcl_ap::enable_if_int_t<T> = 0>                        \
+  ap_int_base &operator Sym(T op) {                                            \
+    return *this = *this Op op;                                                \
+  }
+
+  HCL_AP_ASSIGN_FULL(/=, /)
+  HCL_AP_ASSIGN_FULL(%=, %)
+#undef HCL_AP_ASSIGN_FULL
+
+  ap_int_base &operator<<=(int sh) {
+    if (sh < 0)
+      return *this >>= -sh;
+    hcl_ap::detail::shl<N>(V, sh, V);
+    normalize();
+    return *this;
+  }
+  ap_int_base &operator>>=(int sh) {
+    if (sh < 0)
+      return *this <<= -sh;
+    hcl_ap::detail::shr<N>(V, sh, _AP_S, V);
+    return *this;
+  }
+  template <int _AP_W2, bool _AP_S2>
+  ap_int_base &operator<<=(const ap_int_base<_AP_W2, _AP_S2> &sh) {
+    return *this <<= sh.to_int();
+  }
+  template <int _AP_W2, bool _AP_S2>
+  ap_int_base &operator>>=(const ap_int_base<_AP_W2, _AP_S2> &sh) {
+    return *this >>= sh.to_int();
+  }
+
+  ap_int_base &operator++() { return *this += 1; }
+  ap_int_base &operator--() { return *this -= 1; }
+  ap_int_base operator++(int) {
+    ap_int_base t = *this;
+    *this += 1;
+    return t;
+  }
+  ap_int_base operator--(int) {
+    ap_int_base t = *this;
+    *this -= 1;
+    return t;
+  }
+
+  //===--------------------------------------------------------------------===//
+  // Unary operators
+  //===--------------------------------------------------------------------===//
+
+  ap_int_base operator+() const { return *this; }
+  ap_int_base<_AP_W + 1, true> operator-() const {
+    ap_int_base<_AP_W + 1, true> r(*this);
+    hcl_ap::detail::neg<ap_int_base<_AP_W + 1, true>::N>(r.V, r.V);
+    r.normalize();
+    return r;
+  }
+  ap_int_base operator~() const {
+    ap_int_base r;
+    for (int i = 0; i < N; ++i)
+      r.V[i] = ~V[i];
+    r.normalize();
+    return r;
+  }
+  bool operator!() const { return iszero(); }
+
+  ap_int_base<_AP_W, _AP_S> operator<<(int sh) const {
+    ap_int_base r(*this);
+    return r <<= sh;
+  }
+  ap_int_base<_AP_W, _AP_S> operator>>(int sh) const {
+    ap_int_base r(*this);
+    return r >>= sh;
+  }
+  template <int _AP_W2, bool _AP_S2>
+  ap_int_base<_AP_W, _AP_S>
+  operator<<(const ap_int_base<_AP_W2, _AP_S2> &sh) const {
+    return *this << sh.to_int();
+  }
+  template <int _AP_W2, bool _AP_S2>
+  ap_int_base<_AP_W, _AP_S>
+  operator>>(const ap_int_base<_AP_W2, _AP_S2> &sh) const {
+    return *this >> sh.to_int();
+  }
+};
+
+//===----------------------------------------------------------------------===//
+// Bit and range references
+//===----------------------------------------------------------------------===//
+
+template <int _AP_W, bool _AP_S> struct ap_bit_ref {
+  ap_int_base<_AP_W, _AP_S> &d_bv;
+  int d_index;
+
+  ap_bit_ref(ap_int_base<_AP_W, _AP_S> &bv, int index)
+      : d_bv(bv), d_index(index) {}
+  ap_bit_ref(const ap_bit_ref &) = default;
+
+  bool get() const { return d_bv.get_bit(d_index); }
+  bool to_bool() const { return get(); }
+  operator bool() const { return get(); }
+  bool operator~() const { return !get(); }
+  int length() const { return 1; }
+
+  ap_bit_ref &operator=(bool val) {
+    d_bv.set_bit(d_index, val);
+    return *this;
+  }
+  ap_bit_ref &operator=(const ap_bit_ref &ref) { return *this = ref.get(); }
+  template <typename T, hcl_ap::enable_if_int_t<T> = 0>
+  ap_bit_ref &operator=(T val) {
+    return *this = (val != 0);
+  }
+  template <int _AP_W2, bool _AP_S2>
+  ap_bit_ref &operator=(const ap_int_base<_AP_W2, _AP_S2> &val) {
+    return *this = val.to_bool();
+  }
+};
+
+template <int _AP_W, bool _AP_S> struct ap_range_ref {
+  ap_int_base<_AP_W, _AP_S> &d_bv;
+  int l_index, h_index;
+
+  ap_range_ref(ap_int_base<_AP_W, _AP_S> &bv, int hi, int lo)
+      : d_bv(bv), l_index(lo), h_index(hi) {}
+  ap_range_ref(const ap_range_ref &) = default;
+
+  ap_int_base<_AP_W, false> get() const {
+    return d_bv.get_range(h_index, l_index);
+  }
+  operator ap_int_base<_AP_W, false>() const { return get(); }
+  operator unsigned long long() const { return get().to_uint64(); }
+
+  int length() const {
+    return (h_index > l_index ? h_index - l_index : l_index - h_index) + 1;
+  }
+  int to_int() const { return get().to_int(); }
+  unsigned to_uint() const { return get().to_uint(); }
+  int64_t to_int64() const { return get().to_int64(); }
+  uint64_t to_uint64() const { return get().to_uint64(); }
+  std::string to_string(int radix = 2) const {
+    return get().to_string(radix, false);
+  }
+  bool and_reduce() const {
+    ap_int_base<_AP_W, false> v = get();
+    for (int i = 0; i < length(); ++i)
+      if (!v.get_bit(i))
+        return false;
+    return true;
+  }
+  bool or_reduce() const { return !get().iszero(); }
+  bool xor_reduce() const { return get().xor_reduce(); }
+
+  template <int _AP_W2, bool _AP_S2>
+  ap_range_ref &operator=(const ap_int_base<_AP_W2, _AP_S2> &val) {
+    d_bv.set_range(h_index, l_index, val);
+    return *this;
+  }
+  template <typename T, hcl_ap::enable_if_int_t<T> = 0>
+  ap_range_ref &operator=(T val) {
+    return *this = typename hcl_ap::ctype<T>::type(val);
+  }
+  ap_range_ref &operator=(const ap_range_ref &ref) { return *this = ref.get(); }
+  template <int _AP_W2, bool _AP_S2>
+  ap_range_ref &operator=(const ap_range_ref<_AP_W2, _AP_S2> &ref) {
+    return *this = ref.get();
+  }
+};
+
+//===----------------------------------------------------------------------===//
+// Binary operators
+//===----------------------------------------------------------------------===//
+
+// Arithmetic and bitwise operators widen both operands to the exact result
+// type first, so the operation itself cannot overflow.
+#define HCL_AP_BIN_OP(Sym, RTy, Fn)                                            \
+  template <int _AP_W, bool _AP_S, int _AP_W2, bool _AP_S2>                    \
+  inline typename ap_int_base<_AP_W, _AP_S>::template RType<_AP_W2,            \
+                                                            _AP_S2>::RTy       \
+  operator Sym(const ap_int_base<_AP_W, _AP_S> &op,                            \
+               const ap_int_base<_AP_W2, _AP_S2> &op2) {                       \
+    typedef typename ap_int_base<_AP_W, _AP_S>::template RType<_AP_W2,         \
+                                                               _AP_S2>::RTy R; \
+    R lhs(op), rhs(op2);                                                       \
+    Fn;                                                                        \
+    lhs.normalize();                                                           \
+    return lhs;                                                                \
+  }
+
+HCL_AP_BIN_OP(+, plus, (hcl_ap::detail::add<R::N>(lhs.V, rhs.V, lhs.V)))
+HCL_AP_BIN_OP(-, minus, (hcl_ap::detail::sub<R::N>(lhs.V, rhs.V, lhs.V)))
+HCL_AP_BIN_OP(*, mult, (hcl_ap::detail::mul<R::N>(lhs.V, rhs.V, lhs.V)))
+HCL_AP_BIN_OP(&, logic, for (int i = 0; i < R::N; ++i) lhs.V[i] &= rhs.V[i])
+HCL_AP_BIN_OP(|, logic, for (int i = 0; i < R::N; ++i) lhs.V[i] |= rhs.V[i])
+HCL_AP_BIN_OP(^, logic, for (int i = 0; i < R::N; ++i) lhs.V[i] ^= rhs.V[i])
+#undef HCL_AP_BIN_OP
+
+// Division and remainder run in a type with spare bits, so that mixed
+// signedness and the most negative dividend are handled exactly.
+#define HCL_AP_DIV_OP(Sym, RTy, Idx)                                           \
+  template <int _AP_W, bool _AP_S, int _AP_W2, bool _AP_S2>                    \
+  inline typename ap_int_base<_AP_W, _AP_S>::template RType<_AP_W2,            \
+                                                            _AP_S2>::RTy       \
+  operator Sym(const ap_int_base<_AP_W, _AP_S> &op,                            \
+               const ap_int_base<_AP_W2, _AP_S2> &op2) {                       \
+    typedef typename ap_int_base<_AP_W, _AP_S>::template RType<_AP_W2,         \
+                                                               _AP_S2>::wide C; \
+    C lhs(op), rhs(op2), res[2];                                               \
+    hcl_ap::detail::divmod<C::N>(lhs.V, rhs.V, C::sign_flag, res[0].V,         \
+                                 res[1].V);                                    \
+    return res[Idx];                                                           \
+  }
+
+HCL_AP_DIV_OP(/, div, 0)
+HCL_AP_DIV_OP(%, mod, 1)
+#undef HCL_AP_DIV_OP
+
+#define HCL_AP_CMP_OP(Sym)                                                     \
+  template <int _AP_W, bool _AP_S, int _AP_W2, bool _AP_S2>                    \
+  inline bool operator Sym(const ap_int_base<_AP_W, _AP_S> &op,                \
+                           const ap_int_base<_AP_W2, _AP_S2> &op2) {           \
+    typedef typename ap_int_base<_AP_W, _AP_S>::template RType<_AP_W2,         \
+                                                               _AP_S2>::wide C; \
+    C lhs(op), rhs(op2);                                                       \
+    return hcl_ap::detail::cmp<C::N>(lhs.V, rhs.V, C::sign_flag) Sym 0;        \
+  }
+
+HCL_AP_CMP_OP(==)
+HCL_AP_CMP_OP(!=)
+HCL_AP_CMP_OP(<)
+HCL_AP_CMP_OP(<=)
+HCL_AP_CMP_OP(>)
+HCL_AP_CMP_OP(>=)
+#undef HCL_AP_CMP_OP
+
+// Native integers behave as an ap_int of their own width; floating-point
+// operands turn the whole expression into floating point.
+#define HCL_AP_BIN_OP_WITH_INT(Sym)                                            \
+  template <int _AP_W, bool _AP_S, typename T, hcl_ap::enable_if_int_t<T> = 0> \
+  inline auto operator Sym(const ap_int_base<_AP_W, _AP_S> &op, T op2) {       \
+    return op Sym typename hcl_ap::ctype<T>::type(op2);                        \
+  }                                                                            \
+  template <int _AP_W, bool _AP_S, typename T, hcl_ap::enable_if_int_t<T> = 0> \
+  inline auto operator Sym(T op, const ap_int_base<_AP_W, _AP_S> &op2) {       \
+    return typename hcl_ap::ctype<T>::type(op) Sym op2;                        \
+  }
+
+#define HCL_AP_BIN_OP_WITH_FLOAT(Sym)                                          \
+  template <int _AP_W, bool _AP_S, typename T,                                 \
+            hcl_ap::enable_if_float_t<T> = 0>                                  \
+  inline auto operator Sym(const ap_int_base<_AP_W, _AP_S> &op, T op2) {       \
+    return (T)op.to_double() Sym op2;                                          \
+  }                                                                            \
+  template <int _AP_W, bool _AP_S, typename T,                                 \
+            hcl_ap::enable_if_float_t<T> = 0>                                  \
+  inline auto operator Sym(T op, const ap_int_base<_AP_W, _AP_S> &op2) {       \
+    return op Sym(T) op2.to_double();                                          \
+  }
+
+HCL_AP_BIN_OP_WITH_INT(+)
+HCL_AP_BIN_OP_WITH_INT(-)
+HCL_AP_BIN_OP_WITH_INT(*)
+HCL_AP_BIN_OP_WITH_INT(/)
+HCL_AP_BIN_OP_WITH_INT(%)
+HCL_AP_BIN_OP_WITH_INT(&)
+HCL_AP_BIN_OP_WITH_INT(|)
+HCL_AP_BIN_OP_WITH_INT(^)
+HCL_AP_BIN_OP_WITH_INT(==)
+HCL_AP_BIN_OP_WITH_INT(!=)
+HCL_AP_BIN_OP_WITH_INT(<)
+HCL_AP_BIN_OP_WITH_INT(<=)
+HCL_AP_BIN_OP_WITH_INT(>)
+HCL_AP_BIN_OP_WITH_INT(>=)
+HCL_AP_BIN_OP_WITH_FLOAT(+)
+HCL_AP_BIN_OP_WITH_FLOAT(-)
+HCL_AP_BIN_OP_WITH_FLOAT(*)
+HCL_AP_BIN_OP_WITH_FLOAT(/)
+HCL_AP_BIN_OP_WITH_FLOAT(==)
+HCL_AP_BIN_OP_WITH_FLOAT(!=)
+HCL_AP_BIN_OP_WITH_FLOAT(<)
+HCL_AP_BIN_OP_WITH_FLOAT(<=)
+HCL_AP_BIN_OP_WITH_FLOAT(>)
+HCL_AP_BIN_OP_WITH_FLOAT(>=)
+#undef HCL_AP_BIN_OP_WITH_INT
+#undef HCL_AP_BIN_OP_WITH_FLOAT
+
+template <int _AP_W, bool _AP_S>
+inline std::ostream &operator<<(std::ostream &os,
+                                const ap_int_base<_AP_W, _AP_S> &op) {
+  std::ios_base::fmtflags ff = os.flags();
+  if (ff & std::ios_base::hex)
+    return os << op.to_string(16, false);
+  if (ff & std::ios_base::oct)
+    return os << op.to_string(8, false);
+  return os << op.to_string(10);
+}
+
+template <int _AP_W, bool _AP_S>
+inline std::istream &operator>>(std::istream &is,
+                                ap_int_base<_AP_W, _AP_S> &op) {
+  std::string s;
+  is >> s;
+  op = ap_int_base<_AP_W, _AP_S>(s.c_str());
+  return is;
+}
+
+template <int _AP_W, bool _AP_S>
+inline std::ostream &operator<<(std::ostream &os,
+                                const ap_range_ref<_AP_W, _AP_S> &op) {
+  return os << op.get();
+}
+
+//===----------------------------------------------------------------------===//
+// ap_int / ap_uint
+//===----------------------------------------------------------------------===//
+
+template <int _AP_W> struct ap_int : ap_int_base<_AP_W, true> {
+  typedef ap_int_base<_AP_W, true> Base;
+  using Base::Base;
+  ap_int() = default;
+  ap_int(const Base &op) : Base(op) {}
+};
+
+template <int _AP_W> struct ap_uint : ap_int_base<_AP_W, false> {
+  typedef ap_int_base<_AP_W, false> Base;
+  using Base::Base;
+  ap_uint() = default;
+  ap_uint(const Base &op) : Base(op) {}
+};
+
+#endif // HCL_SIMULATION_AP_INT_H
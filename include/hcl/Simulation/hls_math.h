@@ -0,0 +1,65 @@
+/*
+ * Copyright HeteroCL authors. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//===----------------------------------------------------------------------===//
+// Header-only replacement for the Vivado HLS hls_math.h. The hls:: functions
+// forward to the C++ standard library; fixed-point arguments are evaluated in
+// double precision and quantized back to the argument type.
+//===----------------------------------------------------------------------===//
+
+#ifndef HCL_SIMULATION_HLS_MATH_H
+#define HCL_SIMULATION_HLS_MATH_H
+
+#include <cmath>
+
+#include "ap_fixed.h"
+
+namespace hls {
+
+#define HCL_HLS_UNARY_MATH(Fn)                                                 \
+  using std::Fn;                                                               \
+  template <int _AP_W, int _AP_I, bool _AP_S, ap_q_mode _AP_Q,                 \
+            ap_o_mode _AP_O, int _AP_N>                                        \
+  inline ap_fixed_base<_AP_W, _AP_I, _AP_S, _AP_Q, _AP_O, _AP_N> Fn(           \
+      const ap_fixed_base<_AP_W, _AP_I, _AP_S, _AP_Q, _AP_O, _AP_N> &x) {      \
+    return ap_fixed_base<_AP_W, _AP_I, _AP_S, _AP_Q, _AP_O, _AP_N>(            \
+        std::Fn(x.to_double()));                                               \
+  }
+
+HCL_HLS_UNARY_MATH(sqrt)
+HCL_HLS_UNARY_MATH(exp)
+HCL_HLS_UNARY_MATH(exp2)
+HCL_HLS_UNARY_MATH(log)
+HCL_HLS_UNARY_MATH(log2)
+HCL_HLS_UNARY_MATH(log10)
+HCL_HLS_UNARY_MATH(sin)
+HCL_HLS_UNARY_MATH(cos)
+HCL_HLS_UNARY_MATH(tan)
+HCL_HLS_UNARY_MATH(asin)
+HCL_HLS_UNARY_MATH(acos)
+HCL_HLS_UNARY_MATH(atan)
+HCL_HLS_UNARY_MATH(sinh)
+HCL_HLS_UNARY_MATH(cosh)
+HCL_HLS_UNARY_MATH(tanh)
+HCL_HLS_UNARY_MATH(fabs)
+HCL_HLS_UNARY_MATH(floor)
+HCL_HLS_UNARY_MATH(ceil)
+HCL_HLS_UNARY_MATH(round)
+HCL_HLS_UNARY_MATH(trunc)
+#undef HCL_HLS_UNARY_MATH
+
+using std::abs;
+using std::atan2;
+using std::fmax;
+using std::fmin;
+using std::fmod;
+using std::pow;
+
+template <typename T> inline T rsqrt(T x) { return T(1) / std::sqrt(x); }
+template <typename T> inline T recip(T x) { return T(1) / x; }
+
+} // namespace hls
+
+#endif // HCL_SIMULATION_HLS_MATH_H
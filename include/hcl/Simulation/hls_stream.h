@@ -0,0 +1,80 @@
+/*
+ * Copyright HeteroCL authors. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//===----------------------------------------------------------------------===//
+// Header-only replacement for the Vivado HLS hls_stream.h. A stream is an
+// unbounded FIFO; reading an empty stream prints a warning and returns a
+// default value, as C simulation does.
+//===----------------------------------------------------------------------===//
+
+#ifndef HCL_SIMULATION_HLS_STREAM_H
+#define HCL_SIMULATION_HLS_STREAM_H
+
+#include <cstddef>
+#include <deque>
+#include <iostream>
+#include <string>
+
+namespace hls {
+
+template <typename T, int DEPTH = 0> class stream {
+public:
+  stream() : name("hls::stream") {}
+  explicit stream(const char *name) : name(name) {}
+
+  // Streams model hardware FIFOs and cannot be copied.
+  stream(const stream &) = delete;
+  stream &operator=(const stream &) = delete;
+
+  bool empty() const { return fifo.empty(); }
+  bool full() const { return DEPTH > 0 && (int)fifo.size() >= DEPTH; }
+  std::size_t size() const { return fifo.size(); }
+
+  void read(T &dout) {
+    if (fifo.empty()) {
+      std::cerr << "WARNING: hls::stream '" << name
+                << "' is read while empty, which may result in RTL "
+                   "simulation hanging.\n";
+      dout = T();
+      return;
+    }
+    dout = fifo.front();
+    fifo.pop_front();
+  }
+
+  T read() {
+    T t;
+    read(t);
+    return t;
+  }
+
+  bool read_nb(T &dout) {
+    if (fifo.empty())
+      return false;
+    read(dout);
+    return true;
+  }
+
+  // Writes never block in simulation; DEPTH only affects full().
+  void write(const T &din) { fifo.push_back(din); }
+
+  bool write_nb(const T &din) {
+    if (full())
+      return false;
+    write(din);
+    return true;
+  }
+
+  void operator>>(T &dout) { read(dout); }
+  void operator<<(const T &din) { write(din); }
+
+private:
+  std::string name;
+  std::deque<T> fifo;
+};
+
+} // namespace hls
+
+#endif // HCL_SIMULATION_HLS_STREAM_H
@@ -0,0 +1,76 @@
+/*
+ * Copyright HeteroCL authors. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef HCL_SUPPORT_PROFILE_H
+#define HCL_SUPPORT_PROFILE_H
+
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+
+#include <map>
+#include <optional>
+#include <string>
+
+namespace mlir {
+namespace hcl {
+
+//===----------------------------------------------------------------------===//
+// Execution profiles
+//===----------------------------------------------------------------------===//
+
+/// The global memref the instrumented counters live in.
+static constexpr StringLiteral kProfileCountersName = "__hcl_profile_counters";
+
+/// Trip counts of a loop over all the times it was entered.
+struct LoopProfile {
+  int64_t entries = 0;
+  int64_t iterations = 0;
+  int64_t minTripCount = 0;
+  int64_t maxTripCount = 0;
+};
+
+/// How often the then region of an if was taken.
+struct BranchProfile {
+  int64_t executions = 0;
+  int64_t taken = 0;
+};
+
+/// Profile of a module, keyed by profile site.
+struct Profile {
+  std::map<std::string, LoopProfile> loops;
+  std::map<std::string, BranchProfile> branches;
+};
+
+/// A named loop or an if, which a profile records.
+struct ProfileSite {
+  Operation *op;
+  std::string key;
+  bool isLoop;
+};
+
+/// Collects the profile sites of `func` in a stable order. A loop is keyed by
+/// "<function>/<stage>/<loop name>", and an if by "<function>/<stage>/if<n>",
+/// where n numbers the ifs of the stage in pre-order.
+void getProfileSites(func::FuncOp func, SmallVectorImpl<ProfileSite> &sites);
+
+/// Reads a profile from a JSON file, or returns failure with `error` set.
+LogicalResult readProfile(StringRef path, Profile &profile,
+                          std::string &error);
+
+/// Writes a profile to a JSON file, or returns failure with `error` set.
+LogicalResult writeProfile(StringRef path, const Profile &profile,
+                           std::string &error);
+
+/// Returns the average trip count of a loop from its "tripcount" attribute,
+/// which holds the minimum, maximum and average trip counts.
+std::optional<int64_t> getProfiledTripCount(Operation *loop);
+
+/// Returns the rate at which an if takes its then region, from its
+/// "taken_rate" attribute.
+std::optional<double> getBranchTakenRate(Operation *ifOp);
+
+} // namespace hcl
+} // namespace mlir
+
+#endif // HCL_SUPPORT_PROFILE_H
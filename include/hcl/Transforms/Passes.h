@@ -12,14 +12,30 @@
 namespace mlir {
 namespace hcl {
 
+struct Profile;
+
 std::unique_ptr<OperationPass<ModuleOp>> createLoopTransformationPass();
 std::unique_ptr<OperationPass<ModuleOp>> createAnyWidthIntegerPass();
 std::unique_ptr<OperationPass<ModuleOp>> createMoveReturnToInputPass();
 std::unique_ptr<OperationPass<ModuleOp>> createLegalizeCastPass();
 std::unique_ptr<OperationPass<ModuleOp>> createRemoveStrideMapPass();
 std::unique_ptr<OperationPass<ModuleOp>> createMemRefDCEPass();
+std::unique_ptr<OperationPass<ModuleOp>> createCastChainEliminationPass();
 std::unique_ptr<OperationPass<ModuleOp>> createDataPlacementPass();
+std::unique_ptr<OperationPass<ModuleOp>>
+createDataPlacementPass(double fpgaCycleCost, double transferCost);
+std::unique_ptr<OperationPass<ModuleOp>> createResourceBudgetPass();
+std::unique_ptr<OperationPass<ModuleOp>>
+createResourceBudgetPass(unsigned dsp, unsigned bram, unsigned lut);
 std::unique_ptr<OperationPass<ModuleOp>> createTransformInterpreterPass();
+std::unique_ptr<OperationPass<ModuleOp>> createKernelDedupPass();
+std::unique_ptr<OperationPass<ModuleOp>>
+createKernelDedupPass(bool dynamicShapes);
+std::unique_ptr<OperationPass<ModuleOp>> createShapeSpecializationPass();
+std::unique_ptr<OperationPass<ModuleOp>> createProfileInstrumentationPass();
+std::unique_ptr<OperationPass<ModuleOp>> createProfileAnnotationPass();
+std::unique_ptr<OperationPass<ModuleOp>>
+createProfileAnnotationPass(std::string profileFile);
 
 bool applyLoopTransformation(ModuleOp &f);
 bool applyAnyWidthInteger(ModuleOp &module);
@@ -27,7 +43,16 @@ bool applyMoveReturnToInput(ModuleOp &module);
 bool applyLegalizeCast(ModuleOp &module);
 bool applyRemoveStrideMap(ModuleOp &module);
 bool applyMemRefDCE(ModuleOp &module);
-bool applyDataPlacement(ModuleOp &module);
+bool applyCastChainElimination(ModuleOp &module);
+bool applyDataPlacement(ModuleOp &module, double fpgaCycleCost = 10.0,
+                        double transferCost = 1.0);
+bool applyResourceBudget(ModuleOp &module, unsigned dsp = 0, unsigned bram = 0,
+                         unsigned lut = 0);
+bool applyKernelDedup(ModuleOp &module, bool dynamicShapes = false);
+bool applyShapeSpecialization(ModuleOp &module);
+bool applyTransformInterpreter(ModuleOp &module);
+bool applyProfileInstrumentation(ModuleOp &module);
+bool applyProfileAnnotation(ModuleOp &module, const Profile &profile);
 
 /// Registers all HCL transformation passes
 void registerHCLPasses();
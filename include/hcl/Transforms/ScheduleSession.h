@@ -0,0 +1,86 @@
+/*
+ * Copyright HeteroCL authors. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef HCL_TRANSFORMS_SCHEDULESESSION_H
+#define HCL_TRANSFORMS_SCHEDULESESSION_H
+
+#include "hcl/Dialect/HeteroCLOps.h"
+#include "mlir/Dialect/Affine/IR/AffineOps.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/OwningOpRef.h"
+
+#include <deque>
+#include <map>
+#include <memory>
+#include <unordered_map>
+
+namespace mlir {
+namespace hcl {
+
+/// Schedule primitive dispatching, shared with the loop transformation pass.
+bool isHCLOp(Operation &op);
+LogicalResult applyScheduleOp(ModuleOp &mod, func::FuncOp &f, Operation &op);
+void applyCustomization(
+    func::FuncOp &top_func,
+    std::map<std::string, hcl::CustomizationOp> &customizationMap,
+    SmallVector<Operation *, 10> &opToRemove);
+void eraseScheduleOp(func::FuncOp &f, SmallVector<Operation *, 10> &opToRemove);
+
+// Primitive implementations shared with the HCL transform ops.
+
+/// Partitions `array` by setting its layout map, reporting errors on `op`. A
+/// factor of -1 is only valid for a complete partition.
+LogicalResult partitionArray(func::FuncOp &f, Value &array,
+                             PartitionKindEnum kind, unsigned int target_dim,
+                             int factor, Operation *op);
+/// Coalesces a perfect nest of normalized loops with constant bounds into its
+/// outermost loop. Constants are hoisted before `stageLoop`.
+LogicalResult coalesceLoops(MutableArrayRef<affine::AffineForOp> loops,
+                            affine::AffineForOp stageLoop);
+
+/// Applies the schedule primitives of a module like the loop transformation
+/// pass, caching the IR after every primitive. The base IR (the module without
+/// its schedule primitives) and each prefix of the primitive sequence are
+/// fingerprinted; a later schedule sharing a prefix with an earlier one
+/// resumes from the snapshot of the longest such prefix and only replays the
+/// primitives after it.
+///
+/// Snapshots live in the context of the scheduled modules, so a session must
+/// not outlive that context and must not be used concurrently.
+class ScheduleSession {
+public:
+  explicit ScheduleSession(unsigned maxSnapshots = 64);
+  ~ScheduleSession();
+
+  /// Schedules `module` in place. On failure the module is left unchanged.
+  LogicalResult apply(ModuleOp module);
+
+  /// Drops all snapshots.
+  void clear();
+
+  unsigned getNumSnapshots() const { return snapshots.size(); }
+  /// The number of primitives taken from a snapshot and replayed by the last
+  /// call to apply.
+  unsigned getNumReusedSteps() const { return numReusedSteps; }
+  unsigned getNumAppliedSteps() const { return numAppliedSteps; }
+
+private:
+  struct Snapshot;
+
+  void addSnapshot(uint64_t key, std::unique_ptr<Snapshot> snapshot);
+
+  unsigned maxSnapshots;
+  std::unordered_map<uint64_t, std::unique_ptr<Snapshot>> snapshots;
+  // Insertion order of the snapshots, oldest first, for eviction.
+  std::deque<uint64_t> snapshotOrder;
+  unsigned numReusedSteps = 0;
+  unsigned numAppliedSteps = 0;
+};
+
+} // namespace hcl
+} // namespace mlir
+
+#endif // HCL_TRANSFORMS_SCHEDULESESSION_H
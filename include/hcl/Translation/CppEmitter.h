@@ -0,0 +1,140 @@
+/*
+ * Copyright HeteroCL authors. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef HCL_TRANSLATION_CPPEMITTER_H
+#define HCL_TRANSLATION_CPPEMITTER_H
+
+#include "hcl/Support/Utils.h"
+#include "hcl/Translation/Utils.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+
+//===----------------------------------------------------------------------===//
+// C++ Emitter Base Class
+//===----------------------------------------------------------------------===//
+
+/// This class emits the C++ code shared by all C++-based targets, i.e., the
+/// statements and expressions of a module. Targets provide the type names,
+/// bit-level operations, headers, and pragmas through the virtual hooks.
+class CppEmitterBase : public HCLEmitterBase {
+public:
+  using operand_range = Operation::operand_range;
+  explicit CppEmitterBase(HCLEmitterState &state) : HCLEmitterBase(state) {}
+  virtual ~CppEmitterBase() = default;
+
+  /// SCF statement emitters.
+  void emitScfFor(scf::ForOp op);
+  void emitScfIf(scf::IfOp op);
+  void emitScfYield(scf::YieldOp op);
+
+  /// Affine statement emitters.
+  void emitAffineFor(AffineForOp op);
+  void emitAffineIf(AffineIfOp op);
+  void emitAffineParallel(AffineParallelOp op);
+  void emitAffineApply(AffineApplyOp op);
+  template <typename OpType>
+  void emitAffineMaxMin(OpType op, const char *syntax);
+  void emitAffineLoad(AffineLoadOp op);
+  void emitAffineStore(AffineStoreOp op);
+  void emitAffineYield(AffineYieldOp op);
+
+  /// Memref-related statement emitters.
+  template <typename OpType> void emitAlloc(OpType op);
+  void emitLoad(memref::LoadOp op);
+  void emitStore(memref::StoreOp op);
+  void emitGetGlobal(memref::GetGlobalOp op);
+  void emitGetGlobalFixed(hcl::GetGlobalFixedOp op);
+  void emitGlobal(memref::GlobalOp op);
+  void emitSubView(memref::SubViewOp op);
+
+  /// Tensor-related statement emitters.
+  void emitTensorExtract(tensor::ExtractOp op);
+  void emitTensorInsert(tensor::InsertOp op);
+  void emitTensorStore(memref::TensorStoreOp op);
+  void emitDim(memref::DimOp op);
+  void emitRank(memref::RankOp op);
+
+  /// Standard expression emitters. The operands of unsigned binary operations
+  /// are signless, and emitted with emitUnsignedOperand.
+  void emitBinary(Operation *op, const char *syntax, bool isUnsigned = false);
+  void emitUnary(Operation *op, const char *syntax);
+  void emitPower(Operation *op);
+  void emitMaxMin(Operation *op, const char *syntax, bool isUnsigned = false);
+
+  /// Special operation emitters.
+  void emitCall(func::CallOp op);
+  void emitSelect(arith::SelectOp op);
+  void emitConstant(arith::ConstantOp op);
+  template <typename CastOpType> void emitCast(CastOpType op);
+  void emitGeneralCast(UnrealizedConversionCastOp op);
+  void emitZeroExtend(arith::ExtUIOp op);
+  void emitBitcast(arith::BitcastOp op);
+
+  /// Bit-level operation emitters, which depend on the integer types of the
+  /// target.
+  virtual void emitGetBit(hcl::GetIntBitOp op) = 0;
+  virtual void emitSetBit(hcl::SetIntBitOp op) = 0;
+  virtual void emitGetSlice(hcl::GetIntSliceOp op) = 0;
+  virtual void emitSetSlice(hcl::SetIntSliceOp op) = 0;
+  virtual void emitBitReverse(hcl::BitReverseOp op) = 0;
+
+  /// Top-level MLIR module emitter.
+  virtual void emitModule(ModuleOp module);
+
+protected:
+  /// Returns the C++ type of a value, or of the elements of an array.
+  SmallString<16> getTypeName(Type valType);
+  SmallString<16> getTypeName(Value val);
+
+  /// Returns the C++ type of integer and fixed-point types, or an empty string
+  /// if the target doesn't support the type.
+  virtual SmallString<16> getTargetTypeName(Type valType) = 0;
+
+  /// Returns the memory space of a memref which is emitted as a stream, or a
+  /// null attribute if the memref is a plain array.
+  virtual StringAttr getStreamSpace(Value memref);
+
+  /// Returns the headers of the device and the host files.
+  virtual StringRef getDeviceHeader() = 0;
+  virtual StringRef getHostHeader() = 0;
+
+  /// C++ component emitters.
+  void emitValue(Value val, unsigned rank = 0, bool isPtr = false,
+                 std::string name = "");
+  void emitArrayDecl(Value array, bool isFunc = false, std::string name = "");
+  unsigned emitNestedLoopHead(Value val);
+  void emitNestedLoopTail(unsigned rank);
+  void emitInfoAndNewLine(Operation *op);
+
+  /// Emits a signless integer operand of an operation with unsigned
+  /// semantics, e.g., arith.divui, for targets whose integer types are signed.
+  virtual void emitUnsignedOperand(Value val, unsigned rank) {
+    emitValue(val, rank);
+  }
+
+  /// Emits the declaration of an allocated array without the semicolon.
+  virtual void emitAllocDecl(Value memref, bool isAlloca, std::string name) {
+    emitArrayDecl(memref, false, name);
+  }
+
+  /// MLIR component and pragma emitters. The loop label is emitted before an
+  /// affine loop with a name, and may name its induction variable. Loop
+  /// directives are emitted either before the loop statement (head) or at the
+  /// beginning of the loop body.
+  void emitBlock(Block &block);
+  virtual void emitLoopLabel(AffineForOp op, const std::string &loop_name) {}
+  virtual void emitLoopHeadDirectives(Operation *op) {}
+  virtual void emitLoopBodyDirectives(Operation *op) {}
+  virtual void emitArrayDirectives(Value memref) {}
+
+  /// Emits statements after an expression which wrap its integer results to
+  /// their bit widths, for targets which store them in wider types.
+  virtual void emitResultWrap(Operation *op) {}
+  virtual void emitFunctionDirectives(func::FuncOp func,
+                                      ArrayRef<Value> portList) {}
+  virtual void emitFunction(func::FuncOp func);
+  void emitHostFunction(func::FuncOp func);
+};
+
+#endif // HCL_TRANSLATION_CPPEMITTER_H
@@ -0,0 +1,20 @@
+/*
+ * Copyright HeteroCL authors. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef HCL_TRANSLATION_EMITCPUCPP_H
+#define HCL_TRANSLATION_EMITCPUCPP_H
+
+#include "mlir/IR/BuiltinOps.h"
+
+namespace mlir {
+namespace hcl {
+
+LogicalResult emitCpuCpp(ModuleOp module, llvm::raw_ostream &os);
+void registerEmitCpuCppTranslation();
+
+} // namespace hcl
+} // namespace mlir
+
+#endif // HCL_TRANSLATION_EMITCPUCPP_H
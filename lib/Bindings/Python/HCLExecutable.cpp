@@ -0,0 +1,907 @@
+/*
+ * Copyright HeteroCL authors. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//===----------------------------------------------------------------------===//
+// Compiled-module execution API
+//
+// hcl.compile(module) lowers a clone of the module to LLVM, JIT-compiles it
+// once and returns an Executable. Executables are cached by a hash of the
+// module text and the compile options, so compiling the same design again is
+// a lookup. Calling an Executable passes numpy arrays to the JITed function
+// through the buffer protocol, without copying them. Executable.stream runs
+// the function chunk by chunk over files that do not fit in memory. With
+// profile=True, the module is instrumented to record loop trip counts and
+// taken branches over all calls, which Executable.write_profile saves for
+// profile-annotate. Profiled builds are never cached, so that each of them
+// has its own counters.
+//===----------------------------------------------------------------------===//
+
+#include "hcl/Bindings/Python/HCLModule.h"
+#include "hcl/Conversion/Passes.h"
+#include "hcl/Support/Profile.h"
+#include "hcl/Support/Utils.h"
+#include "hcl/Transforms/Passes.h"
+
+#include "mlir/CAPI/IR.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/Dialect/MemRef/IR/MemRef.h"
+#include "mlir/ExecutionEngine/ExecutionEngine.h"
+#include "mlir/ExecutionEngine/OptUtils.h"
+#include "mlir/Target/LLVMIR/Dialect/Builtin/BuiltinToLLVMIRTranslation.h"
+#include "mlir/Target/LLVMIR/Dialect/LLVMIR/LLVMToLLVMIRTranslation.h"
+
+#include "llvm/ADT/Hashing.h"
+#include "llvm/ADT/ScopeExit.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/xxhash.h"
+
+#include <pybind11/numpy.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+#include <deque>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+
+namespace py = pybind11;
+
+using namespace mlir;
+using namespace mlir::python;
+using namespace hcl;
+
+namespace {
+
+/// The runtime view of one argument of the compiled function.
+struct ArgSpec {
+  bool isMemRef = false;
+  // Static shape; ShapedType::kDynamic marks a dimension taken from the array.
+  SmallVector<int64_t, 4> shape;
+  // numpy kind ('f', 'i' or 'b') and size in bytes of the element type.
+  char kind = 0;
+  unsigned itemSize = 0;
+  std::string typeStr;
+};
+
+/// The profile sites of an instrumented module, in counter order.
+struct ProfileSpec {
+  std::vector<std::string> loops;
+  std::vector<std::string> branches;
+};
+
+class PyExecutable {
+public:
+  PyExecutable(std::unique_ptr<ExecutionEngine> engine, std::string funcName,
+               SmallVector<ArgSpec> inputs, SmallVector<ArgSpec> outputs)
+      : engine(std::move(engine)), funcName(std::move(funcName)),
+        inputs(std::move(inputs)), outputs(std::move(outputs)) {}
+
+  py::object call(py::args args);
+  int64_t stream(py::sequence args, std::vector<std::string> outputPaths,
+                 std::map<unsigned, std::string> updatePaths,
+                 int64_t chunkRows);
+
+  const std::string &getName() const { return funcName; }
+  std::vector<std::string> getArgTypes() const {
+    std::vector<std::string> types;
+    for (auto &spec : inputs)
+      types.push_back(spec.typeStr);
+    return types;
+  }
+  std::vector<std::string> getResultTypes() const {
+    std::vector<std::string> types;
+    for (auto &spec : outputs)
+      types.push_back(spec.typeStr);
+    return types;
+  }
+
+  void enableProfile(ProfileSpec spec, int64_t *counters) {
+    profileSpec = std::move(spec);
+    profileCounters = counters;
+  }
+  Profile getProfile() const;
+  py::dict getProfileDict() const;
+  void writeProfile(const std::string &path) const;
+  void resetProfile();
+
+private:
+  std::unique_ptr<ExecutionEngine> engine;
+  std::string funcName;
+  SmallVector<ArgSpec> inputs;
+  // Memref results, moved to trailing arguments by MoveReturnToInput.
+  SmallVector<ArgSpec> outputs;
+  // Counters of the profile sites, if the module is instrumented.
+  ProfileSpec profileSpec;
+  int64_t *profileCounters = nullptr;
+};
+
+} // namespace
+
+//===----------------------------------------------------------------------===//
+// Signature handling
+//===----------------------------------------------------------------------===//
+
+static bool getElementKind(Type type, char &kind, unsigned &itemSize) {
+  if (type.isF32() || type.isF64()) {
+    kind = 'f';
+    itemSize = type.getIntOrFloatBitWidth() / 8;
+    return true;
+  }
+  if (type.isIndex()) {
+    kind = 'i';
+    itemSize = 8;
+    return true;
+  }
+  if (auto intType = type.dyn_cast<IntegerType>()) {
+    unsigned width = intType.getWidth();
+    if (width == 1) {
+      kind = 'b';
+      itemSize = 1;
+      return true;
+    }
+    if (width == 8 || width == 16 || width == 32 || width == 64) {
+      kind = 'i';
+      itemSize = width / 8;
+      return true;
+    }
+  }
+  return false;
+}
+
+static ArgSpec getArgSpec(Type type) {
+  ArgSpec spec;
+  llvm::raw_string_ostream(spec.typeStr) << type;
+  Type elementType = type;
+  if (auto memrefType = type.dyn_cast<MemRefType>()) {
+    if (!memrefType.getLayout().isIdentity())
+      throw py::value_error("unsupported memref layout: " + spec.typeStr);
+    spec.isMemRef = true;
+    spec.shape.assign(memrefType.getShape().begin(),
+                      memrefType.getShape().end());
+    elementType = memrefType.getElementType();
+  }
+  if (!getElementKind(elementType, spec.kind, spec.itemSize))
+    throw py::value_error("unsupported argument type: " + spec.typeStr);
+  return spec;
+}
+
+static py::dtype getDType(const ArgSpec &spec) {
+  if (spec.kind == 'b')
+    return py::dtype::of<bool>();
+  if (spec.kind == 'f')
+    return spec.itemSize == 4 ? py::dtype::of<float>()
+                              : py::dtype::of<double>();
+  switch (spec.itemSize) {
+  case 1:
+    return py::dtype::of<int8_t>();
+  case 2:
+    return py::dtype::of<int16_t>();
+  case 4:
+    return py::dtype::of<int32_t>();
+  default:
+    return py::dtype::of<int64_t>();
+  }
+}
+
+//===----------------------------------------------------------------------===//
+// Invocation
+//===----------------------------------------------------------------------===//
+
+namespace {
+/// Storage for the arguments of one call. A memref of rank r is passed as
+/// (allocated, aligned, offset, sizes[r], strides[r]) and invokePacked takes
+/// a pointer to each of these fields.
+struct PackedArgs {
+  SmallVector<void *, 16> ptrs;
+  std::deque<int64_t> fields;
+  std::deque<void *> bufs;
+  std::deque<double> f64s;
+  std::deque<float> f32s;
+
+  template <typename T> void push(std::deque<T> &store, T value) {
+    store.push_back(value);
+    ptrs.push_back(&store.back());
+  }
+
+  void pushMemRef(void *data, ArrayRef<int64_t> shape) {
+    push(bufs, data);
+    push(bufs, data);
+    push(fields, (int64_t)0);
+    for (int64_t dim : shape)
+      push(fields, dim);
+    int64_t stride = 1;
+    SmallVector<int64_t, 4> strides(shape.size());
+    for (int i = (int)shape.size() - 1; i >= 0; --i) {
+      strides[i] = stride;
+      stride *= shape[i];
+    }
+    for (int64_t s : strides)
+      push(fields, s);
+  }
+};
+} // namespace
+
+/// Checks that a buffer can be passed as a memref of `spec` and returns its
+/// shape.
+static SmallVector<int64_t, 4> checkMemRef(const ArgSpec &spec,
+                                           const py::buffer_info &info,
+                                           unsigned idx) {
+  auto argError = [&](const Twine &msg) {
+    return py::value_error(("argument " + Twine(idx) + ": " + msg).str());
+  };
+  if (info.ndim != (py::ssize_t)spec.shape.size())
+    throw argError("expected an array of rank " +
+                   Twine(spec.shape.size()) + " for " + spec.typeStr +
+                   ", got rank " + Twine(info.ndim));
+  py::dtype actual(info);
+  bool kindOk = actual.kind() == spec.kind ||
+                (spec.kind == 'i' && actual.kind() == 'u');
+  if (!kindOk || (unsigned)actual.itemsize() != spec.itemSize)
+    throw argError("dtype " + std::string(py::str(actual)) +
+                   " does not match " + spec.typeStr);
+  SmallVector<int64_t, 4> shape;
+  int64_t expectedStride = info.itemsize;
+  for (int i = (int)info.ndim - 1; i >= 0; --i) {
+    if (info.shape[i] != 1 && info.strides[i] != expectedStride)
+      throw argError("array must be C-contiguous");
+    expectedStride *= info.shape[i];
+  }
+  for (unsigned i = 0; i < spec.shape.size(); ++i) {
+    if (!ShapedType::isDynamic(spec.shape[i]) &&
+        spec.shape[i] != info.shape[i])
+      throw argError("shape mismatch for " + spec.typeStr +
+                     " in dimension " + Twine(i) + ": got " +
+                     Twine(info.shape[i]));
+    shape.push_back(info.shape[i]);
+  }
+  return shape;
+}
+
+static void packMemRef(PackedArgs &packed, const ArgSpec &spec,
+                       const py::buffer_info &info, unsigned idx) {
+  packed.pushMemRef(info.ptr, checkMemRef(spec, info, idx));
+}
+
+namespace {
+/// A scalar argument, converted while holding the GIL.
+struct ScalarValue {
+  double f = 0;
+  int64_t i = 0;
+};
+} // namespace
+
+static ScalarValue getScalarValue(const ArgSpec &spec, py::handle obj) {
+  ScalarValue value;
+  if (spec.kind == 'f')
+    value.f = obj.cast<double>();
+  else
+    value.i = spec.kind == 'b' ? (int64_t)obj.cast<bool>()
+                               : obj.cast<int64_t>();
+  return value;
+}
+
+static void packScalar(PackedArgs &packed, const ArgSpec &spec,
+                       const ScalarValue &value) {
+  if (spec.kind == 'f') {
+    if (spec.itemSize == 4)
+      packed.push(packed.f32s, (float)value.f);
+    else
+      packed.push(packed.f64s, value.f);
+    return;
+  }
+  // Integers are stored in a 64-bit slot; the callee reads the low bytes.
+  packed.push(packed.fields, value.i);
+}
+
+py::object PyExecutable::call(py::args args) {
+  if (args.size() != inputs.size())
+    throw py::type_error(funcName + "() takes " +
+                         std::to_string(inputs.size()) + " arguments (" +
+                         std::to_string(args.size()) + " given)");
+
+  PackedArgs packed;
+  // Keep the buffers alive and pinned until the call returns.
+  SmallVector<py::buffer_info, 8> views;
+  views.reserve(inputs.size() + outputs.size());
+  for (unsigned i = 0; i < inputs.size(); ++i) {
+    if (!inputs[i].isMemRef) {
+      packScalar(packed, inputs[i], getScalarValue(inputs[i], args[i]));
+      continue;
+    }
+    if (!py::isinstance<py::buffer>(args[i]))
+      throw py::type_error("argument " + std::to_string(i) +
+                           ": expected a buffer such as a numpy array");
+    views.push_back(args[i].cast<py::buffer>().request(/*writable=*/true));
+    packMemRef(packed, inputs[i], views.back(), i);
+  }
+
+  SmallVector<py::array, 2> results;
+  for (auto &spec : outputs) {
+    SmallVector<py::ssize_t, 4> shape;
+    for (int64_t dim : spec.shape) {
+      if (ShapedType::isDynamic(dim))
+        throw py::value_error("dynamic result shapes are not supported");
+      shape.push_back(dim);
+    }
+    results.push_back(py::array(getDType(spec), shape));
+    views.push_back(results.back().request(/*writable=*/true));
+    packMemRef(packed, spec, views.back(), inputs.size() + results.size() - 1);
+  }
+
+  llvm::Error err = [&] {
+    py::gil_scoped_release release;
+    return engine->invokePacked(funcName, packed.ptrs);
+  }();
+  if (err)
+    throw py::value_error("JIT invocation failed: " +
+                          llvm::toString(std::move(err)));
+
+  if (results.empty())
+    return py::none();
+  if (results.size() == 1)
+    return results.front();
+  py::tuple tuple(results.size());
+  for (unsigned i = 0; i < results.size(); ++i)
+    tuple[i] = results[i];
+  return tuple;
+}
+
+//===----------------------------------------------------------------------===//
+// Streaming
+//===----------------------------------------------------------------------===//
+
+// stream() runs the function over raw, C-ordered binary files too large to
+// hold in memory. The outermost dimension of the streamed arguments and
+// results is tiled into chunks; chunk i+1 is read while the function runs on
+// chunk i, and the results of chunk i are written while it runs on chunk i+1,
+// so only two chunks of each streamed array are ever resident. A static
+// outermost dimension is the batch of one call, and a chunk holds any number
+// of batches, which are run one call after the other.
+
+namespace {
+/// A streamed argument or result, which has two chunk buffers.
+struct StreamedArray {
+  unsigned argIdx;
+  int64_t rowBytes;
+  // The file chunks are read from, if any; an argument without one starts
+  // each chunk zeroed.
+  std::optional<llvm::sys::fs::file_t> input;
+  // The file chunks are written to after the call, if any.
+  std::unique_ptr<llvm::raw_fd_ostream> output;
+  std::string outputPath;
+  std::vector<char> buffers[2];
+};
+} // namespace
+
+/// Returns the size in bytes of one row along the outermost dimension.
+static int64_t getRowBytes(const ArgSpec &spec, unsigned idx) {
+  if (spec.shape.empty())
+    throw py::value_error("argument " + std::to_string(idx) +
+                          ": cannot stream a 0-d " + spec.typeStr);
+  int64_t rowBytes = spec.itemSize;
+  for (int64_t dim : llvm::drop_begin(spec.shape)) {
+    if (ShapedType::isDynamic(dim))
+      throw py::value_error("argument " + std::to_string(idx) +
+                            ": only the outermost dimension of a streamed " +
+                            spec.typeStr + " can be dynamic");
+    rowBytes *= dim;
+  }
+  return rowBytes;
+}
+
+/// Reads `size` bytes at `offset`, retrying short reads.
+static std::string readAt(llvm::sys::fs::file_t file, char *data,
+                          size_t size, uint64_t offset) {
+  size_t done = 0;
+  while (done < size) {
+    auto n = llvm::sys::fs::readNativeFileSlice(
+        file, MutableArrayRef<char>(data + done, size - done), offset + done);
+    if (!n)
+      return llvm::toString(n.takeError());
+    if (*n == 0)
+      return "unexpected end of file";
+    done += *n;
+  }
+  return "";
+}
+
+int64_t PyExecutable::stream(py::sequence args,
+                             std::vector<std::string> outputPaths,
+                             std::map<unsigned, std::string> updatePaths,
+                             int64_t chunkRows) {
+  if (args.size() != inputs.size())
+    throw py::type_error(funcName + "() takes " +
+                         std::to_string(inputs.size()) + " arguments (" +
+                         std::to_string(args.size()) + " given)");
+  if (outputPaths.size() != outputs.size())
+    throw py::value_error("expected " + std::to_string(outputs.size()) +
+                          " output paths, one per memref result");
+
+  // Streamed arrays must agree in their outermost dimension, which is either
+  // the static chunk size or dynamic.
+  std::optional<int64_t> batch;
+  auto addStreamed = [&](std::vector<StreamedArray> &streamed,
+                         const ArgSpec &spec, unsigned idx) {
+    int64_t rowBytes = getRowBytes(spec, idx);
+    if (batch && *batch != spec.shape.front())
+      throw py::value_error("argument " + std::to_string(idx) +
+                            ": streamed arrays must have the same "
+                            "outermost dimension");
+    batch = spec.shape.front();
+    streamed.push_back({idx, rowBytes, std::nullopt, nullptr, "", {}});
+  };
+
+  std::vector<StreamedArray> streamed;
+  auto closeFiles = llvm::make_scope_exit([&] {
+    for (auto &array : streamed)
+      if (array.input)
+        llvm::sys::fs::closeFile(*array.input);
+  });
+  SmallVector<py::buffer_info, 8> views;
+  SmallVector<std::optional<ScalarValue>, 8> scalars(inputs.size());
+  SmallVector<SmallVector<int64_t, 4>, 8> shapes(inputs.size());
+  std::optional<int64_t> numRows;
+  for (unsigned i = 0; i < inputs.size(); ++i) {
+    const ArgSpec &spec = inputs[i];
+    bool isPath = py::isinstance<py::str>(args[i]);
+    bool isStreamed = isPath || args[i].is_none();
+    if (updatePaths.count(i) && !isStreamed)
+      throw py::value_error("argument " + std::to_string(i) +
+                            ": only streamed arguments can be written back");
+    if (!isStreamed) {
+      if (!spec.isMemRef) {
+        scalars[i] = getScalarValue(spec, args[i]);
+        continue;
+      }
+      if (!py::isinstance<py::buffer>(args[i]))
+        throw py::type_error("argument " + std::to_string(i) +
+                             ": expected a path, None or a buffer");
+      // Arrays are passed whole to every chunk.
+      views.push_back(args[i].cast<py::buffer>().request(/*writable=*/true));
+      shapes[i] = checkMemRef(spec, views.back(), i);
+      continue;
+    }
+    if (!spec.isMemRef)
+      throw py::value_error("argument " + std::to_string(i) +
+                            ": cannot stream a scalar");
+    addStreamed(streamed, spec, i);
+    StreamedArray &array = streamed.back();
+    if (isPath) {
+      std::string path = args[i].cast<std::string>();
+      uint64_t size;
+      if (auto ec = llvm::sys::fs::file_size(path, size))
+        throw py::value_error("cannot stat " + path + ": " + ec.message());
+      if (size % array.rowBytes)
+        throw py::value_error(path + ": size is not a multiple of the " +
+                              std::to_string(array.rowBytes) +
+                              "-byte rows of " + spec.typeStr);
+      int64_t rows = size / array.rowBytes;
+      if (numRows && *numRows != rows)
+        throw py::value_error(path + ": expected " + std::to_string(*numRows) +
+                              " rows, got " + std::to_string(rows));
+      numRows = rows;
+      auto file = llvm::sys::fs::openNativeFileForRead(path);
+      if (!file)
+        throw py::value_error("cannot open " + path + ": " +
+                              llvm::toString(file.takeError()));
+      array.input = *file;
+    }
+    auto it = updatePaths.find(i);
+    if (it != updatePaths.end())
+      array.outputPath = it->second;
+  }
+  if (!numRows)
+    throw py::value_error("expected at least one argument read from a file");
+  for (unsigned i = 0; i < outputs.size(); ++i) {
+    addStreamed(streamed, outputs[i], inputs.size() + i);
+    streamed.back().outputPath = outputPaths[i];
+  }
+  for (auto &array : streamed) {
+    if (array.outputPath.empty())
+      continue;
+    std::error_code ec;
+    array.output =
+        std::make_unique<llvm::raw_fd_ostream>(array.outputPath, ec);
+    if (ec)
+      throw py::value_error("cannot write " + array.outputPath + ": " +
+                            ec.message());
+  }
+
+  // A static outermost dimension is the batch of one call, and chunks are
+  // a multiple of it. The last chunk is zero-padded to a whole batch.
+  bool padded = !ShapedType::isDynamic(*batch);
+  if (padded && chunkRows == 0)
+    chunkRows = *batch;
+  else if (padded && (chunkRows < 0 || chunkRows % *batch))
+    throw py::value_error("chunk_rows must be a multiple of the static "
+                          "outermost dimension " + std::to_string(*batch));
+  else if (!padded && chunkRows <= 0)
+    throw py::value_error("chunk_rows is required when the outermost "
+                          "dimension is dynamic");
+  for (auto &array : streamed)
+    for (auto &buffer : array.buffers)
+      buffer.resize(chunkRows * array.rowBytes);
+
+  int64_t numChunks = (*numRows + chunkRows - 1) / chunkRows;
+  auto getChunkRows = [&](int64_t chunk) {
+    return std::min(chunkRows, *numRows - chunk * chunkRows);
+  };
+  auto readChunk = [&](int64_t chunk, unsigned slot) -> std::string {
+    int64_t rows = getChunkRows(chunk);
+    for (auto &array : streamed) {
+      auto &buffer = array.buffers[slot];
+      size_t size = rows * array.rowBytes;
+      if (array.input) {
+        std::string error = readAt(*array.input, buffer.data(), size,
+                                   chunk * chunkRows * array.rowBytes);
+        if (!error.empty())
+          return "argument " + std::to_string(array.argIdx) + ": " + error;
+      } else {
+        size = 0;
+      }
+      std::fill(buffer.begin() + size, buffer.end(), 0);
+    }
+    return "";
+  };
+  auto writeChunk = [&](int64_t chunk, unsigned slot) -> std::string {
+    int64_t rows = getChunkRows(chunk);
+    for (auto &array : streamed) {
+      if (!array.output)
+        continue;
+      array.output->write(array.buffers[slot].data(), rows * array.rowBytes);
+      if (array.output->has_error())
+        return "cannot write " + array.outputPath + ": " +
+               array.output->error().message();
+    }
+    return "";
+  };
+  // Runs the function on the rows [first, first + rows) of a chunk.
+  auto callRows = [&](unsigned slot, int64_t first,
+                      int64_t rows) -> std::string {
+    PackedArgs packed;
+    auto nextStreamed = streamed.begin();
+    auto nextView = views.begin();
+    for (unsigned i = 0; i < inputs.size() + outputs.size(); ++i) {
+      if (i < inputs.size() && scalars[i]) {
+        packScalar(packed, inputs[i], *scalars[i]);
+      } else if (nextStreamed != streamed.end() &&
+                 nextStreamed->argIdx == i) {
+        const ArgSpec &spec =
+            i < inputs.size() ? inputs[i] : outputs[i - inputs.size()];
+        SmallVector<int64_t, 4> shape(spec.shape);
+        shape.front() = rows;
+        packed.pushMemRef(nextStreamed->buffers[slot].data() +
+                              first * nextStreamed->rowBytes,
+                          shape);
+        ++nextStreamed;
+      } else {
+        packed.pushMemRef((nextView++)->ptr, shapes[i]);
+      }
+    }
+    if (auto err = engine->invokePacked(funcName, packed.ptrs))
+      return "JIT invocation failed: " + llvm::toString(std::move(err));
+    return "";
+  };
+  auto callChunk = [&](int64_t chunk, unsigned slot) -> std::string {
+    int64_t rows = getChunkRows(chunk);
+    if (!padded)
+      return callRows(slot, 0, rows);
+    for (int64_t first = 0; first < rows; first += *batch) {
+      std::string error = callRows(slot, first, *batch);
+      if (!error.empty())
+        return error;
+    }
+    return "";
+  };
+
+  std::string error;
+  {
+    py::gil_scoped_release release;
+    // One thread does the file I/O of all chunks.
+    llvm::ThreadPool ioThread(llvm::hardware_concurrency(1));
+    if (numChunks > 0)
+      error = readChunk(0, 0);
+    for (int64_t chunk = 0; chunk < numChunks && error.empty(); ++chunk) {
+      // While the function runs on this chunk, the previous chunk is written
+      // from the other buffers and the next chunk is read into them.
+      unsigned slot = chunk % 2;
+      auto io = ioThread.async([&, chunk, slot] {
+        std::string ioError;
+        if (chunk > 0)
+          ioError = writeChunk(chunk - 1, 1 - slot);
+        if (ioError.empty() && chunk + 1 < numChunks)
+          ioError = readChunk(chunk + 1, 1 - slot);
+        return ioError;
+      });
+      error = callChunk(chunk, slot);
+      std::string ioError = io.get();
+      if (error.empty())
+        error = ioError;
+    }
+    if (error.empty() && numChunks > 0)
+      error = writeChunk(numChunks - 1, (numChunks - 1) % 2);
+  }
+  for (auto &array : streamed) {
+    if (!array.output)
+      continue;
+    array.output->close();
+    if (error.empty() && array.output->has_error())
+      error = "cannot write " + array.outputPath + ": " +
+              array.output->error().message();
+  }
+  if (!error.empty())
+    throw py::value_error(error);
+  return *numRows;
+}
+
+//===----------------------------------------------------------------------===//
+// Profiling
+//===----------------------------------------------------------------------===//
+
+// The counters of a loop are its entries, iterations, and minimum and maximum
+// trip counts, and those of an if are its executions and taken then regions.
+// Loops come first, as laid out by applyProfileInstrumentation.
+
+Profile PyExecutable::getProfile() const {
+  if (!profileCounters)
+    throw py::value_error("'" + funcName + "' was not compiled with profile");
+  Profile profile;
+  const int64_t *counters = profileCounters;
+  for (auto &key : profileSpec.loops) {
+    if (counters[0] > 0)
+      profile.loops[key] = {counters[0], counters[1], counters[2],
+                            counters[3]};
+    counters += 4;
+  }
+  for (auto &key : profileSpec.branches) {
+    if (counters[0] > 0)
+      profile.branches[key] = {counters[0], counters[1]};
+    counters += 2;
+  }
+  return profile;
+}
+
+py::dict PyExecutable::getProfileDict() const {
+  Profile profile = getProfile();
+  py::dict loops, branches;
+  for (auto &[key, loop] : profile.loops) {
+    py::dict entry;
+    entry["entries"] = loop.entries;
+    entry["iterations"] = loop.iterations;
+    entry["min"] = loop.minTripCount;
+    entry["max"] = loop.maxTripCount;
+    loops[py::str(key)] = entry;
+  }
+  for (auto &[key, branch] : profile.branches) {
+    py::dict entry;
+    entry["executions"] = branch.executions;
+    entry["taken"] = branch.taken;
+    branches[py::str(key)] = entry;
+  }
+  py::dict result;
+  result["loops"] = loops;
+  result["branches"] = branches;
+  return result;
+}
+
+void PyExecutable::writeProfile(const std::string &path) const {
+  std::string error;
+  if (failed(hcl::writeProfile(path, getProfile(), error)))
+    throw py::value_error(error);
+}
+
+void PyExecutable::resetProfile() {
+  if (!profileCounters)
+    throw py::value_error("'" + funcName + "' was not compiled with profile");
+  int64_t *counters = profileCounters;
+  for (size_t i = 0; i < profileSpec.loops.size(); ++i, counters += 4) {
+    counters[0] = counters[1] = counters[3] = 0;
+    counters[2] = std::numeric_limits<int64_t>::max();
+  }
+  for (size_t i = 0; i < profileSpec.branches.size(); ++i, counters += 2)
+    counters[0] = counters[1] = 0;
+}
+
+//===----------------------------------------------------------------------===//
+// Compilation and caching
+//===----------------------------------------------------------------------===//
+
+static std::mutex cacheMutex;
+static std::unordered_map<uint64_t, std::shared_ptr<PyExecutable>>
+    executableCache;
+
+/// The runtime libraries hcl-opt -jit loads, when they can be located.
+static std::vector<std::string> getDefaultSharedLibs() {
+  std::vector<std::string> libs;
+  std::string llvmBuildDir, hclBuildDir;
+  if (getEnv("LLVM_BUILD_DIR", llvmBuildDir)) {
+    libs.push_back(llvmBuildDir + "/lib/libmlir_runner_utils.so");
+    libs.push_back(llvmBuildDir + "/lib/libmlir_c_runner_utils.so");
+  }
+  if (getEnv("HCL_DIALECT_BUILD_DIR", hclBuildDir))
+    libs.push_back(hclBuildDir + "/lib/libhcl_runtime_utils.so");
+  llvm::erase_if(libs, [](const std::string &lib) {
+    return !llvm::sys::fs::exists(lib);
+  });
+  return libs;
+}
+
+static std::shared_ptr<PyExecutable>
+compileModule(MlirModule &mlir_mod, const std::string &funcName,
+              unsigned optLevel, std::optional<std::vector<std::string>> libs,
+              bool useCache, bool profile) {
+  ModuleOp module = unwrap(mlir_mod);
+  std::vector<std::string> sharedLibs =
+      libs ? std::move(*libs) : getDefaultSharedLibs();
+  // The clone and its lowering live in the caller's context.
+  ContextLock lock(module.getContext());
+  // Each profiled build owns its counters, so it is not shared.
+  useCache = useCache && !profile;
+
+  // The key covers everything that affects the generated code.
+  std::string text;
+  llvm::raw_string_ostream textOs(text);
+  module->print(textOs, OpPrintingFlags().useLocalScope());
+  textOs.flush();
+  llvm::hash_code hash = llvm::hash_combine(
+      llvm::xxh3_64bits(llvm::arrayRefFromStringRef(text)), funcName,
+      optLevel);
+  for (auto &lib : sharedLibs)
+    hash = llvm::hash_combine(hash, lib);
+  uint64_t key = (uint64_t)(size_t)hash;
+  if (useCache) {
+    std::lock_guard<std::mutex> cacheLock(cacheMutex);
+    auto it = executableCache.find(key);
+    if (it != executableCache.end())
+      return it->second;
+  }
+
+  // Lower a clone so the caller's module is left untouched.
+  OwningOpRef<ModuleOp> cloned = module.clone();
+  ModuleOp lowered = *cloned;
+  auto func = lowered.lookupSymbol<func::FuncOp>(funcName);
+  if (!func)
+    throw py::value_error("no function named '" + funcName + "' in module");
+  if (func.getNumResults() > 0 && !func->hasAttr("top"))
+    throw py::value_error("'" + funcName +
+                          "' returns values but is not marked as top");
+  if (!llvm::all_of(func.getResultTypes(),
+                    [](Type type) { return type.isa<MemRefType>(); }))
+    throw py::value_error("'" + funcName +
+                          "' returns non-memref values, which is unsupported");
+  unsigned numInputs = func.getNumArguments();
+
+  // Instrument the loops and ifs before the lowerings change them.
+  ProfileSpec profileSpec;
+  if (profile) {
+    if (!applyProfileInstrumentation(lowered))
+      throw py::value_error("failed to instrument '" + funcName + "'");
+    if (auto global =
+            lowered.lookupSymbol<memref::GlobalOp>(kProfileCountersName)) {
+      for (auto key : global->getAttrOfType<ArrayAttr>("loops"))
+        profileSpec.loops.push_back(key.cast<StringAttr>().str());
+      for (auto key : global->getAttrOfType<ArrayAttr>("branches"))
+        profileSpec.branches.push_back(key.cast<StringAttr>().str());
+    }
+  }
+
+  if (!applyLowerCompositeType(lowered) ||
+      !applyFixedPointToInteger(lowered, /*simd=*/true) ||
+      !applyLowerPrintOps(lowered) || !applyAnyWidthInteger(lowered) ||
+      !applyMoveReturnToInput(lowered) || !applyLowerBitOps(lowered) ||
+      !applyLegalizeCast(lowered) || !applyCastChainElimination(lowered) ||
+      !applyRemoveStrideMap(lowered))
+    throw py::value_error("failed to lower '" + funcName + "'");
+
+  // Snapshot the signature after the HCL lowerings, which fix the element
+  // types numpy sees, and before it is flattened for LLVM.
+  func = lowered.lookupSymbol<func::FuncOp>(funcName);
+  SmallVector<ArgSpec> inputs, outputs;
+  for (auto en : llvm::enumerate(func.getArgumentTypes()))
+    (en.index() < numInputs ? inputs : outputs)
+        .push_back(getArgSpec(en.value()));
+
+  MLIRContext &ctx = *lowered.getContext();
+  if (!applyHCLToLLVMLoweringPass(lowered, ctx))
+    throw py::value_error("failed to lower '" + funcName + "' to LLVM");
+
+  static std::once_flag targetInit;
+  std::call_once(targetInit, [] {
+    llvm::InitializeNativeTarget();
+    llvm::InitializeNativeTargetAsmPrinter();
+  });
+  registerBuiltinDialectTranslation(ctx);
+  registerLLVMDialectTranslation(ctx);
+
+  SmallVector<StringRef, 4> libRefs(sharedLibs.begin(), sharedLibs.end());
+  ExecutionEngineOptions options;
+  options.transformer = makeOptimizingTransformer(
+      std::min(3u, optLevel), /*sizeLevel=*/0, /*targetMachine=*/nullptr);
+  options.sharedLibPaths = libRefs;
+  auto maybeEngine = ExecutionEngine::create(lowered, options);
+  if (!maybeEngine)
+    throw py::value_error("failed to JIT-compile '" + funcName +
+                          "': " + llvm::toString(maybeEngine.takeError()));
+
+  int64_t *profileCounters = nullptr;
+  if (profile && !(profileSpec.loops.empty() && profileSpec.branches.empty())) {
+    auto address = (*maybeEngine)->lookup(kProfileCountersName);
+    if (!address)
+      throw py::value_error("cannot find the profile counters of '" +
+                            funcName +
+                            "': " + llvm::toString(address.takeError()));
+    profileCounters = static_cast<int64_t *>(*address);
+  }
+
+  auto executable = std::make_shared<PyExecutable>(
+      std::move(*maybeEngine), funcName, std::move(inputs), std::move(outputs));
+  if (profile)
+    executable->enableProfile(std::move(profileSpec), profileCounters);
+  if (useCache) {
+    std::lock_guard<std::mutex> cacheLock(cacheMutex);
+    executableCache.emplace(key, executable);
+  }
+  return executable;
+}
+
+//===----------------------------------------------------------------------===//
+// Python bindings
+//===----------------------------------------------------------------------===//
+
+void mlir::python::populateHCLExecutable(py::module &m) {
+  py::class_<PyExecutable, std::shared_ptr<PyExecutable>>(m, "Executable")
+      .def("__call__", &PyExecutable::call,
+           "Runs the compiled function. Array arguments are passed without "
+           "copying and may be updated in place; memref results are "
+           "returned as new arrays.")
+      .def("stream", &PyExecutable::stream,
+           "Runs the compiled function over raw binary files chunk by "
+           "chunk along the outermost dimension, overlapping file I/O with "
+           "the calls. An argument given as a path is read from that file "
+           "and one given as None starts each chunk zeroed; updates maps "
+           "such arguments to the files their updated chunks are written "
+           "to, and each memref result is written to its output path. "
+           "Other arguments are passed whole to every chunk. chunk_rows "
+           "defaults to a static outermost dimension, and may be any "
+           "multiple of it, which runs the function once per batch of "
+           "that size. Returns the number of rows processed.",
+           py::arg("args"), py::arg("outputs") = std::vector<std::string>(),
+           py::arg("updates") = std::map<unsigned, std::string>(),
+           py::arg("chunk_rows") = 0)
+      .def_property_readonly("name", &PyExecutable::getName)
+      .def_property_readonly("arg_types", &PyExecutable::getArgTypes)
+      .def_property_readonly("result_types", &PyExecutable::getResultTypes)
+      .def_property_readonly(
+          "profile", &PyExecutable::getProfileDict,
+          "Loop trip counts and taken branches recorded over all calls of a "
+          "function compiled with profile=True.")
+      .def("write_profile", &PyExecutable::writeProfile,
+           "Writes the recorded profile to a JSON file, which "
+           "annotate_profile and hcl-opt -profile-annotate read.",
+           py::arg("path"))
+      .def("reset_profile", &PyExecutable::resetProfile);
+
+  m.def("compile", &compileModule,
+        "Lowers and JIT-compiles a function of the module. Results are "
+        "cached by module hash and options, except with profile=True, where "
+        "every call returns a new Executable with its own counters.",
+        py::arg("module"), py::arg("func_name") = "top",
+        py::arg("opt_level") = 3, py::arg("shared_libs") = py::none(),
+        py::arg("cache") = true, py::arg("profile") = false);
+
+  m.def("clear_compile_cache", [] {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    executableCache.clear();
+  });
+  m.def("compile_cache_size", [] {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    return executableCache.size();
+  });
+}
@@ -15,7 +15,9 @@
 #include "hcl/Conversion/Passes.h"
 #include "hcl/Dialect/HeteroCLDialect.h"
 #include "hcl/Dialect/TransformOps/HCLTransformOps.h"
+#include "hcl/Support/Profile.h"
 #include "hcl/Transforms/Passes.h"
+#include "hcl/Transforms/ScheduleSession.h"
 #include "mlir-c/Bindings/Python/Interop.h"
 #include "mlir/Bindings/Python/PybindAdaptors.h"
 #include "mlir/CAPI/IR.h"
@@ -29,6 +31,7 @@
 #include "mlir/Transforms/Passes.h"
 
 #include "llvm-c/ErrorHandling.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/Support/Signals.h"
 
 namespace py = pybind11;
@@ -38,6 +41,31 @@ using namespace mlir;
 using namespace mlir::python;
 using namespace hcl;
 
+//===----------------------------------------------------------------------===//
+// Concurrency model
+//
+// The entry points below release the GIL while they run, so a Python thread
+// pool can compile several designs at once. An MLIRContext and the modules it
+// owns must not be transformed from two threads at the same time, so each
+// entry point also takes the mutex of the module's context (ContextLock).
+// Designs parsed into separate contexts are therefore compiled in parallel,
+// while calls on modules that share a context are serialized. The GIL is
+// always released before the context mutex is taken; callbacks that need
+// Python, such as writing emitted code to a file object, reacquire it.
+//===----------------------------------------------------------------------===//
+
+std::mutex &mlir::python::getContextMutex(MLIRContext *context) {
+  static std::mutex registryMutex;
+  static llvm::DenseMap<MLIRContext *, std::unique_ptr<std::mutex>> mutexes;
+  std::lock_guard<std::mutex> lock(registryMutex);
+  // Entries are never erased: a context allocated at the address of a
+  // destroyed one simply reuses its (unlocked) mutex.
+  std::unique_ptr<std::mutex> &mutex = mutexes[context];
+  if (!mutex)
+    mutex = std::make_unique<std::mutex>();
+  return *mutex;
+}
+
 //===----------------------------------------------------------------------===//
 // Customized Python classes
 //===----------------------------------------------------------------------===//
@@ -76,25 +104,64 @@ private:
 //===----------------------------------------------------------------------===//
 
 static bool loopTransformation(MlirModule &mlir_mod) {
-  py::gil_scoped_release();
   auto mod = unwrap(mlir_mod);
+  ContextLock lock(mod.getContext());
   return applyLoopTransformation(mod);
 }
 
+//===----------------------------------------------------------------------===//
+// Scheduling session APIs
+//===----------------------------------------------------------------------===//
+
+namespace {
+/// A ScheduleSession bound to the context of the modules it schedules. The
+/// context is kept alive as long as the session holds snapshots in it.
+class PyScheduleSession {
+public:
+  explicit PyScheduleSession(unsigned maxSnapshots) : session(maxSnapshots) {}
+
+  bool apply(py::object pyModule) {
+    auto mod = unwrap(py::cast<MlirModule>(pyModule));
+    if (mod.getContext() != context) {
+      clear();
+      pyContext = pyModule.attr("context");
+      context = mod.getContext();
+    }
+    ContextLock lock(context);
+    return succeeded(session.apply(mod));
+  }
+
+  void clear() {
+    if (!context)
+      return;
+    ContextLock lock(context);
+    session.clear();
+  }
+
+  ScheduleSession &get() { return session; }
+
+private:
+  // Declared before the session so that it is released after the snapshots.
+  py::object pyContext;
+  MLIRContext *context = nullptr;
+  ScheduleSession session;
+};
+} // namespace
+
 //===----------------------------------------------------------------------===//
 // Emission APIs
 //===----------------------------------------------------------------------===//
 
 static bool emitVivadoHls(MlirModule &mod, py::object fileObject) {
   PyFileAccumulator accum(fileObject, false);
-  py::gil_scoped_release();
+  ContextLock lock(unwrap(mod)->getContext());
   return mlirLogicalResultIsSuccess(
       mlirEmitVivadoHls(mod, accum.getCallback(), accum.getUserData()));
 }
 
 static bool emitIntelHls(MlirModule &mod, py::object fileObject) {
   PyFileAccumulator accum(fileObject, false);
-  py::gil_scoped_release();
+  ContextLock lock(unwrap(mod)->getContext());
   return mlirLogicalResultIsSuccess(
       mlirEmitIntelHls(mod, accum.getCallback(), accum.getUserData()));
 }
@@ -106,46 +173,67 @@ static bool emitIntelHls(MlirModule &mod, py::object fileObject) {
 static bool lowerHCLToLLVM(MlirModule &mlir_mod, MlirContext &mlir_ctx) {
   auto mod = unwrap(mlir_mod);
   auto ctx = unwrap(mlir_ctx);
+  ContextLock lock(ctx);
   return applyHCLToLLVMLoweringPass(mod, *ctx);
 }
 
-static bool lowerFixedPointToInteger(MlirModule &mlir_mod) {
+static bool lowerFixedPointToInteger(MlirModule &mlir_mod, bool simd) {
   auto mod = unwrap(mlir_mod);
-  return applyFixedPointToInteger(mod);
+  ContextLock lock(mod.getContext());
+  return applyFixedPointToInteger(mod, simd);
 }
 
 static bool lowerAnyWidthInteger(MlirModule &mlir_mod) {
   auto mod = unwrap(mlir_mod);
+  ContextLock lock(mod.getContext());
   return applyAnyWidthInteger(mod);
 }
 
 static bool moveReturnToInput(MlirModule &mlir_mod) {
   auto mod = unwrap(mlir_mod);
+  ContextLock lock(mod.getContext());
   return applyMoveReturnToInput(mod);
 }
 
-static bool lowerCompositeType(MlirModule &mlir_mod) {
+static bool lowerCompositeType(MlirModule &mlir_mod, bool packed) {
   auto mod = unwrap(mlir_mod);
-  return applyLowerCompositeType(mod);
+  ContextLock lock(mod.getContext());
+  return applyLowerCompositeType(mod, packed);
 }
 
 static bool lowerBitOps(MlirModule &mlir_mod) {
   auto mod = unwrap(mlir_mod);
+  ContextLock lock(mod.getContext());
   return applyLowerBitOps(mod);
 }
 
+static bool lowerLogicOps(MlirModule &mlir_mod, unsigned maxSpeculatedOps) {
+  auto mod = unwrap(mlir_mod);
+  ContextLock lock(mod.getContext());
+  return applyLowerLogicOps(mod, maxSpeculatedOps);
+}
+
 static bool legalizeCast(MlirModule &mlir_mod) {
   auto mod = unwrap(mlir_mod);
+  ContextLock lock(mod.getContext());
   return applyLegalizeCast(mod);
 }
 
+static bool castChainElimination(MlirModule &mlir_mod) {
+  auto mod = unwrap(mlir_mod);
+  ContextLock lock(mod.getContext());
+  return applyCastChainElimination(mod);
+}
+
 static bool removeStrideMap(MlirModule &mlir_mod) {
   auto mod = unwrap(mlir_mod);
+  ContextLock lock(mod.getContext());
   return applyRemoveStrideMap(mod);
 }
 
 static bool lowerPrintOps(MlirModule &mlir_mod) {
   auto mod = unwrap(mlir_mod);
+  ContextLock lock(mod.getContext());
   return applyLowerPrintOps(mod);
 }
 
@@ -154,9 +242,39 @@ static bool lowerPrintOps(MlirModule &mlir_mod) {
 //===----------------------------------------------------------------------===//
 static bool memRefDCE(MlirModule &mlir_mod) {
   auto mod = unwrap(mlir_mod);
+  ContextLock lock(mod.getContext());
   return applyMemRefDCE(mod);
 }
 
+static bool kernelDedup(MlirModule &mlir_mod, bool dynamicShapes) {
+  auto mod = unwrap(mlir_mod);
+  ContextLock lock(mod.getContext());
+  return applyKernelDedup(mod, dynamicShapes);
+}
+
+static bool resourceBudget(MlirModule &mlir_mod, unsigned dsp, unsigned bram,
+                           unsigned lut) {
+  auto mod = unwrap(mlir_mod);
+  ContextLock lock(mod.getContext());
+  return applyResourceBudget(mod, dsp, bram, lut);
+}
+
+static bool shapeSpecialization(MlirModule &mlir_mod) {
+  auto mod = unwrap(mlir_mod);
+  ContextLock lock(mod.getContext());
+  return applyShapeSpecialization(mod);
+}
+
+static bool annotateProfile(MlirModule &mlir_mod, const std::string &path) {
+  auto mod = unwrap(mlir_mod);
+  ContextLock lock(mod.getContext());
+  Profile profile;
+  std::string error;
+  if (failed(readProfile(path, profile, error)))
+    throw py::value_error(error);
+  return applyProfileAnnotation(mod, profile);
+}
+
 //===----------------------------------------------------------------------===//
 // HCL Python module definition
 //===----------------------------------------------------------------------===//
@@ -175,6 +293,7 @@ PYBIND11_MODULE(_hcl, m) {
   hcl_m.def(
       "register_dialect",
       [](MlirContext context) {
+        ContextLock lock(unwrap(context));
         MlirDialectHandle hcl = mlirGetDialectHandle__hcl__();
         mlir::DialectRegistry registry;
         mlir::hcl::registerTransformDialectExtension(registry);
@@ -187,21 +306,11 @@ PYBIND11_MODULE(_hcl, m) {
   // Apply transform to a design.
   hcl_m.def("apply_transform", [](MlirModule &mlir_mod) {
     ModuleOp module = unwrap(mlir_mod);
+    ContextLock lock(module.getContext());
 
-    // Apply Transform patterns.
-    // FIXME: Transform dialect
-    // is private within this context.
-    /*
-    const RaggedArray<mlir::transform::MappedValue> extraMapping = {};
-    transform::TransformState state(
-        &module.getBodyRegion(), (mlir::Operation*)&module, extraMapping,
-        transform::TransformOptions().enableExpensiveChecks());
-    for (auto op : llvm::make_early_inc_range(
-             module.getBody()->getOps<transform::TransformOpInterface>())) {
-      if (failed(state.applyTransform(op).checkAndReport()))
-        throw py::value_error("failed to apply the transform");
-      op.erase();
-    }
+    // Apply the transform ops, e.g. transform.sequence of transform.hcl.*
+    if (!applyTransformInterpreter(module))
+      throw py::value_error("failed to apply the transform");
 
     // Collect PDL patterns to a temporary module.
     OpBuilder b(module);
@@ -221,8 +330,9 @@ PYBIND11_MODULE(_hcl, m) {
       if (failed(applyPatternsAndFoldGreedily(module.getBodyRegion(),
                                               std::move(patternList))))
         throw py::value_error("failed to apply the PDL pattern");
+    } else {
+      pdlModule.erase();
     }
-    */
 
     // Simplify the loop structure after the transform.
     PassManager pm(module.getContext());
@@ -240,23 +350,55 @@ PYBIND11_MODULE(_hcl, m) {
   // Loop transform APIs.
   hcl_m.def("loop_transformation", &loopTransformation);
 
+  // Incremental scheduling APIs.
+  py::class_<PyScheduleSession>(hcl_m, "ScheduleSession")
+      .def(py::init<unsigned>(), py::arg("max_snapshots") = 64)
+      .def("apply", &PyScheduleSession::apply,
+           "Applies the schedule of the module in place, resuming from the "
+           "longest schedule prefix seen before.")
+      .def("clear", &PyScheduleSession::clear)
+      .def_property_readonly(
+          "num_snapshots",
+          [](PyScheduleSession &s) { return s.get().getNumSnapshots(); })
+      .def_property_readonly(
+          "reused_steps",
+          [](PyScheduleSession &s) { return s.get().getNumReusedSteps(); })
+      .def_property_readonly(
+          "applied_steps",
+          [](PyScheduleSession &s) { return s.get().getNumAppliedSteps(); });
+
   // Codegen APIs.
   hcl_m.def("emit_vhls", &emitVivadoHls);
   hcl_m.def("emit_ihls", &emitIntelHls);
 
   // LLVM backend APIs.
   hcl_m.def("lower_hcl_to_llvm", &lowerHCLToLLVM);
-  hcl_m.def("lower_fixed_to_int", &lowerFixedPointToInteger);
+  hcl_m.def("lower_fixed_to_int", &lowerFixedPointToInteger,
+            py::arg("module"), py::arg("simd") = false);
   hcl_m.def("lower_anywidth_int", &lowerAnyWidthInteger);
   hcl_m.def("move_return_to_input", &moveReturnToInput);
 
   // Lowering APIs.
-  hcl_m.def("lower_composite_type", &lowerCompositeType);
+  hcl_m.def("lower_composite_type", &lowerCompositeType, py::arg("module"),
+            py::arg("packed") = false);
   hcl_m.def("lower_bit_ops", &lowerBitOps);
+  hcl_m.def("lower_logic_ops", &lowerLogicOps, py::arg("module"),
+            py::arg("max_speculated_ops") = 8);
   hcl_m.def("legalize_cast", &legalizeCast);
+  hcl_m.def("cast_chain_elimination", &castChainElimination);
   hcl_m.def("remove_stride_map", &removeStrideMap);
   hcl_m.def("lower_print_ops", &lowerPrintOps);
 
   // Utility pass APIs.
   hcl_m.def("memref_dce", &memRefDCE);
+  hcl_m.def("kernel_dedup", &kernelDedup, py::arg("module"),
+            py::arg("dynamic_shapes") = false);
+  hcl_m.def("shape_specialization", &shapeSpecialization);
+  hcl_m.def("resource_budget", &resourceBudget, py::arg("module"),
+            py::arg("dsp") = 0, py::arg("bram") = 0, py::arg("lut") = 0);
+  hcl_m.def("annotate_profile", &annotateProfile, py::arg("module"),
+            py::arg("path"));
+
+  // Execution APIs.
+  populateHCLExecutable(hcl_m);
 }
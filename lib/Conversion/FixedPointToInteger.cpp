@@ -32,6 +32,9 @@ struct FixedTypeInfo {
 
 FixedTypeInfo getFixedPointInfo(Type t) {
   FixedTypeInfo info;
+  // Vectors of fixed-point values are lowered element-wise
+  if (auto vectorType = t.dyn_cast<VectorType>())
+    t = vectorType.getElementType();
   if (FixedType ft = dyn_cast<FixedType>(t)) {
     info.width = ft.getWidth();
     info.frac = ft.getFrac();
@@ -47,11 +50,50 @@ FixedTypeInfo getFixedPointInfo(Type t) {
   return info;
 }
 
+/// Returns the integer type of `width` bits with the shape of `like`, e.g.
+/// vector<8xi16> for vector<8x!hcl.Fixed<16, 8>>.
+Type getIntTypeLike(Type like, size_t width) {
+  Type intType = IntegerType::get(like.getContext(), width);
+  if (auto vectorType = like.dyn_cast<VectorType>())
+    return vectorType.clone(intType);
+  return intType;
+}
+
+/// Creates an integer constant of `type`, splatted if `type` is a vector.
+Value createIntConstant(OpBuilder &builder, Location loc, Type type,
+                        int64_t value) {
+  TypedAttr attr = builder.getIntegerAttr(getElementTypeOrSelf(type), value);
+  if (auto vectorType = type.dyn_cast<VectorType>())
+    attr = DenseElementsAttr::get(vectorType, attr);
+  return builder.create<arith::ConstantOp>(loc, attr);
+}
+
+/// Creates a float constant of `type`, splatted if `type` is a vector.
+Value createFloatConstant(OpBuilder &builder, Location loc, Type type,
+                          double value) {
+  TypedAttr attr = builder.getFloatAttr(getElementTypeOrSelf(type), value);
+  if (auto vectorType = type.dyn_cast<VectorType>())
+    attr = DenseElementsAttr::get(vectorType, attr);
+  return builder.create<arith::ConstantOp>(loc, attr);
+}
+
+/// Returns the width of the integers that quotients of `width`-bit
+/// fixed-point values are computed in. Twice the width is enough to be exact;
+/// with `simd`, the width is rounded up to a power of two, so that odd widths
+/// use whole SIMD lanes (e.g. Fixed<12, F> quotients are computed in i32
+/// rather than i24). The results are the same.
+size_t getProductWidth(size_t width, bool simd) {
+  size_t productWidth = width * 2;
+  if (simd)
+    productWidth = std::max<size_t>(8, llvm::PowerOf2Ceil(productWidth));
+  return productWidth;
+}
+
 Value castIntegerWidth(MLIRContext *ctx, OpBuilder &builder, Location loc,
                        Value v, size_t srcWidth, size_t tgtWidth,
                        bool isSigned) {
   Value result;
-  Type newType = IntegerType::get(ctx, tgtWidth);
+  Type newType = getIntTypeLike(v.getType(), tgtWidth);
   if (srcWidth < tgtWidth) {
     // extend bits
     if (isSigned) {
@@ -69,7 +111,12 @@ Value castIntegerWidth(MLIRContext *ctx, OpBuilder &builder, Location loc,
 }
 
 Type convertFixedMemRefOrScalarToInt(Type t, MLIRContext *ctx) {
-  if (MemRefType memrefType = t.dyn_cast<MemRefType>()) {
+  if (auto vectorType = t.dyn_cast<VectorType>()) {
+    // if type is a vector of fixed-point values
+    if (vectorType.getElementType().isa<FixedType, UFixedType>())
+      return getIntTypeLike(t, getFixedPointInfo(t).width);
+    return t;
+  } else if (MemRefType memrefType = t.dyn_cast<MemRefType>()) {
     // if type is memref
     Type et = memrefType.getElementType();
     if (et.isa<FixedType, UFixedType>()) {
@@ -146,14 +193,32 @@ updates the result type of affine load operations
 void updateAffineLoadStore(func::FuncOp &f) {
   SmallVector<Operation *, 10> loads;
   SmallVector<Operation *, 10> stores;
+  SmallVector<Operation *, 10> vectorLoads;
+  SmallVector<Operation *, 10> vectorStores;
   f.walk([&](Operation *op) {
     if (auto add_op = dyn_cast<AffineLoadOp>(op)) {
       loads.push_back(op);
     } else if (auto add_op = dyn_cast<AffineStoreOp>(op)) {
       stores.push_back(op);
+    } else if (auto vector_load = dyn_cast<AffineVectorLoadOp>(op)) {
+      vectorLoads.push_back(op);
+    } else if (auto vector_store = dyn_cast<AffineVectorStoreOp>(op)) {
+      vectorStores.push_back(op);
     }
   });
 
+  // Vector loads and stores keep their shape
+  for (auto op : vectorLoads) {
+    Type newType = convertFixedMemRefOrScalarToInt(op->getResult(0).getType(),
+                                                   f.getContext());
+    op->getResult(0).setType(newType);
+  }
+  for (auto op : vectorStores) {
+    Type newType = convertFixedMemRefOrScalarToInt(op->getOperand(0).getType(),
+                                                   f.getContext());
+    op->getOperand(0).setType(newType);
+  }
+
   for (auto op : loads) {
     for (auto v : llvm::enumerate(op->getResults())) {
       Type newType =
@@ -172,13 +237,8 @@ void updateSelectOp(arith::SelectOp &selectOp) {
   // update the result of select op
   // from fixed-point type to integer type
   Type resType = selectOp.getResult().getType();
-  if (resType.isa<FixedType, UFixedType>()) {
-    int bitwidth = resType.isa<FixedType>()
-                       ? resType.cast<FixedType>().getWidth()
-                       : resType.cast<UFixedType>().getWidth();
-    Type newType = IntegerType::get(selectOp.getContext(), bitwidth);
-    selectOp.getResult().setType(newType);
-  }
+  selectOp.getResult().setType(
+      convertFixedMemRefOrScalarToInt(resType, selectOp.getContext()));
 }
 
 /* Update hcl.print (PrintOp) operations.
@@ -276,25 +336,9 @@ void updateAlloc(func::FuncOp &f) {
 }
 
 void updateSCFIfOp(mlir::scf::IfOp &op) {
-  for (auto res : op.getResults()) {
-    if (res.getType().isa<FixedType>()) {
-      res.setType(IntegerType::get(res.getContext(),
-                                   res.getType().cast<FixedType>().getWidth()));
-    } else if (res.getType().isa<UFixedType>()) {
-      res.setType(IntegerType::get(
-          res.getContext(), res.getType().cast<UFixedType>().getWidth()));
-    } else if (auto memRefType = res.getType().dyn_cast<MemRefType>()) {
-      Type eleTyp = memRefType.getElementType();
-      if (eleTyp.isa<FixedType>()) {
-        eleTyp = IntegerType::get(res.getContext(),
-                                  eleTyp.cast<FixedType>().getWidth());
-      } else if (eleTyp.isa<UFixedType>()) {
-        eleTyp = IntegerType::get(res.getContext(),
-                                  eleTyp.cast<UFixedType>().getWidth());
-      }
-      res.setType(memRefType.clone(eleTyp));
-    }
-  }
+  for (auto res : op.getResults())
+    res.setType(convertFixedMemRefOrScalarToInt(res.getType(),
+                                                res.getContext()));
 }
 
 // Lower AddFixedOp to AddIOp
@@ -304,7 +348,7 @@ void lowerFixedAdd(AddFixedOp &op) {
   FixedTypeInfo ti = getFixedPointInfo(t);
   auto lhs = op->getOperand(0);
   auto rhs = op->getOperand(1);
-  Type newType = IntegerType::get(op.getContext(), ti.width);
+  Type newType = getIntTypeLike(t, ti.width);
   arith::AddIOp newOp =
       rewriter.create<arith::AddIOp>(op->getLoc(), newType, lhs, rhs);
   op->replaceAllUsesWith(newOp);
@@ -317,34 +361,76 @@ void lowerFixedSub(SubFixedOp &op) {
   FixedTypeInfo ti = getFixedPointInfo(t);
   auto lhs = op->getOperand(0);
   auto rhs = op->getOperand(1);
-  Type newType = IntegerType::get(op.getContext(), ti.width);
+  Type newType = getIntTypeLike(t, ti.width);
   arith::SubIOp newOp =
       rewriter.create<arith::SubIOp>(op->getLoc(), newType, lhs, rhs);
   op->replaceAllUsesWith(newOp);
 }
 
+// Lower MulFixedOp to a multiply-high in the width of the operands:
+// lhs<width, frac> * rhs<width, frac> is bits [frac, frac + width) of the
+// 2 * width product, i.e. (low >> frac) | (high << (width - frac)). This keeps
+// vectors in their lanes (e.g. pmulhw/pmullw for Fixed<16, F>) instead of
+// widening them to twice the width.
+void lowerFixedMulHigh(MulFixedOp &op) {
+  Type t = op->getOperand(0).getType();
+  FixedTypeInfo ti = getFixedPointInfo(t);
+  OpBuilder rewriter(op);
+  auto loc = op->getLoc();
+  Type intTy = getIntTypeLike(t, ti.width);
+  auto lhs = op->getOperand(0);
+  auto rhs = op->getOperand(1);
+  Value low, high;
+  if (ti.isSigned) {
+    auto mul =
+        rewriter.create<arith::MulSIExtendedOp>(loc, intTy, intTy, lhs, rhs);
+    low = mul.getLow();
+    high = mul.getHigh();
+  } else {
+    auto mul =
+        rewriter.create<arith::MulUIExtendedOp>(loc, intTy, intTy, lhs, rhs);
+    low = mul.getLow();
+    high = mul.getHigh();
+  }
+  if (ti.frac == 0) {
+    op->getResult(0).replaceAllUsesWith(low);
+    return;
+  }
+  if (ti.frac == ti.width) {
+    op->getResult(0).replaceAllUsesWith(high);
+    return;
+  }
+  Value fracCst = createIntConstant(rewriter, loc, intTy, ti.frac);
+  Value restCst = createIntConstant(rewriter, loc, intTy, ti.width - ti.frac);
+  Value lowBits = rewriter.create<arith::ShRUIOp>(loc, intTy, low, fracCst);
+  Value highBits = rewriter.create<arith::ShLIOp>(loc, intTy, high, restCst);
+  auto res = rewriter.create<arith::OrIOp>(loc, intTy, lowBits, highBits);
+  op->replaceAllUsesWith(res);
+}
+
 // Lower MulFixedop to MulIOp
-void lowerFixedMul(MulFixedOp &op) {
+void lowerFixedMul(MulFixedOp &op, bool simd) {
   Type t = op->getOperand(0).getType();
   FixedTypeInfo ti = getFixedPointInfo(t);
+  if (simd && ti.frac <= ti.width)
+    return lowerFixedMulHigh(op);
   OpBuilder rewriter(op);
+  size_t productWidth = getProductWidth(ti.width, simd);
   Value lhs =
       castIntegerWidth(op->getContext(), rewriter, op->getLoc(),
-                       op->getOperand(0), ti.width, ti.width * 2, ti.isSigned);
+                       op->getOperand(0), ti.width, productWidth, ti.isSigned);
   Value rhs =
       castIntegerWidth(op->getContext(), rewriter, op->getLoc(),
-                       op->getOperand(1), ti.width, ti.width * 2, ti.isSigned);
-  IntegerType intTy = IntegerType::get(op->getContext(), ti.width * 2);
-  IntegerType truncTy = IntegerType::get(op->getContext(), ti.width);
+                       op->getOperand(1), ti.width, productWidth, ti.isSigned);
+  Type intTy = getIntTypeLike(t, productWidth);
+  Type truncTy = getIntTypeLike(t, ti.width);
   arith::MulIOp newOp =
       rewriter.create<arith::MulIOp>(op->getLoc(), intTy, lhs, rhs);
 
   // lhs<width, frac> * rhs<width, frac> -> res<width, 2*frac>
   // Therefore, we need to right shift the result for frac bit
   // Right shift needs to consider signed/unsigned
-  auto fracAttr = rewriter.getIntegerAttr(intTy, ti.frac);
-  auto fracCstOp =
-      rewriter.create<arith::ConstantOp>(op->getLoc(), intTy, fracAttr);
+  Value fracCstOp = createIntConstant(rewriter, op->getLoc(), intTy, ti.frac);
 
   if (ti.isSigned) {
     // use signed right shift
@@ -364,24 +450,23 @@ void lowerFixedMul(MulFixedOp &op) {
 }
 
 // Lower FixedDivOp to DivSIOp/DivUIOp
-void lowerFixedDiv(DivFixedOp &op) {
+void lowerFixedDiv(DivFixedOp &op, bool simd) {
   Type t = op->getOperand(0).getType();
   FixedTypeInfo ti = getFixedPointInfo(t);
   OpBuilder rewriter(op);
+  size_t productWidth = getProductWidth(ti.width, simd);
   Value lhs =
       castIntegerWidth(op->getContext(), rewriter, op->getLoc(),
-                       op->getOperand(0), ti.width, ti.width * 2, ti.isSigned);
+                       op->getOperand(0), ti.width, productWidth, ti.isSigned);
   Value rhs =
       castIntegerWidth(op->getContext(), rewriter, op->getLoc(),
-                       op->getOperand(1), ti.width, ti.width * 2, ti.isSigned);
+                       op->getOperand(1), ti.width, productWidth, ti.isSigned);
   // lhs<width, frac> / rhs<width, frac> -> res<width, 0>
   // Therefore, we need to left shift the lhs for frac bit
   // lhs<width, 2 * frac> / rhs<width, frac> -> res<width, frac>
-  IntegerType intTy = IntegerType::get(op->getContext(), ti.width * 2);
-  IntegerType truncTy = IntegerType::get(op->getContext(), ti.width);
-  auto fracAttr = rewriter.getIntegerAttr(intTy, ti.frac);
-  auto fracCstOp =
-      rewriter.create<arith::ConstantOp>(op->getLoc(), intTy, fracAttr);
+  Type intTy = getIntTypeLike(t, productWidth);
+  Type truncTy = getIntTypeLike(t, ti.width);
+  Value fracCstOp = createIntConstant(rewriter, op->getLoc(), intTy, ti.frac);
   arith::ShLIOp lhs_shifted =
       rewriter.create<arith::ShLIOp>(op->getLoc(), lhs, fracCstOp);
   if (ti.isSigned) { // signed fixed
@@ -541,9 +626,8 @@ void lowerFixedToFloat(FixedToFloatOp &op) {
   auto loc = op.getLoc();
   auto src = op.getOperand();
   auto dst = op.getResult();
-  auto dstTy = dst.getType().cast<FloatType>();
-  auto frac = rewriter.create<arith::ConstantOp>(
-      loc, dstTy, rewriter.getFloatAttr(dstTy, std::pow(2, ti.frac)));
+  Type dstTy = dst.getType();
+  Value frac = createFloatConstant(rewriter, loc, dstTy, std::pow(2, ti.frac));
   if (ti.isSigned) {
     auto res = rewriter.create<arith::SIToFPOp>(loc, dstTy, src);
     auto real = rewriter.create<arith::DivFOp>(loc, dstTy, res, frac);
@@ -561,10 +645,9 @@ void lowerFloatToFixed(FloatToFixedOp &op) {
   auto src = op.getOperand();
   Type t = op.getResult().getType();
   FixedTypeInfo ti = getFixedPointInfo(t);
-  auto FType = src.getType().cast<FloatType>();
-  auto frac = rewriter.create<arith::ConstantOp>(
-      loc, FType, rewriter.getFloatAttr(FType, std::pow(2, ti.frac)));
-  auto dstType = IntegerType::get(op.getContext(), ti.width);
+  Type FType = src.getType();
+  Value frac = createFloatConstant(rewriter, loc, FType, std::pow(2, ti.frac));
+  Type dstType = getIntTypeLike(t, ti.width);
   auto FEncoding = rewriter.create<arith::MulFOp>(loc, FType, src, frac);
   if (ti.isSigned) {
     auto IEncoding = rewriter.create<arith::FPToSIOp>(loc, dstType, FEncoding);
@@ -584,11 +667,10 @@ void lowerFixedToInt(FixedToIntOp &op) {
   FixedTypeInfo ti = getFixedPointInfo(t);
   auto src_width = ti.width;
   auto src_frac = ti.frac;
-  auto dstType = dst.getType().cast<IntegerType>();
-  auto srcType = IntegerType::get(op.getContext(), src_width);
-  size_t dst_width = dstType.getWidth();
-  auto frac = rewriter.create<arith::ConstantOp>(
-      loc, srcType, rewriter.getIntegerAttr(srcType, src_frac));
+  Type dstType = dst.getType();
+  Type srcType = getIntTypeLike(t, src_width);
+  size_t dst_width = getElementTypeOrSelf(dstType).getIntOrFloatBitWidth();
+  Value frac = createIntConstant(rewriter, loc, srcType, src_frac);
   if (ti.isSigned) {
     auto rshifted = rewriter.create<arith::ShRSIOp>(loc, srcType, src, frac);
     if (dst_width > src_width) {
@@ -621,12 +703,11 @@ void lowerIntToFixed(IntToFixedOp &op) {
   auto dst = op.getResult();
   Type t = dst.getType();
   FixedTypeInfo ti = getFixedPointInfo(t);
-  auto src_width = src.getType().cast<IntegerType>().getWidth();
+  auto src_width = getElementTypeOrSelf(src).getIntOrFloatBitWidth();
   auto dst_width = ti.width;
   auto dst_frac = ti.frac;
-  auto dstType = IntegerType::get(op.getContext(), dst_width);
-  auto frac = rewriter.create<arith::ConstantOp>(
-      loc, dstType, rewriter.getIntegerAttr(dstType, dst_frac));
+  Type dstType = getIntTypeLike(t, dst_width);
+  Value frac = createIntConstant(rewriter, loc, dstType, dst_frac);
 
   Value bitAdjusted = castIntegerWidth(op->getContext(), rewriter, loc, src,
                                        src_width, dst_width, ti.isSigned);
@@ -679,8 +760,8 @@ void lowerFixedToFixed(FixedToFixedOp &op) {
   size_t dst_width = dst_ti.width;
   size_t dst_frac = dst_ti.frac;
   bool isSignedSrc = src_ti.isSigned;
-  auto srcType = IntegerType::get(op.getContext(), src_width);
-  auto dstType = IntegerType::get(op.getContext(), dst_width);
+  Type srcType = getIntTypeLike(src.getType(), src_width);
+  Type dstType = getIntTypeLike(dst.getType(), dst_width);
 
   // Step1: match bitwidth to max(src_width, dst_width)
   bool truncate_dst = false;
@@ -712,17 +793,15 @@ void lowerFixedToFixed(FixedToFixedOp &op) {
   if (dst_frac > src_frac) {
     // if (dst_frac > src_frac), left shift (dst_frac - src_frac)
     Type shiftType = match_to_dst ? dstType : srcType;
-    auto frac = rewriter.create<arith::ConstantOp>(
-        loc, shiftType,
-        rewriter.getIntegerAttr(shiftType, dst_frac - src_frac));
+    Value frac =
+        createIntConstant(rewriter, loc, shiftType, dst_frac - src_frac);
     shifted_src =
         rewriter.create<arith::ShLIOp>(loc, shiftType, matched_src, frac);
   } else if (dst_frac < src_frac) {
     // if (dst_frac < src_frac), right shift (src_frac - dst_frac)
     Type shiftType = match_to_dst ? dstType : srcType;
-    auto frac = rewriter.create<arith::ConstantOp>(
-        loc, shiftType,
-        rewriter.getIntegerAttr(shiftType, src_frac - dst_frac));
+    Value frac =
+        createIntConstant(rewriter, loc, shiftType, src_frac - dst_frac);
     if (isSignedSrc) {
       shifted_src =
           rewriter.create<arith::ShRSIOp>(loc, shiftType, matched_src, frac);
@@ -802,19 +881,19 @@ void validateLoweredFunc(func::FuncOp &func) {
 }
 
 /// Visitors to recursively update all operations
-void visitOperation(Operation &op);
-void visitRegion(Region &region);
-void visitBlock(Block &block);
+void visitOperation(Operation &op, bool simd);
+void visitRegion(Region &region, bool simd);
+void visitBlock(Block &block, bool simd);
 
-void visitOperation(Operation &op) {
+void visitOperation(Operation &op, bool simd) {
   if (auto new_op = dyn_cast<AddFixedOp>(op)) {
     lowerFixedAdd(new_op);
   } else if (auto new_op = dyn_cast<SubFixedOp>(op)) {
     lowerFixedSub(new_op);
   } else if (auto new_op = dyn_cast<MulFixedOp>(op)) {
-    lowerFixedMul(new_op);
+    lowerFixedMul(new_op, simd);
   } else if (auto new_op = dyn_cast<DivFixedOp>(op)) {
-    lowerFixedDiv(new_op);
+    lowerFixedDiv(new_op, simd);
   } else if (auto new_op = dyn_cast<CmpFixedOp>(op)) {
     lowerFixedCmp(new_op);
   } else if (auto new_op = dyn_cast<MinFixedOp>(op)) {
@@ -842,15 +921,15 @@ void visitOperation(Operation &op) {
   }
 
   for (auto &region : op.getRegions()) {
-    visitRegion(region);
+    visitRegion(region, simd);
   }
 }
 
-void visitBlock(Block &block) {
+void visitBlock(Block &block, bool simd) {
   SmallVector<Operation *, 10> opToRemove;
   for (auto it = block.rbegin(); it != block.rend(); ++it) {
     Operation &op = *it;
-    visitOperation(op);
+    visitOperation(op, simd);
     if (llvm::isa<AddFixedOp, SubFixedOp, MulFixedOp, DivFixedOp, CmpFixedOp,
                   MinFixedOp, MaxFixedOp, IntToFixedOp, FixedToIntOp,
                   FloatToFixedOp, FixedToFloatOp, FixedToFixedOp,
@@ -867,20 +946,20 @@ void visitBlock(Block &block) {
   }
 }
 
-void visitRegion(Region &region) {
+void visitRegion(Region &region, bool simd) {
   for (auto &block : region.getBlocks()) {
-    visitBlock(block);
+    visitBlock(block, simd);
   }
 }
 
 /// Pass entry point
-bool applyFixedPointToInteger(ModuleOp &mod) {
+bool applyFixedPointToInteger(ModuleOp &mod, bool simd) {
 
   for (func::FuncOp func : mod.getOps<func::FuncOp>()) {
     lowerPrintMemRefOp(func);
     lowerPrintOp(func);
     // lower arith, scf, conversion ops
-    visitRegion(func.getBody());
+    visitRegion(func.getBody(), simd);
     updateFunctionSignature(func);
     updateAlloc(func);
     updateAffineLoadStore(func);
@@ -898,10 +977,12 @@ namespace {
 
 struct HCLFixedToIntegerTransformation
     : public FixedToIntegerBase<HCLFixedToIntegerTransformation> {
+  HCLFixedToIntegerTransformation() = default;
+  HCLFixedToIntegerTransformation(bool simd) { this->simd = simd; }
 
   void runOnOperation() override {
     auto mod = getOperation();
-    if (!applyFixedPointToInteger(mod))
+    if (!applyFixedPointToInteger(mod, simd))
       return signalPassFailure();
   }
 };
@@ -916,5 +997,10 @@ std::unique_ptr<OperationPass<ModuleOp>> createFixedPointToIntegerPass() {
   return std::make_unique<HCLFixedToIntegerTransformation>();
 }
 
+std::unique_ptr<OperationPass<ModuleOp>>
+createFixedPointToIntegerPass(bool simd) {
+  return std::make_unique<HCLFixedToIntegerTransformation>(simd);
+}
+
 } // namespace hcl
 } // namespace mlir
\ No newline at end of file
@@ -242,6 +242,11 @@ struct HCLToLLVMLoweringPass
 namespace mlir {
 namespace hcl {
 bool applyHCLToLLVMLoweringPass(ModuleOp &module, MLIRContext &context) {
+  // Short-circuit logic operations have regions, which the conversion patterns
+  // below cannot handle, so they are lowered to arith and scf first.
+  if (!applyLowerLogicOps(module))
+    return false;
+
   // The first thing to define is the conversion target. This will define the
   // final target for this lowering. For this lowering, we are only targeting
   // the LLVM dialect.
@@ -8,6 +8,9 @@
 // This file defines the lowering of composite types such as structs.
 // This pass is separated from HCLToLLVM because it could be used
 // in other backends as well, such as HLS backend.
+// Memrefs of structs are lowered to one memref per field (struct of arrays),
+// or, with the packed option, to one memref of integer words holding all the
+// fields, which gives a single wide interface port in HLS.
 //===----------------------------------------------------------------------===//
 
 #include "hcl/Conversion/Passes.h"
@@ -17,6 +20,7 @@
 #include "hcl/Transforms/Passes.h"
 
 #include "mlir/Dialect/Affine/IR/AffineOps.h"
+#include "mlir/Dialect/Arith/IR/Arith.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
 #include "mlir/Dialect/MemRef/IR/MemRef.h"
 
@@ -74,8 +78,284 @@ void deadAffineLoadElimination(func::FuncOp &func) {
   }
 }
 
-void lowerStructType(func::FuncOp &func) {
+/// Collects the non-struct field types of `type`, depth first.
+static void getLeafTypes(Type type, SmallVectorImpl<Type> &leafTypes) {
+  if (auto structType = type.dyn_cast<StructType>()) {
+    for (Type fieldType : structType.getElementTypes())
+      getLeafTypes(fieldType, leafTypes);
+  } else {
+    leafTypes.push_back(type);
+  }
+}
+
+/// Collects the non-struct fields of a struct value built by struct_construct
+/// operations, depth first.
+static bool getLeafValues(Value value, SmallVectorImpl<Value> &leaves) {
+  if (!value.getType().isa<StructType>()) {
+    leaves.push_back(value);
+    return true;
+  }
+  auto structConstructOp = value.getDefiningOp<StructConstructOp>();
+  if (!structConstructOp)
+    return false;
+  for (Value field : structConstructOp.getInput())
+    if (!getLeafValues(field, leaves))
+      return false;
+  return true;
+}
+
+/// Builds a struct value of `type` from its non-struct fields, consuming them
+/// from the front of `leaves`.
+static Value buildStructFromLeaves(OpBuilder &builder, Location loc,
+                                   StructType type, ArrayRef<Value> &leaves) {
+  SmallVector<Value, 4> fields;
+  for (Type fieldType : type.getElementTypes()) {
+    if (auto structType = fieldType.dyn_cast<StructType>()) {
+      fields.push_back(buildStructFromLeaves(builder, loc, structType, leaves));
+    } else {
+      fields.push_back(leaves.front());
+      leaves = leaves.drop_front();
+    }
+  }
+  return builder.create<StructConstructOp>(loc, type, fields);
+}
+
+static void copyDiscardableAttrs(Operation *from, Operation *to) {
+  for (NamedAttribute attr : from->getDiscardableAttrs())
+    to->setAttr(attr.getName(), attr.getValue());
+}
+
+/// Loads the element `loadOp` loads, but from `memref`.
+static Value cloneLoad(OpBuilder &builder, Operation *loadOp, Value memref) {
+  Operation *newOp;
+  if (auto affineLoadOp = dyn_cast<affine::AffineLoadOp>(loadOp))
+    newOp = builder.create<affine::AffineLoadOp>(
+        loadOp->getLoc(), memref, affineLoadOp.getAffineMap(),
+        affineLoadOp.getIndices());
+  else
+    newOp = builder.create<memref::LoadOp>(
+        loadOp->getLoc(), memref, cast<memref::LoadOp>(loadOp).getIndices());
+  copyDiscardableAttrs(loadOp, newOp);
+  return newOp->getResult(0);
+}
+
+/// Stores `value` to the element `storeOp` stores to, but in `memref`.
+static void cloneStore(OpBuilder &builder, Operation *storeOp, Value value,
+                       Value memref) {
+  Operation *newOp;
+  if (auto affineStoreOp = dyn_cast<affine::AffineStoreOp>(storeOp))
+    newOp = builder.create<affine::AffineStoreOp>(
+        storeOp->getLoc(), value, memref, affineStoreOp.getAffineMap(),
+        affineStoreOp.getIndices());
+  else
+    newOp = builder.create<memref::StoreOp>(
+        storeOp->getLoc(), value, memref,
+        cast<memref::StoreOp>(storeOp).getIndices());
+  copyDiscardableAttrs(storeOp, newOp);
+}
 
+/// Packs the fields into one integer word, the first field in the lowest
+/// bits, which is the layout int_to_struct reads.
+static Value packLeaves(OpBuilder &builder, Location loc,
+                        ArrayRef<Value> leaves, IntegerType wordType) {
+  Value word;
+  unsigned lo = 0;
+  for (Value leaf : leaves) {
+    unsigned width = leaf.getType().getIntOrFloatBitWidth();
+    Value bits = leaf;
+    if (leaf.getType().isa<FloatType>())
+      bits = builder.create<arith::BitcastOp>(
+          loc, builder.getIntegerType(width), leaf);
+    if (width < wordType.getWidth())
+      bits = builder.create<arith::ExtUIOp>(loc, wordType, bits);
+    if (lo > 0) {
+      Value shift = builder.create<arith::ConstantIntOp>(loc, lo, wordType);
+      bits = builder.create<arith::ShLIOp>(loc, bits, shift);
+    }
+    if (word)
+      bits = builder.create<arith::OrIOp>(loc, word, bits);
+    word = bits;
+    lo += width;
+  }
+  return word;
+}
+
+/// Extracts the fields of `leafTypes` from a word built by packLeaves.
+static void unpackLeaves(OpBuilder &builder, Location loc, Value word,
+                         ArrayRef<Type> leafTypes,
+                         SmallVectorImpl<Value> &leaves) {
+  auto wordType = word.getType().cast<IntegerType>();
+  unsigned lo = 0;
+  for (Type leafType : leafTypes) {
+    unsigned width = leafType.getIntOrFloatBitWidth();
+    Value bits = word;
+    if (lo > 0) {
+      Value shift = builder.create<arith::ConstantIntOp>(loc, lo, wordType);
+      bits = builder.create<arith::ShRUIOp>(loc, bits, shift);
+    }
+    if (width < wordType.getWidth())
+      bits = builder.create<arith::TruncIOp>(
+          loc, builder.getIntegerType(width), bits);
+    if (leafType.isa<FloatType>())
+      bits = builder.create<arith::BitcastOp>(loc, leafType, bits);
+    leaves.push_back(bits);
+    lo += width;
+  }
+}
+
+namespace {
+/// The lowered storage of a memref of structs: one memref per non-struct
+/// field, or a single memref of words holding all the fields.
+struct StructLayout {
+  Value memref;
+  StructType structType;
+  SmallVector<Type, 4> leafTypes;
+  SmallVector<Value, 4> fieldMemRefs;
+  Value wordMemRef;
+};
+} // namespace
+
+static bool isPackable(ArrayRef<Type> leafTypes) {
+  return llvm::all_of(leafTypes, [](Type type) {
+    return type.isa<IntegerType, FloatType>();
+  });
+}
+
+static StructLayout createStructLayout(memref::AllocOp allocOp, bool packed) {
+  StructLayout layout;
+  layout.memref = allocOp.getResult();
+  auto memRefType = allocOp.getType();
+  layout.structType = memRefType.getElementType().cast<StructType>();
+  getLeafTypes(layout.structType, layout.leafTypes);
+
+  OpBuilder builder(allocOp);
+  Location loc = allocOp.getLoc();
+  auto name = allocOp->getAttrOfType<StringAttr>("name");
+  if (packed && isPackable(layout.leafTypes)) {
+    unsigned width = 0;
+    for (Type leafType : layout.leafTypes)
+      width += leafType.getIntOrFloatBitWidth();
+    auto wordMemRefType =
+        memRefType.clone(builder.getIntegerType(width)).cast<MemRefType>();
+    auto wordAllocOp = builder.create<memref::AllocOp>(
+        loc, wordMemRefType, allocOp.getDynamicSizes(),
+        allocOp.getSymbolOperands(), allocOp.getAlignmentAttr());
+    copyDiscardableAttrs(allocOp, wordAllocOp);
+    layout.wordMemRef = wordAllocOp.getResult();
+    return layout;
+  }
+  for (auto en : llvm::enumerate(layout.leafTypes)) {
+    auto fieldMemRefType = memRefType.clone(en.value()).cast<MemRefType>();
+    auto fieldAllocOp = builder.create<memref::AllocOp>(
+        loc, fieldMemRefType, allocOp.getDynamicSizes(),
+        allocOp.getSymbolOperands(), allocOp.getAlignmentAttr());
+    copyDiscardableAttrs(allocOp, fieldAllocOp);
+    if (name)
+      fieldAllocOp->setAttr(
+          "name", builder.getStringAttr(name.getValue() + "_" +
+                                        std::to_string(en.index())));
+    layout.fieldMemRefs.push_back(fieldAllocOp.getResult());
+  }
+  return layout;
+}
+
+/// Replaces a load of a struct by loads of its fields, or by a load of its
+/// word, and rebuilds the struct from them. Fields that are never used end up
+/// with dead loads, which are removed afterwards.
+static void lowerStructLoad(StructLayout &layout, Operation *loadOp) {
+  OpBuilder builder(loadOp);
+  Location loc = loadOp->getLoc();
+  SmallVector<Value, 4> leaves;
+  if (layout.wordMemRef) {
+    Value word = cloneLoad(builder, loadOp, layout.wordMemRef);
+    unpackLeaves(builder, loc, word, layout.leafTypes, leaves);
+  } else {
+    for (Value fieldMemRef : layout.fieldMemRefs)
+      leaves.push_back(cloneLoad(builder, loadOp, fieldMemRef));
+  }
+  ArrayRef<Value> remaining(leaves);
+  Value structValue =
+      buildStructFromLeaves(builder, loc, layout.structType, remaining);
+  loadOp->getResult(0).replaceAllUsesWith(structValue);
+  loadOp->erase();
+}
+
+static bool lowerStructStore(StructLayout &layout, Operation *storeOp) {
+  SmallVector<Value, 4> leaves;
+  if (!getLeafValues(storeOp->getOperand(0), leaves)) {
+    storeOp->emitError("cannot lower a store of a struct that is not built "
+                       "by struct_construct");
+    return false;
+  }
+  OpBuilder builder(storeOp);
+  if (layout.wordMemRef) {
+    auto wordType = layout.wordMemRef.getType()
+                        .cast<MemRefType>()
+                        .getElementType()
+                        .cast<IntegerType>();
+    Value word = packLeaves(builder, storeOp->getLoc(), leaves, wordType);
+    cloneStore(builder, storeOp, word, layout.wordMemRef);
+  } else {
+    for (auto [leaf, fieldMemRef] : llvm::zip(leaves, layout.fieldMemRefs))
+      cloneStore(builder, storeOp, leaf, fieldMemRef);
+  }
+  storeOp->erase();
+  return true;
+}
+
+/// Lowers the memrefs of structs allocated in `func` to a struct of arrays,
+/// one memref per field, or to a single memref of words when `packed` is set
+/// and all the fields are integers or floats. Loads and stores are rewritten
+/// in place, so the original memref is never written.
+bool lowerStructMemRefs(func::FuncOp &func, bool packed) {
+  SmallVector<memref::AllocOp, 4> allocOps;
+  func.walk([&](memref::AllocOp allocOp) {
+    if (allocOp.getType().getElementType().isa<StructType>())
+      allocOps.push_back(allocOp);
+  });
+
+  SmallVector<StructLayout, 4> layouts;
+  for (memref::AllocOp allocOp : allocOps) {
+    for (Operation *user : allocOp->getUsers()) {
+      bool isAccess =
+          isa<affine::AffineLoadOp, memref::LoadOp, memref::DeallocOp>(user) ||
+          (isa<affine::AffineStoreOp, memref::StoreOp>(user) &&
+           user->getOperand(1) == allocOp.getResult());
+      if (!isAccess) {
+        user->emitError("unsupported use of a memref of structs");
+        return false;
+      }
+    }
+    layouts.push_back(createStructLayout(allocOp, packed));
+  }
+
+  // Loads are lowered first, so that structs copied from one memref to
+  // another are built by struct_construct when their stores are lowered.
+  for (StructLayout &layout : layouts)
+    for (Operation *user : llvm::to_vector(layout.memref.getUsers()))
+      if (isa<affine::AffineLoadOp, memref::LoadOp>(user))
+        lowerStructLoad(layout, user);
+  for (StructLayout &layout : layouts) {
+    for (Operation *user : llvm::to_vector(layout.memref.getUsers())) {
+      if (isa<affine::AffineStoreOp, memref::StoreOp>(user)) {
+        if (!lowerStructStore(layout, user))
+          return false;
+      } else if (auto deallocOp = dyn_cast<memref::DeallocOp>(user)) {
+        OpBuilder builder(deallocOp);
+        SmallVector<Value, 4> memrefs(layout.fieldMemRefs);
+        if (layout.wordMemRef)
+          memrefs.push_back(layout.wordMemRef);
+        for (Value memref : memrefs)
+          builder.create<memref::DeallocOp>(deallocOp.getLoc(), memref);
+        deallocOp.erase();
+      }
+    }
+    layout.memref.getDefiningOp()->erase();
+  }
+  return true;
+}
+
+void lowerStructType(func::FuncOp &func) {
   SmallVector<Operation *, 10> structGetOps;
   func.walk([&](Operation *op) {
     if (auto structGetOp = dyn_cast<StructGetOp>(op)) {
@@ -83,100 +363,21 @@ void lowerStructType(func::FuncOp &func) {
     }
   });
 
-  std::map<mlir::detail::ValueImpl *, SmallVector<Value, 8>>
-      structMemRef2fieldMemRefs;
-
   for (auto op : structGetOps) {
-    // Collect info from structGetOp
     auto structGetOp = dyn_cast<StructGetOp>(op);
     Value struct_value = structGetOp->getOperand(0);
     Value struct_field = structGetOp->getResult(0);
-    Location loc = op->getLoc();
     auto index = structGetOp.getIndex();
 
-    // This flag indicates whether we can erase
-    // struct construct and relevant ops.
-    bool erase_struct_construct = false;
-
-    // The defOp can be either a StructConstructOp or
-    // a load from a memref.
-    // Load: we are operating on a memref of struct
-    // Construct: we are operating on a struct value
-    Operation *defOp = struct_value.getDefiningOp();
-    if (auto affine_load = dyn_cast<affine::AffineLoadOp>(defOp)) {
-      // Case 1: defOp is loadOp from memref
-      // Note: the idea to lower struct from memref is to
-      // first create a memref for each struct field, and then
-      // add store operation to those memrefs right after the
-      // struct construction. With that, we can replace
-      // struct get with loading from field memrefs.
-
-      // Step1: create memref for each field
-      Value struct_memref = affine_load.getMemref();
-      // Try to find field_memrefs associated with this struct_memref
-      SmallVector<Value, 4> field_memrefs;
-      auto it = structMemRef2fieldMemRefs.find(struct_memref.getImpl());
-      if (it == structMemRef2fieldMemRefs.end()) {
-        // Create a memref for each field
-        OpBuilder builder(struct_memref.getDefiningOp());
-        StructType struct_type = struct_value.getType().cast<StructType>();
-
-        for (Type field_type : struct_type.getElementTypes()) {
-          MemRefType newMemRefType = struct_memref.getType()
-                                         .cast<MemRefType>()
-                                         .clone(field_type)
-                                         .cast<MemRefType>();
-          Value field_memref =
-              builder.create<memref::AllocOp>(loc, newMemRefType);
-          field_memrefs.push_back(field_memref);
-        }
-        structMemRef2fieldMemRefs.insert(
-            std::make_pair(struct_memref.getImpl(), field_memrefs));
-        erase_struct_construct = true;
-      } else {
-        field_memrefs.append(it->second);
-        erase_struct_construct = false;
-      }
-
-      // Step2: add store to each field memref
-      for (auto &use : struct_memref.getUses()) {
-        if (auto storeOp = dyn_cast<affine::AffineStoreOp>(use.getOwner())) {
-          // Find a storeOp to the struct memref, we add
-          // store to each field memref here.
-          OpBuilder builder(storeOp);
-          for (const auto &field_memref_en : llvm::enumerate(field_memrefs)) {
-            auto field_memref = field_memref_en.value();
-            auto field_index = field_memref_en.index();
-            // Find the struct_construct op
-            auto struct_construct_op = dyn_cast<StructConstructOp>(
-                storeOp.getOperand(0).getDefiningOp());
-            builder.create<affine::AffineStoreOp>(
-                loc, struct_construct_op.getOperand(field_index), field_memref,
-                storeOp.getAffineMap(), storeOp.getIndices());
-          }
-          // erase the storeOp that stores to the struct memref
-          if (erase_struct_construct) {
-            storeOp.erase();
-          }
-          break;
-        }
-      }
-
-      // Step3: replace structGetOp with load from field memrefs
-      OpBuilder load_builder(op);
-      Value loaded_field = load_builder.create<affine::AffineLoadOp>(
-          loc, field_memrefs[index], affine_load.getAffineMap(),
-          affine_load.getIndices());
-      struct_field.replaceAllUsesWith(loaded_field);
-      op->erase(); // erase structGetOp
-    } else if (auto structConstructOp = dyn_cast<StructConstructOp>(defOp)) {
-      // Case 2: defOp is a struct construction op
-      Value replacement = defOp->getOperand(index);
-      struct_field.replaceAllUsesWith(replacement);
-      op->erase(); // erase structGetOp
-    } else {
-      llvm_unreachable("unexpected defOp for structGetOp");
-    }
+    // Memrefs of structs have been lowered, so the struct is built by a
+    // struct construct op. Structs of other origins are left in place and
+    // reported as illegal.
+    auto structConstructOp = struct_value.getDefiningOp<StructConstructOp>();
+    if (!structConstructOp)
+      continue;
+    Value replacement = structConstructOp->getOperand(index);
+    struct_field.replaceAllUsesWith(replacement);
+    op->erase(); // erase structGetOp
   }
 
   // Run DCE after all struct get is folded
@@ -259,12 +460,15 @@ bool isLegal(func::FuncOp &func) {
 }
 
 /// Pass entry point
-bool applyLowerCompositeType(ModuleOp &mod) {
+bool applyLowerCompositeType(ModuleOp &mod, bool packed) {
   for (func::FuncOp func : mod.getOps<func::FuncOp>()) {
     lowerIntToStructOp(func);
   }
   applyMemRefDCE(mod);
   for (func::FuncOp func : mod.getOps<func::FuncOp>()) {
+    if (!lowerStructMemRefs(func, packed)) {
+      return false;
+    }
     lowerStructType(func);
   }
   applyMemRefDCE(mod);
@@ -281,9 +485,12 @@ bool applyLowerCompositeType(ModuleOp &mod) {
 namespace {
 struct HCLLowerCompositeTypeTransformation
     : public LowerCompositeTypeBase<HCLLowerCompositeTypeTransformation> {
+  HCLLowerCompositeTypeTransformation() = default;
+  HCLLowerCompositeTypeTransformation(bool packed) { this->packed = packed; }
+
   void runOnOperation() override {
     auto mod = getOperation();
-    if (!applyLowerCompositeType(mod)) {
+    if (!applyLowerCompositeType(mod, packed)) {
       return signalPassFailure();
     }
   }
@@ -296,5 +503,10 @@ namespace hcl {
 std::unique_ptr<OperationPass<ModuleOp>> createLowerCompositeTypePass() {
   return std::make_unique<HCLLowerCompositeTypeTransformation>();
 }
+
+std::unique_ptr<OperationPass<ModuleOp>>
+createLowerCompositeTypePass(bool packed) {
+  return std::make_unique<HCLLowerCompositeTypeTransformation>(packed);
+}
 } // namespace hcl
 } // namespace mlir
\ No newline at end of file
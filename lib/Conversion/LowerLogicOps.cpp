@@ -0,0 +1,179 @@
+/*
+ * Copyright HeteroCL authors. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//===----------------------------------------------------------------------===//
+// LowerLogicOps Pass
+// This file defines the lowering of the short-circuit logic operations.
+// - And
+// - Or
+// Each region of the operation computes one input. Inputs that are cheap to
+// compute and free of side effects are evaluated unconditionally and combined
+// with arith.andi/arith.ori, which keeps the surrounding loop body free of
+// branches. Otherwise, later inputs are only evaluated in nested scf.if
+// operations when the inputs before them did not decide the result.
+//===----------------------------------------------------------------------===//
+
+#include "hcl/Conversion/Passes.h"
+#include "hcl/Dialect/HeteroCLDialect.h"
+#include "hcl/Dialect/HeteroCLOps.h"
+
+#include "mlir/Dialect/Arith/IR/Arith.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/Dialect/SCF/IR/SCF.h"
+#include "mlir/Interfaces/SideEffectInterfaces.h"
+
+using namespace mlir;
+using namespace hcl;
+
+/// Returns the number of operations evaluating all the regions if none of them
+/// has side effects, and std::nullopt otherwise.
+static std::optional<unsigned> getSpeculationCost(Operation *op) {
+  unsigned numOps = 0;
+  for (Region &region : op->getRegions())
+    for (Operation &nested : region.getOps()) {
+      if (isa<YieldOp>(nested))
+        continue;
+      if (!isPure(&nested))
+        return std::nullopt;
+      nested.walk([&](Operation *) { ++numOps; });
+    }
+  return numOps;
+}
+
+/// Moves the body of `region` before the insertion point of `builder` and
+/// returns the value it yields.
+static Value inlineRegion(OpBuilder &builder, Region &region) {
+  Block &block = region.front();
+  Operation *yieldOp = block.getTerminator();
+  Block *insertBlock = builder.getInsertionBlock();
+  insertBlock->getOperations().splice(builder.getInsertionPoint(),
+                                      block.getOperations(), block.begin(),
+                                      yieldOp->getIterator());
+  return yieldOp->getOperand(0);
+}
+
+/// Builds the short-circuit evaluation of the regions starting at `index`.
+/// An and stops at the first false input, and an or at the first true input.
+static Value buildShortCircuit(OpBuilder &builder, Location loc,
+                               MutableArrayRef<Region> regions, unsigned index,
+                               bool isAnd) {
+  Value input = inlineRegion(builder, regions[index]);
+  if (index + 1 == regions.size())
+    return input;
+  auto ifOp = builder.create<scf::IfOp>(
+      loc, input,
+      [&](OpBuilder &thenBuilder, Location loc) {
+        Value result =
+            isAnd ? buildShortCircuit(thenBuilder, loc, regions, index + 1,
+                                      isAnd)
+                  : thenBuilder.create<arith::ConstantIntOp>(loc, 1, 1);
+        thenBuilder.create<scf::YieldOp>(loc, result);
+      },
+      [&](OpBuilder &elseBuilder, Location loc) {
+        Value result =
+            isAnd ? elseBuilder.create<arith::ConstantIntOp>(loc, 0, 1)
+                  : buildShortCircuit(elseBuilder, loc, regions, index + 1,
+                                      isAnd);
+        elseBuilder.create<scf::YieldOp>(loc, result);
+      });
+  return ifOp.getResult(0);
+}
+
+static LogicalResult lowerLogicOp(Operation *op, bool isAnd,
+                                  unsigned maxSpeculatedOps) {
+  Location loc = op->getLoc();
+  Type type = op->getResult(0).getType();
+  MutableArrayRef<Region> regions = op->getRegions();
+  for (Region &region : regions) {
+    if (!region.hasOneBlock() ||
+        region.front().getTerminator()->getNumOperands() != 1) {
+      op->emitError("expected each region to be a single block yielding an "
+                    "input");
+      return failure();
+    }
+  }
+
+  OpBuilder builder(op);
+  Value result;
+  std::optional<unsigned> cost = getSpeculationCost(op);
+  if (regions.empty()) {
+    // An empty and is true, and an empty or is false.
+    TypedAttr value = builder.getIntegerAttr(builder.getI1Type(), isAnd);
+    if (auto shapedType = type.dyn_cast<ShapedType>())
+      value = DenseElementsAttr::get(shapedType, value);
+    result = builder.create<arith::ConstantOp>(loc, value);
+  } else if (cost && *cost <= maxSpeculatedOps) {
+    for (Region &region : regions) {
+      Value input = inlineRegion(builder, region);
+      if (!result)
+        result = input;
+      else if (isAnd)
+        result = builder.create<arith::AndIOp>(loc, result, input);
+      else
+        result = builder.create<arith::OrIOp>(loc, result, input);
+    }
+  } else if (type.isInteger(1)) {
+    result = buildShortCircuit(builder, loc, regions, 0, isAnd);
+  } else {
+    op->emitError("short-circuit evaluation requires an i1 result");
+    return failure();
+  }
+  op->getResult(0).replaceAllUsesWith(result);
+  op->erase();
+  return success();
+}
+
+namespace mlir {
+namespace hcl {
+
+/// Pass entry point
+bool applyLowerLogicOps(ModuleOp &mod, unsigned maxSpeculatedOps) {
+  for (func::FuncOp func : mod.getOps<func::FuncOp>()) {
+    // Inner operations are lowered first, so that a lowered operation counts
+    // towards the cost of evaluating the region holding it.
+    SmallVector<Operation *, 8> logicOps;
+    func.walk([&](Operation *op) {
+      if (isa<AndOp, OrOp>(op))
+        logicOps.push_back(op);
+    });
+    for (Operation *op : logicOps)
+      if (failed(lowerLogicOp(op, isa<AndOp>(op), maxSpeculatedOps)))
+        return false;
+  }
+  return true;
+}
+} // namespace hcl
+} // namespace mlir
+
+namespace {
+struct HCLLowerLogicOpsTransformation
+    : public LowerLogicOpsBase<HCLLowerLogicOpsTransformation> {
+  HCLLowerLogicOpsTransformation() = default;
+  HCLLowerLogicOpsTransformation(unsigned maxSpeculatedOps) {
+    this->maxSpeculatedOps = maxSpeculatedOps;
+  }
+
+  void runOnOperation() override {
+    auto mod = getOperation();
+    if (!applyLowerLogicOps(mod, maxSpeculatedOps)) {
+      return signalPassFailure();
+    }
+  }
+};
+} // namespace
+
+namespace mlir {
+namespace hcl {
+
+std::unique_ptr<OperationPass<ModuleOp>> createLowerLogicOpsPass() {
+  return std::make_unique<HCLLowerLogicOpsTransformation>();
+}
+
+std::unique_ptr<OperationPass<ModuleOp>>
+createLowerLogicOpsPass(unsigned maxSpeculatedOps) {
+  return std::make_unique<HCLLowerLogicOpsTransformation>(maxSpeculatedOps);
+}
+} // namespace hcl
+} // namespace mlir
@@ -11,6 +11,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "mlir/Dialect/Arith/IR/Arith.h"
 #include "mlir/IR/BuiltinOps.h"
 #include "mlir/IR/DialectImplementation.h"
 #include "mlir/Transforms/InliningUtils.h"
@@ -63,6 +64,14 @@ void HeteroCLDialect::initialize() {
 // Extra methods
 //===----------------------------------------------------------------------===//
 
+Operation *HeteroCLDialect::materializeConstant(OpBuilder &builder,
+                                                Attribute value, Type type,
+                                                Location loc) {
+  if (!arith::ConstantOp::isBuildableWith(value, type))
+    return nullptr;
+  return builder.create<arith::ConstantOp>(loc, type, value.cast<TypedAttr>());
+}
+
 void StructType::print(mlir::AsmPrinter &p) const {
   p << "<";
   llvm::interleaveComma(getElementTypes(), p);
@@ -14,6 +14,7 @@
 #include "hcl/Dialect/HeteroCLOps.h"
 #include "hcl/Dialect/HeteroCLDialect.h"
 
+#include "mlir/Dialect/Arith/IR/Arith.h"
 #include "mlir/IR/Builders.h"
 #include "mlir/IR/BuiltinOps.h"
 #include "mlir/IR/BuiltinTypes.h"
@@ -94,6 +95,368 @@ static void buildCmpFixedOp(OpBuilder &build, OperationState &result,
   //                     build.getI64IntegerAttr(static_cast<int64_t>(predicate)));
 }
 
+//===----------------------------------------------------------------------===//
+// Fixed-point folding and canonicalization
+//
+// Fixed-point operations follow their lowering to integers: the operands are
+// integers of the same width, products are computed at twice the width and
+// shifted back, and all results wrap around.
+//===----------------------------------------------------------------------===//
+
+namespace {
+struct FixedInfo {
+  unsigned width;
+  unsigned frac;
+  bool isSigned;
+};
+} // namespace
+
+static std::optional<FixedInfo> getFixedInfo(Type type) {
+  if (auto fixedType = type.dyn_cast<FixedType>())
+    return FixedInfo{(unsigned)fixedType.getWidth(),
+                     (unsigned)fixedType.getFrac(), true};
+  if (auto ufixedType = type.dyn_cast<UFixedType>())
+    return FixedInfo{(unsigned)ufixedType.getWidth(),
+                     (unsigned)ufixedType.getFrac(), false};
+  return std::nullopt;
+}
+
+/// Returns the integer representation of a fixed-point constant, i.e. of an
+/// integer constant cast to a fixed-point type.
+static std::optional<APInt> getFixedConstant(Value value) {
+  auto castOp = value.getDefiningOp<IntToFixedOp>();
+  if (!castOp)
+    return std::nullopt;
+  auto info = getFixedInfo(castOp.getRes().getType());
+  APInt input;
+  if (!info || info->frac >= info->width ||
+      !matchPattern(castOp.getInput(), m_ConstantInt(&input)))
+    return std::nullopt;
+  APInt base = info->isSigned ? input.sextOrTrunc(info->width)
+                              : input.zextOrTrunc(info->width);
+  return base.shl(info->frac);
+}
+
+static bool isFixedZero(Value value) {
+  auto constant = getFixedConstant(value);
+  return constant && constant->isZero();
+}
+
+static bool isFixedOne(Value value, FixedInfo info) {
+  // 1 is not representable if there are no integer bits, e.g. in Fixed<4, 4>
+  auto constant = getFixedConstant(value);
+  return constant && info.frac + (info.isSigned ? 1 : 0) < info.width &&
+         *constant == APInt(info.width, 1).shl(info.frac);
+}
+
+/// Whether every value of fixed-point type `from` is exactly representable in
+/// fixed-point type `to`.
+static bool isLosslessFixedCast(FixedInfo from, FixedInfo to) {
+  return from.isSigned == to.isSigned && to.frac >= from.frac &&
+         (int64_t)to.width - to.frac >= (int64_t)from.width - from.frac;
+}
+
+/// Whether casting from fixed-point type `from` to `to` keeps no more
+/// fractional and no more integer bits. Such a cast only depends on the bits
+/// of its input that the input itself holds, so casting a value to `from`
+/// first does not change the result.
+static bool isNarrowingFixedCast(FixedInfo from, FixedInfo to) {
+  return to.frac <= from.frac &&
+         (int64_t)to.width - to.frac <= (int64_t)from.width - from.frac;
+}
+
+static APInt evaluateFixedOp(AddFixedOp, FixedInfo, APInt lhs, APInt rhs) {
+  return lhs + rhs;
+}
+
+static APInt evaluateFixedOp(SubFixedOp, FixedInfo, APInt lhs, APInt rhs) {
+  return lhs - rhs;
+}
+
+static APInt evaluateFixedOp(MulFixedOp, FixedInfo info, APInt lhs,
+                             APInt rhs) {
+  unsigned wideWidth = info.width * 2;
+  APInt product = info.isSigned ? lhs.sext(wideWidth) * rhs.sext(wideWidth)
+                                : lhs.zext(wideWidth) * rhs.zext(wideWidth);
+  APInt shifted =
+      info.isSigned ? product.ashr(info.frac) : product.lshr(info.frac);
+  return shifted.trunc(info.width);
+}
+
+namespace {
+/// Folds an operation on two fixed-point constants into a fixed-point
+/// constant. The integer representation of a constant has no fractional bits
+/// set, and neither has the result of adding, subtracting or multiplying two
+/// of them, so the result is again the cast of an integer.
+template <typename OpTy>
+struct FoldConstantFixedOp : public OpRewritePattern<OpTy> {
+  using OpRewritePattern<OpTy>::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(OpTy op,
+                                PatternRewriter &rewriter) const override {
+    Type type = op.getResult().getType();
+    auto info = getFixedInfo(type);
+    auto lhs = getFixedConstant(op.getLhs());
+    auto rhs = getFixedConstant(op.getRhs());
+    if (!info || !lhs || !rhs)
+      return failure();
+    APInt result = evaluateFixedOp(op, *info, *lhs, *rhs);
+    auto intType = rewriter.getIntegerType(info->width);
+    Value integer = rewriter.create<arith::ConstantOp>(
+        op.getLoc(), rewriter.getIntegerAttr(intType, result.lshr(info->frac)));
+    rewriter.replaceOpWithNewOp<IntToFixedOp>(op, type, integer);
+    return success();
+  }
+};
+} // namespace
+
+OpFoldResult AddFixedOp::fold(FoldAdaptor adaptor) {
+  // x + 0 -> x
+  if (isFixedZero(getRhs()))
+    return getLhs();
+  if (isFixedZero(getLhs()))
+    return getRhs();
+  return {};
+}
+
+void AddFixedOp::getCanonicalizationPatterns(RewritePatternSet &results,
+                                             MLIRContext *context) {
+  results.add<FoldConstantFixedOp<AddFixedOp>>(context);
+}
+
+OpFoldResult SubFixedOp::fold(FoldAdaptor adaptor) {
+  // x - 0 -> x
+  if (isFixedZero(getRhs()))
+    return getLhs();
+  return {};
+}
+
+void SubFixedOp::getCanonicalizationPatterns(RewritePatternSet &results,
+                                             MLIRContext *context) {
+  results.add<FoldConstantFixedOp<SubFixedOp>>(context);
+}
+
+OpFoldResult MulFixedOp::fold(FoldAdaptor adaptor) {
+  auto info = getFixedInfo(getResult().getType());
+  if (!info)
+    return {};
+  // x * 1 -> x
+  if (isFixedOne(getRhs(), *info))
+    return getLhs();
+  if (isFixedOne(getLhs(), *info))
+    return getRhs();
+  return {};
+}
+
+void MulFixedOp::getCanonicalizationPatterns(RewritePatternSet &results,
+                                             MLIRContext *context) {
+  results.add<FoldConstantFixedOp<MulFixedOp>>(context);
+}
+
+/// Folds min/max(x, x) -> x and min/max of two constants to one of them.
+static Value foldFixedMinMax(Value lhs, Value rhs, bool isMin) {
+  if (lhs == rhs)
+    return lhs;
+  auto info = getFixedInfo(lhs.getType());
+  auto lhsConstant = getFixedConstant(lhs);
+  auto rhsConstant = getFixedConstant(rhs);
+  if (!info || !lhsConstant || !rhsConstant)
+    return {};
+  bool lhsIsLess = info->isSigned ? lhsConstant->slt(*rhsConstant)
+                                  : lhsConstant->ult(*rhsConstant);
+  return lhsIsLess == isMin ? lhs : rhs;
+}
+
+OpFoldResult MinFixedOp::fold(FoldAdaptor adaptor) {
+  if (Value result = foldFixedMinMax(getLhs(), getRhs(), /*isMin=*/true))
+    return result;
+  return {};
+}
+
+OpFoldResult MaxFixedOp::fold(FoldAdaptor adaptor) {
+  if (Value result = foldFixedMinMax(getLhs(), getRhs(), /*isMin=*/false))
+    return result;
+  return {};
+}
+
+OpFoldResult FixedToIntOp::fold(FoldAdaptor adaptor) {
+  // fixed_to_int(int_to_fixed(x)) -> x if x fits in the integer bits
+  auto castOp = getInput().getDefiningOp<IntToFixedOp>();
+  if (!castOp || castOp.getInput().getType() != getRes().getType())
+    return {};
+  auto info = getFixedInfo(getInput().getType());
+  auto intType = getRes().getType().dyn_cast<IntegerType>();
+  if (info && intType && info->width >= intType.getWidth() + info->frac)
+    return castOp.getInput();
+  return {};
+}
+
+OpFoldResult FixedToFixedOp::fold(FoldAdaptor adaptor) {
+  if (getInput().getType() == getRes().getType())
+    return getInput();
+  // Casting through a type that holds every value of the source type, or
+  // through a type this cast narrows, is the same as casting directly.
+  auto castOp = getInput().getDefiningOp<FixedToFixedOp>();
+  if (!castOp)
+    return {};
+  auto src = getFixedInfo(castOp.getInput().getType());
+  auto mid = getFixedInfo(castOp.getRes().getType());
+  auto dst = getFixedInfo(getRes().getType());
+  if (!src || !mid || !dst ||
+      (!isLosslessFixedCast(*src, *mid) && !isNarrowingFixedCast(*mid, *dst)))
+    return {};
+  if (castOp.getInput().getType() == getRes().getType())
+    return castOp.getInput();
+  getInputMutable().assign(castOp.getInput());
+  return getResult();
+}
+
+//===----------------------------------------------------------------------===//
+// Bit operation folding
+//===----------------------------------------------------------------------===//
+
+static std::optional<unsigned> getConstantBitIndex(Attribute attr,
+                                                   unsigned width) {
+  auto index = attr.dyn_cast_or_null<IntegerAttr>();
+  if (!index || index.getValue().isNegative() ||
+      index.getValue().uge(width))
+    return std::nullopt;
+  return index.getValue().getZExtValue();
+}
+
+/// Returns the constant bit range [lo, hi] of a slice of an integer.
+static std::optional<std::pair<unsigned, unsigned>>
+getConstantSlice(Attribute hiAttr, Attribute loAttr, unsigned width) {
+  auto hi = getConstantBitIndex(hiAttr, width);
+  auto lo = getConstantBitIndex(loAttr, width);
+  if (!hi || !lo || *lo > *hi)
+    return std::nullopt;
+  return std::make_pair(*lo, *hi);
+}
+
+static unsigned getIntegerWidth(Type type) {
+  auto intType = type.dyn_cast<IntegerType>();
+  return intType ? intType.getWidth() : 0;
+}
+
+OpFoldResult GetIntBitOp::fold(FoldAdaptor adaptor) {
+  // get_bit(set_bit(x, i, v), i) -> v
+  if (auto setOp = getNum().getDefiningOp<SetIntBitOp>())
+    if (setOp.getIndex() == getIndex() &&
+        setOp.getVal().getType() == getResult().getType())
+      return setOp.getVal();
+  unsigned width = getIntegerWidth(getNum().getType());
+  auto num = adaptor.getNum().dyn_cast_or_null<IntegerAttr>();
+  auto index = getConstantBitIndex(adaptor.getIndex(), width);
+  if (!num || !index || getIntegerWidth(getResult().getType()) != 1)
+    return {};
+  return IntegerAttr::get(getResult().getType(),
+                          APInt(1, num.getValue()[*index]));
+}
+
+OpFoldResult SetIntBitOp::fold(FoldAdaptor adaptor) {
+  // set_bit(x, i, get_bit(x, i)) -> x
+  if (auto getOp = getVal().getDefiningOp<GetIntBitOp>())
+    if (getOp.getNum() == getNum() && getOp.getIndex() == getIndex())
+      return getNum();
+  unsigned width = getIntegerWidth(getNum().getType());
+  auto num = adaptor.getNum().dyn_cast_or_null<IntegerAttr>();
+  auto index = getConstantBitIndex(adaptor.getIndex(), width);
+  auto val = adaptor.getVal().dyn_cast_or_null<IntegerAttr>();
+  if (!num || !index || !val)
+    return {};
+  APInt result = num.getValue();
+  result.setBitVal(*index, !val.getValue().isZero());
+  return IntegerAttr::get(getResult().getType(), result);
+}
+
+OpFoldResult GetIntSliceOp::fold(FoldAdaptor adaptor) {
+  unsigned width = getIntegerWidth(getNum().getType());
+  unsigned resultWidth = getIntegerWidth(getResult().getType());
+  auto slice = getConstantSlice(adaptor.getHi(), adaptor.getLo(), width);
+  if (!slice || resultWidth == 0)
+    return {};
+  auto [lo, hi] = *slice;
+  // get_slice(x, w - 1, 0) -> x
+  if (lo == 0 && hi == width - 1 &&
+      getNum().getType() == getResult().getType())
+    return getNum();
+  // get_slice(set_slice(x, hi, lo, v), hi, lo) -> v if v fits in the slice
+  if (auto setOp = getNum().getDefiningOp<SetIntSliceOp>())
+    if (setOp.getHi() == getHi() && setOp.getLo() == getLo() &&
+        setOp.getVal().getType() == getResult().getType() &&
+        resultWidth <= hi - lo + 1)
+      return setOp.getVal();
+  auto num = adaptor.getNum().dyn_cast_or_null<IntegerAttr>();
+  if (!num)
+    return {};
+  APInt result = num.getValue().extractBits(hi - lo + 1, lo);
+  return IntegerAttr::get(getResult().getType(),
+                          result.zextOrTrunc(resultWidth));
+}
+
+OpFoldResult SetIntSliceOp::fold(FoldAdaptor adaptor) {
+  unsigned width = getIntegerWidth(getNum().getType());
+  auto slice = getConstantSlice(adaptor.getHi(), adaptor.getLo(), width);
+  if (!slice)
+    return {};
+  auto [lo, hi] = *slice;
+  // set_slice(x, hi, lo, get_slice(x, hi, lo)) -> x if no bit is lost
+  if (auto getOp = getVal().getDefiningOp<GetIntSliceOp>())
+    if (getOp.getNum() == getNum() && getOp.getHi() == getHi() &&
+        getOp.getLo() == getLo() &&
+        getIntegerWidth(getOp.getResult().getType()) >= hi - lo + 1)
+      return getNum();
+  auto num = adaptor.getNum().dyn_cast_or_null<IntegerAttr>();
+  auto val = adaptor.getVal().dyn_cast_or_null<IntegerAttr>();
+  if (!num || !val)
+    return {};
+  APInt result = num.getValue();
+  result.insertBits(val.getValue().zextOrTrunc(hi - lo + 1), lo);
+  return IntegerAttr::get(getResult().getType(), result);
+}
+
+OpFoldResult BitReverseOp::fold(FoldAdaptor adaptor) {
+  // bit_reverse(bit_reverse(x)) -> x
+  if (auto reverseOp = getNum().getDefiningOp<BitReverseOp>())
+    return reverseOp.getNum();
+  if (auto num = adaptor.getNum().dyn_cast_or_null<IntegerAttr>())
+    return IntegerAttr::get(getResult().getType(),
+                            num.getValue().reverseBits());
+  return {};
+}
+
+/// Folds a logical and/or whose result is decided by its constant inputs.
+/// `absorbing` is the input value that decides the result by itself.
+static OpFoldResult foldLogicalOp(ArrayRef<Attribute> inputs, Type type,
+                                  bool absorbing) {
+  if (getIntegerWidth(type) != 1)
+    return {};
+  bool allConstant = true;
+  for (Attribute input : inputs) {
+    auto constant = input.dyn_cast_or_null<IntegerAttr>();
+    if (!constant) {
+      allConstant = false;
+      continue;
+    }
+    if (!constant.getValue().isZero() == absorbing)
+      return IntegerAttr::get(type, APInt(1, absorbing));
+  }
+  if (!allConstant)
+    return {};
+  return IntegerAttr::get(type, APInt(1, !absorbing));
+}
+
+OpFoldResult LogicalAndOp::fold(FoldAdaptor adaptor) {
+  return foldLogicalOp(adaptor.getInput(), getResult().getType(),
+                       /*absorbing=*/false);
+}
+
+OpFoldResult LogicalOrOp::fold(FoldAdaptor adaptor) {
+  return foldLogicalOp(adaptor.getInput(), getResult().getType(),
+                       /*absorbing=*/true);
+}
+
 } // namespace hcl
 } // namespace mlir
 
@@ -4,9 +4,15 @@
  */
 
 #include "hcl/Dialect/TransformOps/HCLTransformOps.h"
+#include "hcl/Dialect/HeteroCLDialect.h"
+#include "hcl/Dialect/HeteroCLOps.h"
+#include "hcl/Dialect/HeteroCLTypes.h"
+#include "hcl/Transforms/ScheduleSession.h"
 #include "mlir/Dialect/Affine/IR/AffineOps.h"
 #include "mlir/Dialect/Affine/LoopUtils.h"
+#include "mlir/Dialect/Arith/IR/Arith.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/Dialect/MemRef/IR/MemRef.h"
 #include "mlir/Dialect/Transform/IR/TransformDialect.h"
 #include "mlir/Dialect/Transform/IR/TransformInterfaces.h"
 #include "mlir/Dialect/Vector/IR/VectorOps.h"
@@ -104,6 +110,526 @@ transform::HCLPipelineOp::applyToOne(transform::TransformRewriter &rewriter,
   return DiagnosedSilenceableFailure::success();
 }
 
+//===----------------------------------------------------------------------===//
+// Schedule primitives on handles
+//===----------------------------------------------------------------------===//
+
+/// Returns the loops associated with each of `handles`, which must be one
+/// `affine.for` per handle.
+static DiagnosedSilenceableFailure
+getSingleLoops(transform::TransformOpInterface transformOp,
+               transform::TransformState &state, ValueRange handles,
+               SmallVectorImpl<affine::AffineForOp> &loops) {
+  for (Value handle : handles) {
+    auto payload = llvm::to_vector(state.getPayloadOps(handle));
+    if (payload.size() != 1 || !isa<affine::AffineForOp>(payload.front()))
+      return transformOp.emitSilenceableError()
+             << "expected each handle to be associated with one '"
+             << affine::AffineForOp::getOperationName() << "'";
+    loops.push_back(cast<affine::AffineForOp>(payload.front()));
+  }
+  return DiagnosedSilenceableFailure::success();
+}
+
+/// Returns the outermost loop of the stage `op` belongs to, i.e. the loop in
+/// the function body that carries the stage name.
+static affine::AffineForOp getStageLoop(Operation *op) {
+  affine::AffineForOp stage;
+  for (Operation *parent = op; parent && !isa<func::FuncOp>(parent);
+       parent = parent->getParentOp())
+    if (auto forOp = dyn_cast<affine::AffineForOp>(parent))
+      stage = forOp;
+  return stage;
+}
+
+/// Checks that each of `loops` is the outermost loop of its stage. The
+/// primitives which rebuild whole stages erase their outermost loops, so a
+/// consumed handle to an inner loop would leave handles to the enclosing loops
+/// dangling.
+static DiagnosedSilenceableFailure
+checkStageLoops(transform::TransformOpInterface transformOp,
+                ArrayRef<affine::AffineForOp> loops) {
+  for (affine::AffineForOp loop : loops)
+    if (loop != getStageLoop(loop))
+      return transformOp.emitSilenceableError()
+             << "expected the outermost loop of a stage";
+  return DiagnosedSilenceableFailure::success();
+}
+
+/// Removes `stage` and the ops nested in it from the payload of all handles
+/// before a primitive erases them, since the primitives don't erase through
+/// the rewriter.
+static void notifyStageErased(transform::TransformRewriter &rewriter,
+                              affine::AffineForOp stage) {
+  auto *listener =
+      dyn_cast_if_present<RewriterBase::Listener>(rewriter.getListener());
+  if (!listener)
+    return;
+  stage->walk([&](Operation *op) { listener->notifyOperationRemoved(op); });
+}
+
+namespace {
+/// Runs a schedule primitive of the loop transformation pass on payload given
+/// by handles. The primitive and the op and loop handles it takes are built
+/// from the stage and loop names of the payload before the terminator of the
+/// function, and erased once it ran.
+class SchedulePrimitiveBuilder {
+public:
+  SchedulePrimitiveBuilder(Operation *transformOp, func::FuncOp f)
+      : transformOp(transformOp), f(f),
+        builder(OpBuilder::atBlockTerminator(&f.getBody().front())) {}
+
+  ~SchedulePrimitiveBuilder() {
+    for (Operation *op : llvm::reverse(createdOps))
+      op->erase();
+  }
+
+  /// Returns an op handle to the stage of `op`.
+  FailureOr<Value> getOpHandle(Operation *op) {
+    StringAttr name;
+    if (affine::AffineForOp stage = getStageLoop(op))
+      name = stage->getAttrOfType<StringAttr>("op_name");
+    if (!name) {
+      transformOp->emitError("expected a loop of a named stage");
+      return failure();
+    }
+    auto handle = create<hcl::CreateOpHandleOp>(
+        hcl::OpHandleType::get(builder.getContext()), name);
+    return handle.getResult();
+  }
+
+  /// Returns a loop handle to `loop`.
+  FailureOr<Value> getLoopHandle(affine::AffineForOp loop) {
+    auto name = loop->getAttrOfType<StringAttr>("loop_name");
+    if (!name) {
+      transformOp->emitError("expected a named loop");
+      return failure();
+    }
+    auto opHandle = getOpHandle(loop);
+    if (failed(opHandle))
+      return failure();
+    auto handle = create<hcl::CreateLoopHandleOp>(
+        hcl::LoopHandleType::get(builder.getContext()), *opHandle, name);
+    return handle.getResult();
+  }
+
+  template <typename OpTy, typename... Args> OpTy create(Args &&...args) {
+    auto op = builder.create<OpTy>(transformOp->getLoc(),
+                                   std::forward<Args>(args)...);
+    createdOps.push_back(op);
+    return op;
+  }
+
+  /// Runs `primitive` and returns the value its `result` was replaced with,
+  /// if any.
+  FailureOr<Value> run(Operation *primitive, Value result = nullptr) {
+    // The primitives replace the uses of their result with what they create.
+    Operation *user = nullptr;
+    if (result)
+      user = create<UnrealizedConversionCastOp>(TypeRange(), result);
+    ModuleOp mod = f->getParentOfType<ModuleOp>();
+    if (failed(hcl::applyScheduleOp(mod, f, *primitive)))
+      return failure();
+    return user ? user->getOperand(0) : Value();
+  }
+
+private:
+  Operation *transformOp;
+  func::FuncOp f;
+  OpBuilder builder;
+  SmallVector<Operation *> createdOps;
+};
+} // namespace
+
+//===----------------------------------------------------------------------===//
+// HCLGetArgumentOp
+//===----------------------------------------------------------------------===//
+
+DiagnosedSilenceableFailure
+transform::HCLGetArgumentOp::apply(transform::TransformRewriter &rewriter,
+                                   transform::TransformResults &results,
+                                   transform::TransformState &state) {
+  SmallVector<Value> arguments;
+  for (Operation *target : state.getPayloadOps(getTarget())) {
+    auto func = dyn_cast<func::FuncOp>(target);
+    if (!func || func.isExternal() || getIndex() >= func.getNumArguments()) {
+      DiagnosedSilenceableFailure diag =
+          emitSilenceableError() << "expected a function with an argument #"
+                                 << getIndex();
+      diag.attachNote(target->getLoc()) << "target op";
+      return diag;
+    }
+    arguments.push_back(func.getArgument(getIndex()));
+  }
+  results.setValues(getArgument().cast<OpResult>(), arguments);
+  return DiagnosedSilenceableFailure::success();
+}
+
+//===----------------------------------------------------------------------===//
+// HCLTileOp
+//===----------------------------------------------------------------------===//
+
+LogicalResult transform::HCLTileOp::verify() {
+  if (getTileSizes().empty())
+    return emitOpError("expected at least one tile size");
+  if (llvm::any_of(getTileSizes(), [](int64_t size) { return size <= 0; }))
+    return emitOpError("expected positive tile sizes");
+  return success();
+}
+
+DiagnosedSilenceableFailure
+transform::HCLTileOp::apply(transform::TransformRewriter &rewriter,
+                            transform::TransformResults &results,
+                            transform::TransformState &state) {
+  ArrayRef<int64_t> tileSizes = getTileSizes();
+  unsigned width = tileSizes.size();
+  SmallVector<Operation *> outerLoops, innerLoops;
+  for (Operation *target : state.getPayloadOps(getTarget())) {
+    auto loop = dyn_cast<affine::AffineForOp>(target);
+    SmallVector<affine::AffineForOp, 6> band;
+    if (loop)
+      affine::getPerfectlyNestedLoops(band, loop);
+    if (band.size() < width) {
+      DiagnosedSilenceableFailure diag =
+          emitSilenceableError() << "expected a perfect nest of " << width
+                                 << " loops";
+      diag.attachNote(target->getLoc()) << "target op";
+      return diag;
+    }
+    band.resize(width);
+
+    // Tiling rebuilds the band, so the names are carried over by hand.
+    SmallVector<StringAttr, 6> loopNames;
+    for (affine::AffineForOp forOp : band)
+      loopNames.push_back(forOp->getAttrOfType<StringAttr>("loop_name"));
+    auto stageName = band.front()->getAttrOfType<StringAttr>("op_name");
+
+    SmallVector<unsigned, 6> sizes(tileSizes.begin(), tileSizes.end());
+    SmallVector<affine::AffineForOp, 6> tiledNest;
+    if (failed(affine::tilePerfectlyNested(band, sizes, &tiledNest))) {
+      Diagnostic diag(target->getLoc(), DiagnosticSeverity::Note);
+      diag << "op failed to tile";
+      return DiagnosedSilenceableFailure::silenceableFailure(std::move(diag));
+    }
+
+    MLIRContext *context = getContext();
+    for (unsigned i = 0; i < width; ++i) {
+      if (loopNames[i]) {
+        StringRef name = loopNames[i].getValue();
+        tiledNest[i]->setAttr("loop_name",
+                              StringAttr::get(context, name + ".outer"));
+        tiledNest[i + width]->setAttr(
+            "loop_name", StringAttr::get(context, name + ".inner"));
+      }
+      outerLoops.push_back(tiledNest[i]);
+      innerLoops.push_back(tiledNest[i + width]);
+    }
+    if (stageName)
+      tiledNest.front()->setAttr("op_name", stageName);
+  }
+  results.set(getOuter().cast<OpResult>(), outerLoops);
+  results.set(getInner().cast<OpResult>(), innerLoops);
+  return DiagnosedSilenceableFailure::success();
+}
+
+//===----------------------------------------------------------------------===//
+// HCLReorderOp
+//===----------------------------------------------------------------------===//
+
+LogicalResult transform::HCLReorderOp::verify() {
+  if (getLoops().size() < 2)
+    return emitOpError("expected at least two loops to reorder");
+  return success();
+}
+
+void transform::HCLReorderOp::getEffects(
+    SmallVectorImpl<MemoryEffects::EffectInstance> &effects) {
+  onlyReadsHandle(getLoops(), effects);
+  modifiesPayload(effects);
+}
+
+DiagnosedSilenceableFailure
+transform::HCLReorderOp::apply(transform::TransformRewriter &rewriter,
+                               transform::TransformResults &results,
+                               transform::TransformState &state) {
+  SmallVector<affine::AffineForOp> loops;
+  DiagnosedSilenceableFailure status =
+      getSingleLoops(*this, state, getLoops(), loops);
+  if (!status.succeeded())
+    return status;
+
+  // The nest to permute starts at the outermost of the given loops.
+  affine::AffineForOp outermost = loops.front();
+  for (affine::AffineForOp loop : loops)
+    if (loop->isProperAncestor(outermost))
+      outermost = loop;
+  SmallVector<affine::AffineForOp, 6> band;
+  affine::getPerfectlyNestedLoops(band, outermost);
+
+  // The given loops take the positions of the given loops in the given order,
+  // the other loops of the nest keep theirs.
+  SmallVector<unsigned, 6> positions;
+  for (affine::AffineForOp loop : loops) {
+    auto it = llvm::find(band, loop);
+    if (it == band.end())
+      return emitSilenceableError()
+             << "expected the loops to be in one perfect loop nest";
+    positions.push_back(it - band.begin());
+  }
+  SmallVector<unsigned, 6> slots(positions);
+  llvm::sort(slots);
+  if (std::adjacent_find(slots.begin(), slots.end()) != slots.end())
+    return emitSilenceableError() << "expected distinct loops";
+  auto permMap = llvm::to_vector<6>(llvm::seq<unsigned>(0, band.size()));
+  for (auto [position, slot] : llvm::zip(positions, slots))
+    permMap[position] = slot;
+
+  // The stage name stays on the outermost loop.
+  unsigned newOutermost = llvm::find(permMap, 0u) - permMap.begin();
+  if (auto stageName = band.front()->getAttrOfType<StringAttr>("op_name")) {
+    if (newOutermost != 0) {
+      band.front()->removeAttr("op_name");
+      band[newOutermost]->setAttr("op_name", stageName);
+    }
+  }
+  affine::permuteLoops(band, permMap);
+  return DiagnosedSilenceableFailure::success();
+}
+
+//===----------------------------------------------------------------------===//
+// HCLFuseOp
+//===----------------------------------------------------------------------===//
+
+LogicalResult transform::HCLFuseOp::verify() {
+  if (getLoops().size() < 2)
+    return emitOpError("expected at least two loops to fuse");
+  return success();
+}
+
+DiagnosedSilenceableFailure
+transform::HCLFuseOp::apply(transform::TransformRewriter &rewriter,
+                            transform::TransformResults &results,
+                            transform::TransformState &state) {
+  SmallVector<affine::AffineForOp> loops;
+  DiagnosedSilenceableFailure status =
+      getSingleLoops(*this, state, getLoops(), loops);
+  if (!status.succeeded())
+    return status;
+
+  SmallVector<affine::AffineForOp, 6> band;
+  affine::getPerfectlyNestedLoops(band, loops.front());
+  if (band.size() < loops.size() ||
+      !std::equal(loops.begin(), loops.end(), band.begin()))
+    return emitSilenceableError() << "expected perfectly nested loops from the "
+                                     "outermost to the innermost";
+
+  std::string fusedName;
+  for (affine::AffineForOp loop : loops)
+    if (auto name = loop->getAttrOfType<StringAttr>("loop_name"))
+      fusedName += name.getValue().str() + "_";
+  fusedName += "fused";
+
+  // The outermost loop is kept and carries the fused iteration space.
+  if (failed(hcl::coalesceLoops(loops, getStageLoop(loops.front())))) {
+    Diagnostic diag(loops.front()->getLoc(), DiagnosticSeverity::Note);
+    diag << "op failed to fuse, the loops must be normalized and have "
+            "constant bounds";
+    return DiagnosedSilenceableFailure::silenceableFailure(std::move(diag));
+  }
+  loops.front()->setAttr("loop_name",
+                         StringAttr::get(getContext(), fusedName));
+  SmallVector<Operation *> fused = {loops.front()};
+  results.set(getFused().cast<OpResult>(), fused);
+  return DiagnosedSilenceableFailure::success();
+}
+
+//===----------------------------------------------------------------------===//
+// HCLComputeAtOp
+//===----------------------------------------------------------------------===//
+
+DiagnosedSilenceableFailure
+transform::HCLComputeAtOp::apply(transform::TransformRewriter &rewriter,
+                                 transform::TransformResults &results,
+                                 transform::TransformState &state) {
+  SmallVector<affine::AffineForOp> loops;
+  DiagnosedSilenceableFailure status =
+      getSingleLoops(*this, state, {getProducer(), getAxis()}, loops);
+  if (!status.succeeded())
+    return status;
+  affine::AffineForOp producer = loops[0], axis = loops[1];
+  status = checkStageLoops(*this, producer);
+  if (!status.succeeded())
+    return status;
+  auto f = axis->getParentOfType<func::FuncOp>();
+  if (producer->getParentOfType<func::FuncOp>() != f)
+    return emitSilenceableError()
+           << "expected the producer and the axis in the same function";
+
+  SchedulePrimitiveBuilder builder(*this, f);
+  auto producerHandle = builder.getOpHandle(producer);
+  auto consumerHandle = builder.getOpHandle(axis);
+  auto axisHandle = builder.getLoopHandle(axis);
+  if (failed(producerHandle) || failed(consumerHandle) || failed(axisHandle))
+    return DiagnosedSilenceableFailure::definiteFailure();
+  auto computeAt = builder.create<hcl::ComputeAtOp>(
+      *producerHandle, *consumerHandle, *axisHandle);
+  // The consumer stage is rebuilt around the axis, which may be an inner loop.
+  notifyStageErased(rewriter, getStageLoop(axis));
+  if (failed(builder.run(computeAt)))
+    return DiagnosedSilenceableFailure::definiteFailure();
+  return DiagnosedSilenceableFailure::success();
+}
+
+//===----------------------------------------------------------------------===//
+// HCLPartitionOp
+//===----------------------------------------------------------------------===//
+
+LogicalResult transform::HCLPartitionOp::verify() {
+  if (!getFactor() &&
+      getPartitionKind() != hcl::PartitionKindEnum::CompletePartition)
+    return emitOpError("expected a factor for a block or cyclic partition");
+  return success();
+}
+
+void transform::HCLPartitionOp::getEffects(
+    SmallVectorImpl<MemoryEffects::EffectInstance> &effects) {
+  onlyReadsHandle(getTarget(), effects);
+  modifiesPayload(effects);
+}
+
+DiagnosedSilenceableFailure
+transform::HCLPartitionOp::apply(transform::TransformRewriter &rewriter,
+                                 transform::TransformResults &results,
+                                 transform::TransformState &state) {
+  int factor = getFactor() ? (int)*getFactor() : -1;
+  for (Value array : state.getPayloadValues(getTarget())) {
+    auto f = array.getParentRegion()->getParentOfType<func::FuncOp>();
+    if (!array.getType().isa<MemRefType>() || !f)
+      return emitSilenceableError() << "expected a memref in a function";
+    if (failed(hcl::partitionArray(f, array, getPartitionKind(), getDim(),
+                                   factor, *this)))
+      return DiagnosedSilenceableFailure::definiteFailure();
+  }
+  return DiagnosedSilenceableFailure::success();
+}
+
+//===----------------------------------------------------------------------===//
+// HCLReuseAtOp and HCLBufferAtOp
+//===----------------------------------------------------------------------===//
+
+/// Creates a buffer of each memref of `target` at the loop of `axis` with the
+/// schedule primitive `PrimitiveOp`.
+template <typename PrimitiveOp>
+static DiagnosedSilenceableFailure
+applyBufferPrimitive(transform::TransformOpInterface transformOp,
+                     transform::TransformState &state, Value target,
+                     Value axis, SmallVectorImpl<Value> &buffers) {
+  SmallVector<affine::AffineForOp> loops;
+  DiagnosedSilenceableFailure status =
+      getSingleLoops(transformOp, state, axis, loops);
+  if (!status.succeeded())
+    return status;
+  auto f = loops.front()->getParentOfType<func::FuncOp>();
+  SchedulePrimitiveBuilder builder(transformOp, f);
+  auto axisHandle = builder.getLoopHandle(loops.front());
+  if (failed(axisHandle))
+    return DiagnosedSilenceableFailure::definiteFailure();
+  for (Value array : state.getPayloadValues(target)) {
+    if (!array.getType().isa<MemRefType>() ||
+        array.getParentRegion()->getParentOfType<func::FuncOp>() != f)
+      return transformOp.emitSilenceableError()
+             << "expected a memref in the function of the axis";
+    auto primitive =
+        builder.create<PrimitiveOp>(array.getType(), array, *axisHandle);
+    auto buffer = builder.run(primitive, primitive.getResult());
+    if (failed(buffer))
+      return DiagnosedSilenceableFailure::definiteFailure();
+    buffers.push_back(*buffer);
+  }
+  return DiagnosedSilenceableFailure::success();
+}
+
+void transform::HCLReuseAtOp::getEffects(
+    SmallVectorImpl<MemoryEffects::EffectInstance> &effects) {
+  onlyReadsHandle(getTarget(), effects);
+  consumesHandle(getAxis(), effects);
+  producesHandle(getBuffer(), effects);
+  modifiesPayload(effects);
+}
+
+DiagnosedSilenceableFailure
+transform::HCLReuseAtOp::apply(transform::TransformRewriter &rewriter,
+                               transform::TransformResults &results,
+                               transform::TransformState &state) {
+  SmallVector<Value> buffers;
+  DiagnosedSilenceableFailure status = applyBufferPrimitive<hcl::ReuseAtOp>(
+      *this, state, getTarget(), getAxis(), buffers);
+  if (!status.succeeded())
+    return status;
+  results.setValues(getBuffer().cast<OpResult>(), buffers);
+  return DiagnosedSilenceableFailure::success();
+}
+
+void transform::HCLBufferAtOp::getEffects(
+    SmallVectorImpl<MemoryEffects::EffectInstance> &effects) {
+  onlyReadsHandle(getTarget(), effects);
+  onlyReadsHandle(getAxis(), effects);
+  producesHandle(getBuffer(), effects);
+  modifiesPayload(effects);
+}
+
+DiagnosedSilenceableFailure
+transform::HCLBufferAtOp::apply(transform::TransformRewriter &rewriter,
+                                transform::TransformResults &results,
+                                transform::TransformState &state) {
+  SmallVector<Value> buffers;
+  DiagnosedSilenceableFailure status = applyBufferPrimitive<hcl::BufferAtOp>(
+      *this, state, getTarget(), getAxis(), buffers);
+  if (!status.succeeded())
+    return status;
+  results.setValues(getBuffer().cast<OpResult>(), buffers);
+  return DiagnosedSilenceableFailure::success();
+}
+
+//===----------------------------------------------------------------------===//
+// HCLOutlineOp
+//===----------------------------------------------------------------------===//
+
+LogicalResult transform::HCLOutlineOp::verify() {
+  if (getStages().empty())
+    return emitOpError("expected at least one stage to outline");
+  return success();
+}
+
+DiagnosedSilenceableFailure
+transform::HCLOutlineOp::apply(transform::TransformRewriter &rewriter,
+                               transform::TransformResults &results,
+                               transform::TransformState &state) {
+  SmallVector<affine::AffineForOp> loops;
+  DiagnosedSilenceableFailure status =
+      getSingleLoops(*this, state, getStages(), loops);
+  if (!status.succeeded())
+    return status;
+  status = checkStageLoops(*this, loops);
+  if (!status.succeeded())
+    return status;
+  auto f = loops.front()->getParentOfType<func::FuncOp>();
+  SchedulePrimitiveBuilder builder(*this, f);
+  SmallVector<Value> stageHandles;
+  for (affine::AffineForOp loop : loops) {
+    if (loop->getParentOfType<func::FuncOp>() != f)
+      return emitSilenceableError() << "expected stages of one function";
+    auto handle = builder.getOpHandle(loop);
+    if (failed(handle))
+      return DiagnosedSilenceableFailure::definiteFailure();
+    stageHandles.push_back(*handle);
+  }
+  auto outline = builder.create<hcl::OutlineOp>(stageHandles);
+  if (failed(builder.run(outline)))
+    return DiagnosedSilenceableFailure::definiteFailure();
+  return DiagnosedSilenceableFailure::success();
+}
+
 //===----------------------------------------------------------------------===//
 // Transform op registration
 //===----------------------------------------------------------------------===//
@@ -116,6 +642,10 @@ public:
   HCLTransformDialectExtension() {
     declareDependentDialect<affine::AffineDialect>();
     declareDependentDialect<func::FuncDialect>();
+    // The schedule primitives and the buffers they create
+    declareGeneratedDialect<hcl::HeteroCLDialect>();
+    declareGeneratedDialect<arith::ArithDialect>();
+    declareGeneratedDialect<memref::MemRefDialect>();
     registerTransformOps<
 #define GET_OP_LIST
 #include "hcl/Dialect/TransformOps/HCLTransformOps.cpp.inc"
@@ -0,0 +1,116 @@
+/*
+ * Copyright HeteroCL authors. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "hcl/Support/Profile.h"
+
+#include "mlir/Dialect/Affine/IR/AffineOps.h"
+#include "mlir/Dialect/SCF/IR/SCF.h"
+
+#include "llvm/Support/FormatVariadic.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace mlir;
+using namespace hcl;
+
+/// Returns the name of the stage holding `op`, which the outermost loop of the
+/// stage carries as "op_name".
+static StringRef getStageName(Operation *op) {
+  StringRef stage;
+  for (Operation *parent = op; parent && !isa<func::FuncOp>(parent);
+       parent = parent->getParentOp())
+    if (auto name = parent->getAttrOfType<StringAttr>("op_name"))
+      stage = name.getValue();
+  return stage;
+}
+
+void hcl::getProfileSites(func::FuncOp func,
+                          SmallVectorImpl<ProfileSite> &sites) {
+  std::map<std::string, unsigned> numIfs;
+  func.walk<WalkOrder::PreOrder>([&](Operation *op) {
+    std::string prefix =
+        (func.getName() + "/" + getStageName(op) + "/").str();
+    if (isa<affine::AffineForOp, scf::ForOp>(op)) {
+      if (auto name = op->getAttrOfType<StringAttr>("loop_name"))
+        sites.push_back({op, prefix + name.getValue().str(), true});
+    } else if (isa<affine::AffineIfOp, scf::IfOp>(op)) {
+      unsigned index = numIfs[prefix]++;
+      sites.push_back({op, prefix + "if" + std::to_string(index), false});
+    }
+  });
+}
+
+LogicalResult hcl::readProfile(StringRef path, Profile &profile,
+                               std::string &error) {
+  auto buffer = llvm::MemoryBuffer::getFile(path);
+  if (!buffer) {
+    error = "cannot open " + path.str() + ": " + buffer.getError().message();
+    return failure();
+  }
+  auto json = llvm::json::parse((*buffer)->getBuffer());
+  if (!json) {
+    error = "cannot parse " + path.str() + ": " +
+            llvm::toString(json.takeError());
+    return failure();
+  }
+  auto *root = json->getAsObject();
+  if (!root) {
+    error = path.str() + ": expected a JSON object";
+    return failure();
+  }
+  auto getInt = [](const llvm::json::Object *object, StringRef name) {
+    return object->getInteger(name).value_or(0);
+  };
+  if (auto *loops = root->getObject("loops"))
+    for (auto &entry : *loops)
+      if (auto *loop = entry.second.getAsObject())
+        profile.loops[entry.first.str()] = {
+            getInt(loop, "entries"), getInt(loop, "iterations"),
+            getInt(loop, "min"), getInt(loop, "max")};
+  if (auto *branches = root->getObject("branches"))
+    for (auto &entry : *branches)
+      if (auto *branch = entry.second.getAsObject())
+        profile.branches[entry.first.str()] = {getInt(branch, "executions"),
+                                               getInt(branch, "taken")};
+  return success();
+}
+
+LogicalResult hcl::writeProfile(StringRef path, const Profile &profile,
+                                std::string &error) {
+  llvm::json::Object loops, branches;
+  for (auto &[key, loop] : profile.loops)
+    loops[key] = llvm::json::Object{{"entries", loop.entries},
+                                    {"iterations", loop.iterations},
+                                    {"min", loop.minTripCount},
+                                    {"max", loop.maxTripCount}};
+  for (auto &[key, branch] : profile.branches)
+    branches[key] = llvm::json::Object{{"executions", branch.executions},
+                                       {"taken", branch.taken}};
+  llvm::json::Object root{{"loops", std::move(loops)},
+                          {"branches", std::move(branches)}};
+
+  std::error_code ec;
+  llvm::raw_fd_ostream os(path, ec);
+  if (ec) {
+    error = "cannot write " + path.str() + ": " + ec.message();
+    return failure();
+  }
+  os << llvm::formatv("{0:2}", llvm::json::Value(std::move(root))) << "\n";
+  return success();
+}
+
+std::optional<int64_t> hcl::getProfiledTripCount(Operation *loop) {
+  auto tripCount = loop->getAttrOfType<DenseI64ArrayAttr>("tripcount");
+  if (!tripCount || tripCount.size() != 3)
+    return std::nullopt;
+  return tripCount[2];
+}
+
+std::optional<double> hcl::getBranchTakenRate(Operation *ifOp) {
+  if (auto rate = ifOp->getAttrOfType<FloatAttr>("taken_rate"))
+    return rate.getValueAsDouble();
+  return std::nullopt;
+}
@@ -7,6 +7,7 @@
 
 #include "hcl/Support/Utils.h"
 #include "hcl/Dialect/HeteroCLTypes.h"
+#include "hcl/Support/Profile.h"
 #include "mlir/Dialect/Affine/IR/AffineOps.h"
 #include "mlir/Dialect/Affine/Utils.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
@@ -498,6 +499,8 @@ void hcl::getArrays(Block &block, SmallVectorImpl<Value> &arrays,
 std::optional<unsigned> hcl::getAverageTripCount(AffineForOp forOp) {
   if (auto optionalTripCount = getConstantTripCount(forOp))
     return optionalTripCount.value();
+  else if (auto profiledTripCount = getProfiledTripCount(forOp))
+    return profiledTripCount.value();
   else {
     // TODO: A temporary approach to estimate the trip count. For now, we take
     // the average of the upper bound and lower bound of trip count as the
@@ -0,0 +1,235 @@
+/*
+ * Copyright HeteroCL authors. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//===----------------------------------------------------------------------===//
+// CastChainElimination Pass
+// The lowering passes each insert the integer conversions they need, which
+// leaves chains such as trunci(extsi(x)) or extsi(extui(x)) in the IR. This
+// pass collapses two consecutive integer casts into at most one whenever that
+// is exact, folds chained fixed-point casts, and hoists casts of loop-invariant
+// values out of their loops.
+//
+// An index is treated as a 64-bit integer, which index_cast sign-extends or
+// truncates and index_castui zero-extends or truncates to.
+//===----------------------------------------------------------------------===//
+
+#include "PassDetail.h"
+
+#include "hcl/Dialect/HeteroCLDialect.h"
+#include "hcl/Dialect/HeteroCLOps.h"
+#include "hcl/Transforms/Passes.h"
+
+#include "mlir/Dialect/Arith/IR/Arith.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/Interfaces/LoopLikeInterface.h"
+#include "mlir/Transforms/GreedyPatternRewriteDriver.h"
+
+using namespace mlir;
+using namespace hcl;
+
+namespace {
+enum class CastKind { SExt, ZExt, Trunc };
+
+/// An integer conversion of `input`. Casts between an index and a 64-bit
+/// integer are not extensions nor truncations and have no kind.
+struct IntCast {
+  Value input;
+  std::optional<CastKind> kind;
+};
+} // namespace
+
+static unsigned getIntWidth(Type type) {
+  if (type.isIndex())
+    return IndexType::kInternalStorageBitWidth;
+  return type.getIntOrFloatBitWidth();
+}
+
+static bool isScalarInt(Type type) {
+  return type.isIndex() || type.isa<IntegerType>();
+}
+
+static std::optional<IntCast> matchIntCast(Operation *op) {
+  if (!op || op->getNumOperands() != 1 || op->getNumResults() != 1)
+    return std::nullopt;
+  Value input = op->getOperand(0);
+  if (!isScalarInt(input.getType()) ||
+      !isScalarInt(op->getResult(0).getType()))
+    return std::nullopt;
+  unsigned inWidth = getIntWidth(input.getType());
+  unsigned outWidth = getIntWidth(op->getResult(0).getType());
+  std::optional<CastKind> extKind;
+  if (isa<arith::ExtSIOp, arith::IndexCastOp>(op))
+    extKind = CastKind::SExt;
+  else if (isa<arith::ExtUIOp, arith::IndexCastUIOp>(op))
+    extKind = CastKind::ZExt;
+  else if (!isa<arith::TruncIOp>(op))
+    return std::nullopt;
+  if (outWidth > inWidth)
+    return IntCast{input, extKind};
+  if (outWidth < inWidth)
+    return IntCast{input, CastKind::Trunc};
+  return IntCast{input, std::nullopt};
+}
+
+/// Returns the kind of a single cast from `inWidth` to `outWidth` bits that is
+/// equivalent to casting with `inner`, then with `outer`. Returns std::nullopt
+/// if there is none, and a null kind for the identity.
+static std::optional<std::optional<CastKind>>
+composeCasts(std::optional<CastKind> inner, std::optional<CastKind> outer,
+             unsigned inWidth, unsigned outWidth) {
+  if (!inner)
+    return outer;
+  if (!outer)
+    return inner;
+  if (*inner == CastKind::Trunc) {
+    // The bits a truncation drops cannot be extended back.
+    if (*outer == CastKind::Trunc)
+      return inner;
+    return std::nullopt;
+  }
+  if (*outer == CastKind::Trunc) {
+    // trunc(ext(x)) keeps x, the low bits of x, or the low bits of ext(x)
+    if (outWidth == inWidth)
+      return std::optional<CastKind>();
+    if (outWidth < inWidth)
+      return outer;
+    return inner;
+  }
+  // A zero-extended value has a clear sign bit, so sign-extending it further
+  // is a zero extension as well.
+  if (*inner == *outer || *inner == CastKind::ZExt)
+    return inner;
+  return std::nullopt;
+}
+
+static Value createIntCast(OpBuilder &builder, Location loc, Value input,
+                           Type type, CastKind kind) {
+  if (input.getType().isIndex() || type.isIndex()) {
+    if (kind == CastKind::ZExt)
+      return builder.create<arith::IndexCastUIOp>(loc, type, input);
+    return builder.create<arith::IndexCastOp>(loc, type, input);
+  }
+  switch (kind) {
+  case CastKind::SExt:
+    return builder.create<arith::ExtSIOp>(loc, type, input);
+  case CastKind::ZExt:
+    return builder.create<arith::ExtUIOp>(loc, type, input);
+  case CastKind::Trunc:
+    return builder.create<arith::TruncIOp>(loc, type, input);
+  }
+  llvm_unreachable("unknown cast kind");
+}
+
+namespace {
+/// Replaces a cast of a cast by a single cast of the original value.
+template <typename OpTy>
+struct CollapseIntCastChain : public OpRewritePattern<OpTy> {
+  using OpRewritePattern<OpTy>::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(OpTy op,
+                                PatternRewriter &rewriter) const override {
+    auto outer = matchIntCast(op);
+    if (!outer)
+      return failure();
+    auto inner = matchIntCast(outer->input.getDefiningOp());
+    if (!inner)
+      return failure();
+    Value input = inner->input;
+    Type type = op.getType();
+    unsigned inWidth = getIntWidth(input.getType());
+    unsigned outWidth = getIntWidth(type);
+    auto kind = composeCasts(inner->kind, outer->kind, inWidth, outWidth);
+    if (!kind)
+      return failure();
+    if (input.getType() == type) {
+      rewriter.replaceOp(op, input);
+      return success();
+    }
+    // Only an index and a 64-bit integer differ without an extension or a
+    // truncation, and index_cast converts between them.
+    CastKind castKind = kind->value_or(CastKind::SExt);
+    rewriter.replaceOp(
+        op, createIntCast(rewriter, op.getLoc(), input, type, castKind));
+    return success();
+  }
+};
+} // namespace
+
+static bool isCastOp(Operation *op) {
+  return isa<arith::ExtSIOp, arith::ExtUIOp, arith::TruncIOp,
+             arith::IndexCastOp, arith::IndexCastUIOp, arith::SIToFPOp,
+             arith::UIToFPOp, arith::FPToSIOp, arith::FPToUIOp,
+             arith::ExtFOp, arith::TruncFOp, IntToFixedOp, FixedToIntOp,
+             FixedToFixedOp, FixedToFloatOp, FloatToFixedOp>(op);
+}
+
+/// Moves casts whose input does not change across the iterations of their
+/// loops before the outermost such loop.
+static void hoistInvariantCasts(func::FuncOp func) {
+  SmallVector<Operation *, 8> castOps;
+  func.walk([&](Operation *op) {
+    if (isCastOp(op))
+      castOps.push_back(op);
+  });
+  for (Operation *op : castOps) {
+    while (auto loop = dyn_cast<LoopLikeOpInterface>(op->getParentOp())) {
+      if (!loop.isDefinedOutsideOfLoop(op->getOperand(0)))
+        break;
+      loop.moveOutOfLoop(op);
+    }
+  }
+}
+
+namespace mlir {
+namespace hcl {
+
+/// Pass entry point
+bool applyCastChainElimination(ModuleOp &mod) {
+  MLIRContext *ctx = mod.getContext();
+  RewritePatternSet patterns(ctx);
+  patterns.add<CollapseIntCastChain<arith::ExtSIOp>,
+               CollapseIntCastChain<arith::ExtUIOp>,
+               CollapseIntCastChain<arith::TruncIOp>,
+               CollapseIntCastChain<arith::IndexCastOp>,
+               CollapseIntCastChain<arith::IndexCastUIOp>>(ctx);
+  FrozenRewritePatternSet frozenPatterns(std::move(patterns));
+  for (func::FuncOp func : mod.getOps<func::FuncOp>()) {
+    // The casts are collected up front, so that only they are rewritten or
+    // folded (e.g. fixed_to_fixed chains) and the rest of the IR is left as is.
+    SmallVector<Operation *, 16> castOps;
+    func.walk([&](Operation *op) {
+      if (isCastOp(op))
+        castOps.push_back(op);
+    });
+    GreedyRewriteConfig config;
+    config.strictMode = GreedyRewriteStrictness::ExistingAndNewOps;
+    (void)applyOpPatternsAndFold(castOps, frozenPatterns, config);
+    hoistInvariantCasts(func);
+  }
+  return true;
+}
+} // namespace hcl
+} // namespace mlir
+
+namespace {
+struct HCLCastChainEliminationTransformation
+    : public CastChainEliminationBase<HCLCastChainEliminationTransformation> {
+  void runOnOperation() override {
+    auto mod = getOperation();
+    if (!applyCastChainElimination(mod)) {
+      return signalPassFailure();
+    }
+  }
+};
+} // namespace
+
+namespace mlir {
+namespace hcl {
+
+std::unique_ptr<OperationPass<ModuleOp>> createCastChainEliminationPass() {
+  return std::make_unique<HCLCastChainEliminationTransformation>();
+}
+} // namespace hcl
+} // namespace mlir
@@ -8,17 +8,30 @@
 #include "hcl/Dialect/HeteroCLDialect.h"
 #include "hcl/Dialect/HeteroCLOps.h"
 #include "hcl/Dialect/HeteroCLTypes.h"
+#include "hcl/Support/Profile.h"
 #include "hcl/Support/Utils.h"
 #include "hcl/Transforms/Passes.h"
+#include "hcl/Transforms/ScheduleSession.h"
 
+#include "mlir/Dialect/Affine/Analysis/LoopAnalysis.h"
 #include "mlir/Dialect/Affine/IR/AffineOps.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
 #include "mlir/Dialect/MemRef/IR/MemRef.h"
 #include "mlir/Dialect/SCF/IR/SCF.h"
+#include "mlir/Dialect/Utils/StaticValueUtils.h"
 
+#include "llvm/ADT/SetVector.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/Debug.h"
+
+#include <cmath>
+#include <deque>
+#include <limits>
 #include <map>
 #include <set>
 
+#define DEBUG_TYPE "data-placement"
+
 using namespace mlir;
 using namespace hcl;
 
@@ -28,40 +41,48 @@ namespace hcl {
 class Node {
   // Member variables
   Operation *op;
+  // position of the node in its graph, in program order
+  unsigned id;
   DeviceEnum device = DeviceEnum::UnknownDevice;
-  std::vector<Node *> upstream;
-  std::vector<Node *> downstream;
-  std::vector<Operation *> consumedMemRefs;
-  std::vector<Operation *> producedMemRefs;
+  bool pinned = false;
+  llvm::SmallSetVector<Node *, 4> upstream;
+  llvm::SmallSetVector<Node *, 4> downstream;
+  SmallVector<Value, 4> consumedMemRefs;
+  SmallVector<Value, 4> producedMemRefs;
 
 public:
-  Node(Operation *op) : op(op) {}
-  void addUpstream(Node *node) { upstream.push_back(node); }
-  void addDownstream(Node *node) { downstream.push_back(node); }
-  void addConsumedMemRef(Operation *memRef) {
-    consumedMemRefs.push_back(memRef);
-  }
-  void addProducedMemRef(Operation *memRef) {
-    producedMemRefs.push_back(memRef);
-  }
-  std::vector<Node *> getUpstream() { return this->upstream; }
-  std::vector<Node *> getDownstream() { return this->downstream; }
+  Node(Operation *op, unsigned id) : op(op), id(id) {}
+  Operation *getOperation() { return this->op; }
+  unsigned getId() { return this->id; }
+  void addUpstream(Node *node) { upstream.insert(node); }
+  void addDownstream(Node *node) { downstream.insert(node); }
+  void addConsumedMemRef(Value memRef) { consumedMemRefs.push_back(memRef); }
+  void addProducedMemRef(Value memRef) { producedMemRefs.push_back(memRef); }
+  ArrayRef<Node *> getUpstream() { return this->upstream.getArrayRef(); }
+  ArrayRef<Node *> getDownstream() { return this->downstream.getArrayRef(); }
   DeviceEnum getDevice() { return this->device; }
   void setDevice(DeviceEnum device) { this->device = device; }
-  std::vector<Operation *> getConsumedMemRefs() { return consumedMemRefs; }
-  void print() {
-    llvm::outs() << "Node: " << this->getName();
-    llvm::outs() << " [" << this->getDeviceName() << "]\n";
-    llvm::outs() << "  Upstream: ";
+  // A pinned node was placed by hcl.host_xcel_to and keeps its device
+  bool isPinned() { return this->pinned; }
+  void pin(DeviceEnum device) {
+    this->device = device;
+    this->pinned = true;
+  }
+  ArrayRef<Value> getConsumedMemRefs() { return consumedMemRefs; }
+  ArrayRef<Value> getProducedMemRefs() { return producedMemRefs; }
+  void print(raw_ostream &os) {
+    os << "Node: " << this->getName();
+    os << " [" << this->getDeviceName() << "]\n";
+    os << "  Upstream: ";
     for (auto node : this->upstream) {
-      llvm::outs() << node->getName() << " ";
+      os << node->getName() << " ";
     }
-    llvm::outs() << "\n";
-    llvm::outs() << "  Downstream: ";
+    os << "\n";
+    os << "  Downstream: ";
     for (auto node : this->downstream) {
-      llvm::outs() << node->getName() << " ";
+      os << node->getName() << " ";
     }
-    llvm::outs() << "\n";
+    os << "\n";
   }
   std::string getName() {
     // check if "op_name" attribute exists
@@ -87,126 +108,426 @@ public:
   }
 };
 
+/// A dependence between two nodes through a memref
+struct Edge {
+  Node *src;
+  Node *dst;
+  Value memRef;
+};
+
+//===----------------------------------------------------------------------===//
+// Cost model
+//
+// All costs are in host cycles. On the host, every operation takes a cycle per
+// iteration of the loops around it. On the accelerator, a pipelined loop
+// starts an iteration every II cycles, unrolling divides the trip count of a
+// loop, and the operations of a block run one after the other; accelerator
+// cycles are then scaled by `fpgaCycleCost`. Moving a memref between the
+// devices costs `transferCost` per byte. Profiled trip counts stand in for
+// non-constant ones, and profiled ifs weigh their regions by how often they
+// run.
+//===----------------------------------------------------------------------===//
+
+static bool isLoop(Operation &op) {
+  return isa<AffineForOp>(op) || isa<scf::ForOp>(op);
+}
+
+/// Returns the number of iterations of a loop, or 1 if it is neither a
+/// constant nor profiled.
+static double getTripCount(Operation &loop) {
+  if (auto forOp = dyn_cast<AffineForOp>(loop)) {
+    if (auto tripCount = getConstantTripCount(forOp))
+      return *tripCount;
+  } else if (auto forOp = dyn_cast<scf::ForOp>(loop)) {
+    auto lb = getConstantIntValue(forOp.getLowerBound());
+    auto ub = getConstantIntValue(forOp.getUpperBound());
+    auto step = getConstantIntValue(forOp.getStep());
+    if (lb && ub && step && *step > 0)
+      return *ub > *lb ? (*ub - *lb + *step - 1) / *step : 0;
+  }
+  if (auto tripCount = getProfiledTripCount(&loop))
+    return *tripCount;
+  return 1;
+}
+
+/// Returns how often region `index` of `op` runs when `op` does. Both regions
+/// of an if count fully unless the if is profiled, which bounds its latency.
+static double getRegionWeight(Operation &op, unsigned index) {
+  if (auto rate = getBranchTakenRate(&op))
+    return index == 0 ? *rate : 1 - *rate;
+  return 1;
+}
+
+static double getHostLatency(Block &block);
+static double getXcelLatency(Block &block);
+
+static double getHostLoopLatency(Operation &loop) {
+  return getTripCount(loop) * getHostLatency(loop.getRegion(0).front());
+}
+
+static double getXcelLoopLatency(Operation &loop) {
+  double tripCount = getTripCount(loop);
+  if (auto factor = loop.getAttrOfType<IntegerAttr>("unroll")) {
+    // a factor of 0 unrolls the loop completely
+    int64_t unroll = factor.getInt();
+    tripCount = unroll == 0 ? 1 : std::ceil(tripCount / unroll);
+  }
+  double bodyLatency = getXcelLatency(loop.getRegion(0).front());
+  if (auto ii = loop.getAttrOfType<IntegerAttr>("pipeline_ii"))
+    return tripCount * ii.getInt() + bodyLatency;
+  return tripCount * bodyLatency;
+}
+
+static double getHostLatency(Block &block) {
+  double latency = 0;
+  for (Operation &op : block) {
+    if (op.hasTrait<OpTrait::IsTerminator>())
+      continue;
+    if (isLoop(op)) {
+      latency += getHostLoopLatency(op);
+      continue;
+    }
+    latency += 1;
+    for (Region &region : op.getRegions())
+      for (Block &nested : region)
+        latency += getRegionWeight(op, region.getRegionNumber()) *
+                   getHostLatency(nested);
+  }
+  return latency;
+}
+
+static double getXcelLatency(Block &block) {
+  double latency = 0;
+  for (Operation &op : block) {
+    if (op.hasTrait<OpTrait::IsTerminator>())
+      continue;
+    if (isLoop(op)) {
+      latency += getXcelLoopLatency(op);
+      continue;
+    }
+    latency += 1;
+    for (Region &region : op.getRegions())
+      for (Block &nested : region)
+        latency += getRegionWeight(op, region.getRegionNumber()) *
+                   getXcelLatency(nested);
+  }
+  return latency;
+}
+
+/// Returns the size of a memref in bytes, counting dynamic sizes as 1.
+static double getMemRefBytes(Value memRef) {
+  auto type = memRef.getType().cast<MemRefType>();
+  double numElements = 1;
+  for (int64_t size : type.getShape())
+    if (!ShapedType::isDynamic(size))
+      numElements *= size;
+  Type elementType = type.getElementType();
+  unsigned bitwidth = 32;
+  if (elementType.isIntOrFloat())
+    bitwidth = elementType.getIntOrFloatBitWidth();
+  else if (auto fixedType = elementType.dyn_cast<FixedType>())
+    bitwidth = fixedType.getWidth();
+  else if (auto ufixedType = elementType.dyn_cast<UFixedType>())
+    bitwidth = ufixedType.getWidth();
+  return numElements * ((bitwidth + 7) / 8);
+}
+
+namespace {
+/// Minimum s-t cut of a graph, by augmenting along shortest paths
+class MinCut {
+  struct Arc {
+    unsigned to;
+    double capacity;
+  };
+  std::vector<Arc> arcs;
+  std::vector<std::vector<unsigned>> adjacency;
+
+public:
+  MinCut(unsigned numNodes) : adjacency(numNodes) {}
+
+  void addArc(unsigned from, unsigned to, double capacity,
+              double reverseCapacity = 0) {
+    adjacency[from].push_back(arcs.size());
+    arcs.push_back({to, capacity});
+    adjacency[to].push_back(arcs.size());
+    arcs.push_back({from, reverseCapacity});
+  }
+
+  /// Returns whether each node is on the source side of a minimum cut
+  std::vector<bool> solve(unsigned source, unsigned sink) {
+    const double epsilon = 1e-9;
+    std::vector<int> parentArc(adjacency.size());
+    auto search = [&]() {
+      std::fill(parentArc.begin(), parentArc.end(), -1);
+      std::vector<bool> visited(adjacency.size(), false);
+      std::deque<unsigned> worklist{source};
+      visited[source] = true;
+      while (!worklist.empty()) {
+        unsigned node = worklist.front();
+        worklist.pop_front();
+        for (unsigned arc : adjacency[node]) {
+          unsigned next = arcs[arc].to;
+          if (visited[next] || arcs[arc].capacity <= epsilon)
+            continue;
+          visited[next] = true;
+          parentArc[next] = arc;
+          worklist.push_back(next);
+        }
+      }
+      return visited;
+    };
+    while (search()[sink]) {
+      // the reverse of an arc is its neighbor and points at its tail
+      double flow = std::numeric_limits<double>::infinity();
+      for (unsigned node = sink; node != source;
+           node = arcs[parentArc[node] ^ 1].to)
+        flow = std::min(flow, arcs[parentArc[node]].capacity);
+      for (unsigned node = sink; node != source;
+           node = arcs[parentArc[node] ^ 1].to) {
+        arcs[parentArc[node]].capacity -= flow;
+        arcs[parentArc[node] ^ 1].capacity += flow;
+      }
+    }
+    return search();
+  }
+};
+} // namespace
+
+/// The nodes are owned by the graph and stay at the same address when the
+/// graph is moved. Producers and consumers are indexed by memref, so building
+/// the graph and looking up the nodes touching a memref take linear and
+/// constant time respectively.
 class DataFlowGraph {
   // Member variables
-  std::map<std::string, Node *> nodeMap;
+  std::deque<Node> nodes;
+  llvm::StringMap<Node *> nodeMap;
+  llvm::DenseMap<Value, SmallVector<Node *, 2>> producers;
+  llvm::DenseMap<Value, SmallVector<Node *, 2>> consumers;
+  std::vector<Edge> edges;
 
 public:
-  void addNode(Node *node) { this->nodeMap[node->getName()] = node; }
-  void addEdge(Node *src, Node *dst) {
+  DataFlowGraph() = default;
+  DataFlowGraph(DataFlowGraph &&) = default;
+  DataFlowGraph &operator=(DataFlowGraph &&) = default;
+  DataFlowGraph(const DataFlowGraph &) = delete;
+  DataFlowGraph &operator=(const DataFlowGraph &) = delete;
+
+  Node *addNode(Operation *op) {
+    Node *node = &this->nodes.emplace_back(op, this->nodes.size());
+    this->nodeMap[node->getName()] = node;
+    return node;
+  }
+  void addEdge(Node *src, Node *dst, Value memRef) {
     src->addDownstream(dst);
     dst->addUpstream(src);
+    this->edges.push_back({src, dst, memRef});
   }
-  Node *getNode(std::string name) { return this->nodeMap[name]; }
-  void getNodeByConsumedMemRef(Operation *memRef,
-                               std::vector<Node *> &consumerNodes) {
-    for (auto node : this->nodeMap) {
-      for (auto consumedMemRef : node.second->getConsumedMemRefs()) {
-        if (consumedMemRef == memRef) {
-          consumerNodes.push_back(node.second);
-        }
-      }
-    }
+  void addConsumedMemRef(Node *node, Value memRef) {
+    node->addConsumedMemRef(memRef);
+    this->consumers[memRef].push_back(node);
+  }
+  void addProducedMemRef(Node *node, Value memRef) {
+    node->addProducedMemRef(memRef);
+    this->producers[memRef].push_back(node);
   }
-  void print() {
+  Node *getNode(StringRef name) { return this->nodeMap.lookup(name); }
+  ArrayRef<Node *> getNodeByConsumedMemRef(Value memRef) {
+    auto it = this->consumers.find(memRef);
+    if (it == this->consumers.end())
+      return {};
+    return it->second;
+  }
+  ArrayRef<Node *> getNodeByProducedMemRef(Value memRef) {
+    auto it = this->producers.find(memRef);
+    if (it == this->producers.end())
+      return {};
+    return it->second;
+  }
+  void print(raw_ostream &os) {
     // print the graph
-    for (auto node : this->nodeMap) {
-      node.second->print();
+    for (auto &node : this->nodes) {
+      node.print(os);
+    }
+  }
+
+  /// Returns the nodes such that every node comes after its upstream nodes.
+  /// Edges always point forward in program order, but the order is computed
+  /// from the edges rather than relied upon.
+  std::vector<Node *> getTopologicalOrder() {
+    std::vector<unsigned> numPending(this->nodes.size());
+    std::vector<Node *> order;
+    order.reserve(this->nodes.size());
+    for (auto &node : this->nodes) {
+      numPending[node.getId()] = node.getUpstream().size();
+      if (numPending[node.getId()] == 0)
+        order.push_back(&node);
+    }
+    for (unsigned i = 0; i < order.size(); ++i) {
+      for (auto downstreamNode : order[i]->getDownstream()) {
+        if (--numPending[downstreamNode->getId()] == 0)
+          order.push_back(downstreamNode);
+      }
+    }
+    // nodes on a cycle, if any, are visited in program order
+    if (order.size() != this->nodes.size()) {
+      for (auto &node : this->nodes) {
+        if (numPending[node.getId()] != 0)
+          order.push_back(&node);
+      }
     }
+    return order;
   }
 
+  /// Labels every node of unknown device with the device of its first labeled
+  /// upstream node, until no label changes. Visiting the nodes in topological
+  /// order, a single sweep reaches the fixpoint unless the graph has cycles,
+  /// so labels travel any number of hops in linear time.
   void propagateDevice() {
-    // propagate device to all nodes
-    for (auto node : this->nodeMap) {
-      // get the device of the node
-      DeviceEnum device = node.second->getDevice();
-      // propagate the device to all downstream nodes
-      for (auto downstreamNode : node.second->getDownstream()) {
-        if (downstreamNode->getDevice() == DeviceEnum::UnknownDevice) {
-          downstreamNode->setDevice(device);
+    std::vector<Node *> order = getTopologicalOrder();
+    bool changed = true;
+    while (changed) {
+      changed = false;
+      for (auto node : order) {
+        if (node->getDevice() != DeviceEnum::UnknownDevice)
+          continue;
+        for (auto upstreamNode : node->getUpstream()) {
+          if (upstreamNode->getDevice() != DeviceEnum::UnknownDevice) {
+            node->setDevice(upstreamNode->getDevice());
+            changed = true;
+            break;
+          }
         }
       }
     }
   }
 
-  void partition(ModuleOp &mod, func::FuncOp &funcOp) {
-    // partition doesn't work now because of outline op
-    // collect all nodes on FPGA
+  void annotateDevice() {
+    for (auto &node : this->nodes) {
+      if (node.getDevice() == DeviceEnum::UnknownDevice)
+        continue;
+      Operation *op = node.getOperation();
+      op->setAttr("device",
+                  StringAttr::get(op->getContext(),
+                                  ConvertToDeviceString(node.getDevice())));
+    }
+  }
+
+  /// Places the nodes that are not pinned on the host or the accelerator such
+  /// that the sum of their compute costs and the cost of the memrefs crossing
+  /// between the devices is minimal. Each memref dependence costs a transfer
+  /// when its ends are on different devices. Memrefs that no node of the
+  /// graph produces (e.g. arguments) and the outputs of the function live on
+  /// the host. This is a minimum cut between the two devices.
+  void assignDevices(double fpgaCycleCost, double transferCost) {
+    const double infinity = std::numeric_limits<double>::infinity();
+    unsigned host = nodes.size(), xcel = nodes.size() + 1;
+    MinCut cut(nodes.size() + 2);
+    auto isOutput = [](Value memRef) {
+      return memRef.isa<BlockArgument>() ||
+             llvm::any_of(memRef.getUsers(), [](Operation *user) {
+               return isa<func::ReturnOp>(user);
+             });
+    };
+    for (auto &node : nodes) {
+      Operation &op = *node.getOperation();
+      double hostCost = getHostLoopLatency(op);
+      double xcelCost = fpgaCycleCost * getXcelLoopLatency(op);
+      llvm::SetVector<Value> hostMemRefs;
+      for (auto memRef : node.getConsumedMemRefs())
+        if (!producers.count(memRef))
+          hostMemRefs.insert(memRef);
+      for (auto memRef : node.getProducedMemRefs())
+        if (isOutput(memRef))
+          hostMemRefs.insert(memRef);
+      for (auto memRef : hostMemRefs)
+        xcelCost += transferCost * getMemRefBytes(memRef);
+      // the arc from the host is cut when the node is on the accelerator
+      unsigned i = node.getId();
+      bool onHost = node.getDevice() == DeviceEnum::CPUDevice;
+      bool onXcel = node.getDevice() != DeviceEnum::CPUDevice &&
+                    node.getDevice() != DeviceEnum::UnknownDevice;
+      if (node.isPinned() && onHost)
+        xcelCost = infinity;
+      if (node.isPinned() && onXcel)
+        hostCost = infinity;
+      // Only the difference of the costs matters to the cut. Removing their
+      // common part saves an augmentation along host -> node -> xcel for
+      // every node, which keeps the cut near-linear on chains of stages.
+      double common = std::min(xcelCost, hostCost);
+      cut.addArc(host, i, xcelCost - common);
+      cut.addArc(i, xcel, hostCost - common);
+    }
+    for (auto &edge : edges) {
+      double cost = transferCost * getMemRefBytes(edge.memRef);
+      cut.addArc(edge.src->getId(), edge.dst->getId(), cost, cost);
+    }
+    std::vector<bool> hostSide = cut.solve(host, xcel);
+    for (auto &node : nodes) {
+      if (node.isPinned())
+        continue;
+      node.setDevice(hostSide[node.getId()] ? DeviceEnum::CPUDevice
+                                             : DeviceEnum::FPGADevice);
+    }
+  }
+
+  /// Outlines every maximal sequence of consecutive stages placed on the
+  /// accelerator into a kernel function.
+  LogicalResult partition(ModuleOp &mod, func::FuncOp &funcOp,
+                          SmallVector<Operation *, 10> &opToRemove) {
+    SmallVector<SmallVector<Node *>> kernels(1);
+    for (auto &node : this->nodes) {
+      bool isStage = isa<AffineForOp>(node.getOperation()) &&
+                     node.getOperation()->hasAttr("op_name");
+      bool onXcel = node.getDevice() != DeviceEnum::CPUDevice &&
+                    node.getDevice() != DeviceEnum::UnknownDevice;
+      if (isStage && onXcel) {
+        kernels.back().push_back(&node);
+      } else if (!kernels.back().empty()) {
+        kernels.push_back({});
+      }
+    }
     OpBuilder builder(funcOp.getBody().back().getTerminator());
-    std::vector<Node *> fpgaNodes;
-    std::vector<Operation *> op_handles;
-    for (auto node : this->nodeMap) {
-      if (node.second->getDevice() == DeviceEnum::FPGADevice) {
-        fpgaNodes.push_back(node.second);
-        auto op_handle = builder.create<CreateOpHandleOp>(
-            funcOp.getLoc(), node.second->getName());
-        op_handles.push_back(op_handle);
+    for (auto &kernel : kernels) {
+      if (kernel.empty())
+        continue;
+      SmallVector<Value> opHandles;
+      for (auto node : kernel) {
+        auto opHandle =
+            builder.create<CreateOpHandleOp>(funcOp.getLoc(), node->getName());
+        opHandles.push_back(opHandle);
+      }
+      auto outlineOp = builder.create<OutlineOp>(funcOp.getLoc(), opHandles);
+      opToRemove.push_back(outlineOp);
+      if (failed(applyScheduleOp(mod, funcOp, *outlineOp))) {
+        funcOp->emitError("Failed to outline the kernel function");
+        return failure();
       }
     }
-    // SmallVector<Value> op_handles_values;
-    // for (auto op_handle : op_handles) {
-    //   op_handles_values.push_back(op_handle->getResult(0));
-    // }
-    // auto outline_op = builder.create<OutlineOp>(funcOp.getLoc(),
-    // op_handles_values); if (failed(runOutline(mod, funcOp, outline_op))) {
-    //   funcOp->emitError("Failed to outline the kernel function");
-    // }
-    return;
+    return success();
   }
 };
 
-void getAllLoadedMemRefs(Operation *op, std::set<Operation *> &memRefs) {
-  SmallVector<Operation *, 8> loadOps;
+void getAllLoadedMemRefs(Operation *op, llvm::SetVector<Value> &memRefs) {
   op->walk([&](Operation *op) {
-    if (isa<AffineLoadOp>(op)) {
-      loadOps.push_back(op);
-    } else if (isa<memref::LoadOp>(op)) {
-      loadOps.push_back(op);
+    if (isa<AffineLoadOp>(op) || isa<memref::LoadOp>(op)) {
+      memRefs.insert(op->getOperand(0));
     }
   });
-
-  // add memrefs to the set
-  for (auto loadOp : loadOps) {
-    auto operand = loadOp->getOperand(0);
-    // check if operand defining op is a block arg
-    if (operand.isa<BlockArgument>()) {
-      // get block arg index
-      unsigned int index = operand.cast<BlockArgument>().getArgNumber();
-      memRefs.insert(reinterpret_cast<Operation *>(index));
-    } else {
-      memRefs.insert(loadOp->getOperand(0).getDefiningOp());
-    }
-  }
 }
 
-void getAllStoredMemRefs(Operation *op, std::set<Operation *> &memRefs) {
-  SmallVector<Operation *, 8> storeOps;
+void getAllStoredMemRefs(Operation *op, llvm::SetVector<Value> &memRefs) {
   op->walk([&](Operation *op) {
-    if (isa<AffineStoreOp>(op)) {
-      storeOps.push_back(op);
-    } else if (isa<memref::StoreOp>(op)) {
-      storeOps.push_back(op);
+    if (isa<AffineStoreOp>(op) || isa<memref::StoreOp>(op)) {
+      memRefs.insert(op->getOperand(1));
     }
   });
-
-  // add memrefs to the set
-  for (auto storeOp : storeOps) {
-    auto operand = storeOp->getOperand(1);
-    if (operand.isa<BlockArgument>()) {
-      // get block arg index
-      unsigned int index = operand.cast<BlockArgument>().getArgNumber();
-      memRefs.insert(reinterpret_cast<Operation *>(index));
-    } else {
-      memRefs.insert(storeOp->getOperand(1).getDefiningOp());
-    }
-  }
 }
 
 DataFlowGraph buildDFGInScope(Operation &scope_op) {
   // build a data flow graph
   // given an operation as the scope of the graph
   DataFlowGraph graph;
-  std::map<Operation *, Node *> latestProducer;
+  llvm::DenseMap<Value, Node *> latestProducer;
   for (auto &region : scope_op.getRegions()) {
     for (auto &block : region.getBlocks()) {
       for (auto &op : block.getOperations()) {
@@ -215,27 +536,25 @@ DataFlowGraph buildDFGInScope(Operation &scope_op) {
           continue;
         }
         // create a node for each op
-        Node *node = new Node(&op);
-        graph.addNode(node);
+        Node *node = graph.addNode(&op);
         // get all the memrefs consumed and produced by the op
-        std::set<Operation *> consumedMemRefs;
-        std::set<Operation *> producedMemRefs;
+        llvm::SetVector<Value> consumedMemRefs;
+        llvm::SetVector<Value> producedMemRefs;
         getAllLoadedMemRefs(&op, consumedMemRefs);
         getAllStoredMemRefs(&op, producedMemRefs);
         // add edges to the graph
         for (auto memRef : consumedMemRefs) {
           // get the node that produces the memref
           // add an edge from the node to the current node
-          // check if memRef is in latestProducer map
-          node->addConsumedMemRef(memRef);
-          if (latestProducer.find(memRef) != latestProducer.end()) {
-            Node *producer = latestProducer[memRef];
-            graph.addEdge(producer, node);
+          graph.addConsumedMemRef(node, memRef);
+          auto it = latestProducer.find(memRef);
+          if (it != latestProducer.end()) {
+            graph.addEdge(it->second, node, memRef);
           }
         }
         // update the latest producer for each memref
         for (auto memRef : producedMemRefs) {
-          node->addProducedMemRef(memRef);
+          graph.addProducedMemRef(node, memRef);
           latestProducer[memRef] = node;
         }
       }
@@ -257,19 +576,23 @@ void buildHierarchicalDFG(
   });
   // build a data flow graph for each top level op
   for (auto op : topLevelOps) {
-    DataFlowGraph graph = buildDFGInScope(*op);
-    hierarchicalDFG[op] = graph;
+    hierarchicalDFG.emplace(op, buildDFGInScope(*op));
   }
 }
 
 /// Pass entry point
-bool applyDataPlacement(ModuleOp &module) {
+bool applyDataPlacement(ModuleOp &module, double fpgaCycleCost,
+                        double transferCost) {
   /* Assumptions:
    * 1. The module has a top-level function called "top"
    */
 
   // get top-level function
   func::FuncOp func = module.lookupSymbol<func::FuncOp>("top");
+  if (!func) {
+    module.emitError("Cannot find the top-level function");
+    return false;
+  }
 
   // build a hierarchical data flow graph
   // key: scope of the graph, an operation that has body (e.g. forOp, funcOp)
@@ -290,14 +613,6 @@ bool applyDataPlacement(ModuleOp &module) {
   for (auto op : hostXcelToOps) {
     HostXcelToOp toOp = dyn_cast<HostXcelToOp>(op);
     auto target = toOp.getTarget();
-    Operation *target_defining_op;
-    if (target.isa<BlockArgument>()) {
-      // get block arg index
-      unsigned int index = target.cast<BlockArgument>().getArgNumber();
-      target_defining_op = reinterpret_cast<Operation *>(index);
-    } else {
-      target_defining_op = target.getDefiningOp();
-    }
     auto optional_axis = toOp.getAxis();
     Operation *scope_op; // which scope of graph does the op partition
     // check if axis has value
@@ -315,7 +630,7 @@ bool applyDataPlacement(ModuleOp &module) {
         return false;
       }
       // get the loop op that has the specified axis
-      Operation *axis_op;
+      Operation *axis_op = nullptr;
       rootForOp.walk([&](Operation *op) {
         if (isa<AffineForOp>(op)) {
           AffineForOp forOp = dyn_cast<AffineForOp>(op);
@@ -335,14 +650,16 @@ bool applyDataPlacement(ModuleOp &module) {
       // get parent operation of the axis op
       scope_op = axis_op->getParentOp();
       // get the data flow graph of the scope
-      DataFlowGraph graph = hierarchicalDFG[scope_op];
-      Node *target_node = axis_index == 0 ? graph.getNode(op_name.str())
-                                          : graph.getNode(loop_name.str());
+      DataFlowGraph &graph = hierarchicalDFG[scope_op];
+      Node *target_node =
+          axis_index == 0 ? graph.getNode(op_name) : graph.getNode(loop_name);
+      if (!target_node) {
+        op->emitError("Cannot find loop ") << loop_name.str();
+        return false;
+      }
       auto device = toOp.getDevice();
       for (auto node : target_node->getDownstream()) {
-        node->setDevice(device);
-        // llvm::outs() << "set node " << node->getName() << " to device " <<
-        // node->getDeviceName() << "\n";
+        node->pin(device);
       }
     } else {
       // if axis is not specified, the memref must be a block argument
@@ -353,42 +670,40 @@ bool applyDataPlacement(ModuleOp &module) {
       }
       scope_op = func.getOperation();
       // get the data flow graph of the scope
-      DataFlowGraph graph = hierarchicalDFG[scope_op];
+      DataFlowGraph &graph = hierarchicalDFG[scope_op];
       // get the node that consumes the memref
-      std::vector<Node *> target_nodes;
-      graph.getNodeByConsumedMemRef(target_defining_op, target_nodes);
       auto device = toOp.getDevice();
-      for (auto node : target_nodes) {
-        node->setDevice(device);
-        // llvm::outs() << "set node " << node->getName() << " to device " <<
-        // node->getDeviceName() << "\n";
+      for (auto node : graph.getNodeByConsumedMemRef(target)) {
+        node->pin(device);
       }
     }
     scopes.insert(scope_op);
   }
 
-  // propagate device information and partition graphs
+  // Labels only propagate inside nested scopes, whose loops cannot be
+  // outlined; their device is recorded as an attribute instead. The stages of
+  // the top-level function are placed by cost.
+  scopes.erase(func.getOperation());
   for (auto scope : scopes) {
-    DataFlowGraph graph = hierarchicalDFG[scope];
+    DataFlowGraph &graph = hierarchicalDFG[scope];
     graph.propagateDevice();
-    graph.partition(module, func);
-    graph.print();
+    graph.annotateDevice();
+    LLVM_DEBUG(graph.print(llvm::dbgs()));
   }
+  DataFlowGraph &graph = hierarchicalDFG[func.getOperation()];
+  graph.assignDevices(fpgaCycleCost, transferCost);
+  LLVM_DEBUG(graph.print(llvm::dbgs()));
 
-  // for (auto func : module.getOps<func::FuncOp>()) {
-  //   DataFlowGraph graph = buildDFG(*func.getOperation());
-  //   graph.print();
-  // }
-
-  // try creating a new module
-  // this worked:
-  // OpBuilder builder(module.getContext());
-  // builder.setInsertionPointToStart(module.getBody());
-  // builder.create<ModuleOp>(module.getLoc());
-
-  // move all ops in the old module to the new module
-  //   newModule.getBody()->getOperations().splice(
-  //         newModule.getBody()->begin(), module.getBody()->getOperations());
+  // The placement is realized by outlining, so the hcl.host_xcel_to ops of
+  // the top-level function are removed along with the outline ops.
+  SmallVector<Operation *, 10> opToRemove;
+  for (auto op : hostXcelToOps) {
+    if (op->getParentOp() == func.getOperation())
+      opToRemove.push_back(op);
+  }
+  if (failed(graph.partition(module, func, opToRemove)))
+    return false;
+  eraseScheduleOp(func, opToRemove);
   return true;
 }
 
@@ -398,9 +713,15 @@ bool applyDataPlacement(ModuleOp &module) {
 namespace {
 struct HCLDataPlacementTransformation
     : public DataPlacementBase<HCLDataPlacementTransformation> {
+  HCLDataPlacementTransformation() = default;
+  HCLDataPlacementTransformation(double fpgaCycleCost, double transferCost) {
+    this->fpgaCycleCost = fpgaCycleCost;
+    this->transferCost = transferCost;
+  }
+
   void runOnOperation() override {
     auto mod = getOperation();
-    if (!applyDataPlacement(mod)) {
+    if (!applyDataPlacement(mod, fpgaCycleCost, transferCost)) {
       signalPassFailure();
     }
   }
@@ -412,5 +733,11 @@ namespace hcl {
 std::unique_ptr<OperationPass<ModuleOp>> createDataPlacementPass() {
   return std::make_unique<HCLDataPlacementTransformation>();
 }
+
+std::unique_ptr<OperationPass<ModuleOp>>
+createDataPlacementPass(double fpgaCycleCost, double transferCost) {
+  return std::make_unique<HCLDataPlacementTransformation>(fpgaCycleCost,
+                                                          transferCost);
+}
 } // namespace hcl
 } // namespace mlir
\ No newline at end of file
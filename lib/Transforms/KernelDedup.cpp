@@ -0,0 +1,430 @@
+/*
+ * Copyright HeteroCL authors. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//===----------------------------------------------------------------------===//
+// KernelDedup Pass
+// This pass merges structurally identical kernels, e.g. the stage functions
+// hcl.outline creates for the layers of an unrolled network. Two kernels are
+// identical if they only differ in names (symbol, stage, loop and buffer
+// names), in the values of scalar constants, and, with dynamic-shapes, in
+// constant loop bounds and the static sizes of memref arguments that are only
+// used by loads and stores. The values that differ become arguments of the
+// kernel that is kept, and every call site passes its own values. Loops whose
+// bounds become arguments get a "tripcount" = [min, max, avg] attribute over
+// the call sites, so that the HLS emitters still print a loop_tripcount.
+//===----------------------------------------------------------------------===//
+#include "PassDetail.h"
+#include "hcl/Transforms/Passes.h"
+
+#include "mlir/Dialect/Affine/IR/AffineOps.h"
+#include "mlir/Dialect/Arith/IR/Arith.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/Dialect/MemRef/IR/MemRef.h"
+#include "mlir/IR/SymbolTable.h"
+
+#include "llvm/ADT/Hashing.h"
+#include "llvm/ADT/MapVector.h"
+#include "llvm/ADT/SetVector.h"
+
+#include <map>
+
+using namespace mlir;
+using namespace hcl;
+
+/// Returns true if the memref argument is only indexed by loads and stores,
+/// which stay valid when its static shape becomes dynamic. Other uses, e.g.
+/// calls, returns or views, may depend on the exact type.
+static bool isOnlyAccessed(BlockArgument arg) {
+  return llvm::all_of(arg.getUses(), [&](OpOperand &use) {
+    Operation *user = use.getOwner();
+    if (auto read = dyn_cast<affine::AffineReadOpInterface>(user))
+      return read.getMemRef() == arg;
+    if (auto write = dyn_cast<affine::AffineWriteOpInterface>(user))
+      return write.getMemRef() == arg;
+    if (auto load = dyn_cast<memref::LoadOp>(user))
+      return load.getMemRef() == arg;
+    if (auto store = dyn_cast<memref::StoreOp>(user))
+      return store.getMemRef() == arg;
+    return false;
+  });
+}
+
+namespace {
+
+/// A value that may differ between otherwise identical kernels.
+struct Hole {
+  enum Kind { Constant, LowerBound, UpperBound, ArgShape };
+  Kind kind;
+  Operation *op;
+  // The argument number of an ArgShape hole.
+  unsigned argNo;
+  // The constant, the bound as an index attribute, or the argument shape.
+  Attribute value;
+};
+
+/// The structure of a kernel, with the holes left out of it.
+struct KernelSignature {
+  std::string structure;
+  SmallVector<Hole> holes;
+};
+
+/// Serializes a kernel so that equal strings mean structurally identical
+/// kernels: values and blocks are numbered in order of appearance, and names
+/// are dropped.
+class KernelSerializer {
+public:
+  KernelSerializer(KernelSignature &sig, bool dynamicShapes)
+      : sig(sig), os(sig.structure), dynamicShapes(dynamicShapes) {}
+
+  void serialize(func::FuncOp func) {
+    Builder builder(func.getContext());
+    os << "(";
+    for (BlockArgument arg : func.getArguments()) {
+      auto type = arg.getType().dyn_cast<MemRefType>();
+      if (dynamicShapes && type && type.hasStaticShape() &&
+          isOnlyAccessed(arg)) {
+        os << "memref<" << type.getRank() << "x" << type.getElementType()
+           << "," << type.getLayout() << "," << type.getMemorySpace() << ">";
+        sig.holes.push_back({Hole::ArgShape, func, arg.getArgNumber(),
+                             builder.getDenseI64ArrayAttr(type.getShape())});
+      } else {
+        os << arg.getType();
+      }
+      os << ",";
+      getId(arg);
+    }
+    os << ")->(";
+    llvm::interleaveComma(func.getResultTypes(), os);
+    os << ")";
+    serializeAttrs(func, {"function_type", "sym_visibility"});
+    serializeRegion(func.getBody());
+  }
+
+private:
+  unsigned getId(Value value) {
+    return valueIds.try_emplace(value, valueIds.size()).first->second;
+  }
+
+  void serializeAttrs(Operation *op, ArrayRef<StringRef> skipped) {
+    static const StringRef names[] = {"sym_name", "loop_name", "op_name",
+                                      "name",     "from",      "to"};
+    os << "{";
+    for (NamedAttribute attr : op->getAttrDictionary()) {
+      if (llvm::is_contained(names, attr.getName().strref()) ||
+          llvm::is_contained(skipped, attr.getName().strref()))
+        continue;
+      // Loop bounds are serialized separately.
+      if (isa<affine::AffineForOp>(op) && attr.getValue().isa<AffineMapAttr>())
+        continue;
+      os << attr.getName().strref() << "=" << attr.getValue() << ",";
+    }
+    os << "}";
+  }
+
+  void serializeBound(affine::AffineForOp forOp, bool isLower) {
+    Builder builder(forOp.getContext());
+    // Symbolic bounds lose the static trip count, so constant bounds are
+    // only holes when shapes may become dynamic anyway.
+    bool isConstant = isLower ? forOp.hasConstantLowerBound()
+                              : forOp.hasConstantUpperBound();
+    if (dynamicShapes && isConstant) {
+      int64_t bound = isLower ? forOp.getConstantLowerBound()
+                              : forOp.getConstantUpperBound();
+      os << "?";
+      sig.holes.push_back({isLower ? Hole::LowerBound : Hole::UpperBound,
+                           forOp, 0, builder.getIndexAttr(bound)});
+      return;
+    }
+    os << (isLower ? forOp.getLowerBoundMap() : forOp.getUpperBoundMap());
+  }
+
+  void serialize(Operation *op) {
+    os << op->getName().getStringRef();
+    auto cst = dyn_cast<arith::ConstantOp>(op);
+    if (cst && cst.getValue().isa<IntegerAttr, FloatAttr>()) {
+      os << "?";
+      sig.holes.push_back({Hole::Constant, op, 0, cst.getValue()});
+      serializeAttrs(op, {"value"});
+    } else {
+      if (auto forOp = dyn_cast<affine::AffineForOp>(op)) {
+        serializeBound(forOp, /*isLower=*/true);
+        serializeBound(forOp, /*isLower=*/false);
+      }
+      serializeAttrs(op, {});
+    }
+    os << "(";
+    for (Value operand : op->getOperands())
+      os << getId(operand) << ",";
+    os << ")[";
+    for (Block *successor : op->getSuccessors())
+      os << blockIds.lookup(successor) << ",";
+    os << "]->(";
+    for (Value result : op->getResults()) {
+      os << result.getType() << ",";
+      getId(result);
+    }
+    os << ")";
+    for (Region &region : op->getRegions())
+      serializeRegion(region);
+    os << ";";
+  }
+
+  void serializeRegion(Region &region) {
+    for (Block &block : region)
+      blockIds.try_emplace(&block, blockIds.size());
+    os << "{";
+    for (Block &block : region) {
+      os << "^" << blockIds.lookup(&block) << "(";
+      for (BlockArgument arg : block.getArguments()) {
+        os << arg.getType() << ",";
+        getId(arg);
+      }
+      os << ")";
+      for (Operation &op : block)
+        serialize(&op);
+    }
+    os << "}";
+  }
+
+  KernelSignature &sig;
+  llvm::raw_string_ostream os;
+  bool dynamicShapes;
+  DenseMap<Value, unsigned> valueIds;
+  DenseMap<Block *, unsigned> blockIds;
+};
+
+} // namespace
+
+/// Sets "tripcount" = [min, max, avg] on the loops of a merged kernel whose
+/// constant bounds became arguments, weighting each kernel by its calls.
+static void setMergedTripCounts(ArrayRef<KernelSignature> sigs,
+                                ArrayRef<SmallVector<func::CallOp>> calls,
+                                ArrayRef<unsigned> params) {
+  llvm::SetVector<Operation *> loops;
+  for (unsigned h : params)
+    if (sigs[0].holes[h].kind == Hole::LowerBound ||
+        sigs[0].holes[h].kind == Hole::UpperBound)
+      loops.insert(sigs[0].holes[h].op);
+
+  for (Operation *op : loops) {
+    auto forOp = cast<affine::AffineForOp>(op);
+    // Both bounds must have been constant in every kernel.
+    int lower = -1, upper = -1;
+    for (auto hole : llvm::enumerate(sigs[0].holes)) {
+      if (hole.value().op != op)
+        continue;
+      (hole.value().kind == Hole::LowerBound ? lower : upper) = hole.index();
+    }
+    if (lower < 0 || upper < 0 || forOp->hasAttr("tripcount"))
+      continue;
+
+    int64_t minCount = INT64_MAX, maxCount = 0, total = 0, numCalls = 0;
+    for (auto item : llvm::zip(sigs, calls)) {
+      const KernelSignature &sig = std::get<0>(item);
+      int64_t numKernelCalls = std::get<1>(item).size();
+      if (numKernelCalls == 0)
+        continue;
+      auto getBound = [&](int h) {
+        return sig.holes[h].value.cast<IntegerAttr>().getInt();
+      };
+      int64_t count = llvm::divideCeil(
+          std::max<int64_t>(getBound(upper) - getBound(lower), 0),
+          forOp.getStep());
+      minCount = std::min(minCount, count);
+      maxCount = std::max(maxCount, count);
+      total += count * numKernelCalls;
+      numCalls += numKernelCalls;
+    }
+    if (numCalls == 0)
+      continue;
+    int64_t avg = (total + numCalls / 2) / numCalls;
+    Builder builder(forOp.getContext());
+    forOp->setAttr("tripcount",
+                   builder.getDenseI64ArrayAttr({minCount, maxCount, avg}));
+  }
+}
+
+/// Turns the holes of `kernel` that differ among `sigs` into arguments and
+/// redirects the calls of all kernels to it. `sigs[0]` describes `kernel`.
+static void mergeKernels(func::FuncOp kernel, ArrayRef<KernelSignature> sigs,
+                         ArrayRef<SmallVector<func::CallOp>> calls) {
+  OpBuilder builder(kernel.getContext());
+  Block &entry = kernel.front();
+  SmallVector<unsigned> params;
+  for (unsigned h = 0, e = sigs[0].holes.size(); h < e; ++h) {
+    const Hole &hole = sigs[0].holes[h];
+    if (llvm::all_of(sigs, [&](const KernelSignature &sig) {
+          return sig.holes[h].value == hole.value;
+        }))
+      continue;
+
+    // 1) Parameterize the kernel
+    switch (hole.kind) {
+    case Hole::Constant: {
+      auto type = hole.value.cast<TypedAttr>().getType();
+      auto arg = entry.addArgument(type, hole.op->getLoc());
+      hole.op->getResult(0).replaceAllUsesWith(arg);
+      hole.op->erase();
+      params.push_back(h);
+      break;
+    }
+    case Hole::LowerBound:
+    case Hole::UpperBound: {
+      auto forOp = cast<affine::AffineForOp>(hole.op);
+      auto arg = entry.addArgument(builder.getIndexType(), forOp.getLoc());
+      if (hole.kind == Hole::LowerBound)
+        forOp.setLowerBound({arg}, builder.getSymbolIdentityMap());
+      else
+        forOp.setUpperBound({arg}, builder.getSymbolIdentityMap());
+      params.push_back(h);
+      break;
+    }
+    case Hole::ArgShape: {
+      // Only the dimensions that differ become dynamic.
+      auto arg = entry.getArgument(hole.argNo);
+      auto type = arg.getType().cast<MemRefType>();
+      SmallVector<int64_t> shape(type.getShape());
+      for (const KernelSignature &sig : sigs) {
+        auto other = sig.holes[h].value.cast<DenseI64ArrayAttr>().asArrayRef();
+        for (unsigned d = 0; d < shape.size(); ++d)
+          if (other[d] != shape[d])
+            shape[d] = ShapedType::kDynamic;
+      }
+      arg.setType(MemRefType::get(shape, type.getElementType(),
+                                  type.getLayout(), type.getMemorySpace()));
+      break;
+    }
+    }
+  }
+  kernel.setType(builder.getFunctionType(entry.getArgumentTypes(),
+                                         kernel.getResultTypes()));
+  setMergedTripCounts(sigs, calls, params);
+  // New scalar arguments are signless
+  if (auto itypes = kernel->getAttrOfType<StringAttr>("itypes"))
+    kernel->setAttr("itypes",
+                    builder.getStringAttr(itypes.getValue().str() +
+                                          std::string(params.size(), '_')));
+
+  // 2) Pass the values of each kernel at its call sites
+  for (auto item : llvm::zip(sigs, calls)) {
+    const KernelSignature &sig = std::get<0>(item);
+    for (func::CallOp call : std::get<1>(item)) {
+      builder.setInsertionPoint(call);
+      SmallVector<Value> operands;
+      for (auto operand : llvm::enumerate(call.getOperands())) {
+        Value value = operand.value();
+        Type type = entry.getArgument(operand.index()).getType();
+        if (value.getType() != type)
+          value = builder.create<memref::CastOp>(call.getLoc(), type, value);
+        operands.push_back(value);
+      }
+      for (unsigned h : params) {
+        Attribute value = sig.holes[h].value;
+        operands.push_back(builder.create<arith::ConstantOp>(
+            call.getLoc(), value.cast<TypedAttr>()));
+      }
+      auto newCall = builder.create<func::CallOp>(call.getLoc(), kernel,
+                                                  operands);
+      call->replaceAllUsesWith(newCall->getResults());
+      call.erase();
+    }
+  }
+}
+
+namespace mlir {
+namespace hcl {
+
+/// Pass entry point
+bool applyKernelDedup(ModuleOp &mod, bool dynamicShapes) {
+  // Merging kernels can make their callers identical, so iterate.
+  bool changed = true;
+  while (changed) {
+    changed = false;
+
+    // 1) Collect the kernels that are only used by calls
+    llvm::MapVector<Operation *, SmallVector<func::CallOp>> kernels;
+    for (auto func : mod.getOps<func::FuncOp>())
+      if (func.isPrivate() && !func.isExternal() && !func->hasAttr("top"))
+        kernels[func];
+    if (auto uses = SymbolTable::getSymbolUses(mod)) {
+      for (SymbolTable::SymbolUse use : *uses) {
+        auto func = mod.lookupSymbol<func::FuncOp>(use.getSymbolRef());
+        if (!func || !kernels.count(func))
+          continue;
+        if (auto call = dyn_cast<func::CallOp>(use.getUser()))
+          kernels[func].push_back(call);
+        else
+          kernels.erase(func); // referenced by something else
+      }
+    }
+
+    // 2) Group the kernels by structural hash
+    std::map<size_t, SmallVector<func::FuncOp>> buckets;
+    DenseMap<Operation *, KernelSignature> sigs;
+    for (auto &kernel : kernels) {
+      auto func = cast<func::FuncOp>(kernel.first);
+      KernelSignature &sig = sigs[func];
+      KernelSerializer(sig, dynamicShapes).serialize(func);
+      buckets[llvm::hash_value(sig.structure)].push_back(func);
+    }
+
+    // 3) Merge the kernels with the same structure into the first of them
+    for (auto &bucket : buckets) {
+      SmallVector<func::FuncOp> funcs(bucket.second);
+      while (funcs.size() > 1) {
+        func::FuncOp kernel = funcs.front();
+        SmallVector<func::FuncOp> group, rest;
+        for (auto func : funcs)
+          (sigs[func].structure == sigs[kernel].structure ? group : rest)
+              .push_back(func);
+        funcs = rest;
+        if (group.size() == 1)
+          continue;
+        SmallVector<KernelSignature> groupSigs;
+        SmallVector<SmallVector<func::CallOp>> groupCalls;
+        for (auto func : group) {
+          groupSigs.push_back(sigs[func]);
+          groupCalls.push_back(kernels[func]);
+        }
+        mergeKernels(kernel, groupSigs, groupCalls);
+        for (auto func : llvm::drop_begin(group))
+          func.erase();
+        changed = true;
+      }
+    }
+  }
+  return true;
+}
+
+} // namespace hcl
+} // namespace mlir
+
+namespace {
+struct HCLKernelDedup : public KernelDedupBase<HCLKernelDedup> {
+  HCLKernelDedup() = default;
+  HCLKernelDedup(bool dynamicShapes) { this->dynamicShapes = dynamicShapes; }
+
+  void runOnOperation() override {
+    auto mod = getOperation();
+    if (!applyKernelDedup(mod, dynamicShapes))
+      return signalPassFailure();
+  }
+};
+} // namespace
+
+namespace mlir {
+namespace hcl {
+
+std::unique_ptr<OperationPass<ModuleOp>> createKernelDedupPass() {
+  return std::make_unique<HCLKernelDedup>();
+}
+
+std::unique_ptr<OperationPass<ModuleOp>>
+createKernelDedupPass(bool dynamicShapes) {
+  return std::make_unique<HCLKernelDedup>(dynamicShapes);
+}
+
+} // namespace hcl
+} // namespace mlir
@@ -9,7 +9,9 @@
 #include "hcl/Dialect/HeteroCLOps.h"
 #include "hcl/Support/Utils.h"
 #include "hcl/Transforms/Passes.h"
+#include "hcl/Transforms/ScheduleSession.h"
 
+#include "mlir/Dialect/Affine/Analysis/LoopAnalysis.h"
 #include "mlir/Dialect/Affine/IR/AffineOps.h"
 #include "mlir/Dialect/Affine/LoopFusionUtils.h"
 #include "mlir/Dialect/Affine/LoopUtils.h"
@@ -66,6 +68,88 @@ Attribute createZeroAttr(OpBuilder &builder, mlir::Type elementType) {
   return {};
 }
 
+// Peel the last tile of a loop split by `factor` into an epilogue nest after
+// `outerLoop`, when `factor` does not divide the trip count. The tiles of the
+// main nest then run exactly `factor` iterations of `innerLoop`, and the
+// epilogue runs the remaining ones. The clones of the loops nested in
+// `outerLoop` are recorded in `mapping`.
+static AffineForOp peelRemainderTile(AffineForOp outerLoop,
+                                     AffineForOp innerLoop, int64_t factor,
+                                     int64_t tripCount, IRMapping &mapping) {
+  int64_t numFullTiles = tripCount / factor;
+  OpBuilder builder(outerLoop);
+  builder.setInsertionPointAfter(outerLoop);
+  auto epilogue = cast<AffineForOp>(builder.clone(*outerLoop, mapping));
+  auto epilogueInner =
+      getForInductionVarOwner(mapping.lookup(innerLoop.getInductionVar()));
+  outerLoop.setConstantUpperBound(numFullTiles);
+  innerLoop.setConstantUpperBound(factor);
+  epilogue.setConstantLowerBound(numFullTiles);
+  epilogue.setConstantUpperBound(numFullTiles + 1);
+  epilogueInner.setConstantUpperBound(tripCount % factor);
+  return epilogue;
+}
+
+// Name the loops of the peeled epilogues with a ".rem" suffix, so that the
+// loop handles keep referring to the main nest, and drop their single-trip
+// outer loops. Epilogues at the top level become the stage "<stage>.rem", so
+// that the primitives applied to the stage afterwards reach them as well.
+static void finalizeRemainderTiles(ArrayRef<AffineForOp> epilogues) {
+  // inner epilogues come last and are handled first
+  for (AffineForOp epilogue : llvm::reverse(epilogues)) {
+    auto stageName = epilogue->getAttrOfType<StringAttr>("op_name");
+    epilogue->removeAttr("op_name");
+    epilogue.walk([&](AffineForOp forOp) {
+      auto name = getLoopName(forOp);
+      if (!name.empty() && !name.ends_with(".rem"))
+        setLoopName(forOp, name.str() + ".rem");
+    });
+    SmallVector<AffineForOp, 2> stageLoops(
+        epilogue.getBody()->getOps<AffineForOp>());
+    if (failed(promoteIfSingleIteration(epilogue)))
+      stageLoops = {epilogue};
+    if (stageName)
+      for (auto forOp : stageLoops)
+        setStageName(forOp, stageName.getValue().str() + ".rem");
+  }
+}
+
+// Collect the loops peeled from the loop `loop_name` of a stage, i.e. the
+// loops named "<loop_name>.rem" in the stage and in its remainder stages.
+static void getRemainderLoops(func::FuncOp &f, AffineForOp rootForOp,
+                              StringRef op_name, StringRef loop_name,
+                              SmallVectorImpl<AffineForOp> &loops) {
+  std::string remLoopName = loop_name.str() + ".rem";
+  std::string remStageName = op_name.str() + ".rem";
+  auto collect = [&](AffineForOp root) {
+    root.walk([&](AffineForOp forOp) {
+      if (getLoopName(forOp) == remLoopName)
+        loops.push_back(forOp);
+    });
+  };
+  collect(rootForOp);
+  for (auto forOp : f.getOps<AffineForOp>())
+    if (auto name = forOp->getAttrOfType<StringAttr>("op_name"))
+      if (name.getValue() == remStageName)
+        collect(forOp);
+}
+
+// Whether remainder tiles were peeled from a stage.
+static bool hasRemainderTiles(func::FuncOp &f, AffineForOp rootForOp,
+                              StringRef op_name) {
+  std::string remStageName = op_name.str() + ".rem";
+  for (auto forOp : f.getOps<AffineForOp>())
+    if (auto name = forOp->getAttrOfType<StringAttr>("op_name"))
+      if (name.getValue() == remStageName)
+        return true;
+  WalkResult result = rootForOp.walk([&](AffineForOp forOp) {
+    if (getLoopName(forOp).ends_with(".rem"))
+      return WalkResult::interrupt();
+    return WalkResult::advance();
+  });
+  return result.wasInterrupted();
+}
+
 LogicalResult runSplitting(func::FuncOp &f, SplitOp &splitOp) {
   // 1) Get the schedule
   unsigned int factor = splitOp.getFactor();
@@ -107,6 +191,7 @@ LogicalResult runSplitting(func::FuncOp &f, SplitOp &splitOp) {
   }
 
   // 4) Split the loop
+  std::optional<uint64_t> tripCount = getConstantTripCount(band[0]);
   SmallVector<unsigned, 6> tileSizes;
   tileSizes.push_back(factor);
   AffineLoopBand tiledNest;
@@ -176,7 +261,15 @@ LogicalResult runSplitting(func::FuncOp &f, SplitOp &splitOp) {
   if (isOuterMost)
     setStageName(tiledNest[0], op_name);
 
-  // 8) Create new loop handles
+  // 8) Peel the remainder tile
+  if (splitOp.getPeel() && tripCount &&
+      !tiledNest[1].hasConstantUpperBound()) {
+    IRMapping mapping;
+    finalizeRemainderTiles({peelRemainderTile(tiledNest[0], tiledNest[1],
+                                              factor, *tripCount, mapping)});
+  }
+
+  // 9) Create new loop handles
   auto firstOp = *(f.getOps<AffineForOp>().begin());
   OpBuilder builder(firstOp);
   auto outer = builder.create<CreateLoopHandleOp>(
@@ -188,7 +281,7 @@ LogicalResult runSplitting(func::FuncOp &f, SplitOp &splitOp) {
       opHandle.getResult(),
       StringAttr::get(firstOp->getContext(), newNameArr[1]));
 
-  // 9) Link the loop handles with SSA values
+  // 10) Link the loop handles with SSA values
   splitOp.getResult(0).replaceAllUsesWith(outer);
   splitOp.getResult(1).replaceAllUsesWith(inner);
 
@@ -251,6 +344,8 @@ LogicalResult runTiling(func::FuncOp &f, TileOp &tileOp) {
     isOuterMost = true;
 
   // 4) Tile the loops
+  std::optional<uint64_t> xTripCount = getConstantTripCount(band[0]);
+  std::optional<uint64_t> yTripCount = getConstantTripCount(band[1]);
   SmallVector<unsigned, 6> tileSizes;
   tileSizes.push_back(x_factor);
   tileSizes.push_back(y_factor);
@@ -324,7 +419,33 @@ LogicalResult runTiling(func::FuncOp &f, TileOp &tileOp) {
   if (isOuterMost)
     setStageName(tiledNest[0], op_name);
 
-  // 8) Create new loop handles &
+  // 8) Peel the remainder tiles, first along x, then along y in both the
+  //    main nest and the x epilogue
+  if (tileOp.getPeel()) {
+    SmallVector<AffineForOp, 3> epilogues;
+    SmallVector<std::pair<AffineForOp, AffineForOp>, 2> yLoops;
+    yLoops.push_back({tiledNest[1], tiledNest[3]});
+    if (xTripCount && !tiledNest[2].hasConstantUpperBound()) {
+      IRMapping mapping;
+      epilogues.push_back(peelRemainderTile(tiledNest[0], tiledNest[2],
+                                            x_factor, *xTripCount, mapping));
+      yLoops.push_back(
+          {getForInductionVarOwner(
+               mapping.lookup(tiledNest[1].getInductionVar())),
+           getForInductionVarOwner(
+               mapping.lookup(tiledNest[3].getInductionVar()))});
+    }
+    if (yTripCount && !tiledNest[3].hasConstantUpperBound()) {
+      for (auto &loops : yLoops) {
+        IRMapping mapping;
+        epilogues.push_back(peelRemainderTile(
+            loops.first, loops.second, y_factor, *yTripCount, mapping));
+      }
+    }
+    finalizeRemainderTiles(epilogues);
+  }
+
+  // 9) Create new loop handles &
   //    Link the loop handles with SSA values
   auto firstOp = *(f.getOps<AffineForOp>().begin());
   OpBuilder builder(firstOp);
@@ -582,6 +703,13 @@ LogicalResult runUnrolling(func::FuncOp &f, UnrollOp &unrollOp) {
     return failure();
   }
 
+  // 4) Unroll the remainder tiles peeled from the loop as well
+  SmallVector<AffineForOp, 4> remLoops;
+  getRemainderLoops(f, rootForOp, op_name, loop_name, remLoops);
+  for (auto forOp : remLoops)
+    forOp->setAttr("unroll",
+                   Builder(forOp->getContext()).getI32IntegerAttr(factor));
+
   return success();
 }
 
@@ -658,6 +786,13 @@ LogicalResult runPipelining(func::FuncOp &f, PipelineOp &pipelineOp) {
     pipelineOp.emitError("Cannot find Loop ") << loop_name.str();
     return failure();
   }
+
+  // 4) Pipeline the remainder tiles peeled from the loop as well
+  SmallVector<AffineForOp, 4> remLoops;
+  getRemainderLoops(f, rootForOp, op_name, loop_name, remLoops);
+  for (auto forOp : remLoops)
+    forOp->setAttr("pipeline_ii",
+                   Builder(forOp->getContext()).getI32IntegerAttr(ii));
   return success();
 }
 
@@ -940,6 +1075,13 @@ LogicalResult runComputeAt(func::FuncOp &f, ComputeAtOp &computeAtOp) {
     computeAtOp.emitError("Cannot find corresponding producer and consumer");
     return failure();
   }
+  // The producer would only be computed in the main nest of the consumer
+  if (hasRemainderTiles(f, producerFor, producer_name) ||
+      hasRemainderTiles(f, consumerFor, consumer_name)) {
+    computeAtOp.emitError("Cannot compute a stage at another when remainder "
+                          "tiles were peeled from either");
+    return failure();
+  }
 
   // 3) Find the requested loops
   int cnt_depth = 0;
@@ -1246,6 +1388,12 @@ LogicalResult runPartition(func::FuncOp &f, PartitionOp &partitionOp,
   // 2) Find the requested array
   // has been done in findArray
 
+  return partitionArray(f, array, kind, target_dim, factor, partitionOp);
+}
+
+LogicalResult partitionArray(func::FuncOp &f, Value &array,
+                             PartitionKindEnum kind, unsigned int target_dim,
+                             int factor, Operation *partitionOp) {
   // 3) Construct new memory layout map
   auto builder = Builder(array.getContext());
   auto arrayType = array.getType().dyn_cast<MemRefType>();
@@ -1259,8 +1407,8 @@ LogicalResult runPartition(func::FuncOp &f, PartitionOp &partitionOp,
   // last N : physical index
   unsigned rank = arrayType.getRank();
   if (layout.getNumResults() != rank) {
-    partitionOp.emitWarning("Partition on the array partitioned before. "
-                            "The original layout map will be rewritten!");
+    partitionOp->emitWarning("Partition on the array partitioned before. "
+                             "The original layout map will be rewritten!");
   }
   for (int64_t dim = 0; dim < rank; ++dim) {
     if (target_dim == 0 || (target_dim > 0 && dim == target_dim - 1)) {
@@ -1287,7 +1435,7 @@ LogicalResult runPartition(func::FuncOp &f, PartitionOp &partitionOp,
         partitionIndices.push_back(builder.getAffineDimExpr(dim));
         addressIndices.push_back(builder.getAffineConstantExpr(0));
       } else {
-        partitionOp.emitError("No this partition kind");
+        partitionOp->emitError("No this partition kind");
         return failure();
       }
     } else {
@@ -3599,107 +3747,113 @@ void applyCustomization(
   }
 }
 
+// Dispatch a schedule primitive to its implementation
+LogicalResult applyScheduleOp(ModuleOp &mod, func::FuncOp &f, Operation &op) {
+  if (auto new_op = dyn_cast<SplitOp>(op)) {
+    if (failed(runSplitting(f, new_op)))
+      return failure();
+  } else if (auto new_op = dyn_cast<TileOp>(op)) {
+    if (failed(runTiling(f, new_op)))
+      return failure();
+  } else if (auto new_op = dyn_cast<ReorderOp>(op)) {
+    if (failed(runReordering(f, new_op)))
+      return failure();
+  } else if (auto new_op = dyn_cast<UnrollOp>(op)) {
+    if (failed(runUnrolling(f, new_op)))
+      return failure();
+  } else if (auto new_op = dyn_cast<UnfoldOp>(op)) {
+    if (failed(runUnfolding(f, new_op)))
+      return failure();
+  } else if (auto new_op = dyn_cast<IntraKernelToOp>(op)) {
+    if (failed(runIntraKernelOpCheck(f, new_op)))
+      return failure();
+  } else if (auto new_op = dyn_cast<PipelineOp>(op)) {
+    if (failed(runPipelining(f, new_op)))
+      return failure();
+  } else if (auto new_op = dyn_cast<ThreadBindOp>(op)) {
+    if (failed(runThreadBind(f, new_op)))
+      return failure();
+  } else if (auto new_op = dyn_cast<ParallelOp>(op)) {
+    if (failed(runParallel(f, new_op)))
+      return failure();
+  } else if (auto new_op = dyn_cast<FuseOp>(op)) {
+    if (failed(runFusing(f, new_op)))
+      return failure();
+  } else if (auto new_op = dyn_cast<ComputeAtOp>(op)) {
+    if (failed(runComputeAt(f, new_op)))
+      return failure();
+  } else if (auto new_op = dyn_cast<PartitionOp>(op)) {
+    Value array;
+    if (findArray(f, new_op.getTarget(), array)) {
+      if (failed(runPartition(f, new_op, array)))
+        return failure();
+    } else {
+      return failure();
+    }
+  } else if (auto new_op = dyn_cast<ReuseAtOp>(op)) {
+    if (failed(runReuseAt(f, new_op)))
+      return failure();
+  } else if (auto new_op = dyn_cast<BufferAtOp>(op)) {
+    if (failed(runBufferAt(f, new_op)))
+      return failure();
+  } else if (auto new_op = dyn_cast<ReshapeOp>(op)) {
+    Value array;
+    if (findArray(f, new_op.getTarget(), array)) {
+      if (failed(runReshape(f, new_op, array)))
+        return failure();
+    } else {
+      return failure();
+    }
+  } else if (auto new_op = dyn_cast<ReformOp>(op)) {
+    Value array;
+    if (findArray(f, new_op.getTarget(), array)) {
+      if (failed(runReform(f, new_op, array)))
+        return failure();
+    } else {
+      return failure();
+    }
+  } else if (auto new_op = dyn_cast<InterKernelToOp>(op)) {
+    Value array;
+    auto optional_fifo_depth = new_op.getFifoDepth();
+    unsigned int fifo_depth;
+    if (optional_fifo_depth.has_value()) {
+      fifo_depth = optional_fifo_depth.value();
+    } else {
+      fifo_depth = -1; // conservative assumption
+    }
+    if (findArray(f, new_op.getTarget(), array)) {
+      if (failed(
+              runInterKernelDataPlacementSingleFunction(array, fifo_depth)))
+        return failure();
+    } else {
+      return failure();
+    }
+  } else if (auto new_op = dyn_cast<OutlineOp>(op)) {
+    if (failed(runOutline(mod, f, new_op)))
+      return failure();
+  } else if (auto new_op = dyn_cast<ReplaceOp>(op)) {
+    Value src, dst;
+    if (findArray(f, new_op.getSrc(), src) &&
+        findArray(f, new_op.getDst(), dst)) {
+      if (failed(runReplaceOp(f, new_op, src, dst)))
+        return failure();
+    } else {
+      return failure();
+    }
+  }
+  return success();
+}
+
 bool applyLoopTransformationOnSingleFunction(
     ModuleOp &mod, func::FuncOp &f,
     std::map<std::string, hcl::CustomizationOp> &customizationMap) {
   SmallVector<Operation *, 10> opToRemove;
   applyCustomization(f, customizationMap, opToRemove);
   // schedule should preverse orders, thus traverse one by one
-  // the following shows the dispatching logic
   for (Operation &op : f.getOps()) {
     if (isHCLOp(op)) {
-      if (auto new_op = dyn_cast<SplitOp>(op)) {
-        if (failed(runSplitting(f, new_op)))
-          return false;
-      } else if (auto new_op = dyn_cast<TileOp>(op)) {
-        if (failed(runTiling(f, new_op)))
-          return false;
-      } else if (auto new_op = dyn_cast<ReorderOp>(op)) {
-        if (failed(runReordering(f, new_op)))
-          return false;
-      } else if (auto new_op = dyn_cast<UnrollOp>(op)) {
-        if (failed(runUnrolling(f, new_op)))
-          return false;
-      } else if (auto new_op = dyn_cast<UnfoldOp>(op)) {
-        if (failed(runUnfolding(f, new_op)))
-          return false;
-      } else if (auto new_op = dyn_cast<IntraKernelToOp>(op)) {
-        if (failed(runIntraKernelOpCheck(f, new_op)))
-          return false;
-      } else if (auto new_op = dyn_cast<PipelineOp>(op)) {
-        if (failed(runPipelining(f, new_op)))
-          return false;
-      } else if (auto new_op = dyn_cast<ThreadBindOp>(op)) {
-        if (failed(runThreadBind(f, new_op)))
-          return false;
-      } else if (auto new_op = dyn_cast<ParallelOp>(op)) {
-        if (failed(runParallel(f, new_op)))
-          return false;
-      } else if (auto new_op = dyn_cast<FuseOp>(op)) {
-        if (failed(runFusing(f, new_op)))
-          return false;
-      } else if (auto new_op = dyn_cast<ComputeAtOp>(op)) {
-        if (failed(runComputeAt(f, new_op)))
-          return false;
-      } else if (auto new_op = dyn_cast<PartitionOp>(op)) {
-        Value array;
-        if (findArray(f, new_op.getTarget(), array)) {
-          if (failed(runPartition(f, new_op, array)))
-            return false;
-        } else {
-          return false;
-        }
-      } else if (auto new_op = dyn_cast<ReuseAtOp>(op)) {
-        if (failed(runReuseAt(f, new_op)))
-          return false;
-      } else if (auto new_op = dyn_cast<BufferAtOp>(op)) {
-        if (failed(runBufferAt(f, new_op)))
-          return false;
-      } else if (auto new_op = dyn_cast<ReshapeOp>(op)) {
-        Value array;
-        if (findArray(f, new_op.getTarget(), array)) {
-          if (failed(runReshape(f, new_op, array)))
-            return false;
-        } else {
-          return false;
-        }
-      } else if (auto new_op = dyn_cast<ReformOp>(op)) {
-        Value array;
-        if (findArray(f, new_op.getTarget(), array)) {
-          if (failed(runReform(f, new_op, array)))
-            return false;
-        } else {
-          return false;
-        }
-      } else if (auto new_op = dyn_cast<InterKernelToOp>(op)) {
-        Value array;
-        auto optional_fifo_depth = new_op.getFifoDepth();
-        unsigned int fifo_depth;
-        if (optional_fifo_depth.has_value()) {
-          fifo_depth = optional_fifo_depth.value();
-        } else {
-          fifo_depth = -1; // conservative assumption
-        }
-        if (findArray(f, new_op.getTarget(), array)) {
-          if (failed(
-                  runInterKernelDataPlacementSingleFunction(array, fifo_depth)))
-            return false;
-        } else {
-          return false;
-        }
-      } else if (auto new_op = dyn_cast<OutlineOp>(op)) {
-        if (failed(runOutline(mod, f, new_op)))
-          return false;
-      } else if (auto new_op = dyn_cast<ReplaceOp>(op)) {
-        Value src, dst;
-        if (findArray(f, new_op.getSrc(), src) &&
-            findArray(f, new_op.getDst(), dst)) {
-          if (failed(runReplaceOp(f, new_op, src, dst)))
-            return false;
-        } else {
-          return false;
-        }
-      }
+      if (failed(applyScheduleOp(mod, f, op)))
+        return false;
       opToRemove.push_back(&op);
     }
   }
@@ -0,0 +1,231 @@
+/*
+ * Copyright HeteroCL authors. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//===----------------------------------------------------------------------===//
+// Profile-guided optimization passes
+// ProfileInstrumentation makes a module count, in a global memref of i64, how
+// often each named loop is entered and iterates and how often each if takes
+// its then region. The global carries the keys of the profile sites, so that
+// its counters can be turned into a profile after a run, e.g. by the JIT.
+// ProfileAnnotation attaches such a profile to a module as "tripcount" =
+// [min, max, avg] attributes on loops and "taken_rate" attributes on ifs,
+// which the cost models and the HLS emitters use instead of static estimates.
+//===----------------------------------------------------------------------===//
+
+#include "PassDetail.h"
+
+#include "hcl/Support/Profile.h"
+#include "hcl/Transforms/Passes.h"
+
+#include "mlir/Dialect/Arith/IR/Arith.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/Dialect/MemRef/IR/MemRef.h"
+
+#include <limits>
+
+using namespace mlir;
+using namespace hcl;
+
+// Loops use four counters: entries, iterations, minimum and maximum trip
+// counts. Ifs use two: executions and taken then regions.
+static constexpr unsigned kNumLoopCounters = 4;
+static constexpr unsigned kNumBranchCounters = 2;
+
+/// Replaces counter `slot` with the result of `update` on its value.
+static void updateCounter(OpBuilder &builder, Location loc, Value counters,
+                          unsigned slot,
+                          function_ref<Value(Value)> update) {
+  Value index = builder.create<arith::ConstantIndexOp>(loc, slot);
+  Value count = builder.create<memref::LoadOp>(loc, counters, index);
+  builder.create<memref::StoreOp>(loc, update(count), counters, index);
+}
+
+static void incrementCounter(OpBuilder &builder, Location loc, Value counters,
+                             unsigned slot) {
+  updateCounter(builder, loc, counters, slot, [&](Value count) -> Value {
+    Value one = builder.create<arith::ConstantIntOp>(loc, 1, 64);
+    return builder.create<arith::AddIOp>(loc, count, one);
+  });
+}
+
+/// Counts the iterations of `loop` in a local counter, which is added to the
+/// counters of the loop whenever the loop exits.
+static void instrumentLoop(Operation *loop, Value counters, Value tripCount,
+                           unsigned slot) {
+  Location loc = loop->getLoc();
+  OpBuilder builder(loop);
+  Value zero = builder.create<arith::ConstantIntOp>(loc, 0, 64);
+  builder.create<memref::StoreOp>(loc, zero, tripCount);
+
+  builder.setInsertionPointToStart(&loop->getRegion(0).front());
+  Value count = builder.create<memref::LoadOp>(loc, tripCount);
+  Value one = builder.create<arith::ConstantIntOp>(loc, 1, 64);
+  Value next = builder.create<arith::AddIOp>(loc, count, one);
+  builder.create<memref::StoreOp>(loc, next, tripCount);
+
+  builder.setInsertionPointAfter(loop);
+  Value trips = builder.create<memref::LoadOp>(loc, tripCount);
+  incrementCounter(builder, loc, counters, slot);
+  updateCounter(builder, loc, counters, slot + 1, [&](Value count) -> Value {
+    return builder.create<arith::AddIOp>(loc, count, trips);
+  });
+  updateCounter(builder, loc, counters, slot + 2, [&](Value count) -> Value {
+    return builder.create<arith::MinSIOp>(loc, count, trips);
+  });
+  updateCounter(builder, loc, counters, slot + 3, [&](Value count) -> Value {
+    return builder.create<arith::MaxSIOp>(loc, count, trips);
+  });
+}
+
+static void instrumentBranch(Operation *ifOp, Value counters, unsigned slot) {
+  OpBuilder builder(ifOp);
+  incrementCounter(builder, ifOp->getLoc(), counters, slot);
+  builder.setInsertionPointToStart(&ifOp->getRegion(0).front());
+  incrementCounter(builder, ifOp->getLoc(), counters, slot + 1);
+}
+
+namespace mlir {
+namespace hcl {
+
+/// Pass entry point
+bool applyProfileInstrumentation(ModuleOp &mod) {
+  SmallVector<std::pair<func::FuncOp, SmallVector<ProfileSite>>, 4> funcSites;
+  SmallVector<Attribute, 16> loopKeys, branchKeys;
+  for (func::FuncOp func : mod.getOps<func::FuncOp>()) {
+    if (func.isExternal())
+      continue;
+    SmallVector<ProfileSite> sites;
+    getProfileSites(func, sites);
+    for (auto &site : sites)
+      (site.isLoop ? loopKeys : branchKeys)
+          .push_back(StringAttr::get(mod.getContext(), site.key));
+    if (!sites.empty())
+      funcSites.push_back({func, std::move(sites)});
+  }
+  if (funcSites.empty())
+    return true;
+
+  // The counters of the loops come first, then those of the ifs.
+  unsigned numCounters = loopKeys.size() * kNumLoopCounters +
+                         branchKeys.size() * kNumBranchCounters;
+  SmallVector<int64_t> init(numCounters, 0);
+  for (unsigned i = 0; i < loopKeys.size(); ++i)
+    init[i * kNumLoopCounters + 2] = std::numeric_limits<int64_t>::max();
+  OpBuilder builder = OpBuilder::atBlockBegin(mod.getBody());
+  Type i64 = builder.getI64Type();
+  auto type = MemRefType::get({(int64_t)numCounters}, i64);
+  auto initAttr =
+      DenseElementsAttr::get(RankedTensorType::get({(int64_t)numCounters}, i64),
+                             ArrayRef<int64_t>(init));
+  auto global = builder.create<memref::GlobalOp>(
+      mod.getLoc(), kProfileCountersName, /*sym_visibility=*/StringAttr(),
+      type, initAttr, /*constant=*/false, /*alignment=*/IntegerAttr());
+  global->setAttr("loops", builder.getArrayAttr(loopKeys));
+  global->setAttr("branches", builder.getArrayAttr(branchKeys));
+
+  unsigned loopSlot = 0;
+  unsigned branchSlot = loopKeys.size() * kNumLoopCounters;
+  for (auto &[func, sites] : funcSites) {
+    Location loc = func.getLoc();
+    builder.setInsertionPointToStart(&func.front());
+    Value counters =
+        builder.create<memref::GetGlobalOp>(loc, type, kProfileCountersName);
+    for (auto &site : sites) {
+      if (site.isLoop) {
+        Value tripCount =
+            builder.create<memref::AllocaOp>(loc, MemRefType::get({}, i64));
+        instrumentLoop(site.op, counters, tripCount, loopSlot);
+        loopSlot += kNumLoopCounters;
+      } else {
+        instrumentBranch(site.op, counters, branchSlot);
+        branchSlot += kNumBranchCounters;
+      }
+    }
+  }
+  return true;
+}
+
+/// Pass entry point
+bool applyProfileAnnotation(ModuleOp &mod, const Profile &profile) {
+  Builder builder(mod.getContext());
+  for (func::FuncOp func : mod.getOps<func::FuncOp>()) {
+    SmallVector<ProfileSite> sites;
+    getProfileSites(func, sites);
+    for (auto &site : sites) {
+      if (site.isLoop) {
+        auto it = profile.loops.find(site.key);
+        if (it == profile.loops.end() || it->second.entries <= 0)
+          continue;
+        const LoopProfile &loop = it->second;
+        int64_t avg = (loop.iterations + loop.entries / 2) / loop.entries;
+        site.op->setAttr("tripcount",
+                         builder.getDenseI64ArrayAttr(
+                             {loop.minTripCount, loop.maxTripCount, avg}));
+      } else {
+        auto it = profile.branches.find(site.key);
+        if (it == profile.branches.end() || it->second.executions <= 0)
+          continue;
+        const BranchProfile &branch = it->second;
+        site.op->setAttr("taken_rate",
+                         builder.getF64FloatAttr((double)branch.taken /
+                                                 branch.executions));
+      }
+    }
+  }
+  return true;
+}
+
+} // namespace hcl
+} // namespace mlir
+
+namespace {
+struct HCLProfileInstrumentation
+    : public ProfileInstrumentationBase<HCLProfileInstrumentation> {
+  void runOnOperation() override {
+    auto mod = getOperation();
+    if (!applyProfileInstrumentation(mod))
+      return signalPassFailure();
+  }
+};
+
+struct HCLProfileAnnotation
+    : public ProfileAnnotationBase<HCLProfileAnnotation> {
+  HCLProfileAnnotation() = default;
+  HCLProfileAnnotation(std::string profileFile) {
+    this->profileFile = profileFile;
+  }
+
+  void runOnOperation() override {
+    auto mod = getOperation();
+    Profile profile;
+    std::string error;
+    if (failed(readProfile(profileFile, profile, error))) {
+      mod.emitError(error);
+      return signalPassFailure();
+    }
+    if (!applyProfileAnnotation(mod, profile))
+      return signalPassFailure();
+  }
+};
+} // namespace
+
+namespace mlir {
+namespace hcl {
+
+std::unique_ptr<OperationPass<ModuleOp>> createProfileInstrumentationPass() {
+  return std::make_unique<HCLProfileInstrumentation>();
+}
+
+std::unique_ptr<OperationPass<ModuleOp>> createProfileAnnotationPass() {
+  return std::make_unique<HCLProfileAnnotation>();
+}
+
+std::unique_ptr<OperationPass<ModuleOp>>
+createProfileAnnotationPass(std::string profileFile) {
+  return std::make_unique<HCLProfileAnnotation>(profileFile);
+}
+
+} // namespace hcl
+} // namespace mlir
@@ -0,0 +1,535 @@
+/*
+ * Copyright HeteroCL authors. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//===----------------------------------------------------------------------===//
+// Resource budget
+// Estimates the DSPs, BRAMs and LUTs of a design from its operators, the
+// unroll factors of its loops and the partitions of its arrays, and fits the
+// design into a budget. While the estimate exceeds the budget, the unroll
+// factor of the loop using most of the resource over budget, and then the
+// partition factor saving most BRAMs, are halved, so the design keeps as
+// much parallelism as fits. Operators that still do not fit are limited per
+// stage by an `allocation` attribute, which the HLS emitter turns into
+// `#pragma HLS allocation`.
+//===----------------------------------------------------------------------===//
+
+#include "PassDetail.h"
+
+#include "hcl/Dialect/HeteroCLDialect.h"
+#include "hcl/Dialect/HeteroCLOps.h"
+#include "hcl/Dialect/HeteroCLTypes.h"
+#include "hcl/Support/Utils.h"
+#include "hcl/Transforms/Passes.h"
+
+#include "mlir/Dialect/Affine/Analysis/LoopAnalysis.h"
+#include "mlir/Dialect/Affine/IR/AffineOps.h"
+#include "mlir/Dialect/Arith/IR/Arith.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/Dialect/MemRef/IR/MemRef.h"
+
+#include "llvm/ADT/MapVector.h"
+#include "llvm/Support/Debug.h"
+
+#include <algorithm>
+
+#define DEBUG_TYPE "resource-budget"
+
+using namespace mlir;
+using namespace hcl;
+
+namespace {
+struct Resources {
+  int64_t dsp = 0;
+  // in 18Kb blocks
+  int64_t bram = 0;
+  int64_t lut = 0;
+};
+
+/// The cost of one instance of an operator, and the name of the operator in
+/// `#pragma HLS allocation`.
+struct OperatorCost {
+  StringRef kind;
+  int64_t dsp;
+  int64_t lut;
+};
+
+/// The instances of the operators of a kind and their total cost.
+struct OperatorUsage {
+  int64_t instances = 0;
+  int64_t dsp = 0;
+  int64_t lut = 0;
+};
+} // namespace
+
+using OperatorUsages = llvm::MapVector<StringRef, OperatorUsage>;
+
+// Banks up to this size are built from LUTs rather than BRAMs.
+static constexpr int64_t kMaxLutRamBits = 1024;
+static constexpr int64_t kBitsPerLutRam = 64;
+static constexpr int64_t kBitsPerBram = 18 * 1024;
+// Operators of at least this many LUTs are shared by HLS when limited.
+static constexpr int64_t kMinSharedLuts = 100;
+
+static bool exceeds(int64_t used, int64_t budget) {
+  return budget > 0 && used > budget;
+}
+
+static bool exceeds(const Resources &used, const Resources &budget) {
+  return exceeds(used.dsp, budget.dsp) || exceeds(used.bram, budget.bram) ||
+         exceeds(used.lut, budget.lut);
+}
+
+//===----------------------------------------------------------------------===//
+// Estimation
+//===----------------------------------------------------------------------===//
+
+static int64_t getBitWidth(Type type) {
+  if (auto fixedType = type.dyn_cast<FixedType>())
+    return fixedType.getWidth();
+  if (auto ufixedType = type.dyn_cast<UFixedType>())
+    return ufixedType.getWidth();
+  if (type.isIndex())
+    return 32;
+  if (type.isIntOrFloat())
+    return type.getIntOrFloatBitWidth();
+  return 0;
+}
+
+/// Rough costs of the operators on a 7-series or UltraScale device. Products
+/// are split into 18x27-bit DSP slices unless they are narrow; adders,
+/// comparators and dividers are built from LUTs.
+static std::optional<OperatorCost> getOperatorCost(Operation *op) {
+  if (op->getNumResults() != 1 || op->getNumOperands() == 0)
+    return std::nullopt;
+  int64_t width = getBitWidth(op->getOperand(0).getType());
+  if (width == 0)
+    return std::nullopt;
+  bool isDouble = width > 32;
+
+  if (isa<arith::MulIOp, MulFixedOp>(op)) {
+    if (width <= 10)
+      return OperatorCost{"mul", 0, width * width};
+    return OperatorCost{"mul", ((width + 17) / 18) * ((width + 26) / 27),
+                        width};
+  }
+  if (isa<arith::AddIOp, AddFixedOp>(op))
+    return OperatorCost{"add", 0, width};
+  if (isa<arith::SubIOp, SubFixedOp>(op))
+    return OperatorCost{"sub", 0, width};
+  if (isa<arith::CmpIOp, CmpFixedOp>(op))
+    return OperatorCost{"icmp", 0, width};
+  if (isa<arith::DivSIOp, DivFixedOp>(op))
+    return OperatorCost{"sdiv", 0, width * width};
+  if (isa<arith::DivUIOp>(op))
+    return OperatorCost{"udiv", 0, width * width};
+  if (isa<arith::RemSIOp>(op))
+    return OperatorCost{"srem", 0, width * width};
+  if (isa<arith::RemUIOp>(op))
+    return OperatorCost{"urem", 0, width * width};
+  if (isa<arith::MulFOp>(op))
+    return isDouble ? OperatorCost{"dmul", 11, 300}
+                    : OperatorCost{"fmul", 3, 100};
+  if (isa<arith::AddFOp>(op))
+    return isDouble ? OperatorCost{"dadd", 3, 650}
+                    : OperatorCost{"fadd", 2, 220};
+  if (isa<arith::SubFOp>(op))
+    return isDouble ? OperatorCost{"dsub", 3, 650}
+                    : OperatorCost{"fsub", 2, 220};
+  if (isa<arith::DivFOp>(op))
+    return isDouble ? OperatorCost{"ddiv", 0, 3200}
+                    : OperatorCost{"fdiv", 0, 800};
+  return std::nullopt;
+}
+
+static int64_t getTripCount(AffineForOp forOp) {
+  if (auto tripCount = getConstantTripCount(forOp))
+    return std::max<int64_t>(*tripCount, 1);
+  return 1;
+}
+
+static bool isInPipelinedLoop(AffineForOp forOp) {
+  for (auto parent = forOp->getParentOfType<AffineForOp>(); parent;
+       parent = parent->getParentOfType<AffineForOp>())
+    if (parent->hasAttr("pipeline_ii"))
+      return true;
+  return false;
+}
+
+/// Returns how many copies of the body of a loop HLS builds. Loops in a
+/// pipelined loop are unrolled completely, the others by their unroll
+/// factor, where 0 means completely.
+static int64_t getNumCopies(AffineForOp forOp) {
+  if (isInPipelinedLoop(forOp))
+    return getTripCount(forOp);
+  auto unroll = forOp->getAttrOfType<IntegerAttr>("unroll");
+  if (!unroll)
+    return 1;
+  int64_t factor = unroll.getInt();
+  if (factor <= 0)
+    return getTripCount(forOp);
+  if (!getConstantTripCount(forOp))
+    return factor;
+  return std::min(factor, getTripCount(forOp));
+}
+
+/// Returns the operators built for the operations in `root`.
+static OperatorUsages getOperatorUsages(Operation *root) {
+  OperatorUsages usages;
+  root->walk([&](Operation *op) {
+    auto cost = getOperatorCost(op);
+    if (!cost)
+      return;
+    int64_t copies = 1;
+    for (auto loop = op->getParentOfType<AffineForOp>(); loop;
+         loop = loop->getParentOfType<AffineForOp>())
+      copies *= getNumCopies(loop);
+    auto &usage = usages[cost->kind];
+    usage.instances += copies;
+    usage.dsp += copies * cost->dsp;
+    usage.lut += copies * cost->lut;
+  });
+  return usages;
+}
+
+/// Operators HLS can share between operations when their instances are
+/// limited.
+static bool isShared(const OperatorUsage &usage) {
+  return usage.dsp > 0 || usage.lut >= kMinSharedLuts * usage.instances;
+}
+
+/// Returns the resources of the operators of a stage, within the limits of
+/// its `allocation` attribute.
+static Resources getStageResources(AffineForOp stage) {
+  Resources res;
+  auto limits = stage->getAttrOfType<DictionaryAttr>("allocation");
+  for (auto &[kind, usage] : getOperatorUsages(stage)) {
+    int64_t instances = usage.instances;
+    if (limits)
+      if (auto limit = limits.getAs<IntegerAttr>(kind))
+        instances = std::min(instances, limit.getInt());
+    res.dsp += usage.dsp * instances / usage.instances;
+    res.lut += usage.lut * instances / usage.instances;
+  }
+  return res;
+}
+
+/// Whether the layout of an array is the partition map of hcl.partition,
+/// i.e. the bank indices followed by the addresses in the banks.
+static bool isPartitioned(MemRefType type) {
+  return getLayoutMap(type) &&
+         type.getLayout().getAffineMap().getNumResults() == 2 * type.getRank();
+}
+
+/// Returns the number of banks of a dimension of a partitioned array.
+static int64_t getNumBanks(MemRefType type, unsigned dim) {
+  if (isFullyPartitioned(type, dim))
+    return type.getShape()[dim];
+  SmallVector<int64_t, 8> factors;
+  getPartitionFactors(type, &factors);
+  return factors[dim];
+}
+
+/// Each bank of an array takes whole BRAMs, unless it is small enough to be
+/// built from LUTs. Streams are FIFOs and are not counted.
+static Resources getArrayResources(MemRefType type) {
+  Resources res;
+  if (!type.hasStaticShape())
+    return res;
+  if (auto space = type.getMemorySpace().dyn_cast_or_null<StringAttr>())
+    if (space.getValue().starts_with("stream"))
+      return res;
+  int64_t width = getBitWidth(type.getElementType());
+  int64_t banks = 1;
+  if (isPartitioned(type))
+    for (unsigned dim = 0; dim < type.getRank(); ++dim)
+      banks *= getNumBanks(type, dim);
+  int64_t bits = type.getNumElements() * width;
+  int64_t bankBits = (bits + banks - 1) / banks;
+  if (bankBits <= kMaxLutRamBits)
+    res.lut = banks * ((bankBits + kBitsPerLutRam - 1) / kBitsPerLutRam);
+  else
+    res.bram = banks * ((bankBits + kBitsPerBram - 1) / kBitsPerBram);
+  return res;
+}
+
+/// Operators and arrays are not shared between stages, so their resources
+/// add up.
+static Resources estimateResources(ArrayRef<AffineForOp> stages,
+                                   ArrayRef<memref::AllocOp> arrays) {
+  Resources res;
+  for (auto stage : stages) {
+    auto stageRes = getStageResources(stage);
+    res.dsp += stageRes.dsp;
+    res.lut += stageRes.lut;
+  }
+  for (auto array : arrays) {
+    auto arrayRes = getArrayResources(array.getType());
+    res.bram += arrayRes.bram;
+    res.lut += arrayRes.lut;
+  }
+  return res;
+}
+
+//===----------------------------------------------------------------------===//
+// Fitting
+//===----------------------------------------------------------------------===//
+
+/// Returns the largest factor up to `maxFactor` that divides the trip count
+/// of the loop, so that no remainder iterations are left.
+static int64_t getUnrollFactor(AffineForOp forOp, int64_t maxFactor) {
+  auto tripCount = getConstantTripCount(forOp);
+  if (!tripCount)
+    return maxFactor;
+  for (int64_t factor = maxFactor; factor > 1; --factor)
+    if (*tripCount % factor == 0)
+      return factor;
+  return 1;
+}
+
+/// Halves the unroll factor of the loop whose operators take the most DSPs,
+/// or LUTs if those are over budget instead. Returns false if no unrolled
+/// loop uses any.
+static bool reduceUnrolling(ArrayRef<AffineForOp> stages,
+                            const Resources &used, const Resources &budget) {
+  bool reduceDSP = exceeds(used.dsp, budget.dsp);
+  AffineForOp target;
+  int64_t targetCost = 0;
+  for (auto stage : stages) {
+    stage.walk([&](AffineForOp forOp) {
+      // Loops in pipelined loops are unrolled whatever their factor.
+      if (!forOp->hasAttr("unroll") || isInPipelinedLoop(forOp) ||
+          getNumCopies(forOp) <= 1)
+        return;
+      int64_t cost = 0;
+      for (auto &[kind, usage] : getOperatorUsages(forOp))
+        cost += reduceDSP ? usage.dsp : usage.lut;
+      if (cost > targetCost) {
+        target = forOp;
+        targetCost = cost;
+      }
+    });
+  }
+  if (!target)
+    return false;
+
+  int64_t factor = getUnrollFactor(target, getNumCopies(target) / 2);
+  LLVM_DEBUG(llvm::dbgs() << "unroll " << getLoopName(target) << " by "
+                          << factor << "\n");
+  if (factor <= 1)
+    target->removeAttr("unroll");
+  else
+    target->setAttr("unroll",
+                    Builder(target->getContext()).getI32IntegerAttr(factor));
+  return true;
+}
+
+/// Returns the array type with dimension `dim` split into `factor` banks,
+/// keeping the partition kind of the layout map built by hcl.partition.
+static MemRefType getPartitionedType(MemRefType type, unsigned dim,
+                                     int64_t factor) {
+  auto *ctx = type.getContext();
+  unsigned rank = type.getRank();
+  auto layout = type.getLayout().getAffineMap();
+  SmallVector<AffineExpr, 8> results(layout.getResults().begin(),
+                                     layout.getResults().end());
+  AffineExpr index = getAffineDimExpr(dim, ctx);
+  if (factor <= 1) {
+    results[dim] = getAffineConstantExpr(0, ctx);
+    results[dim + rank] = index;
+  } else if (results[dim].getKind() == AffineExprKind::Mod) {
+    results[dim] = index % factor;
+    results[dim + rank] = index.floorDiv(factor);
+  } else {
+    int64_t blockSize = (type.getShape()[dim] + factor - 1) / factor;
+    results[dim] = index.floorDiv(blockSize);
+    results[dim + rank] = index % blockSize;
+  }
+  auto layoutMap = AffineMap::get(rank, 0, results, ctx);
+  return MemRefType::get(type.getShape(), type.getElementType(), layoutMap,
+                         type.getMemorySpace());
+}
+
+/// Whether the type of an array can change: its users must accept any layout,
+/// and if it is returned, the signature of its function is updated, which the
+/// callers of the function would not follow.
+static bool canRetype(memref::AllocOp array) {
+  auto func = array->getParentOfType<func::FuncOp>();
+  for (auto user : array->getUsers()) {
+    if (isa<affine::AffineReadOpInterface, affine::AffineWriteOpInterface,
+            memref::LoadOp, memref::StoreOp, memref::DeallocOp>(user))
+      continue;
+    if (isa<func::ReturnOp>(user) && user->getParentOp() == func &&
+        SymbolTable::symbolKnownUseEmpty(func, func->getParentOp()))
+      continue;
+    return false;
+  }
+  return true;
+}
+
+/// Halves the cyclic or block partition factor that saves the most BRAMs.
+/// Complete partitions are kept, as their banks are registers. Returns false
+/// if no partition saves any.
+static bool reducePartitioning(ArrayRef<memref::AllocOp> arrays) {
+  memref::AllocOp target;
+  MemRefType targetType;
+  int64_t targetSaving = 0;
+  for (auto array : arrays) {
+    auto type = array.getType();
+    if (!isPartitioned(type))
+      continue;
+    if (!canRetype(array))
+      continue;
+    SmallVector<int64_t, 8> factors;
+    getPartitionFactors(type, &factors);
+    for (unsigned dim = 0; dim < type.getRank(); ++dim) {
+      if (isFullyPartitioned(type, dim) || factors[dim] <= 1)
+        continue;
+      auto newType = getPartitionedType(type, dim, factors[dim] / 2);
+      int64_t saving = getArrayResources(type).bram -
+                       getArrayResources(newType).bram;
+      if (saving > targetSaving) {
+        target = array;
+        targetType = newType;
+        targetSaving = saving;
+      }
+    }
+  }
+  if (!target)
+    return false;
+
+  LLVM_DEBUG(llvm::dbgs() << "repartition " << target << " as " << targetType
+                          << "\n");
+  target.getResult().setType(targetType);
+
+  // update function signature
+  auto func = target->getParentOfType<func::FuncOp>();
+  auto resultTypes = func.front().getTerminator()->getOperandTypes();
+  auto inputTypes = func.front().getArgumentTypes();
+  func.setType(FunctionType::get(func.getContext(), inputTypes, resultTypes));
+  return true;
+}
+
+/// Limits the instances of the shared operators of each stage by the same
+/// ratio, so that they fit into what the other operators and the arrays
+/// leave of the budget.
+static void limitOperators(ArrayRef<AffineForOp> stages,
+                           ArrayRef<memref::AllocOp> arrays,
+                           const Resources &budget) {
+  SmallVector<OperatorUsages, 8> stageUsages;
+  Resources shared, fixed = estimateResources({}, arrays);
+  for (auto stage : stages) {
+    stageUsages.push_back(getOperatorUsages(stage));
+    for (auto &[kind, usage] : stageUsages.back()) {
+      auto &res = isShared(usage) ? shared : fixed;
+      res.dsp += usage.dsp;
+      res.lut += usage.lut;
+    }
+  }
+
+  double ratio = 1.0;
+  if (exceeds(shared.dsp + fixed.dsp, budget.dsp) && shared.dsp > 0)
+    ratio = std::min(ratio, std::max<double>(budget.dsp - fixed.dsp, 0) /
+                                shared.dsp);
+  if (exceeds(shared.lut + fixed.lut, budget.lut) && shared.lut > 0)
+    ratio = std::min(ratio, std::max<double>(budget.lut - fixed.lut, 0) /
+                                shared.lut);
+  if (ratio >= 1.0)
+    return;
+
+  for (auto [stage, usages] : llvm::zip(stages, stageUsages)) {
+    auto *ctx = stage->getContext();
+    NamedAttrList limits;
+    if (auto attr = stage->getAttrOfType<DictionaryAttr>("allocation"))
+      limits.append(attr.getValue());
+    for (auto &[kind, usage] : usages) {
+      if (!isShared(usage))
+        continue;
+      int64_t limit =
+          std::max<int64_t>(1, (int64_t)(usage.instances * ratio));
+      if (auto prev = limits.get(kind).dyn_cast_or_null<IntegerAttr>())
+        limit = std::min(limit, prev.getInt());
+      if (limit < usage.instances)
+        limits.set(kind, Builder(ctx).getI32IntegerAttr(limit));
+    }
+    if (!limits.empty())
+      stage->setAttr("allocation", limits.getDictionary(ctx));
+  }
+}
+
+namespace mlir {
+namespace hcl {
+
+bool applyResourceBudget(ModuleOp &module, unsigned dsp, unsigned bram,
+                         unsigned lut) {
+  Resources budget{dsp, bram, lut};
+  // Stages are the loop nests at the top level of the functions, and arrays
+  // the buffers they allocate; the arguments are external memories.
+  SmallVector<AffineForOp, 16> stages;
+  SmallVector<memref::AllocOp, 16> arrays;
+  for (auto func : module.getOps<func::FuncOp>()) {
+    if (func.isExternal())
+      continue;
+    for (auto forOp : func.front().getOps<AffineForOp>())
+      stages.push_back(forOp);
+    func.walk([&](memref::AllocOp alloc) { arrays.push_back(alloc); });
+  }
+
+  Resources used = estimateResources(stages, arrays);
+  LLVM_DEBUG(llvm::dbgs() << "estimate: " << used.dsp << " DSP, " << used.bram
+                          << " BRAM, " << used.lut << " LUT\n");
+  while ((exceeds(used.dsp, budget.dsp) || exceeds(used.lut, budget.lut)) &&
+         reduceUnrolling(stages, used, budget))
+    used = estimateResources(stages, arrays);
+  while (exceeds(used.bram, budget.bram) && reducePartitioning(arrays))
+    used = estimateResources(stages, arrays);
+  if (exceeds(used.dsp, budget.dsp) || exceeds(used.lut, budget.lut)) {
+    limitOperators(stages, arrays, budget);
+    used = estimateResources(stages, arrays);
+  }
+  LLVM_DEBUG(llvm::dbgs() << "fitted: " << used.dsp << " DSP, " << used.bram
+                          << " BRAM, " << used.lut << " LUT\n");
+
+  if (exceeds(used, budget))
+    module.emitWarning("estimated resources (")
+        << used.dsp << " DSP, " << used.bram << " BRAM, " << used.lut
+        << " LUT) exceed the budget (" << dsp << " DSP, " << bram
+        << " BRAM, " << lut << " LUT)";
+  return true;
+}
+
+} // namespace hcl
+} // namespace mlir
+
+namespace {
+struct HCLResourceBudget : public ResourceBudgetBase<HCLResourceBudget> {
+  HCLResourceBudget() = default;
+  HCLResourceBudget(unsigned dsp, unsigned bram, unsigned lut) {
+    this->dsp = dsp;
+    this->bram = bram;
+    this->lut = lut;
+  }
+
+  void runOnOperation() override {
+    auto mod = getOperation();
+    if (!applyResourceBudget(mod, dsp, bram, lut))
+      return signalPassFailure();
+  }
+};
+} // namespace
+
+namespace mlir {
+namespace hcl {
+
+std::unique_ptr<OperationPass<ModuleOp>> createResourceBudgetPass() {
+  return std::make_unique<HCLResourceBudget>();
+}
+
+std::unique_ptr<OperationPass<ModuleOp>>
+createResourceBudgetPass(unsigned dsp, unsigned bram, unsigned lut) {
+  return std::make_unique<HCLResourceBudget>(dsp, bram, lut);
+}
+
+} // namespace hcl
+} // namespace mlir
@@ -0,0 +1,297 @@
+/*
+ * Copyright HeteroCL authors. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "hcl/Transforms/ScheduleSession.h"
+#include "hcl/Dialect/HeteroCLDialect.h"
+#include "hcl/Transforms/Passes.h"
+
+#include "mlir/IR/IRMapping.h"
+
+#include "llvm/ADT/Hashing.h"
+#include "llvm/ADT/SetVector.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/xxhash.h"
+
+#include <set>
+#include <tuple>
+
+using namespace mlir;
+using namespace hcl;
+
+//===----------------------------------------------------------------------===//
+// Incremental scheduling
+//
+// A schedule is the sequence of primitives of all functions, in module order.
+// The values a primitive refers to are identified by a ValueKey, which does not
+// depend on the module holding them: a function argument, the result of the
+// n-th non-schedule operation of a function, or the result of the n-th
+// primitive. Step i of a schedule is fingerprinted by the base IR and the
+// primitives before it, including their attributes and operand keys.
+//
+// While a schedule is replayed, every value a primitive refers to is kept in
+// use by an anchor (an unrealized_conversion_cast before the terminator of its
+// function). The primitives link their results with replaceAllUsesWith, so the
+// anchor always points at the current value of a key, e.g. the loop handle a
+// split produced. Snapshots copy the anchors along with the IR; on resumption,
+// the remaining primitives are cloned into the snapshot with their operands
+// remapped through the anchors and then applied as usual.
+//===----------------------------------------------------------------------===//
+
+namespace {
+/// (function, kind, index, result number)
+using ValueKey = std::tuple<unsigned, unsigned, unsigned, unsigned>;
+enum ValueKind : unsigned { FuncArgument, BaseResult, StepResult };
+
+struct Step {
+  unsigned func;
+  Operation *op;
+};
+} // namespace
+
+struct ScheduleSession::Snapshot {
+  OwningOpRef<ModuleOp> module;
+  std::map<ValueKey, Operation *> anchors;
+};
+
+ScheduleSession::ScheduleSession(unsigned maxSnapshots)
+    : maxSnapshots(maxSnapshots) {}
+
+ScheduleSession::~ScheduleSession() = default;
+
+void ScheduleSession::clear() {
+  snapshots.clear();
+  snapshotOrder.clear();
+}
+
+void ScheduleSession::addSnapshot(uint64_t key,
+                                  std::unique_ptr<Snapshot> snapshot) {
+  if (maxSnapshots == 0)
+    return;
+  while (snapshots.size() >= maxSnapshots) {
+    snapshots.erase(snapshotOrder.front());
+    snapshotOrder.pop_front();
+  }
+  snapshots.emplace(key, std::move(snapshot));
+  snapshotOrder.push_back(key);
+}
+
+static Operation *createAnchor(func::FuncOp f, Value value) {
+  OpBuilder builder(f.getBody().front().getTerminator());
+  Type type = value.getType();
+  return builder.create<UnrealizedConversionCastOp>(value.getLoc(),
+                                                     TypeRange(type), value);
+}
+
+/// Clones `module` into `clone` and returns the mapping from the top-level
+/// operations of its functions to their copies.
+static DenseMap<Operation *, Operation *>
+cloneModule(ModuleOp module, OwningOpRef<ModuleOp> &clone) {
+  clone = module.clone();
+  DenseMap<Operation *, Operation *> opMap;
+  for (auto [f, newF] : llvm::zip(module.getOps<func::FuncOp>(),
+                                  (*clone).getOps<func::FuncOp>()))
+    for (auto [op, newOp] : llvm::zip(f.getOps(), newF.getOps()))
+      opMap[&op] = &newOp;
+  return opMap;
+}
+
+/// Fingerprints the module without its schedule primitives.
+static llvm::hash_code hashBaseIR(ModuleOp module) {
+  OwningOpRef<ModuleOp> base = module.clone();
+  for (auto f : (*base).getOps<func::FuncOp>()) {
+    SmallVector<Operation *> primitives;
+    for (Operation &op : f.getOps())
+      if (isHCLOp(op))
+        primitives.push_back(&op);
+    for (Operation *op : llvm::reverse(primitives)) {
+      op->dropAllUses();
+      op->erase();
+    }
+  }
+  std::string text;
+  llvm::raw_string_ostream os(text);
+  (*base).print(os, OpPrintingFlags().useLocalScope());
+  return llvm::hash_combine(
+      module.getContext(),
+      llvm::xxh3_64bits(llvm::arrayRefFromStringRef(os.str())));
+}
+
+LogicalResult ScheduleSession::apply(ModuleOp module) {
+  numReusedSteps = numAppliedSteps = 0;
+  OwningOpRef<ModuleOp> work = module.clone();
+  auto funcs = llvm::to_vector((*work).getOps<func::FuncOp>());
+
+  // 1) Inline customizations into the functions applying them
+  std::map<std::string, hcl::CustomizationOp> customizationMap;
+  for (auto c : (*work).getOps<hcl::CustomizationOp>())
+    customizationMap[c.getName().str()] = c;
+  llvm::SetVector<Operation *> customizationOps;
+  for (auto f : funcs) {
+    SmallVector<Operation *, 10> opToRemove;
+    applyCustomization(f, customizationMap, opToRemove);
+    customizationOps.insert(opToRemove.begin(), opToRemove.end());
+  }
+  for (Operation *op : llvm::reverse(customizationOps))
+    op->erase();
+
+  // 2) Collect the primitives and key the values they may refer to
+  SmallVector<Step> steps;
+  DenseMap<Value, ValueKey> keys;
+  for (auto item : llvm::enumerate(funcs)) {
+    unsigned fi = item.index();
+    func::FuncOp f = item.value();
+    if (f.isExternal())
+      continue;
+    for (BlockArgument arg : f.getArguments())
+      keys[arg] = {fi, FuncArgument, arg.getArgNumber(), 0};
+    unsigned numBaseOps = 0;
+    for (Operation &op : f.getOps()) {
+      bool isPrimitive = isHCLOp(op);
+      unsigned index = isPrimitive ? steps.size() : numBaseOps++;
+      for (OpResult result : op.getResults())
+        keys[result] = {fi, isPrimitive ? StepResult : BaseResult, index,
+                        result.getResultNumber()};
+      if (isPrimitive)
+        steps.push_back({fi, &op});
+    }
+  }
+  std::set<ValueKey> usedKeys;
+  for (Step &step : steps)
+    for (Value operand : step.op->getOperands()) {
+      // Values nested in regions cannot be keyed; replay without caching.
+      if (!keys.count(operand))
+        return success(applyLoopTransformation(module));
+      usedKeys.insert(keys[operand]);
+    }
+
+  // 3) Fingerprint every prefix of the schedule. Whether a later primitive
+  // still refers to a buffer can change what a primitive does (e.g.
+  // compute_at removes unused buffers), so the buffers the rest of the
+  // schedule refers to are part of the key as well.
+  SmallVector<uint64_t> snapshotKeys;
+  llvm::hash_code hash = hashBaseIR(*work);
+  for (unsigned i = 0; i <= steps.size(); ++i) {
+    if (i > 0) {
+      Operation *op = steps[i - 1].op;
+      std::string attrs;
+      llvm::raw_string_ostream os(attrs);
+      op->getAttrDictionary().print(os);
+      hash = llvm::hash_combine(hash, steps[i - 1].func,
+                                op->getName().getStringRef(), os.str());
+      for (Value operand : op->getOperands()) {
+        auto [fi, kind, index, resultNo] = keys[operand];
+        hash = llvm::hash_combine(hash, fi, kind, index, resultNo);
+      }
+    }
+    std::set<ValueKey> liveBuffers;
+    for (unsigned j = i; j < steps.size(); ++j)
+      for (Value operand : steps[j].op->getOperands()) {
+        ValueKey key = keys[operand];
+        if (operand.getType().isa<MemRefType>() &&
+            std::get<1>(key) != FuncArgument &&
+            (std::get<1>(key) != StepResult || std::get<2>(key) < i))
+          liveBuffers.insert(key);
+      }
+    llvm::hash_code key = hash;
+    for (auto [fi, kind, index, resultNo] : liveBuffers)
+      key = llvm::hash_combine(key, fi, kind, index, resultNo);
+    snapshotKeys.push_back((uint64_t)(size_t)key);
+  }
+
+  // 4) Find the longest cached prefix holding every value the rest of the
+  // schedule refers to
+  auto isResumable = [&](Snapshot &snapshot, unsigned start) {
+    for (unsigned j = start; j < steps.size(); ++j)
+      for (Value operand : steps[j].op->getOperands()) {
+        ValueKey key = keys[operand];
+        if ((std::get<1>(key) != StepResult || std::get<2>(key) < start) &&
+            !snapshot.anchors.count(key))
+          return false;
+      }
+    return true;
+  };
+  unsigned start = 0;
+  Snapshot *resume = nullptr;
+  for (unsigned i = steps.size(); i > 0; --i) {
+    auto it = snapshots.find(snapshotKeys[i]);
+    if (it != snapshots.end() && isResumable(*it->second, i)) {
+      start = i;
+      resume = it->second.get();
+      break;
+    }
+  }
+
+  // 5) Set up the IR to schedule, with the remaining primitives in place
+  Snapshot state;
+  SmallVector<Operation *> liveOps(steps.size(), nullptr);
+  if (resume) {
+    auto opMap = cloneModule(*resume->module, state.module);
+    for (auto &[key, anchor] : resume->anchors)
+      state.anchors[key] = opMap.lookup(anchor);
+    IRMapping mapping;
+    for (unsigned i = start; i < steps.size(); ++i) {
+      for (Value operand : steps[i].op->getOperands())
+        if (!mapping.contains(operand))
+          mapping.map(operand, state.anchors[keys[operand]]->getOperand(0));
+      StringRef funcName = funcs[steps[i].func].getSymName();
+      auto f = (*state.module).lookupSymbol<func::FuncOp>(funcName);
+      OpBuilder builder(f.getBody().front().getTerminator());
+      liveOps[i] = builder.clone(*steps[i].op, mapping);
+    }
+  } else {
+    for (unsigned i = 0; i < steps.size(); ++i) {
+      liveOps[i] = steps[i].op;
+      for (Value operand : steps[i].op->getOperands()) {
+        ValueKey key = keys[operand];
+        if (std::get<1>(key) != StepResult && !state.anchors.count(key))
+          state.anchors[key] = createAnchor(funcs[std::get<0>(key)], operand);
+      }
+    }
+    state.module = std::move(work);
+  }
+  numReusedSteps = start;
+
+  // 6) Apply the remaining primitives, taking a snapshot after each of them
+  ModuleOp mod = *state.module;
+  for (unsigned i = start; i < steps.size(); ++i) {
+    Operation *op = liveOps[i];
+    auto f = op->getParentOfType<func::FuncOp>();
+    for (OpResult result : op->getResults()) {
+      ValueKey key = keys[steps[i].op->getResult(result.getResultNumber())];
+      if (usedKeys.count(key))
+        state.anchors[key] = createAnchor(f, result);
+    }
+    if (failed(applyScheduleOp(mod, f, *op)))
+      return failure();
+    ++numAppliedSteps;
+
+    if (snapshots.count(snapshotKeys[i + 1]))
+      continue;
+    auto snapshot = std::make_unique<Snapshot>();
+    auto opMap = cloneModule(mod, snapshot->module);
+    for (auto &[key, anchor] : state.anchors)
+      snapshot->anchors[key] = opMap.lookup(anchor);
+    // Primitives that are not applied yet are cloned again on resumption.
+    for (unsigned j = steps.size(); j > i + 1; --j) {
+      Operation *pending = opMap.lookup(liveOps[j - 1]);
+      pending->dropAllUses();
+      pending->erase();
+    }
+    addSnapshot(snapshotKeys[i + 1], std::move(snapshot));
+  }
+
+  // 7) Remove the anchors and the schedule, and hand the result over
+  for (auto &[key, anchor] : state.anchors)
+    anchor->erase();
+  for (auto f : mod.getOps<func::FuncOp>()) {
+    SmallVector<Operation *, 10> opToRemove;
+    for (Operation &op : f.getOps())
+      if (isHCLOp(op))
+        opToRemove.push_back(&op);
+    eraseScheduleOp(f, opToRemove);
+  }
+  module.getBodyRegion().takeBody(mod.getBodyRegion());
+  return success();
+}
@@ -0,0 +1,218 @@
+/*
+ * Copyright HeteroCL authors. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//===----------------------------------------------------------------------===//
+// ShapeSpecialization Pass
+// Kernels with dynamic shapes, e.g. those kernel-dedup merges with
+// dynamic-shapes, take their loop bounds as index arguments, so that trip
+// counts are unknown when unrolling, pipelining or tiling. This pass creates
+// one version of such a kernel per hot shape listed in its `hot_shapes`
+// attribute, which a profile or the user provides. Each shape gives the values
+// of the index arguments, in order, e.g.
+//
+//   func.func @kernel(%A: memref<?xf32>, %n: index)
+//       attributes {hot_shapes = [array<i64: 32>, array<i64: 1024>]}
+//
+// In a version, the index arguments are replaced by constants and the body is
+// canonicalized, which makes the loop bounds constant. The kernel itself then
+// dispatches to the version matching its arguments, or to a copy of the
+// original body for the other shapes.
+//===----------------------------------------------------------------------===//
+
+#include "PassDetail.h"
+#include "hcl/Transforms/Passes.h"
+
+#include "mlir/Dialect/Arith/IR/Arith.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/Dialect/SCF/IR/SCF.h"
+#include "mlir/IR/SymbolTable.h"
+#include "mlir/Transforms/GreedyPatternRewriteDriver.h"
+
+using namespace mlir;
+using namespace hcl;
+
+static constexpr StringLiteral kHotShapesAttrName = "hot_shapes";
+
+/// Returns the hot shapes of `func`, or failure if they do not match the
+/// index arguments of `func`.
+static LogicalResult getHotShapes(func::FuncOp func, ArrayAttr shapesAttr,
+                                  unsigned numIndexArgs,
+                                  SmallVectorImpl<ArrayRef<int64_t>> &shapes) {
+  if (numIndexArgs == 0)
+    return func.emitError("hot shapes require index arguments");
+  for (Attribute attr : shapesAttr) {
+    auto shape = attr.dyn_cast<DenseI64ArrayAttr>();
+    if (!shape || shape.size() != numIndexArgs)
+      return func.emitError("expected each hot shape to be an array of ")
+             << numIndexArgs << " integers";
+    shapes.push_back(shape.asArrayRef());
+  }
+  return success();
+}
+
+/// Clones `func` without its body, as a private function named `name` placed
+/// before `func`.
+static func::FuncOp cloneDeclaration(func::FuncOp func, StringRef name,
+                                     SymbolTable &symbolTable) {
+  auto clone = func.cloneWithoutRegions();
+  clone.setName(name);
+  clone.setPrivate();
+  clone->removeAttr("top");
+  clone->removeAttr(kHotShapesAttrName);
+  symbolTable.insert(clone, func->getIterator());
+  return clone;
+}
+
+/// Creates the version of `generic` for `shape`, given the values of its
+/// index arguments `indexArgs`.
+static func::FuncOp specialize(func::FuncOp generic, func::FuncOp func,
+                               ArrayRef<BlockArgument> indexArgs,
+                               ArrayRef<int64_t> shape,
+                               const FrozenRewritePatternSet &patterns,
+                               SymbolTable &symbolTable) {
+  std::string name = func.getName().str();
+  for (int64_t size : shape)
+    name += "_" + std::to_string(size);
+  auto version = cloneDeclaration(func, name, symbolTable);
+  IRMapping mapping;
+  generic.getBody().cloneInto(&version.getBody(), mapping);
+
+  OpBuilder builder = OpBuilder::atBlockBegin(&version.front());
+  for (auto [arg, size] : llvm::zip(indexArgs, shape)) {
+    Value cst = builder.create<arith::ConstantIndexOp>(func.getLoc(), size);
+    mapping.lookup(Value(arg)).replaceAllUsesWith(cst);
+  }
+  (void)applyPatternsAndFoldGreedily(version, patterns);
+  return version;
+}
+
+/// Builds the calls to the versions starting at `index`, each guarded by the
+/// comparison of the index arguments with its shape, and returns their
+/// results.
+static ValueRange buildDispatch(OpBuilder &builder, Location loc,
+                                func::FuncOp func,
+                                ArrayRef<BlockArgument> indexArgs,
+                                ArrayRef<ArrayRef<int64_t>> shapes,
+                                ArrayRef<func::FuncOp> versions,
+                                func::FuncOp generic, unsigned index) {
+  ValueRange args = func.getArguments();
+  if (index == versions.size())
+    return builder.create<func::CallOp>(loc, generic, args).getResults();
+
+  Value cond;
+  for (auto [arg, size] : llvm::zip(indexArgs, shapes[index])) {
+    Value cst = builder.create<arith::ConstantIndexOp>(loc, size);
+    Value eq = builder.create<arith::CmpIOp>(loc, arith::CmpIPredicate::eq,
+                                             arg, cst);
+    if (cond)
+      cond = builder.create<arith::AndIOp>(loc, cond, eq);
+    else
+      cond = eq;
+  }
+  auto ifOp = builder.create<scf::IfOp>(
+      loc, func.getResultTypes(), cond,
+      [&](OpBuilder &thenBuilder, Location loc) {
+        auto call =
+            thenBuilder.create<func::CallOp>(loc, versions[index], args);
+        thenBuilder.create<scf::YieldOp>(loc, call.getResults());
+      },
+      [&](OpBuilder &elseBuilder, Location loc) {
+        ValueRange results = buildDispatch(elseBuilder, loc, func, indexArgs,
+                                           shapes, versions, generic,
+                                           index + 1);
+        elseBuilder.create<scf::YieldOp>(loc, results);
+      });
+  return ifOp.getResults();
+}
+
+static LogicalResult specializeShapes(func::FuncOp func, ArrayAttr shapesAttr,
+                                      const FrozenRewritePatternSet &patterns,
+                                      SymbolTable &symbolTable) {
+  SmallVector<BlockArgument, 4> indexArgs;
+  for (BlockArgument arg : func.getArguments())
+    if (arg.getType().isIndex())
+      indexArgs.push_back(arg);
+  SmallVector<ArrayRef<int64_t>, 4> shapes;
+  if (failed(getHotShapes(func, shapesAttr, indexArgs.size(), shapes)))
+    return failure();
+
+  // The original body becomes the generic fallback
+  auto generic = cloneDeclaration(func, func.getName().str() + "_generic",
+                                  symbolTable);
+  generic.getBody().takeBody(func.getBody());
+
+  SmallVector<func::FuncOp, 4> versions;
+  for (ArrayRef<int64_t> shape : shapes)
+    versions.push_back(
+        specialize(generic, func, indexArgs, shape, patterns, symbolTable));
+
+  // The kernel keeps its signature and dispatches on its index arguments
+  Block *entry = func.addEntryBlock();
+  indexArgs.clear();
+  for (BlockArgument arg : func.getArguments())
+    if (arg.getType().isIndex())
+      indexArgs.push_back(arg);
+  OpBuilder builder = OpBuilder::atBlockBegin(entry);
+  ValueRange results = buildDispatch(builder, func.getLoc(), func, indexArgs,
+                                     shapes, versions, generic, 0);
+  builder.create<func::ReturnOp>(func.getLoc(), results);
+  func->removeAttr(kHotShapesAttrName);
+  return success();
+}
+
+namespace mlir {
+namespace hcl {
+
+/// Pass entry point
+bool applyShapeSpecialization(ModuleOp &mod) {
+  MLIRContext *ctx = mod.getContext();
+  RewritePatternSet patterns(ctx);
+  for (Dialect *dialect : ctx->getLoadedDialects())
+    dialect->getCanonicalizationPatterns(patterns);
+  for (RegisteredOperationName op : ctx->getRegisteredOperations())
+    op.getCanonicalizationPatterns(patterns, ctx);
+  FrozenRewritePatternSet frozenPatterns(std::move(patterns));
+
+  SymbolTable symbolTable(mod);
+  SmallVector<func::FuncOp, 4> funcs;
+  for (func::FuncOp func : mod.getOps<func::FuncOp>())
+    if (!func.isExternal() && func->hasAttr(kHotShapesAttrName))
+      funcs.push_back(func);
+  for (func::FuncOp func : funcs) {
+    auto shapesAttr = func->getAttrOfType<ArrayAttr>(kHotShapesAttrName);
+    if (!shapesAttr) {
+      func.emitError("expected hot_shapes to be an array");
+      return false;
+    }
+    if (failed(specializeShapes(func, shapesAttr, frozenPatterns,
+                                symbolTable)))
+      return false;
+  }
+  return true;
+}
+
+} // namespace hcl
+} // namespace mlir
+
+namespace {
+struct HCLShapeSpecialization
+    : public ShapeSpecializationBase<HCLShapeSpecialization> {
+  void runOnOperation() override {
+    auto mod = getOperation();
+    if (!applyShapeSpecialization(mod))
+      return signalPassFailure();
+  }
+};
+} // namespace
+
+namespace mlir {
+namespace hcl {
+
+std::unique_ptr<OperationPass<ModuleOp>> createShapeSpecializationPass() {
+  return std::make_unique<HCLShapeSpecialization>();
+}
+
+} // namespace hcl
+} // namespace mlir
@@ -10,6 +10,27 @@
 using namespace mlir;
 using namespace hcl;
 
+namespace mlir {
+namespace hcl {
+
+/// Applies the top-level transform ops of the module, e.g.
+/// `transform.sequence`, to the module and erases them.
+bool applyTransformInterpreter(ModuleOp &module) {
+  auto transforms = llvm::to_vector(
+      module.getBody()->getOps<transform::TransformOpInterface>());
+  for (transform::TransformOpInterface transform : transforms) {
+    if (failed(transform::applyTransforms(
+            module, transform, /*extraMapping=*/{},
+            transform::TransformOptions().enableExpensiveChecks())))
+      return false;
+    transform->erase();
+  }
+  return true;
+}
+
+} // namespace hcl
+} // namespace mlir
+
 namespace {
 struct TransformInterpreter
     : public hcl::TransformInterpreterBase<TransformInterpreter> {
@@ -19,14 +40,8 @@ struct TransformInterpreter
 
 void TransformInterpreter::runOnOperation() {
   ModuleOp module = getOperation();
-  // transform::TransformState state(
-  //     module.getBodyRegion(), module,
-  //     transform::TransformOptions().enableExpensiveChecks());
-  // for (auto op : module.getBody()->getOps<transform::TransformOpInterface>())
-  // {
-  //   if (failed(state.applyTransform(op).checkAndReport()))
-  //     return signalPassFailure();
-  // }
+  if (!applyTransformInterpreter(module))
+    return signalPassFailure();
 }
 
 std::unique_ptr<OperationPass<ModuleOp>> hcl::createTransformInterpreterPass() {
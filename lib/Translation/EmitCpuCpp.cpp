@@ -0,0 +1,489 @@
+/*
+ * Copyright HeteroCL authors. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ * Modification: ScaleHLS
+ * https://github.com/hanchenye/scalehls
+ */
+
+#include "hcl/Translation/EmitCpuCpp.h"
+#include "hcl/Support/Utils.h"
+#include "hcl/Translation/CppEmitter.h"
+#include "mlir/Dialect/Affine/Analysis/AffineAnalysis.h"
+#include "mlir/Dialect/Affine/Analysis/LoopAnalysis.h"
+#include "mlir/InitAllDialects.h"
+#include "mlir/Tools/mlir-translate/Translation.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "hcl/Dialect/HeteroCLDialect.h"
+#include "hcl/Dialect/HeteroCLOps.h"
+
+using namespace mlir;
+using namespace hcl;
+
+//===----------------------------------------------------------------------===//
+// Utils
+//===----------------------------------------------------------------------===//
+
+// Arrays with more elements than this are allocated on the heap instead of
+// the stack, since CPU threads have much smaller stacks than on-chip memory.
+static const int64_t MAX_STACK_ARRAY_SIZE = 4096;
+
+static const char *deviceHeader = R"XXX(
+//===------------------------------------------------------------*- C++ -*-===//
+//
+// Automatically generated file for CPU execution.
+// Build with, e.g., g++ -std=c++17 -O3 -march=native -fopenmp
+//
+//===----------------------------------------------------------------------===//
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+using namespace std;
+
+template <typename T> struct hcl_unsigned {
+  using type = typename make_unsigned<T>::type;
+};
+#ifdef __SIZEOF_INT128__
+template <> struct hcl_unsigned<__int128> {
+  using type = unsigned __int128;
+};
+template <> struct hcl_unsigned<unsigned __int128> {
+  using type = unsigned __int128;
+};
+#endif
+
+// Returns bits [lo, hi] of x.
+template <typename T> static inline T hcl_get_slice(T x, int64_t hi, int64_t lo) {
+  using U = typename hcl_unsigned<T>::type;
+  int64_t width = hi - lo + 1;
+  U v = U(x) >> lo;
+  if (width < int64_t(sizeof(T) * 8))
+    v &= (U(1) << width) - 1;
+  return T(v);
+}
+
+// Returns x with bits [lo, hi] replaced by the low bits of val.
+template <typename T, typename V>
+static inline T hcl_set_slice(T x, int64_t hi, int64_t lo, V val) {
+  using U = typename hcl_unsigned<T>::type;
+  int64_t width = hi - lo + 1;
+  U mask = width < int64_t(sizeof(T) * 8) ? (U(1) << width) - 1 : ~U(0);
+  return T((U(x) & ~(mask << lo)) | ((U(val) & mask) << lo));
+}
+
+// Truncates x to its lowest width bits, which are sign-extended for signed
+// types, since integers of other widths are stored in wider native types.
+template <typename T> static inline T hcl_wrap(T x, int width) {
+  using U = typename hcl_unsigned<T>::type;
+  U mask = (U(1) << width) - 1;
+  U v = U(x) & mask;
+  if (T(-1) < T(0) && ((v >> (width - 1)) & 1))
+    v |= ~mask;
+  return T(v);
+}
+
+// Returns the lowest width bits of x as an unsigned value, i.e., x
+// zero-extended from its width, for operations with unsigned semantics.
+template <typename T>
+static inline typename hcl_unsigned<T>::type hcl_zext(T x, int width) {
+  using U = typename hcl_unsigned<T>::type;
+  return U(x) & ((U(1) << width) - 1);
+}
+
+// Reverses the lowest width bits of x.
+template <typename T> static inline T hcl_bit_reverse(T x, int width) {
+  using U = typename hcl_unsigned<T>::type;
+  U v = U(x), r = 0;
+  for (int i = 0; i < width; ++i, v >>= 1)
+    r = (r << 1) | (v & 1);
+  return T(r);
+}
+
+)XXX";
+
+static const char *hostHeader = R"XXX(
+//===------------------------------------------------------------*- C++ -*-===//
+//
+// Automatically generated file for host
+//
+//===----------------------------------------------------------------------===//
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+
+#include "kernel.h"
+using namespace std;
+
+)XXX";
+
+/// Returns true if values of the given type cannot be represented with a
+/// native C++ type.
+static bool isUnsupportedType(Type type) {
+  if (auto arrayType = type.dyn_cast<ShapedType>())
+    type = arrayType.getElementType();
+  if (type.isa<hcl::FixedType, hcl::UFixedType>())
+    return true;
+  if (auto intType = type.dyn_cast<IntegerType>())
+    return intType.getWidth() > 128;
+  return false;
+}
+
+/// Returns true if the given affine loop is the innermost loop of its nest
+/// and carries no dependence, so that its iterations can be vectorized.
+static bool isVectorizableLoop(AffineForOp forOp) {
+  bool isInnermost = true;
+  forOp.getBody()->walk([&](Operation *op) {
+    if (isa<AffineForOp, AffineParallelOp, scf::ForOp, scf::WhileOp,
+            func::CallOp>(op))
+      isInnermost = false;
+  });
+  return isInnermost && affine::isLoopParallel(forOp);
+}
+
+/// Returns true if the given loop is nested in a loop which is already
+/// parallelized with OpenMP.
+static bool isInParallelLoop(Operation *op) {
+  for (auto parent = op->getParentOp(); parent;
+       parent = parent->getParentOp()) {
+    if (isa<AffineForOp, scf::ForOp>(parent) &&
+        getLoopDirective(parent, "parallel"))
+      return true;
+    if (auto parallelOp = dyn_cast<AffineParallelOp>(parent))
+      if (parallelOp.getNumResults() == 0)
+        return true;
+  }
+  return false;
+}
+
+//===----------------------------------------------------------------------===//
+// CpuCppEmitter Class Declaration
+//===----------------------------------------------------------------------===//
+
+namespace {
+class CpuCppEmitter : public CppEmitterBase {
+public:
+  explicit CpuCppEmitter(HCLEmitterState &state) : CppEmitterBase(state) {}
+
+  /// Bit-level operation emitters with the helpers of the device header.
+  void emitGetBit(hcl::GetIntBitOp op) override;
+  void emitSetBit(hcl::SetIntBitOp op) override;
+  void emitGetSlice(hcl::GetIntSliceOp op) override;
+  void emitSetSlice(hcl::SetIntSliceOp op) override;
+  void emitBitReverse(hcl::BitReverseOp op) override;
+
+  void emitModule(ModuleOp module) override;
+
+protected:
+  SmallString<16> getTargetTypeName(Type valType) override;
+  StringRef getDeviceHeader() override { return deviceHeader; }
+  StringRef getHostHeader() override { return hostHeader; }
+
+  // CPUs have no FIFOs, so streamed arrays are emitted as plain arrays.
+  StringAttr getStreamSpace(Value memref) override { return StringAttr(); }
+
+  void emitAllocDecl(Value memref, bool isAlloca, std::string name) override;
+  void emitUnsignedOperand(Value val, unsigned rank) override;
+  void emitResultWrap(Operation *op) override;
+
+  /// OpenMP pragma emitters.
+  void emitLoopHeadDirectives(Operation *op) override;
+};
+} // namespace
+
+//===----------------------------------------------------------------------===//
+// CpuCppEmitter Class Definition
+//===----------------------------------------------------------------------===//
+
+// Arbitrary-precision integers are widened to the nearest native integer type,
+// and wrapped to their widths by emitResultWrap. Returns an empty string for
+// types without a native C++ equivalent, i.e., fixed-point types and integers
+// wider than 128 bits.
+SmallString<16> CpuCppEmitter::getTargetTypeName(Type valType) {
+  // Handle integer types.
+  if (auto intType = valType.dyn_cast<IntegerType>()) {
+    unsigned width = intType.getWidth();
+    if (width == 1)
+      return SmallString<16>("bool");
+
+    std::string signedness = "";
+    if (intType.getSignedness() == IntegerType::SignednessSemantics::Unsigned)
+      signedness = "u";
+    if (width <= 64) {
+      unsigned nativeWidth = 8;
+      while (nativeWidth < width)
+        nativeWidth *= 2;
+      return SmallString<16>(signedness + "int" + std::to_string(nativeWidth) +
+                             "_t");
+    }
+    if (width <= 128)
+      return SmallString<16>(signedness == "u" ? "unsigned __int128"
+                                               : "__int128");
+  }
+
+  return SmallString<16>();
+}
+
+void CpuCppEmitter::emitGetBit(hcl::GetIntBitOp op) {
+  indent();
+  Value result = op.getResult();
+  fixUnsignedType(result, op->hasAttr("unsigned"));
+  emitValue(result);
+  os << " = (";
+  emitValue(op.getNum());
+  os << " >> ";
+  emitValue(op.getIndex());
+  os << ") & 1;";
+  emitInfoAndNewLine(op);
+}
+
+void CpuCppEmitter::emitSetBit(hcl::SetIntBitOp op) {
+  indent();
+  emitValue(op.getResult());
+  os << " = hcl_set_slice(";
+  emitValue(op.getNum());
+  os << ", ";
+  emitValue(op.getIndex());
+  os << ", ";
+  emitValue(op.getIndex());
+  os << ", ";
+  emitValue(op.getVal());
+  os << ");";
+  emitInfoAndNewLine(op);
+}
+
+void CpuCppEmitter::emitGetSlice(hcl::GetIntSliceOp op) {
+  indent();
+  Value result = op.getResult();
+  fixUnsignedType(result, op->hasAttr("unsigned"));
+  emitValue(result);
+  os << " = hcl_get_slice(";
+  emitValue(op.getNum());
+  os << ", ";
+  emitValue(op.getHi());
+  os << ", ";
+  emitValue(op.getLo());
+  os << ");";
+  emitInfoAndNewLine(op);
+}
+
+void CpuCppEmitter::emitSetSlice(hcl::SetIntSliceOp op) {
+  indent();
+  emitValue(op.getResult());
+  os << " = hcl_set_slice(";
+  emitValue(op.getNum());
+  os << ", ";
+  emitValue(op.getHi());
+  os << ", ";
+  emitValue(op.getLo());
+  os << ", ";
+  emitValue(op.getVal());
+  os << ");";
+  emitInfoAndNewLine(op);
+}
+
+void CpuCppEmitter::emitBitReverse(hcl::BitReverseOp op) {
+  indent();
+  Value result = op.getResult();
+  fixUnsignedType(result, op->hasAttr("unsigned"));
+  emitValue(result);
+  os << " = hcl_bit_reverse(";
+  emitValue(op.getNum());
+  // The value may be stored in a wider native type, so pass its real width.
+  os << ", " << op.getNum().getType().getIntOrFloatBitWidth() << ");";
+  emitInfoAndNewLine(op);
+}
+
+void CpuCppEmitter::emitAllocDecl(Value memref, bool isAlloca,
+                                  std::string name) {
+  auto arrayType = memref.getType().cast<ShapedType>();
+  if (isAlloca || !arrayType.hasStaticShape() ||
+      arrayType.getNumElements() <= MAX_STACK_ARRAY_SIZE) {
+    emitArrayDecl(memref, false, name);
+    return;
+  }
+
+  // Large buffers are owned by a unique_ptr, so that they are released at the
+  // end of the enclosing scope and memref.dealloc can be ignored.
+  auto shape = arrayType.getShape();
+  auto typeName = getTypeName(memref);
+  auto varName = addName(memref, false, name);
+  os << "std::unique_ptr<" << typeName << "[]";
+  for (auto dim : llvm::drop_begin(shape, 1))
+    os << "[" << dim << "]";
+  os << "> " << varName << "_buf(new " << typeName;
+  for (auto dim : shape)
+    os << "[" << dim << "]";
+  os << ");\n";
+  indent();
+  os << "auto " << varName << " = " << varName << "_buf.get()";
+}
+
+// Signless integers are stored in signed types, so the operands of unsigned
+// operations are cast to the unsigned type of the same width. Operands of
+// non-native widths are zero-extended from their width first.
+void CpuCppEmitter::emitUnsignedOperand(Value val, unsigned rank) {
+  auto intType = getElementTypeOrSelf(val.getType()).dyn_cast<IntegerType>();
+  if (!intType || intType.getWidth() == 1 || intType.isUnsigned()) {
+    emitValue(val, rank);
+    return;
+  }
+
+  unsigned width = intType.getWidth();
+  if (width < 8 || !llvm::isPowerOf2_32(width)) {
+    os << "hcl_zext(";
+    emitValue(val, rank);
+    os << ", " << width << ")";
+    return;
+  }
+  os << "(" << getTargetTypeName(IntegerType::get(
+                   val.getContext(), width, IntegerType::Unsigned))
+     << ")";
+  emitValue(val, rank);
+}
+
+// Integers of non-native widths are stored in the next wider native type, so
+// the results of operations which may leave the range of their width are
+// truncated and sign-extended. Other operations keep their operands in range,
+// e.g., arith.extui zero-extends into a strictly wider type.
+void CpuCppEmitter::emitResultWrap(Operation *op) {
+  if (!isa<arith::AddIOp, arith::SubIOp, arith::MulIOp, arith::DivSIOp,
+           arith::DivUIOp, arith::RemUIOp, arith::ShLIOp, arith::ShRUIOp,
+           arith::MaxUIOp, arith::MinUIOp, arith::TruncIOp, arith::IndexCastOp,
+           arith::FPToSIOp, arith::FPToUIOp, math::AbsIOp, hcl::GetIntSliceOp,
+           hcl::SetIntBitOp, hcl::SetIntSliceOp, hcl::BitReverseOp>(op))
+    return;
+
+  for (auto result : op->getResults()) {
+    auto intType =
+        getElementTypeOrSelf(result.getType()).dyn_cast<IntegerType>();
+    if (!intType)
+      continue;
+    unsigned width = intType.getWidth();
+    if (width == 1 || (width >= 8 && llvm::isPowerOf2_32(width)))
+      continue;
+
+    unsigned rank = emitNestedLoopHead(result);
+    indent();
+    emitValue(result, rank);
+    os << " = hcl_wrap(";
+    emitValue(result, rank);
+    os << ", " << width << ");";
+    emitInfoAndNewLine(op);
+    emitNestedLoopTail(rank);
+  }
+}
+
+// OpenMP and GCC loop pragmas must directly precede the loop statement, so
+// no loop label is emitted. The loop name still names the induction variable.
+void CpuCppEmitter::emitLoopHeadDirectives(Operation *op) {
+  // Reductions are accumulated sequentially by the AffineYieldOp emitter, so
+  // only parallel loops without results are distributed across threads.
+  if (auto parallelOp = dyn_cast<AffineParallelOp>(op)) {
+    if (parallelOp.getNumResults() == 0 && !isInParallelLoop(op)) {
+      indent();
+      os << "#pragma omp parallel for";
+      if (parallelOp.getNumDims() > 1)
+        os << " collapse(" << parallelOp.getNumDims() << ")";
+      os << "\n";
+    }
+    return;
+  }
+
+  // Only the outermost parallel loop forks threads. Nested ones run
+  // sequentially within each thread.
+  bool isParallel =
+      getLoopDirective(op, "parallel") && !isInParallelLoop(op);
+
+  // Unrolling is requested explicitly and takes precedence over automatic
+  // vectorization of innermost loops.
+  std::optional<int64_t> unrollFactor;
+  if (auto factor = getLoopDirective(op, "unroll")) {
+    int64_t val = factor.cast<IntegerAttr>().getInt();
+    if (val == 0) {
+      // Full unrolling needs a constant trip count on CPUs.
+      if (auto forOp = dyn_cast<AffineForOp>(op))
+        if (auto tripCount = affine::getConstantTripCount(forOp))
+          unrollFactor = *tripCount;
+    } else
+      unrollFactor = val;
+  }
+
+  bool isSimd = false;
+  if (auto forOp = dyn_cast<AffineForOp>(op))
+    isSimd = !unrollFactor && isVectorizableLoop(forOp);
+
+  if (isParallel) {
+    indent();
+    os << "#pragma omp parallel for";
+    if (isSimd)
+      os << " simd";
+    os << "\n";
+  } else if (isSimd) {
+    indent();
+    os << "#pragma omp simd\n";
+  }
+
+  // GCC rejects any other pragma between an OpenMP loop pragma and the loop.
+  if (unrollFactor && *unrollFactor > 1 && !isParallel) {
+    indent();
+    os << "#pragma GCC unroll " << *unrollFactor << "\n";
+  }
+}
+
+/// Top-level MLIR module emitter.
+void CpuCppEmitter::emitModule(ModuleOp module) {
+  // Fixed-point and wide integer types have no native C++ equivalent and are
+  // expected to be lowered before emission.
+  module.walk([&](Operation *op) {
+    bool unsupported = llvm::any_of(op->getResultTypes(), isUnsupportedType);
+    if (auto func = dyn_cast<func::FuncOp>(op))
+      unsupported |=
+          llvm::any_of(func.getArgumentTypes(), isUnsupportedType);
+    if (auto global = dyn_cast<memref::GlobalOp>(op))
+      unsupported |= isUnsupportedType(global.getType());
+    if (unsupported)
+      emitError(op, "has a type without native C++ support, please lower it "
+                    "first (e.g., with --fixed-to-integer).");
+  });
+  if (state.encounteredError)
+    return;
+
+  CppEmitterBase::emitModule(module);
+}
+
+//===----------------------------------------------------------------------===//
+// Entry of hcl-translate
+//===----------------------------------------------------------------------===//
+
+LogicalResult hcl::emitCpuCpp(ModuleOp module, llvm::raw_ostream &os) {
+  HCLEmitterState state(os);
+  CpuCppEmitter(state).emitModule(module);
+  return failure(state.encounteredError);
+}
+
+void hcl::registerEmitCpuCppTranslation() {
+  static TranslateFromMLIRRegistration toCpuCpp(
+      "emit-cpu-cpp", "Emit C++ with OpenMP pragmas for CPUs", emitCpuCpp,
+      [&](DialectRegistry &registry) {
+        // clang-format off
+        registry.insert<
+          mlir::hcl::HeteroCLDialect,
+          mlir::func::FuncDialect,
+          mlir::arith::ArithDialect,
+          mlir::tensor::TensorDialect,
+          mlir::scf::SCFDialect,
+          mlir::affine::AffineDialect,
+          mlir::math::MathDialect,
+          mlir::memref::MemRefDialect,
+          mlir::linalg::LinalgDialect
+        >();
+        // clang-format on
+      });
+}
\ No newline at end of file
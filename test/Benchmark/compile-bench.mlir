@@ -0,0 +1,12 @@
+// Copyright HeteroCL authors. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+// RUN: hcl-compile-bench -sizes=1,2 -repeat=1 -const-size=16 | FileCheck %s
+// RUN: hcl-compile-bench -sizes=1,2 -repeat=1 -const-size=16 -write-baseline=%t.json > /dev/null
+// RUN: hcl-compile-bench -sizes=1,2 -repeat=1 -const-size=16 -baseline=%t.json -exponent-slack=100 | FileCheck %s --check-prefix=BASELINE
+
+// CHECK: loop-opt {{.*}} complexity ~ O(N^
+// CHECK: fixed-to-integer {{.*}} complexity ~ O(N^
+// CHECK: lower-composite-type {{.*}} complexity ~ O(N^
+// CHECK: emit-vivado-hls {{.*}} complexity ~ O(N^
+// BASELINE: no compile-time regressions against the baseline
@@ -0,0 +1,10 @@
+// Copyright HeteroCL authors. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+// RUN: %PYTHON %S/../../benchmark/startup.py --hcl-opt hcl-opt --hcl-translate hcl-translate --runs 1 --json %t.json | FileCheck %s
+// RUN: %PYTHON %S/../../benchmark/startup.py --hcl-opt hcl-opt --hcl-translate hcl-translate --runs 1 --baseline %t.json --tolerance 100 > /dev/null
+
+// CHECK: opt-parse
+// CHECK: opt-loop-opt
+// CHECK: opt-lower-to-llvm
+// CHECK: translate-vivado-hls
@@ -0,0 +1,77 @@
+# Copyright HeteroCL authors. All Rights Reserved.
+# SPDX-License-Identifier: Apache-2.0
+
+# RUN: %PYTHON %s
+
+from hcl_mlir.ir import Context, Module
+from hcl_mlir.dialects import hcl as hcl_d
+
+
+def make_design(unroll):
+    return f"""
+    module {{
+        func.func @gemm(%A: memref<64x32xf32>, %B: memref<32x64xf32>, %C: memref<64x64xf32>)
+        {{
+            %s = hcl.create_op_handle "s"
+            %li = hcl.create_loop_handle %s, "i"
+            %lj = hcl.create_loop_handle %s, "j"
+            %lk = hcl.create_loop_handle %s, "k"
+            affine.for %i = 0 to 64 {{
+                affine.for %j = 0 to 64 {{
+                    affine.for %k = 0 to 32 {{
+                        %a = affine.load %A[%i, %k] : memref<64x32xf32>
+                        %b = affine.load %B[%k, %j] : memref<32x64xf32>
+                        %c = affine.load %C[%i, %j] : memref<64x64xf32>
+                        %prod = arith.mulf %a, %b : f32
+                        %sum = arith.addf %prod, %c: f32
+                        affine.store %sum, %C[%i, %j] : memref<64x64xf32>
+                    }} {{ loop_name = "k" }}
+                }} {{ loop_name = "j" }}
+            }} {{ loop_name = "i", op_name = "s" }}
+            %li_outer, %li_inner = hcl.split (%li, 16)
+            %lj_out, %lj_in, %lk_out, %lk_in = hcl.tile (%lj, %lk, 16, 8)
+            hcl.pipeline (%lk_out, 1)
+            hcl.unroll (%lk_in, {unroll})
+            return
+        }}
+    }}
+    """
+
+
+def reference(code):
+    ctx = Context()
+    hcl_d.register_dialect(ctx)
+    mod = Module.parse(code, ctx)
+    hcl_d.loop_transformation(mod)
+    return str(mod)
+
+
+def test_schedule_session():
+    ctx = Context()
+    hcl_d.register_dialect(ctx)
+    session = hcl_d.ScheduleSession()
+
+    mod = Module.parse(make_design(4), ctx)
+    assert session.apply(mod)
+    assert session.reused_steps == 0 and session.applied_steps == 4
+    assert str(mod) == reference(make_design(4))
+
+    # Only the last primitive changed: resume after the first three.
+    mod = Module.parse(make_design(8), ctx)
+    assert session.apply(mod)
+    assert session.reused_steps == 3 and session.applied_steps == 1
+    assert str(mod) == reference(make_design(8))
+
+    # An identical schedule is served entirely from the cache.
+    mod = Module.parse(make_design(4), ctx)
+    assert session.apply(mod)
+    assert session.reused_steps == 4 and session.applied_steps == 0
+    assert str(mod) == reference(make_design(4))
+
+    session.clear()
+    assert session.num_snapshots == 0
+    print("Done incremental scheduling")
+
+
+if __name__ == "__main__":
+    test_schedule_session()
@@ -0,0 +1,70 @@
+# Copyright HeteroCL authors. All Rights Reserved.
+# SPDX-License-Identifier: Apache-2.0
+
+# RUN: %PYTHON %s
+
+import io
+from concurrent.futures import ThreadPoolExecutor
+from hcl_mlir.ir import Context, Module
+from hcl_mlir.dialects import hcl as hcl_d
+
+
+def make_design(tile):
+    return f"""
+    module {{
+        func.func @gemm(%A: memref<64x64xf32>, %B: memref<64x64xf32>, %C: memref<64x64xf32>)
+        {{
+            %s = hcl.create_op_handle "s"
+            %li = hcl.create_loop_handle %s, "i"
+            %lj = hcl.create_loop_handle %s, "j"
+            affine.for %i = 0 to 64 {{
+                affine.for %j = 0 to 64 {{
+                    affine.for %k = 0 to 64 {{
+                        %a = affine.load %A[%i, %k] : memref<64x64xf32>
+                        %b = affine.load %B[%k, %j] : memref<64x64xf32>
+                        %c = affine.load %C[%i, %j] : memref<64x64xf32>
+                        %prod = arith.mulf %a, %b : f32
+                        %sum = arith.addf %prod, %c: f32
+                        affine.store %sum, %C[%i, %j] : memref<64x64xf32>
+                    }} {{ loop_name = "k" }}
+                }} {{ loop_name = "j" }}
+            }} {{ loop_name = "i", op_name = "s" }}
+            %li_out, %li_in, %lj_out, %lj_in = hcl.tile (%li, %lj, {tile}, {tile})
+            hcl.pipeline (%lj_in, 1)
+            return
+        }}
+    }}
+    """
+
+
+def compile_design(code, ctx=None):
+    if ctx is None:
+        ctx = Context()
+        hcl_d.register_dialect(ctx)
+    mod = Module.parse(code, ctx)
+    assert hcl_d.loop_transformation(mod)
+    buf = io.StringIO()
+    assert hcl_d.emit_vhls(mod, buf)
+    return buf.getvalue()
+
+
+def test_threads():
+    designs = [make_design(tile) for tile in (2, 4, 8, 16) * 4]
+    expected = [compile_design(code) for code in designs]
+
+    # One context per design: compiled in parallel.
+    with ThreadPoolExecutor(max_workers=8) as pool:
+        results = list(pool.map(compile_design, designs))
+    assert results == expected
+
+    # A shared context: calls are serialized by the context lock.
+    ctx = Context()
+    hcl_d.register_dialect(ctx)
+    with ThreadPoolExecutor(max_workers=8) as pool:
+        results = list(pool.map(lambda code: compile_design(code, ctx), designs))
+    assert results == expected
+    print("Done concurrent compilation")
+
+
+if __name__ == "__main__":
+    test_threads()
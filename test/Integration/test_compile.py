@@ -0,0 +1,211 @@
+# Copyright HeteroCL authors. All Rights Reserved.
+# SPDX-License-Identifier: Apache-2.0
+
+# RUN: %PYTHON %s
+import os
+import tempfile
+
+import numpy as np
+
+from hcl_mlir.ir import Context, Module
+from hcl_mlir.dialects import hcl as hcl_d
+
+
+def test_compile_inplace(M=4, N=8):
+    mlir_code = f"""
+    module {{
+        func.func @top(%A: memref<{M}x{N}xf32>, %B: memref<{M}x{N}xf32>) attributes {{top}}
+        {{
+            affine.for %i = 0 to {M} {{
+                affine.for %j = 0 to {N} {{
+                    %a = affine.load %A[%i, %j] : memref<{M}x{N}xf32>
+                    %b = arith.addf %a, %a : f32
+                    affine.store %b, %B[%i, %j] : memref<{M}x{N}xf32>
+                }} {{ loop_name = "j" }}
+            }} {{ loop_name = "i", op_name = "s" }}
+            return
+        }}
+    }}
+    """
+    ctx = Context()
+    hcl_d.register_dialect(ctx)
+    mod = Module.parse(mlir_code, ctx)
+
+    hcl_d.clear_compile_cache()
+    exe = hcl_d.compile(mod)
+    assert hcl_d.compile_cache_size() == 1
+    A = np.random.rand(M, N).astype(np.float32)
+    B = np.zeros((M, N), dtype=np.float32)
+    assert exe(A, B) is None
+    assert np.allclose(B, A + A)
+
+    # Compiling the same module again hits the cache.
+    assert hcl_d.compile(mod) is exe
+    assert hcl_d.compile_cache_size() == 1
+
+    # Mismatched dtypes and non-contiguous views are rejected, not copied.
+    for bad in (A.astype(np.float64), np.zeros((N, M), np.float32).T):
+        try:
+            exe(bad, B)
+        except ValueError:
+            pass
+        else:
+            raise RuntimeError("expected ValueError")
+
+
+def test_compile_return(N=16):
+    mlir_code = f"""
+    module {{
+        func.func @top(%A: memref<{N}xi32>) -> memref<{N}xi32> attributes {{top}}
+        {{
+            %B = memref.alloc() : memref<{N}xi32>
+            affine.for %i = 0 to {N} {{
+                %a = affine.load %A[%i] : memref<{N}xi32>
+                %b = arith.muli %a, %a : i32
+                affine.store %b, %B[%i] : memref<{N}xi32>
+            }} {{ loop_name = "i", op_name = "s" }}
+            return %B : memref<{N}xi32>
+        }}
+    }}
+    """
+    ctx = Context()
+    hcl_d.register_dialect(ctx)
+    mod = Module.parse(mlir_code, ctx)
+    exe = hcl_d.compile(mod, cache=False)
+    A = np.arange(N, dtype=np.int32)
+    B = exe(A)
+    assert B.dtype == np.int32 and B.shape == (N,)
+    assert np.array_equal(B, A * A)
+
+
+def test_stream(M=4, N=8, rows=10):
+    mlir_code = f"""
+    module {{
+        func.func @top(%A: memref<{M}x{N}xf32>, %B: memref<{M}x{N}xf32>) -> memref<{M}x{N}xf32> attributes {{top}}
+        {{
+            %C = memref.alloc() : memref<{M}x{N}xf32>
+            affine.for %i = 0 to {M} {{
+                affine.for %j = 0 to {N} {{
+                    %a = affine.load %A[%i, %j] : memref<{M}x{N}xf32>
+                    %b = arith.addf %a, %a : f32
+                    affine.store %b, %B[%i, %j] : memref<{M}x{N}xf32>
+                    %c = arith.mulf %a, %a : f32
+                    affine.store %c, %C[%i, %j] : memref<{M}x{N}xf32>
+                }} {{ loop_name = "j" }}
+            }} {{ loop_name = "i", op_name = "s" }}
+            return %C : memref<{M}x{N}xf32>
+        }}
+    }}
+    """
+    ctx = Context()
+    hcl_d.register_dialect(ctx)
+    mod = Module.parse(mlir_code, ctx)
+    exe = hcl_d.compile(mod, cache=False)
+
+    # The rows do not fill the last chunk, which is padded.
+    A = np.random.rand(rows, N).astype(np.float32)
+    with tempfile.TemporaryDirectory() as tmp:
+        a_path, b_path, c_path = (os.path.join(tmp, f) for f in "abc")
+        A.tofile(a_path)
+        # Chunks of one batch, then of two batches (two calls per chunk).
+        for chunk_rows in (0, 2 * M):
+            assert exe.stream([a_path, None], outputs=[c_path],
+                              updates={1: b_path},
+                              chunk_rows=chunk_rows) == rows
+            B = np.fromfile(b_path, dtype=np.float32).reshape(rows, N)
+            C = np.fromfile(c_path, dtype=np.float32).reshape(rows, N)
+            assert np.allclose(B, A + A)
+            assert np.allclose(C, A * A)
+
+        # Chunks must hold whole batches.
+        try:
+            exe.stream([a_path, None], outputs=[c_path], chunk_rows=M + 1)
+        except ValueError:
+            pass
+        else:
+            raise RuntimeError("expected ValueError")
+
+
+def test_profile(N=8):
+    mlir_code = f"""
+    module {{
+        func.func @top(%A: memref<{N}xi32>, %B: memref<{N}xi32>) attributes {{top}}
+        {{
+            %c0 = arith.constant 0 : index
+            %c1 = arith.constant 1 : index
+            %one = arith.constant 1 : i32
+            %two = arith.constant 2 : i32
+            affine.for %i = 0 to {N} {{
+                %a = affine.load %A[%i] : memref<{N}xi32>
+                %n = arith.index_cast %a : i32 to index
+                scf.for %j = %c0 to %n step %c1 {{
+                    %b = memref.load %B[%i] : memref<{N}xi32>
+                    %b1 = arith.addi %b, %one : i32
+                    memref.store %b1, %B[%i] : memref<{N}xi32>
+                }} {{ loop_name = "j" }}
+                %big = arith.cmpi sgt, %a, %two : i32
+                scf.if %big {{
+                    %b = memref.load %B[%i] : memref<{N}xi32>
+                    %b2 = arith.muli %b, %two : i32
+                    memref.store %b2, %B[%i] : memref<{N}xi32>
+                }}
+            }} {{ loop_name = "i", op_name = "s" }}
+            return
+        }}
+    }}
+    """
+    ctx = Context()
+    hcl_d.register_dialect(ctx)
+    mod = Module.parse(mlir_code, ctx)
+
+    # Profiled builds are not cached: each one has its own counters.
+    hcl_d.clear_compile_cache()
+    exe = hcl_d.compile(mod, profile=True)
+    other = hcl_d.compile(mod, profile=True)
+    assert other is not exe
+    assert hcl_d.compile_cache_size() == 0
+
+    A = np.arange(N, dtype=np.int32)
+    for _ in range(2):
+        B = np.zeros(N, dtype=np.int32)
+        exe(A, B)
+        assert np.array_equal(B, np.where(A > 2, 2 * A, A))
+    profile = exe.profile
+    assert profile["loops"]["top/s/i"] == {
+        "entries": 2, "iterations": 2 * N, "min": N, "max": N}
+    assert profile["loops"]["top/s/j"] == {
+        "entries": 2 * N, "iterations": 2 * int(A.sum()), "min": 0,
+        "max": N - 1}
+    assert profile["branches"]["top/s/if0"] == {
+        "executions": 2 * N, "taken": 2 * int((A > 2).sum())}
+    # The other executable did not run.
+    assert other.profile["loops"]["top/s/i"]["entries"] == 0
+
+    exe.reset_profile()
+    assert exe.profile["loops"]["top/s/j"]["entries"] == 0
+    exe(A, np.zeros(N, dtype=np.int32))
+
+    with tempfile.TemporaryDirectory() as tmp:
+        path = os.path.join(tmp, "profile.json")
+        exe.write_profile(path)
+        assert hcl_d.annotate_profile(mod, path)
+    text = str(mod)
+    avg = (int(A.sum()) + N // 2) // N
+    assert f"tripcount = array<i64: {N}, {N}, {N}>" in text
+    assert f"tripcount = array<i64: 0, {N - 1}, {avg}>" in text
+    assert "taken_rate = 6.250000e-01 : f64" in text
+
+    # Functions compiled without profile have no counters.
+    try:
+        hcl_d.compile(mod, cache=False).profile
+    except ValueError:
+        pass
+    else:
+        raise RuntimeError("expected ValueError")
+
+
+if __name__ == "__main__":
+    test_compile_inplace()
+    test_compile_return()
+    test_stream()
+    test_profile()
@@ -0,0 +1,46 @@
+// Copyright HeteroCL authors. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+// RUN: hcl-opt --lower-composite %s | FileCheck %s
+// RUN: hcl-opt --lower-composite --lower-composite-packed %s | FileCheck %s --check-prefix=PACKED
+module {
+  // Each field gets its own memref, and fields that are never read are
+  // removed along with their stores.
+  // CHECK-LABEL: func.func @top
+  // CHECK-NOT:     compute_2_0
+  // CHECK:         %[[F1:.*]] = memref.alloc() {name = "compute_2_1"} : memref<100xf32>
+  // CHECK-NOT:     hcl.struct
+  // CHECK:         affine.store %{{.*}}, %[[F1]][%{{.*}}] {to = "compute_2"} : memref<100xf32>
+  // CHECK:         %[[V:.*]] = affine.load %[[F1]][%{{.*}}] {from = "compute_2"} : memref<100xf32>
+  // CHECK-NEXT:    affine.store %[[V]], %{{.*}}[%{{.*}}] {to = "compute_3"} : memref<100xf32>
+
+  // The fields are packed into one word, the first one in the lowest bits.
+  // PACKED-LABEL: func.func @top
+  // PACKED:         %[[W:.*]] = memref.alloc() {name = "compute_2"} : memref<100xi40>
+  // PACKED-NOT:     hcl.struct
+  // PACKED:         %[[B:.*]] = arith.bitcast %{{.*}} : f32 to i32
+  // PACKED:         %[[HI:.*]] = arith.extui %[[B]] : i32 to i40
+  // PACKED:         %[[SHL:.*]] = arith.shli %[[HI]], %{{.*}} : i40
+  // PACKED:         %[[WORD:.*]] = arith.ori %{{.*}}, %[[SHL]] : i40
+  // PACKED:         affine.store %[[WORD]], %[[W]][%{{.*}}] {to = "compute_2"} : memref<100xi40>
+  // PACKED:         %[[L:.*]] = affine.load %[[W]][%{{.*}}] {from = "compute_2"} : memref<100xi40>
+  // PACKED:         %[[SHR:.*]] = arith.shrui %[[L]], %{{.*}} : i40
+  // PACKED:         %[[T:.*]] = arith.trunci %[[SHR]] : i40 to i32
+  // PACKED:         arith.bitcast %[[T]] : i32 to f32
+  func.func @top(%arg0: memref<100xi8>, %arg1: memref<100xf32>) -> memref<100xf32> attributes {itypes = "s_", otypes = "_"} {
+    %0 = memref.alloc() {name = "compute_2"} : memref<100x!hcl.struct<i8, f32>>
+    affine.for %arg2 = 0 to 100 {
+      %2 = affine.load %arg0[%arg2] {from = "compute_0"} : memref<100xi8>
+      %3 = affine.load %arg1[%arg2] {from = "compute_1"} : memref<100xf32>
+      %4 = hcl.struct_construct(%2, %3) : i8, f32 -> <i8, f32>
+      affine.store %4, %0[%arg2] {to = "compute_2"} : memref<100x!hcl.struct<i8, f32>>
+    } {loop_name = "x", op_name = "compute_2"}
+    %1 = memref.alloc() {name = "compute_3"} : memref<100xf32>
+    affine.for %arg2 = 0 to 100 {
+      %2 = affine.load %0[%arg2] {from = "compute_2"} : memref<100x!hcl.struct<i8, f32>>
+      %3 = hcl.struct_get %2[1] : <i8, f32> -> f32
+      affine.store %3, %1[%arg2] {to = "compute_3"} : memref<100xf32>
+    } {loop_name = "x", op_name = "compute_3"}
+    return %1 : memref<100xf32>
+  }
+}
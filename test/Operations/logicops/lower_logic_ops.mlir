@@ -0,0 +1,69 @@
+// Copyright HeteroCL authors. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+// RUN: hcl-opt %s --lower-logic-ops | FileCheck %s
+// RUN: hcl-opt %s --lower-logic-ops --lower-logic-ops-max-speculated-ops=0 | FileCheck %s --check-prefix=BRANCH
+module {
+  // Cheap and pure inputs are combined without branches.
+  // CHECK-LABEL: func.func @cheap
+  // CHECK:         affine.for
+  // CHECK:           %[[LT:.*]] = arith.cmpi slt
+  // CHECK:           %[[AND:.*]] = arith.andi %arg2, %[[LT]] : i1
+  // CHECK-NOT:       scf.if
+  // CHECK:           arith.select %[[AND]]
+
+  // BRANCH-LABEL: func.func @cheap
+  // BRANCH:         %[[R:.*]] = scf.if %arg2 -> (i1) {
+  // BRANCH:           %[[LT:.*]] = arith.cmpi slt
+  // BRANCH:           scf.yield %[[LT]] : i1
+  // BRANCH:         } else {
+  // BRANCH:           %[[FALSE:.*]] = arith.constant false
+  // BRANCH:           scf.yield %[[FALSE]] : i1
+  // BRANCH:         }
+  // BRANCH:         arith.select %[[R]]
+  func.func @cheap(%arg0: memref<16xi32>, %arg1: memref<16xi32>, %arg2: i1) {
+    %c8_i32 = arith.constant 8 : i32
+    %c0_i32 = arith.constant 0 : i32
+    affine.for %i = 0 to 16 {
+      %0 = affine.load %arg0[%i] : memref<16xi32>
+      %1 = hcl.and {
+        hcl.yield %arg2 : i1
+      }, {
+        %lt = arith.cmpi slt, %0, %c8_i32 : i32
+        hcl.yield %lt : i1
+      } : i1
+      %2 = arith.select %1, %0, %c0_i32 : i32
+      affine.store %2, %arg1[%i] : memref<16xi32>
+    } {loop_name = "i", op_name = "S"}
+    return
+  }
+
+  // Inputs reading memory are only computed when the result is undecided.
+  // CHECK-LABEL: func.func @short_circuit
+  // CHECK:         %[[EQ:.*]] = arith.cmpi eq, %arg1, %arg2 : index
+  // CHECK:         %[[R:.*]] = scf.if %[[EQ]] -> (i1) {
+  // CHECK:           %[[TRUE:.*]] = arith.constant true
+  // CHECK:           scf.yield %[[TRUE]] : i1
+  // CHECK:         } else {
+  // CHECK:           %[[V:.*]] = memref.load %arg0[%arg1] : memref<4xi1>
+  // CHECK:           %[[R2:.*]] = scf.if %[[V]] -> (i1) {
+  // CHECK:             scf.yield
+  // CHECK:           } else {
+  // CHECK:             scf.yield %arg3 : i1
+  // CHECK:           }
+  // CHECK:           scf.yield %[[R2]] : i1
+  // CHECK:         }
+  // CHECK:         return %[[R]] : i1
+  func.func @short_circuit(%arg0: memref<4xi1>, %arg1: index, %arg2: index, %arg3: i1) -> i1 {
+    %0 = hcl.or {
+      %eq = arith.cmpi eq, %arg1, %arg2 : index
+      hcl.yield %eq : i1
+    }, {
+      %v = memref.load %arg0[%arg1] : memref<4xi1>
+      hcl.yield %v : i1
+    }, {
+      hcl.yield %arg3 : i1
+    } : i1
+    return %0 : i1
+  }
+}
@@ -0,0 +1,6 @@
+module {
+  func.func @broken(%A: memref<16xf32>) {
+    %a = affine.load %A[%i] : memref<16xf32>
+    return
+  }
+}
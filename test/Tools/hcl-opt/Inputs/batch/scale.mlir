@@ -0,0 +1,13 @@
+module {
+  func.func @scale(%A: memref<16xf32>) {
+    %c2 = arith.constant 2.0 : f32
+    %c3 = arith.constant 3.0 : f32
+    %c6 = arith.mulf %c2, %c3 : f32
+    affine.for %i = 0 to 16 {
+      %a = affine.load %A[%i] : memref<16xf32>
+      %b = arith.mulf %a, %c6 : f32
+      affine.store %b, %A[%i] : memref<16xf32>
+    } {loop_name = "i", op_name = "s"}
+    return
+  }
+}
@@ -0,0 +1,17 @@
+// Copyright HeteroCL authors. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+// RUN: rm -rf %t && mkdir -p %t
+// RUN: not hcl-opt -batch=%S/Inputs/batch -batch-output-dir=%t -batch-threads=2 -canonicalize 2>&1 | FileCheck %s --check-prefix=LOG
+// RUN: FileCheck %s --input-file=%t/scale.mlir
+// RUN: not test -e %t/broken.mlir
+
+// A design that fails to parse is reported without stopping the others.
+// LOG:       broken.mlir{{.*}}error:
+// LOG:       [hcl-batch] FAILED {{.*}}broken.mlir
+// LOG-NOT:   FAILED
+// LOG:       [hcl-batch] 2 designs, 1 failed
+
+// CHECK-LABEL: func.func @scale
+// CHECK:         %[[C6:.*]] = arith.constant 6.000000e+00 : f32
+// CHECK:         arith.mulf %{{.*}}, %[[C6]] : f32
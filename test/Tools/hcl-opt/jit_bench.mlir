@@ -0,0 +1,20 @@
+// Copyright HeteroCL authors. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+// RUN: hcl-opt -jit -jit-bench-iters=3 %s | FileCheck %s
+// RUN: hcl-opt -jit -jit-opt-level=3 -jit-bench-iters=3 %s | FileCheck %s
+
+// CHECK: [hcl-jit] top: {{[0-9.]+}} ms/iter (min {{[0-9.]+}} ms, 3 iters)
+module {
+  memref.global "private" @gv : memref<64xi32> = dense<1>
+
+  func.func @top() -> () {
+    %A = memref.get_global @gv : memref<64xi32>
+    affine.for %i = 0 to 64 {
+      %a = affine.load %A[%i] : memref<64xi32>
+      %b = arith.addi %a, %a : i32
+      affine.store %b, %A[%i] : memref<64xi32>
+    } {loop_name = "i", op_name = "s"}
+    return
+  }
+}
@@ -0,0 +1,95 @@
+# Copyright HeteroCL authors. All Rights Reserved.
+# SPDX-License-Identifier: Apache-2.0
+
+# RUN: %PYTHON %s hcl-opt
+import os
+import subprocess
+import sys
+import tempfile
+import time
+
+from hcl_mlir.server import Client, CompileServerError
+
+MODULE = """
+module {
+  func.func @scale(%A: memref<16xf32>) {
+    %c2 = arith.constant 2.0 : f32
+    %c3 = arith.constant 3.0 : f32
+    %c6 = arith.mulf %c2, %c3 : f32
+    affine.for %i = 0 to 16 {
+      %a = affine.load %A[%i] : memref<16xf32>
+      %b = arith.mulf %a, %c6 : f32
+      affine.store %b, %A[%i] : memref<16xf32>
+    } {loop_name = "i", op_name = "s"}
+    return
+  }
+}
+"""
+
+
+def connect(path, server):
+    for _ in range(200):
+        if server.poll() is not None:
+            raise RuntimeError("hcl-opt -serve exited early")
+        try:
+            return Client(path)
+        except OSError:
+            time.sleep(0.05)
+    raise RuntimeError("hcl-opt -serve did not start")
+
+
+def expect_error(fn):
+    try:
+        fn()
+    except CompileServerError:
+        return
+    raise RuntimeError("expected CompileServerError")
+
+
+def test_serve(hcl_opt):
+    with tempfile.TemporaryDirectory() as tmp:
+        path = os.path.join(tmp, "hcl.sock")
+        server = subprocess.Popen(
+            [hcl_opt, f"-serve={path}", "-serve-contexts=1", "-serve-context-requests=2"]
+        )
+        try:
+            with connect(path, server) as client:
+                # A second server does not take the socket of a live one.
+                second = subprocess.run(
+                    [hcl_opt, f"-serve={path}"], capture_output=True, check=False
+                )
+                assert second.returncode == 1, second.stderr
+                assert os.path.exists(path)
+
+                out = client.compile(MODULE, ["-canonicalize"])
+                assert "arith.constant 6.000000e+00 : f32" in out
+                # The same request is answered from the cache.
+                assert client.compile(MODULE, ["-canonicalize"]) == out
+                hls = client.compile(MODULE, translate="emit-vivado-hls")
+                assert "void scale(" in hls
+
+                # Failures are reported to the client and not cached.
+                expect_error(lambda: client.compile("module {"))
+                expect_error(lambda: client.compile(MODULE, ["-jit"]))
+                expect_error(lambda: client.compile(MODULE, ["-no-such-flag"]))
+                expect_error(lambda: client.compile(MODULE, translate="emit-x"))
+
+                # Flags of earlier requests do not leak into later ones.
+                assert client.compile(MODULE) != out
+
+                stats = client.stats()
+                assert stats["hits"] == 1, stats
+                assert stats["entries"] == 3, stats
+                assert 0 < stats["bytes"] < 1 << 20, stats
+                # The only context was recreated every two compiled requests.
+                assert stats["recreated"] >= 3, stats
+                client.shutdown()
+            assert server.wait(timeout=60) == 0
+            assert not os.path.exists(path)
+        finally:
+            if server.poll() is None:
+                server.kill()
+
+
+if __name__ == "__main__":
+    test_serve(sys.argv[1])
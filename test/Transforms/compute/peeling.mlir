@@ -0,0 +1,68 @@
+// Copyright HeteroCL authors. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+// RUN: hcl-opt -opt %s | FileCheck %s
+
+module {
+    // CHECK-LABEL: func.func @split_peel
+    func.func @split_peel(%A: memref<1000xf32>, %B: memref<1000xf32>)
+    {
+        %s = hcl.create_op_handle "s"
+        %li = hcl.create_loop_handle %s, "i"
+        // CHECK:      affine.for %{{.*}} = 0 to 15 {
+        // CHECK-NEXT:   affine.for %{{.*}} = 0 to 64 {
+        // CHECK:        } {loop_name = "i.inner", pipeline_ii = 1 : i32}
+        // CHECK-NEXT: } {loop_name = "i.outer", op_name = "s"}
+        // CHECK-NEXT: affine.for %{{.*}} = 0 to 40 {
+        // CHECK:      } {loop_name = "i.inner.rem", op_name = "s.rem", pipeline_ii = 1 : i32}
+        // CHECK-NOT:  affine.min
+        affine.for %i = 0 to 1000 {
+            %a = affine.load %A[%i] : memref<1000xf32>
+            %b = arith.addf %a, %a : f32
+            affine.store %b, %B[%i] : memref<1000xf32>
+        } { loop_name = "i", op_name = "s" }
+        %li_outer, %li_inner = hcl.split (%li, 64) {peel}
+        hcl.pipeline (%li_inner, 1)
+        return
+    }
+
+    // CHECK-LABEL: func.func @tile_peel
+    func.func @tile_peel(%A: memref<100x30xf32>, %B: memref<100x30xf32>)
+    {
+        %s = hcl.create_op_handle "t"
+        %li = hcl.create_loop_handle %s, "i"
+        %lj = hcl.create_loop_handle %s, "j"
+        // CHECK:      affine.for %{{.*}} = 0 to 12 {
+        // CHECK-NEXT:   affine.for %{{.*}} = 0 to 3 {
+        // CHECK-NEXT:     affine.for %{{.*}} = 0 to 8 {
+        // CHECK-NEXT:       affine.for %{{.*}} = 0 to 8 {
+        // CHECK:            } {loop_name = "j.inner", unroll = 2 : i32}
+        // CHECK-NEXT:     } {loop_name = "i.inner"}
+        // CHECK-NEXT:   } {loop_name = "j.outer"}
+        // CHECK-NEXT:   affine.for %{{.*}} = 0 to 8 {
+        // CHECK-NEXT:     affine.for %{{.*}} = 0 to 6 {
+        // CHECK:          } {loop_name = "j.inner.rem", unroll = 2 : i32}
+        // CHECK-NEXT:   } {loop_name = "i.inner.rem"}
+        // CHECK-NEXT: } {loop_name = "i.outer", op_name = "t"}
+        // CHECK-NEXT: affine.for %{{.*}} = 0 to 3 {
+        // CHECK-NEXT:   affine.for %{{.*}} = 0 to 4 {
+        // CHECK-NEXT:     affine.for %{{.*}} = 0 to 8 {
+        // CHECK:          } {loop_name = "j.inner.rem", unroll = 2 : i32}
+        // CHECK-NEXT:   } {loop_name = "i.inner.rem"}
+        // CHECK-NEXT: } {loop_name = "j.outer.rem", op_name = "t.rem"}
+        // CHECK-NEXT: affine.for %{{.*}} = 0 to 4 {
+        // CHECK-NEXT:   affine.for %{{.*}} = 0 to 6 {
+        // CHECK:        } {loop_name = "j.inner.rem", unroll = 2 : i32}
+        // CHECK-NEXT: } {loop_name = "i.inner.rem", op_name = "t.rem"}
+        // CHECK-NOT:  affine.min
+        affine.for %i = 0 to 100 {
+            affine.for %j = 0 to 30 {
+                %a = affine.load %A[%i, %j] : memref<100x30xf32>
+                affine.store %a, %B[%i, %j] : memref<100x30xf32>
+            } { loop_name = "j" }
+        } { loop_name = "i", op_name = "t" }
+        %li_out, %li_in, %lj_out, %lj_in = hcl.tile (%li, %lj, 8, 8) {peel}
+        hcl.unroll (%lj_in, 2)
+        return
+    }
+}
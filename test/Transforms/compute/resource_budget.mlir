@@ -0,0 +1,55 @@
+// Copyright HeteroCL authors. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+// RUN: hcl-opt -opt -resource-budget -resource-budget-dsp=40 -resource-budget-bram=4 %s | FileCheck %s
+// RUN: hcl-opt -opt -resource-budget -resource-budget-dsp=40 -resource-budget-bram=4 %s | hcl-translate -emit-vivado-hls | FileCheck %s --check-prefix=HLS
+
+// The 16 banks of %buf take a BRAM each, and 4 fit.
+// CHECK: #[[MAP:.*]] = affine_map<(d0) -> (d0 mod 4, d0 floordiv 4)>
+module {
+    func.func @top(%A: memref<64xi32>, %F: memref<16x8xf32>, %G: memref<16x8xf32>)
+    {
+        // CHECK: memref.alloc() : memref<1024xi32, #[[MAP]]>
+        %buf = memref.alloc() : memref<1024xi32>
+        %s1 = hcl.create_op_handle "s1"
+        %li = hcl.create_loop_handle %s1, "i"
+        %lj = hcl.create_loop_handle %s1, "j"
+        %s2 = hcl.create_op_handle "s2"
+        %lp = hcl.create_loop_handle %s2, "p"
+        %lk = hcl.create_loop_handle %s2, "k"
+        // 16 copies of a 32-bit multiplier take 64 DSPs, so the unrolling of
+        // j is undone.
+        // CHECK: affine.for
+        // CHECK: affine.for
+        // CHECK-NOT: unroll
+        // CHECK: } {loop_name = "j"}
+        affine.for %i = 0 to 16 {
+            affine.for %j = 0 to 64 {
+                %a = affine.load %A[%j] : memref<64xi32>
+                %m = arith.muli %a, %a : i32
+                affine.store %m, %buf[%i * 64 + %j] : memref<1024xi32>
+            } { loop_name = "j" }
+        } { loop_name = "i", op_name = "s1" }
+        // k is unrolled by the pipelining of p whatever its factor, so its 40
+        // DSPs of floating-point operators are limited instead.
+        // CHECK: } {allocation = {fadd = 7 : i32, fmul = 7 : i32}, loop_name = "p", op_name = "s2", pipeline_ii = 1 : i32}
+        affine.for %p = 0 to 16 {
+            affine.for %k = 0 to 8 {
+                %x = affine.load %F[%p, %k] : memref<16x8xf32>
+                %y = arith.mulf %x, %x : f32
+                %z = arith.addf %y, %x : f32
+                affine.store %z, %G[%p, %k] : memref<16x8xf32>
+            } { loop_name = "k" }
+        } { loop_name = "p", op_name = "s2" }
+        hcl.unroll (%lj, 16)
+        hcl.pipeline (%lp, 1)
+        hcl.partition(%buf: memref<1024xi32>, "CyclicPartition", 1, 16)
+        return
+    }
+}
+
+// HLS: #pragma HLS array_partition variable={{.*}} cyclic dim=1 factor=4
+// HLS-NOT: #pragma HLS unroll
+// HLS: #pragma HLS pipeline II=1
+// HLS: #pragma HLS allocation operation instances=fadd limit=7
+// HLS-NEXT: #pragma HLS allocation operation instances=fmul limit=7
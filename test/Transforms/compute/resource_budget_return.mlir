@@ -0,0 +1,25 @@
+// Copyright HeteroCL authors. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+// RUN: hcl-opt -opt -resource-budget -resource-budget-bram=4 %s | FileCheck %s
+
+// A returned buffer is repartitioned along with the signature of its function.
+// CHECK: #[[MAP:.*]] = affine_map<(d0) -> (d0 mod 4, d0 floordiv 4)>
+module {
+    // CHECK: func.func @top(%{{.*}}: memref<64xi32>) -> memref<1024xi32, #[[MAP]]>
+    func.func @top(%A: memref<64xi32>) -> memref<1024xi32>
+    {
+        // CHECK: memref.alloc() : memref<1024xi32, #[[MAP]]>
+        %buf = memref.alloc() : memref<1024xi32>
+        %s = hcl.create_op_handle "s"
+        affine.for %i = 0 to 16 {
+            affine.for %j = 0 to 64 {
+                %a = affine.load %A[%j] : memref<64xi32>
+                affine.store %a, %buf[%i * 64 + %j] : memref<1024xi32>
+            } { loop_name = "j" }
+        } { loop_name = "i", op_name = "s" }
+        hcl.partition(%buf: memref<1024xi32>, "CyclicPartition", 1, 16)
+        // CHECK: return %{{.*}} : memref<1024xi32, #[[MAP]]>
+        return %buf : memref<1024xi32>
+    }
+}
@@ -0,0 +1,202 @@
+// Copyright HeteroCL authors. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+// RUN: hcl-opt -apply-transform %s | FileCheck %s
+
+// CHECK: #[[PART:.*]] = affine_map<(d0, d1) -> (d0 mod 4, 0, d0 floordiv 4, d1)>
+module {
+    // CHECK-LABEL: func.func @tile
+    func.func @tile(%A: memref<64x32xf32>, %B: memref<32x64xf32>, %C: memref<64x64xf32>)
+    {
+        // CHECK: affine.for %{{.*}} = 0 to 64 step 16 {
+        // CHECK:   affine.for %{{.*}} = 0 to 64 step 8 {
+        affine.for %i = 0 to 64 {
+            affine.for %j = 0 to 64 {
+                affine.for %k = 0 to 32 {
+                    %a = affine.load %A[%i, %k] : memref<64x32xf32>
+                    %b = affine.load %B[%k, %j] : memref<32x64xf32>
+                    %c = affine.load %C[%i, %j] : memref<64x64xf32>
+                    %prod = arith.mulf %a, %b : f32
+                    %sum = arith.addf %prod, %c: f32
+                    affine.store %sum, %C[%i, %j] : memref<64x64xf32>
+                // CHECK:       } {loop_name = "k"}
+                // CHECK:     } {loop_name = "j.inner", pipeline_ii = 1 : i32}
+                // CHECK:   } {loop_name = "i.inner"}
+                // CHECK: } {loop_name = "j.outer"}
+                // CHECK: } {loop_name = "i.outer", op_name = "s"}
+                } { loop_name = "k" }
+            } { loop_name = "j" }
+        } { loop_name = "i", op_name = "s" }
+        return
+    }
+    // CHECK-LABEL: func.func @reorder
+    func.func @reorder(%A: memref<64x32xf32>, %B: memref<32x64xf32>, %C: memref<64x64xf32>)
+    {
+        affine.for %i = 0 to 64 {
+            affine.for %j = 0 to 64 {
+                affine.for %k = 0 to 32 {
+                    %a = affine.load %A[%i, %k] : memref<64x32xf32>
+                    %b = affine.load %B[%k, %j] : memref<32x64xf32>
+                    %c = affine.load %C[%i, %j] : memref<64x64xf32>
+                    %prod = arith.mulf %a, %b : f32
+                    %sum = arith.addf %prod, %c: f32
+                    affine.store %sum, %C[%i, %j] : memref<64x64xf32>
+                // CHECK:     } {loop_name = "i"}
+                // CHECK:   } {loop_name = "j"}
+                // CHECK: } {loop_name = "k", op_name = "s"}
+                } { loop_name = "k" }
+            } { loop_name = "j" }
+        } { loop_name = "i", op_name = "s" }
+        return
+    }
+    // CHECK-LABEL: func.func @fuse
+    func.func @fuse(%A: memref<16x8xf32>, %B: memref<16x8xf32>)
+    {
+        // CHECK: affine.for %{{.*}} = 0 to 128 {
+        // CHECK-NOT: affine.for
+        affine.for %i = 0 to 16 {
+            affine.for %j = 0 to 8 {
+                %a = affine.load %A[%i, %j] : memref<16x8xf32>
+                affine.store %a, %B[%i, %j] : memref<16x8xf32>
+            } { loop_name = "j" }
+        // CHECK: } {loop_name = "i_j_fused", op_name = "s"}
+        } { loop_name = "i", op_name = "s" }
+        return
+    }
+    // CHECK-LABEL: func.func @partition
+    // CHECK-SAME: %{{.*}}: memref<16x8xf32, #[[PART]]>
+    func.func @partition(%A: memref<16x8xf32>, %B: memref<16x8xf32>)
+    {
+        affine.for %i = 0 to 16 {
+            affine.for %j = 0 to 8 {
+                %a = affine.load %A[%i, %j] : memref<16x8xf32>
+                affine.store %a, %B[%i, %j] : memref<16x8xf32>
+            } { loop_name = "j" }
+        } { loop_name = "i", op_name = "s" }
+        return
+    }
+    // CHECK-LABEL: func.func @compute_at
+    func.func @compute_at(%A: memref<10x10xf32>, %B: memref<10x10xf32>, %C: memref<10x10xf32>)
+    {
+        // CHECK: affine.for
+        // CHECK:   affine.for
+        // CHECK:     arith.addf
+        // CHECK:     arith.mulf
+        // CHECK:   } {loop_name = "j1"}
+        // CHECK: } {loop_name = "i1", op_name = "s2"}
+        // CHECK-NOT: op_name = "s1"
+        affine.for %i = 0 to 10 {
+            affine.for %j = 0 to 10 {
+                %a = affine.load %A[%i, %j] : memref<10x10xf32>
+                %b = arith.addf %a, %a : f32
+                affine.store %b, %B[%i, %j] : memref<10x10xf32>
+            } { loop_name = "j" }
+        } { loop_name = "i", op_name = "s1" }
+        affine.for %i = 0 to 10 {
+            affine.for %j = 0 to 10 {
+                %b = affine.load %B[%i, %j] : memref<10x10xf32>
+                %c = arith.mulf %b, %b : f32
+                affine.store %c, %C[%i, %j] : memref<10x10xf32>
+            } { loop_name = "j1" }
+        } { loop_name = "i1", op_name = "s2" }
+        return
+    }
+    // CHECK-LABEL: func.func @reuse_at
+    func.func @reuse_at(%A: memref<10x10xf32>, %B: memref<10x8xf32>)
+    {
+        // CHECK: memref.alloc() {name = "s_reuse_{{[0-9]+}}"} : memref<3xf32>
+        affine.for %i = 0 to 10 {
+            affine.for %j = 0 to 8 {
+                %tmp = affine.load %A[%i, %j] : memref<10x10xf32>
+                %tmp1 = affine.load %A[%i, %j+1] : memref<10x10xf32>
+                %tmp2 = affine.load %A[%i, %j+2] : memref<10x10xf32>
+                %sum = arith.addf %tmp, %tmp1: f32
+                %sum1 = arith.addf %sum, %tmp2: f32
+                affine.store %sum1, %B[%i, %j] : memref<10x8xf32>
+            } { loop_name = "j" }
+        } { loop_name = "i", op_name = "s" }
+        // CHECK-NOT: hcl.
+        return
+    }
+    // CHECK-LABEL: func.func @buffer_at
+    func.func @buffer_at(%A: memref<64x32xf32>, %B: memref<32x64xf32>, %C: memref<64x64xf32>)
+    {
+        // CHECK: memref.alloc() : memref<64xf32>
+        affine.for %i = 0 to 64 {
+            affine.for %j = 0 to 64 {
+                affine.for %k = 0 to 32 {
+                    %a = affine.load %A[%i, %k] : memref<64x32xf32>
+                    %b = affine.load %B[%k, %j] : memref<32x64xf32>
+                    %c = affine.load %C[%i, %j] : memref<64x64xf32>
+                    %prod = arith.mulf %a, %b : f32
+                    %sum = arith.addf %prod, %c: f32
+                    affine.store %sum, %C[%i, %j] : memref<64x64xf32>
+                } { loop_name = "k", reduction = 1 : i32}
+            // CHECK: } {buffer, loop_name = "j_init", pipeline_ii = 1 : i32}
+            // CHECK: } {loop_name = "j"}
+            // CHECK: } {buffer, loop_name = "j_back", pipeline_ii = 1 : i32}
+            } { loop_name = "j" }
+        } { loop_name = "i", op_name = "s" }
+        return
+    }
+    // CHECK-LABEL: func.func @outline
+    func.func @outline(%A: memref<10x32xi32>) -> memref<10x32xi32> attributes {itypes = "s", otypes = "s"}
+    {
+        %C = memref.alloc() {name = "C"} : memref<10x32xi32>
+        // CHECK: call @Stage_C
+        affine.for %i = 0 to 10 {
+            affine.for %j = 0 to 32 {
+                %a = affine.load %A[%i, %j] : memref<10x32xi32>
+                %c1 = arith.constant 1 : i32
+                %c = arith.addi %a, %c1 : i32
+                affine.store %c, %C[%i, %j] : memref<10x32xi32>
+            } { loop_name = "j" }
+        } { loop_name = "i", op_name = "C" }
+        return %C : memref<10x32xi32>
+    }
+
+    // CHECK-NOT: transform.
+    transform.sequence failures(propagate) {
+    ^bb0(%root: !transform.any_op):
+        // Tile i and j of the matrix multiply, then pipeline the point loop of j.
+        %tile = transform.structured.match ops{["func.func"]} attributes{sym_name = "tile"} in %root : (!transform.any_op) -> !transform.any_op
+        %ti = transform.structured.match ops{["affine.for"]} attributes{loop_name = "i"} in %tile : (!transform.any_op) -> !transform.any_op
+        %tile_outer, %tile_inner = transform.hcl.tile %ti tile_sizes [16, 8] : (!transform.any_op) -> (!transform.any_op, !transform.any_op)
+        %ti_inner, %tj_inner = transform.split_handle %tile_inner : (!transform.any_op) -> (!transform.any_op, !transform.any_op)
+        %pipelined = transform.hcl.pipeline %tj_inner {initialInterval = 1} : (!transform.any_op) -> !transform.any_op
+
+        // Move k outermost and i innermost.
+        %reorder = transform.structured.match ops{["func.func"]} attributes{sym_name = "reorder"} in %root : (!transform.any_op) -> !transform.any_op
+        %ri = transform.structured.match ops{["affine.for"]} attributes{loop_name = "i"} in %reorder : (!transform.any_op) -> !transform.any_op
+        %rk = transform.structured.match ops{["affine.for"]} attributes{loop_name = "k"} in %reorder : (!transform.any_op) -> !transform.any_op
+        transform.hcl.reorder %rk, %ri : !transform.any_op, !transform.any_op
+
+        %fuse = transform.structured.match ops{["func.func"]} attributes{sym_name = "fuse"} in %root : (!transform.any_op) -> !transform.any_op
+        %fi = transform.structured.match ops{["affine.for"]} attributes{loop_name = "i"} in %fuse : (!transform.any_op) -> !transform.any_op
+        %fj = transform.structured.match ops{["affine.for"]} attributes{loop_name = "j"} in %fuse : (!transform.any_op) -> !transform.any_op
+        %fused = transform.hcl.fuse %fi, %fj : (!transform.any_op, !transform.any_op) -> !transform.any_op
+
+        %partition = transform.structured.match ops{["func.func"]} attributes{sym_name = "partition"} in %root : (!transform.any_op) -> !transform.any_op
+        %pa = transform.hcl.get_argument %partition [0] : (!transform.any_op) -> !transform.any_value
+        transform.hcl.partition %pa {partition_kind = 2 : i32, dim = 1, factor = 4} : !transform.any_value
+
+        %compute_at = transform.structured.match ops{["func.func"]} attributes{sym_name = "compute_at"} in %root : (!transform.any_op) -> !transform.any_op
+        %producer = transform.structured.match ops{["affine.for"]} attributes{loop_name = "i"} in %compute_at : (!transform.any_op) -> !transform.any_op
+        %consumer_j = transform.structured.match ops{["affine.for"]} attributes{loop_name = "j1"} in %compute_at : (!transform.any_op) -> !transform.any_op
+        transform.hcl.compute_at %producer at %consumer_j : !transform.any_op, !transform.any_op
+
+        %reuse_at = transform.structured.match ops{["func.func"]} attributes{sym_name = "reuse_at"} in %root : (!transform.any_op) -> !transform.any_op
+        %ra = transform.hcl.get_argument %reuse_at [0] : (!transform.any_op) -> !transform.any_value
+        %rj = transform.structured.match ops{["affine.for"]} attributes{loop_name = "j"} in %reuse_at : (!transform.any_op) -> !transform.any_op
+        %reuse = transform.hcl.reuse_at %ra at %rj : (!transform.any_value, !transform.any_op) -> !transform.any_value
+
+        %buffer_at = transform.structured.match ops{["func.func"]} attributes{sym_name = "buffer_at"} in %root : (!transform.any_op) -> !transform.any_op
+        %bc = transform.hcl.get_argument %buffer_at [2] : (!transform.any_op) -> !transform.any_value
+        %bi = transform.structured.match ops{["affine.for"]} attributes{loop_name = "i"} in %buffer_at : (!transform.any_op) -> !transform.any_op
+        %buffer = transform.hcl.buffer_at %bc at %bi : (!transform.any_value, !transform.any_op) -> !transform.any_value
+
+        %outline = transform.structured.match ops{["func.func"]} attributes{sym_name = "outline"} in %root : (!transform.any_op) -> !transform.any_op
+        %oi = transform.structured.match ops{["affine.for"]} attributes{loop_name = "i"} in %outline : (!transform.any_op) -> !transform.any_op
+        transform.hcl.outline %oi : !transform.any_op
+    }
+}
@@ -0,0 +1,35 @@
+// Copyright HeteroCL authors. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+// RUN: not hcl-opt -apply-transform %s 2>&1 | FileCheck %s
+
+module {
+    func.func @compute_at(%A: memref<10x10xf32>, %B: memref<10x10xf32>, %C: memref<10x10xf32>)
+    {
+        affine.for %i = 0 to 10 {
+            affine.for %j = 0 to 10 {
+                %a = affine.load %A[%i, %j] : memref<10x10xf32>
+                %b = arith.addf %a, %a : f32
+                affine.store %b, %B[%i, %j] : memref<10x10xf32>
+            } { loop_name = "j" }
+        } { loop_name = "i", op_name = "s1" }
+        affine.for %i = 0 to 10 {
+            affine.for %j = 0 to 10 {
+                %b = affine.load %B[%i, %j] : memref<10x10xf32>
+                %c = arith.mulf %b, %b : f32
+                affine.store %c, %C[%i, %j] : memref<10x10xf32>
+            } { loop_name = "j1" }
+        } { loop_name = "i1", op_name = "s2" }
+        return
+    }
+
+    transform.sequence failures(propagate) {
+    ^bb0(%root: !transform.any_op):
+        // The producer stage is erased with its outermost loop "i", which
+        // another handle could still refer to.
+        // CHECK: error: expected the outermost loop of a stage
+        %producer = transform.structured.match ops{["affine.for"]} attributes{loop_name = "j"} in %root : (!transform.any_op) -> !transform.any_op
+        %consumer_j = transform.structured.match ops{["affine.for"]} attributes{loop_name = "j1"} in %root : (!transform.any_op) -> !transform.any_op
+        transform.hcl.compute_at %producer at %consumer_j : !transform.any_op, !transform.any_op
+    }
+}
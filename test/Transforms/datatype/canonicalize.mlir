@@ -0,0 +1,122 @@
+// Copyright HeteroCL authors. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+// RUN: hcl-opt -canonicalize %s | FileCheck %s
+
+module {
+  // CHECK-LABEL: func.func @fixed_identity
+  // CHECK-NOT:     hcl.
+  // CHECK:         return %arg0
+  func.func @fixed_identity(%arg0: !hcl.Fixed<8, 4>) -> !hcl.Fixed<8, 4> {
+    %c0_i32 = arith.constant 0 : i32
+    %c1_i32 = arith.constant 1 : i32
+    %0 = hcl.int_to_fixed(%c0_i32) : i32 -> !hcl.Fixed<8, 4>
+    %1 = hcl.int_to_fixed(%c1_i32) : i32 -> !hcl.Fixed<8, 4>
+    %2 = "hcl.add_fixed"(%arg0, %0) : (!hcl.Fixed<8, 4>, !hcl.Fixed<8, 4>) -> !hcl.Fixed<8, 4>
+    %3 = "hcl.sub_fixed"(%2, %0) : (!hcl.Fixed<8, 4>, !hcl.Fixed<8, 4>) -> !hcl.Fixed<8, 4>
+    %4 = "hcl.mul_fixed"(%1, %3) : (!hcl.Fixed<8, 4>, !hcl.Fixed<8, 4>) -> !hcl.Fixed<8, 4>
+    %5 = "hcl.max_fixed"(%4, %4) : (!hcl.Fixed<8, 4>, !hcl.Fixed<8, 4>) -> !hcl.Fixed<8, 4>
+    return %5 : !hcl.Fixed<8, 4>
+  }
+
+  // 1 is not representable in Fixed<4, 4>, so the product is kept.
+  // CHECK-LABEL: func.func @fixed_no_one
+  // CHECK:         "hcl.mul_fixed"
+  func.func @fixed_no_one(%arg0: !hcl.UFixed<4, 4>) -> !hcl.UFixed<4, 4> {
+    %c1_i32 = arith.constant 1 : i32
+    %0 = hcl.int_to_fixed(%c1_i32) : i32 -> !hcl.UFixed<4, 4>
+    %1 = "hcl.mul_fixed"(%arg0, %0) : (!hcl.UFixed<4, 4>, !hcl.UFixed<4, 4>) -> !hcl.UFixed<4, 4>
+    return %1 : !hcl.UFixed<4, 4>
+  }
+
+  // CHECK-LABEL: func.func @fixed_constants
+  // CHECK-DAG:     %[[C5:.*]] = arith.constant 5 : i8
+  // CHECK-DAG:     %[[C6:.*]] = arith.constant 6 : i16
+  // CHECK-DAG:     %[[S:.*]] = hcl.int_to_fixed(%[[C5]]) : i8 -> !hcl.Fixed<8, 4>
+  // CHECK-DAG:     %[[P:.*]] = hcl.int_to_fixed(%[[C6]]) : i16 -> !hcl.Fixed<16, 4>
+  // CHECK:         return %[[S]], %[[P]]
+  func.func @fixed_constants() -> (!hcl.Fixed<8, 4>, !hcl.Fixed<16, 4>) {
+    %c2_i32 = arith.constant 2 : i32
+    %c3_i32 = arith.constant 3 : i32
+    %0 = hcl.int_to_fixed(%c2_i32) : i32 -> !hcl.Fixed<8, 4>
+    %1 = hcl.int_to_fixed(%c3_i32) : i32 -> !hcl.Fixed<8, 4>
+    %2 = "hcl.add_fixed"(%0, %1) : (!hcl.Fixed<8, 4>, !hcl.Fixed<8, 4>) -> !hcl.Fixed<8, 4>
+    %3 = hcl.int_to_fixed(%c2_i32) : i32 -> !hcl.Fixed<16, 4>
+    %4 = hcl.int_to_fixed(%c3_i32) : i32 -> !hcl.Fixed<16, 4>
+    %5 = "hcl.mul_fixed"(%3, %4) : (!hcl.Fixed<16, 4>, !hcl.Fixed<16, 4>) -> !hcl.Fixed<16, 4>
+    return %2, %5 : !hcl.Fixed<8, 4>, !hcl.Fixed<16, 4>
+  }
+
+  // CHECK-LABEL: func.func @cast_chains
+  // CHECK-NOT:     hcl.
+  // CHECK:         return %arg0, %arg1
+  func.func @cast_chains(%arg0: !hcl.Fixed<8, 4>, %arg1: i8) -> (!hcl.Fixed<8, 4>, i8) {
+    %0 = hcl.fixed_to_fixed(%arg0) : !hcl.Fixed<8, 4> -> !hcl.Fixed<16, 8>
+    %1 = hcl.fixed_to_fixed(%0) : !hcl.Fixed<16, 8> -> !hcl.Fixed<8, 4>
+    %2 = hcl.int_to_fixed(%arg1) : i8 -> !hcl.Fixed<16, 4>
+    %3 = hcl.fixed_to_int(%2) : !hcl.Fixed<16, 4> -> i8
+    return %1, %3 : !hcl.Fixed<8, 4>, i8
+  }
+
+  // A narrowing cast in between rounds the value and is kept.
+  // CHECK-LABEL: func.func @lossy_cast_chain
+  // CHECK:         hcl.fixed_to_fixed(%arg0) : !hcl.Fixed<8, 4> -> !hcl.Fixed<8, 2>
+  // CHECK:         hcl.fixed_to_fixed
+  func.func @lossy_cast_chain(%arg0: !hcl.Fixed<8, 4>) -> !hcl.Fixed<8, 4> {
+    %0 = hcl.fixed_to_fixed(%arg0) : !hcl.Fixed<8, 4> -> !hcl.Fixed<8, 2>
+    %1 = hcl.fixed_to_fixed(%0) : !hcl.Fixed<8, 2> -> !hcl.Fixed<8, 4>
+    return %1 : !hcl.Fixed<8, 4>
+  }
+
+  // CHECK-LABEL: func.func @bit_constants
+  // CHECK-DAG:     %[[TRUE:.*]] = arith.constant true
+  // CHECK-DAG:     %[[SLICE:.*]] = arith.constant -1 : i4
+  // CHECK-DAG:     %[[REV:.*]] = arith.constant -2147483648 : i32
+  // CHECK-DAG:     %[[SET:.*]] = arith.constant 117 : i32
+  // CHECK:         return %[[TRUE]], %[[SLICE]], %[[REV]], %[[SET]]
+  func.func @bit_constants() -> (i1, i4, i32, i32) {
+    %c2 = arith.constant 2 : index
+    %c4 = arith.constant 4 : index
+    %c7 = arith.constant 7 : index
+    %c5_i32 = arith.constant 5 : i32
+    %c240_i32 = arith.constant 240 : i32
+    %c1_i32 = arith.constant 1 : i32
+    %c7_i3 = arith.constant 7 : i3
+    %0 = hcl.get_bit(%c5_i32 : i32, %c2) -> i1
+    %1 = hcl.get_slice(%c240_i32 : i32, %c7, %c4) -> i4
+    %2 = hcl.bit_reverse(%c1_i32 : i32)
+    %3 = hcl.set_slice(%c5_i32 : i32, %c7, %c4, %c7_i3 : i3) -> i32
+    return %0, %1, %2, %3 : i1, i4, i32, i32
+  }
+
+  // CHECK-LABEL: func.func @bit_identities
+  // CHECK-NOT:     hcl.
+  // CHECK:         return %arg0, %arg0, %arg1, %arg0
+  func.func @bit_identities(%arg0: i32, %arg1: i1, %arg2: index) -> (i32, i32, i1, i32) {
+    %c3 = arith.constant 3 : index
+    %c10 = arith.constant 10 : index
+    %0 = hcl.bit_reverse(%arg0 : i32)
+    %1 = hcl.bit_reverse(%0 : i32)
+    %2 = hcl.get_slice(%arg0 : i32, %c10, %c3) -> i8
+    %3 = hcl.set_slice(%arg0 : i32, %c10, %c3, %2 : i8) -> i32
+    %4 = hcl.set_bit(%arg0 : i32, %arg2, %arg1 : i1) -> i32
+    %5 = hcl.get_bit(%4 : i32, %arg2) -> i1
+    %6 = hcl.get_bit(%arg0 : i32, %arg2) -> i1
+    %7 = hcl.set_bit(%arg0 : i32, %arg2, %6 : i1) -> i32
+    return %1, %3, %5, %7 : i32, i32, i1, i32
+  }
+
+  // CHECK-LABEL: func.func @logical_ops
+  // CHECK-DAG:     %[[FALSE:.*]] = arith.constant false
+  // CHECK-DAG:     %[[TRUE:.*]] = arith.constant true
+  // CHECK:         %[[AND:.*]] = hcl.logical_and %arg0, %arg1
+  // CHECK:         return %[[FALSE]], %[[TRUE]], %[[AND]]
+  func.func @logical_ops(%arg0: i1, %arg1: i1) -> (i1, i1, i1) {
+    %true = arith.constant true
+    %false = arith.constant false
+    %0 = hcl.logical_and %arg0, %false : i1, i1 -> i1
+    %1 = hcl.logical_or %true, %arg1 : i1, i1 -> i1
+    %2 = hcl.logical_and %arg0, %arg1 : i1, i1 -> i1
+    return %0, %1, %2 : i1, i1, i1
+  }
+}
@@ -0,0 +1,79 @@
+// Copyright HeteroCL authors. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+// RUN: hcl-opt -cast-chain-elim %s | FileCheck %s
+
+module {
+  // CHECK-LABEL: func.func @int_chains
+  // CHECK-SAME:    (%[[X:.*]]: i8, %[[Y:.*]]: i32)
+  // CHECK-DAG:     %[[A:.*]] = arith.extsi %[[X]] : i8 to i16
+  // CHECK-DAG:     %[[B:.*]] = arith.extui %[[X]] : i8 to i64
+  // CHECK-DAG:     %[[C:.*]] = arith.trunci %[[Y]] : i32 to i8
+  // CHECK-DAG:     %[[D:.*]] = arith.extui %[[X]] : i8 to i32
+  // CHECK-DAG:     %[[E:.*]] = arith.extsi %[[Y]] : i32 to i64
+  // CHECK:         return %[[X]], %[[A]], %[[B]], %[[C]], %[[D]], %[[E]]
+  func.func @int_chains(%x: i8, %y: i32) -> (i8, i16, i64, i8, i32, i64) {
+    // trunc(ext(x)) to the type of x
+    %0 = arith.extsi %x : i8 to i32
+    %1 = arith.trunci %0 : i32 to i8
+    // trunc(ext(x)) wider than x
+    %2 = arith.trunci %0 : i32 to i16
+    // sext(zext(x)) is a zero extension
+    %3 = arith.extui %x : i8 to i32
+    %4 = arith.extsi %3 : i32 to i64
+    // trunc(trunc(y))
+    %5 = arith.trunci %y : i32 to i16
+    %6 = arith.trunci %5 : i16 to i8
+    // index_castui(zext(x)) through an index
+    %7 = arith.index_castui %3 : i32 to index
+    %8 = arith.index_cast %7 : index to i32
+    // sext(y) through an index
+    %9 = arith.index_cast %y : i32 to index
+    %10 = arith.index_cast %9 : index to i64
+    return %1, %2, %4, %6, %8, %10 : i8, i16, i64, i8, i32, i64
+  }
+
+  // The bits a truncation drops are not recovered by an extension, and a
+  // sign-extended value is not zero-extended by a zero extension.
+  // CHECK-LABEL: func.func @kept_chains
+  // CHECK:         %[[T:.*]] = arith.trunci %arg0 : i32 to i8
+  // CHECK:         arith.extsi %[[T]] : i8 to i32
+  // CHECK:         %[[S:.*]] = arith.extsi %[[T]] : i8 to i16
+  // CHECK:         arith.extui %[[S]] : i16 to i32
+  func.func @kept_chains(%y: i32) -> (i32, i32) {
+    %0 = arith.trunci %y : i32 to i8
+    %1 = arith.extsi %0 : i8 to i32
+    %2 = arith.extsi %0 : i8 to i16
+    %3 = arith.extui %2 : i16 to i32
+    return %1, %3 : i32, i32
+  }
+
+  // CHECK-LABEL: func.func @fixed_chain
+  // CHECK:         %[[R:.*]] = hcl.fixed_to_fixed(%arg0) : !hcl.Fixed<16, 8> -> !hcl.Fixed<8, 2>
+  // CHECK:         return %[[R]]
+  func.func @fixed_chain(%arg0: !hcl.Fixed<16, 8>) -> !hcl.Fixed<8, 2> {
+    %0 = hcl.fixed_to_fixed(%arg0) : !hcl.Fixed<16, 8> -> !hcl.UFixed<12, 4>
+    %1 = hcl.fixed_to_fixed(%0) : !hcl.UFixed<12, 4> -> !hcl.Fixed<8, 2>
+    return %1 : !hcl.Fixed<8, 2>
+  }
+
+  // CHECK-LABEL: func.func @hoist
+  // CHECK:         %[[S:.*]] = arith.extsi %arg2 : i8 to i32
+  // CHECK-NEXT:    affine.for
+  // CHECK-NEXT:      affine.for
+  // CHECK-NEXT:        affine.load
+  // CHECK-NEXT:        arith.extsi
+  // CHECK-NEXT:        arith.muli %{{.*}}, %[[S]] : i32
+  func.func @hoist(%arg0: memref<4x4xi8>, %arg1: memref<4x4xi32>, %arg2: i8) {
+    affine.for %i = 0 to 4 {
+      affine.for %j = 0 to 4 {
+        %0 = affine.load %arg0[%i, %j] : memref<4x4xi8>
+        %1 = arith.extsi %0 : i8 to i32
+        %2 = arith.extsi %arg2 : i8 to i32
+        %3 = arith.muli %1, %2 : i32
+        affine.store %3, %arg1[%i, %j] : memref<4x4xi32>
+      } {loop_name = "j"}
+    } {loop_name = "i", op_name = "S"}
+    return
+  }
+}
@@ -0,0 +1,92 @@
+// Copyright HeteroCL authors. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+// RUN: hcl-opt %s --fixed-to-integer | FileCheck %s
+// RUN: hcl-opt %s --fixed-to-integer --fixed-to-integer-simd | FileCheck %s --check-prefix=SIMD
+
+module {
+  // CHECK-LABEL: func.func @vector_mul
+  // CHECK-SAME:    (%[[A:.*]]: vector<8xi12>, %[[B:.*]]: vector<8xi12>) -> vector<8xi12>
+  // CHECK:         %[[LHS:.*]] = arith.extsi %[[A]] : vector<8xi12> to vector<8xi24>
+  // CHECK:         %[[RHS:.*]] = arith.extsi %[[B]] : vector<8xi12> to vector<8xi24>
+  // CHECK:         %[[MUL:.*]] = arith.muli %[[LHS]], %[[RHS]] : vector<8xi24>
+  // CHECK:         %[[FRAC:.*]] = arith.constant dense<4> : vector<8xi24>
+  // CHECK:         %[[SHR:.*]] = arith.shrsi %[[MUL]], %[[FRAC]] : vector<8xi24>
+  // CHECK:         %[[RES:.*]] = arith.trunci %[[SHR]] : vector<8xi24> to vector<8xi12>
+  // CHECK:         %[[SUM:.*]] = arith.addi %[[RES]], %[[A]] : vector<8xi12>
+  // CHECK:         return %[[SUM]]
+
+  // SIMD-LABEL: func.func @vector_mul
+  // SIMD-SAME:    (%[[A:.*]]: vector<8xi12>, %[[B:.*]]: vector<8xi12>) -> vector<8xi12>
+  // SIMD-NOT:     arith.extsi
+  // SIMD:         %[[LOW:[^,]*]], %[[HIGH:.*]] = arith.mulsi_extended %[[A]], %[[B]] : vector<8xi12>
+  // SIMD:         %[[FRAC:.*]] = arith.constant dense<4> : vector<8xi12>
+  // SIMD:         %[[REST:.*]] = arith.constant dense<8> : vector<8xi12>
+  // SIMD:         %[[LOBITS:.*]] = arith.shrui %[[LOW]], %[[FRAC]] : vector<8xi12>
+  // SIMD:         %[[HIBITS:.*]] = arith.shli %[[HIGH]], %[[REST]] : vector<8xi12>
+  // SIMD:         %[[RES:.*]] = arith.ori %[[LOBITS]], %[[HIBITS]] : vector<8xi12>
+  // SIMD:         arith.addi %[[RES]], %[[A]] : vector<8xi12>
+  func.func @vector_mul(%a: vector<8x!hcl.Fixed<12, 4>>, %b: vector<8x!hcl.Fixed<12, 4>>) -> vector<8x!hcl.Fixed<12, 4>> {
+    %0 = "hcl.mul_fixed"(%a, %b) : (vector<8x!hcl.Fixed<12, 4>>, vector<8x!hcl.Fixed<12, 4>>) -> vector<8x!hcl.Fixed<12, 4>>
+    %1 = "hcl.add_fixed"(%0, %a) : (vector<8x!hcl.Fixed<12, 4>>, vector<8x!hcl.Fixed<12, 4>>) -> vector<8x!hcl.Fixed<12, 4>>
+    return %1 : vector<8x!hcl.Fixed<12, 4>>
+  }
+
+  // CHECK-LABEL: func.func @vector_load_store
+  // CHECK:         affine.vector_load %{{.*}}[%{{.*}}] : memref<64xi8>, vector<16xi8>
+  // CHECK:         arith.extui %{{.*}} : vector<16xi8> to vector<16xi16>
+  // CHECK:         arith.divui %{{.*}}, %{{.*}} : vector<16xi16>
+  // CHECK:         affine.vector_store %{{.*}}, %{{.*}}[%{{.*}}] : memref<64xi8>, vector<16xi8>
+
+  // SIMD-LABEL: func.func @vector_load_store
+  // SIMD:         arith.divui %{{.*}}, %{{.*}} : vector<16xi16>
+  func.func @vector_load_store(%arg0: memref<64x!hcl.UFixed<8, 2>>, %arg1: memref<64x!hcl.UFixed<8, 2>>) {
+    affine.for %i = 0 to 64 step 16 {
+      %0 = affine.vector_load %arg0[%i] : memref<64x!hcl.UFixed<8, 2>>, vector<16x!hcl.UFixed<8, 2>>
+      %1 = "hcl.div_fixed"(%0, %0) : (vector<16x!hcl.UFixed<8, 2>>, vector<16x!hcl.UFixed<8, 2>>) -> vector<16x!hcl.UFixed<8, 2>>
+      affine.vector_store %1, %arg1[%i] : memref<64x!hcl.UFixed<8, 2>>, vector<16x!hcl.UFixed<8, 2>>
+    }
+    return
+  }
+
+  // CHECK-LABEL: func.func @vector_mul_lanes
+  // CHECK:         arith.extui %{{.*}} : vector<16xi16> to vector<16xi32>
+
+  // SIMD-LABEL: func.func @vector_mul_lanes
+  // SIMD-NOT:     arith.extui
+  // SIMD:         arith.mului_extended %{{.*}}, %{{.*}} : vector<16xi16>
+  // SIMD:         arith.shrui %{{.*}}, %{{.*}} : vector<16xi16>
+  // SIMD:         arith.shli %{{.*}}, %{{.*}} : vector<16xi16>
+  // SIMD:         arith.ori %{{.*}}, %{{.*}} : vector<16xi16>
+  func.func @vector_mul_lanes(%a: vector<16x!hcl.UFixed<16, 8>>) -> vector<16x!hcl.UFixed<16, 8>> {
+    %0 = "hcl.mul_fixed"(%a, %a) : (vector<16x!hcl.UFixed<16, 8>>, vector<16x!hcl.UFixed<16, 8>>) -> vector<16x!hcl.UFixed<16, 8>>
+    return %0 : vector<16x!hcl.UFixed<16, 8>>
+  }
+
+  // CHECK-LABEL: func.func @vector_casts
+  // CHECK:         arith.constant dense<2.560000e+02> : vector<4xf32>
+  // CHECK:         arith.mulf %{{.*}}, %{{.*}} : vector<4xf32>
+  // CHECK:         arith.fptosi %{{.*}} : vector<4xf32> to vector<4xi16>
+  // CHECK:         arith.constant dense<8> : vector<4xi16>
+  // CHECK:         arith.trunci %{{.*}} : vector<4xi32> to vector<4xi16>
+  // CHECK:         arith.shli %{{.*}}, %{{.*}} : vector<4xi16>
+  // CHECK:         arith.addi %{{.*}}, %{{.*}} : vector<4xi16>
+  // CHECK:         arith.extsi %{{.*}} : vector<4xi16> to vector<4xi24>
+  // CHECK:         arith.constant dense<4> : vector<4xi24>
+  // CHECK:         arith.shrsi %{{.*}}, %{{.*}} : vector<4xi24>
+  // CHECK:         arith.constant dense<1.600000e+01> : vector<4xf32>
+  // CHECK:         arith.sitofp %{{.*}} : vector<4xi24> to vector<4xf32>
+  // CHECK:         arith.divf %{{.*}}, %{{.*}} : vector<4xf32>
+  // CHECK:         arith.constant dense<4> : vector<4xi24>
+  // CHECK:         arith.shrsi %{{.*}}, %{{.*}} : vector<4xi24>
+  // CHECK:         arith.extsi %{{.*}} : vector<4xi24> to vector<4xi32>
+  func.func @vector_casts(%f: vector<4xf32>, %i: vector<4xi32>) -> (vector<4xf32>, vector<4xi32>) {
+    %0 = hcl.float_to_fixed(%f) : vector<4xf32> -> vector<4x!hcl.Fixed<16, 8>>
+    %1 = hcl.int_to_fixed(%i) : vector<4xi32> -> vector<4x!hcl.Fixed<16, 8>>
+    %2 = "hcl.add_fixed"(%0, %1) : (vector<4x!hcl.Fixed<16, 8>>, vector<4x!hcl.Fixed<16, 8>>) -> vector<4x!hcl.Fixed<16, 8>>
+    %3 = hcl.fixed_to_fixed(%2) : vector<4x!hcl.Fixed<16, 8>> -> vector<4x!hcl.Fixed<24, 4>>
+    %4 = hcl.fixed_to_float(%3) : vector<4x!hcl.Fixed<24, 4>> -> vector<4xf32>
+    %5 = hcl.fixed_to_int(%3) : vector<4x!hcl.Fixed<24, 4>> -> vector<4xi32>
+    return %4, %5 : vector<4xf32>, vector<4xi32>
+  }
+}
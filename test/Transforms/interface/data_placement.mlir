@@ -0,0 +1,46 @@
+// Copyright HeteroCL authors. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+// RUN: hcl-opt -data-placement %s | FileCheck %s
+// RUN: hcl-opt -data-placement -data-placement-transfer-cost=100 %s | FileCheck %s --check-prefix=HOST
+
+// A and C are much faster on the accelerator. B alone is faster on the host,
+// but placing it there would move A and B between the devices.
+module {
+  // CHECK-LABEL: func.func private @Stage_A_B_C
+  // CHECK-LABEL: func.func @top
+  // CHECK-NOT:     affine.for
+  // CHECK:         call @Stage_A_B_C
+  // CHECK-NOT:     affine.for
+
+  // When transfers are expensive, everything stays on the host.
+  // HOST-NOT:    call
+  // HOST:        op_name = "A"
+  // HOST:        op_name = "B"
+  // HOST:        op_name = "C"
+  func.func @top(%arg0: memref<1024xi32>, %arg1: memref<1024xi32>) attributes {itypes = "ss", otypes = ""} {
+    %0 = memref.alloc() {name = "A"} : memref<1024xi32>
+    affine.for %arg2 = 0 to 1024 {
+      affine.for %arg3 = 0 to 64 {
+        %2 = affine.load %arg0[%arg2] {from = "X"} : memref<1024xi32>
+        %3 = arith.muli %2, %2 : i32
+        affine.store %3, %0[%arg2] {to = "A"} : memref<1024xi32>
+      } {loop_name = "k", unroll = 0 : i32}
+    } {loop_name = "i", op_name = "A", pipeline_ii = 1 : i32}
+    %1 = memref.alloc() {name = "B"} : memref<1024xi32>
+    affine.for %arg2 = 0 to 1024 {
+      %2 = affine.load %0[%arg2] {from = "A"} : memref<1024xi32>
+      %c1_i32 = arith.constant 1 : i32
+      %3 = arith.addi %2, %c1_i32 : i32
+      affine.store %3, %1[%arg2] {to = "B"} : memref<1024xi32>
+    } {loop_name = "i", op_name = "B", pipeline_ii = 1 : i32}
+    affine.for %arg2 = 0 to 1024 {
+      affine.for %arg3 = 0 to 64 {
+        %2 = affine.load %1[%arg2] {from = "B"} : memref<1024xi32>
+        %3 = arith.muli %2, %2 : i32
+        affine.store %3, %arg1[%arg2] {to = "C"} : memref<1024xi32>
+      } {loop_name = "k", unroll = 0 : i32}
+    } {loop_name = "i", op_name = "C", pipeline_ii = 1 : i32}
+    return
+  }
+}
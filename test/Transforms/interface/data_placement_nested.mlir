@@ -0,0 +1,43 @@
+// Copyright HeteroCL authors. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+// RUN: hcl-opt -data-placement %s | FileCheck %s
+
+// Placing the loops after x on the FPGA reaches every loop downstream of it,
+// however many hops away and whatever their names.
+module {
+  // CHECK-LABEL: func.func @top
+  // CHECK-NOT:     hcl.
+  // CHECK:         } {loop_name = "x"}
+  // CHECK:         } {device = "FPGADevice", loop_name = "w"}
+  // CHECK:         } {device = "FPGADevice", loop_name = "v"}
+  // CHECK:         } {device = "FPGADevice", loop_name = "u"}
+  // CHECK:       } {loop_name = "i", op_name = "S"}
+  func.func @top(%arg0: memref<4x8xi32>, %arg1: memref<4x8xi32>) attributes {itypes = "ss", otypes = ""} {
+    %0 = memref.alloc() {name = "X"} : memref<8xi32>
+    %1 = memref.alloc() {name = "W"} : memref<8xi32>
+    %2 = memref.alloc() {name = "V"} : memref<8xi32>
+    %s = hcl.create_op_handle "S"
+    %lx = hcl.create_loop_handle %s, "x"
+    affine.for %i = 0 to 4 {
+      affine.for %j = 0 to 8 {
+        %3 = affine.load %arg0[%i, %j] : memref<4x8xi32>
+        affine.store %3, %0[%j] : memref<8xi32>
+      } {loop_name = "x"}
+      affine.for %j = 0 to 8 {
+        %3 = affine.load %0[%j] : memref<8xi32>
+        affine.store %3, %1[%j] : memref<8xi32>
+      } {loop_name = "w"}
+      affine.for %j = 0 to 8 {
+        %3 = affine.load %1[%j] : memref<8xi32>
+        affine.store %3, %2[%j] : memref<8xi32>
+      } {loop_name = "v"}
+      affine.for %j = 0 to 8 {
+        %3 = affine.load %2[%j] : memref<8xi32>
+        affine.store %3, %arg1[%i, %j] : memref<4x8xi32>
+      } {loop_name = "u"}
+    } {loop_name = "i", op_name = "S"}
+    hcl.host_xcel_to(%0 : memref<8xi32>, "FPGADevice", %lx)
+    return
+  }
+}
@@ -0,0 +1,44 @@
+// Copyright HeteroCL authors. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+// RUN: hcl-opt -data-placement %s | FileCheck %s
+
+// C is pinned to the host, so B follows it there instead of being moved off
+// the accelerator together with A.
+module {
+  // CHECK-LABEL: func.func private @Stage_A(
+  // CHECK-NOT:   func.func private @Stage_
+  // CHECK-LABEL: func.func @top
+  // CHECK:         call @Stage_A
+  // CHECK:         op_name = "B"
+  // CHECK:         op_name = "C"
+  // CHECK-NOT:     hcl.
+  func.func @top(%arg0: memref<1024xi32>, %arg1: memref<1024xi32>) attributes {itypes = "ss", otypes = ""} {
+    %0 = memref.alloc() {name = "A"} : memref<1024xi32>
+    affine.for %arg2 = 0 to 1024 {
+      affine.for %arg3 = 0 to 64 {
+        %2 = affine.load %arg0[%arg2] {from = "X"} : memref<1024xi32>
+        %3 = arith.muli %2, %2 : i32
+        affine.store %3, %0[%arg2] {to = "A"} : memref<1024xi32>
+      } {loop_name = "k", unroll = 0 : i32}
+    } {loop_name = "i", op_name = "A", pipeline_ii = 1 : i32}
+    %1 = memref.alloc() {name = "B"} : memref<1024xi32>
+    affine.for %arg2 = 0 to 1024 {
+      %2 = affine.load %0[%arg2] {from = "A"} : memref<1024xi32>
+      %c1_i32 = arith.constant 1 : i32
+      %3 = arith.addi %2, %c1_i32 : i32
+      affine.store %3, %1[%arg2] {to = "B"} : memref<1024xi32>
+    } {loop_name = "i", op_name = "B", pipeline_ii = 1 : i32}
+    %4 = hcl.create_op_handle "B"
+    %5 = hcl.create_loop_handle %4, "i"
+    hcl.host_xcel_to(%1 : memref<1024xi32>, "CPUDevice", %5)
+    affine.for %arg2 = 0 to 1024 {
+      affine.for %arg3 = 0 to 64 {
+        %2 = affine.load %1[%arg2] {from = "B"} : memref<1024xi32>
+        %3 = arith.muli %2, %2 : i32
+        affine.store %3, %arg1[%arg2] {to = "C"} : memref<1024xi32>
+      } {loop_name = "k", unroll = 0 : i32}
+    } {loop_name = "i", op_name = "C", pipeline_ii = 1 : i32}
+    return
+  }
+}
@@ -0,0 +1,118 @@
+// Copyright HeteroCL authors. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+// RUN: hcl-opt -kernel-dedup %s | FileCheck %s
+// RUN: hcl-opt -kernel-dedup -kernel-dedup-dynamic-shapes %s | FileCheck %s --check-prefix=DYN
+
+module {
+  // CHECK-LABEL: func.func private @Stage_A(%arg0: memref<10xi32>, %arg1: memref<10xi32>, %arg2: i32)
+  // CHECK:         arith.muli %{{.*}}, %arg2 : i32
+  // CHECK-NOT:   func.func private @Stage_B
+  // CHECK-NOT:   func.func private @Stage_C
+  // CHECK:       func.func private @Stage_D(%arg0: memref<8xi32>, %arg1: memref<8xi32>)
+  // CHECK:       func.func private @Stage_E(%arg0: memref<10xi32>, %arg1: memref<10xi32>)
+  // CHECK:         affine.for %{{.*}} = 0 to 5 {
+  // CHECK-NOT:     tripcount
+  // CHECK:       func.func private @Stage_F(%arg0: memref<6xi32>)
+  // CHECK:       func.func private @Stage_G(%arg0: memref<4xi32>)
+
+  // DYN-LABEL: func.func private @Stage_A(%arg0: memref<?xi32>, %arg1: memref<?xi32>, %arg2: index, %arg3: i32)
+  // DYN:         affine.for %{{.*}} = 0 to %arg2 {
+  // DYN:           arith.muli %{{.*}}, %arg3 : i32
+  // DYN:         } {loop_name = "i", op_name = "A", tripcount = array<i64: 5, 10, 9>}
+  // DYN-NOT:     func.func private @Stage_{{[B-E]}}
+  // An argument passed on to a call keeps its static shape.
+  // DYN:       func.func private @Stage_F(%arg0: memref<6xi32>)
+  // DYN:         memref.cast %arg0 : memref<6xi32> to memref<?xi32>
+  // DYN:       func.func private @Stage_G(%arg0: memref<4xi32>)
+  // DYN:         memref.cast %arg0 : memref<4xi32> to memref<?xi32>
+  // DYN-NOT:     func.func private @Stage_
+  func.func private @Stage_A(%arg0: memref<10xi32>, %arg1: memref<10xi32>) attributes {bit, itypes = "__"} {
+    affine.for %arg2 = 0 to 10 {
+      %0 = affine.load %arg0[%arg2] {from = "X"} : memref<10xi32>
+      %c2_i32 = arith.constant 2 : i32
+      %1 = arith.muli %0, %c2_i32 : i32
+      affine.store %1, %arg1[%arg2] {to = "A"} : memref<10xi32>
+    } {loop_name = "i", op_name = "A"}
+    return
+  }
+  func.func private @Stage_B(%arg0: memref<10xi32>, %arg1: memref<10xi32>) attributes {bit, itypes = "__"} {
+    affine.for %arg2 = 0 to 10 {
+      %0 = affine.load %arg0[%arg2] {from = "A"} : memref<10xi32>
+      %c3_i32 = arith.constant 3 : i32
+      %1 = arith.muli %0, %c3_i32 : i32
+      affine.store %1, %arg1[%arg2] {to = "B"} : memref<10xi32>
+    } {loop_name = "i", op_name = "B"}
+    return
+  }
+  func.func private @Stage_C(%arg0: memref<10xi32>, %arg1: memref<10xi32>) attributes {bit, itypes = "__"} {
+    affine.for %arg2 = 0 to 10 {
+      %0 = affine.load %arg0[%arg2] {from = "B"} : memref<10xi32>
+      %c2_i32 = arith.constant 2 : i32
+      %1 = arith.muli %0, %c2_i32 : i32
+      affine.store %1, %arg1[%arg2] {to = "C"} : memref<10xi32>
+    } {loop_name = "j", op_name = "C"}
+    return
+  }
+  func.func private @Stage_D(%arg0: memref<8xi32>, %arg1: memref<8xi32>) attributes {bit, itypes = "__"} {
+    affine.for %arg2 = 0 to 8 {
+      %0 = affine.load %arg0[%arg2] {from = "Y"} : memref<8xi32>
+      %c2_i32 = arith.constant 2 : i32
+      %1 = arith.muli %0, %c2_i32 : i32
+      affine.store %1, %arg1[%arg2] {to = "D"} : memref<8xi32>
+    } {loop_name = "i", op_name = "D"}
+    return
+  }
+  func.func private @Stage_E(%arg0: memref<10xi32>, %arg1: memref<10xi32>) attributes {bit, itypes = "__"} {
+    affine.for %arg2 = 0 to 5 {
+      %0 = affine.load %arg0[%arg2] {from = "C"} : memref<10xi32>
+      %c2_i32 = arith.constant 2 : i32
+      %1 = arith.muli %0, %c2_i32 : i32
+      affine.store %1, %arg1[%arg2] {to = "E"} : memref<10xi32>
+    } {loop_name = "i", op_name = "E"}
+    return
+  }
+  func.func private @sink(memref<?xi32>)
+  func.func private @Stage_F(%arg0: memref<6xi32>) attributes {itypes = "_"} {
+    %0 = memref.cast %arg0 : memref<6xi32> to memref<?xi32>
+    call @sink(%0) : (memref<?xi32>) -> ()
+    return
+  }
+  func.func private @Stage_G(%arg0: memref<4xi32>) attributes {itypes = "_"} {
+    %0 = memref.cast %arg0 : memref<4xi32> to memref<?xi32>
+    call @sink(%0) : (memref<?xi32>) -> ()
+    return
+  }
+  // CHECK-LABEL: func.func @top
+  // CHECK:         %[[C2:.*]] = arith.constant 2 : i32
+  // CHECK:         call @Stage_A(%{{.*}}, %{{.*}}, %[[C2]]) : (memref<10xi32>, memref<10xi32>, i32) -> ()
+  // CHECK:         %[[C3:.*]] = arith.constant 3 : i32
+  // CHECK:         call @Stage_A(%{{.*}}, %{{.*}}, %[[C3]])
+  // CHECK:         call @Stage_A(
+  // CHECK:         call @Stage_D(
+  // CHECK:         call @Stage_E(
+
+  // DYN-LABEL: func.func @top
+  // DYN:         memref.cast %{{.*}} : memref<8xi32> to memref<?xi32>
+  // DYN:         %[[C8:.*]] = arith.constant 8 : index
+  // DYN:         call @Stage_A(%{{.*}}, %{{.*}}, %[[C8]], %{{.*}}) : (memref<?xi32>, memref<?xi32>, index, i32) -> ()
+  // DYN:         %[[C5:.*]] = arith.constant 5 : index
+  // DYN:         call @Stage_A(%{{.*}}, %{{.*}}, %[[C5]], %{{.*}})
+  func.func @top(%arg0: memref<10xi32>, %arg1: memref<8xi32>) -> memref<8xi32> attributes {itypes = "ss", otypes = "s"} {
+    %0 = memref.alloc() {name = "A"} : memref<10xi32>
+    call @Stage_A(%arg0, %0) : (memref<10xi32>, memref<10xi32>) -> ()
+    %1 = memref.alloc() {name = "B"} : memref<10xi32>
+    call @Stage_B(%0, %1) : (memref<10xi32>, memref<10xi32>) -> ()
+    %2 = memref.alloc() {name = "C"} : memref<10xi32>
+    call @Stage_C(%1, %2) : (memref<10xi32>, memref<10xi32>) -> ()
+    %3 = memref.alloc() {name = "D"} : memref<8xi32>
+    call @Stage_D(%arg1, %3) : (memref<8xi32>, memref<8xi32>) -> ()
+    %4 = memref.alloc() {name = "E"} : memref<10xi32>
+    call @Stage_E(%2, %4) : (memref<10xi32>, memref<10xi32>) -> ()
+    %5 = memref.alloc() {name = "F"} : memref<6xi32>
+    call @Stage_F(%5) : (memref<6xi32>) -> ()
+    %6 = memref.alloc() {name = "G"} : memref<4xi32>
+    call @Stage_G(%6) : (memref<4xi32>) -> ()
+    return %3 : memref<8xi32>
+  }
+}
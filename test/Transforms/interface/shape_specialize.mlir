@@ -0,0 +1,38 @@
+// Copyright HeteroCL authors. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+// RUN: hcl-opt -shape-specialize %s | FileCheck %s
+
+module {
+  // CHECK-LABEL: func.func private @kernel_generic(%arg0: memref<?xf32>, %arg1: memref<?xf32>, %arg2: index)
+  // CHECK:         affine.for %{{.*}} = 0 to %arg2 {
+
+  // CHECK-LABEL: func.func private @kernel_32(%arg0: memref<?xf32>, %arg1: memref<?xf32>, %arg2: index)
+  // CHECK:         affine.for %{{.*}} = 0 to 32 {
+  // CHECK:         } {loop_name = "i", op_name = "s"}
+
+  // CHECK-LABEL: func.func private @kernel_1024(
+  // CHECK:         affine.for %{{.*}} = 0 to 1024 {
+
+  // CHECK-LABEL: func.func @kernel(%arg0: memref<?xf32>, %arg1: memref<?xf32>, %arg2: index)
+  // CHECK-NOT:     hot_shapes
+  // CHECK:         %[[C32:.*]] = arith.constant 32 : index
+  // CHECK:         %[[EQ32:.*]] = arith.cmpi eq, %arg2, %[[C32]] : index
+  // CHECK:         scf.if %[[EQ32]] {
+  // CHECK:           call @kernel_32(%arg0, %arg1, %arg2)
+  // CHECK:         } else {
+  // CHECK:           %[[C1024:.*]] = arith.constant 1024 : index
+  // CHECK:           %[[EQ1024:.*]] = arith.cmpi eq, %arg2, %[[C1024]] : index
+  // CHECK:           scf.if %[[EQ1024]] {
+  // CHECK:             call @kernel_1024(%arg0, %arg1, %arg2)
+  // CHECK:           } else {
+  // CHECK:             call @kernel_generic(%arg0, %arg1, %arg2)
+  func.func @kernel(%A: memref<?xf32>, %B: memref<?xf32>, %n: index) attributes {hot_shapes = [array<i64: 32>, array<i64: 1024>]} {
+    affine.for %i = 0 to %n {
+      %a = affine.load %A[%i] : memref<?xf32>
+      %b = arith.mulf %a, %a : f32
+      affine.store %b, %B[%i] : memref<?xf32>
+    } {loop_name = "i", op_name = "s"}
+    return
+  }
+}
@@ -0,0 +1,34 @@
+// Copyright HeteroCL authors. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+// RUN: hcl-opt -profile-annotate=%S/Inputs/profile.json %s | FileCheck %s
+// RUN: hcl-opt -profile-annotate=%S/Inputs/profile.json %s | hcl-translate -emit-vivado-hls | FileCheck %s --check-prefix=HLS
+
+#map = affine_map<(d0) -> (d0 + 1)>
+#set = affine_set<(d0) : (d0 - 48 >= 0)>
+module {
+  // CHECK-LABEL: func.func @top
+  // CHECK:         affine.for
+  // CHECK:           affine.for
+  // CHECK:             affine.if
+  // CHECK:             } {taken_rate = 2.500000e-01 : f64}
+  // CHECK:           } {loop_name = "j", tripcount = array<i64: 1, 64, 33>}
+  // CHECK:         } {loop_name = "i", op_name = "s", tripcount = array<i64: 64, 64, 64>}
+
+  // HLS:       l_s_i: for
+  // HLS:         #pragma HLS loop_tripcount min=64 max=64 avg=64
+  // HLS:         l_j: for
+  // HLS:           #pragma HLS loop_tripcount min=1 max=64 avg=33
+  func.func @top(%A: memref<64x64xf32>) {
+    affine.for %i = 0 to 64 {
+      affine.for %j = 0 to #map(%i) {
+        affine.if #set(%j) {
+          %a = affine.load %A[%i, %j] : memref<64x64xf32>
+          %b = arith.addf %a, %a : f32
+          affine.store %b, %A[%i, %j] : memref<64x64xf32>
+        }
+      } {loop_name = "j"}
+    } {loop_name = "i", op_name = "s"}
+    return
+  }
+}
@@ -0,0 +1,37 @@
+// Copyright HeteroCL authors. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+// RUN: hcl-opt -profile-instrument %s | FileCheck %s
+
+#set = affine_set<(d0) : (d0 - 8 >= 0)>
+module {
+  // CHECK:       memref.global @__hcl_profile_counters : memref<6xi64> = dense<[0, 0, 9223372036854775807, 0, 0, 0]>
+  // CHECK-SAME:    branches = ["top/s/if0"], loops = ["top/s/i"]
+
+  // CHECK-LABEL: func.func @top
+  // CHECK:         %[[COUNTERS:.*]] = memref.get_global @__hcl_profile_counters : memref<6xi64>
+  // CHECK:         %[[TRIPS:.*]] = memref.alloca() : memref<i64>
+  // CHECK:         memref.store %{{.*}}, %[[TRIPS]][] : memref<i64>
+  // CHECK:         affine.for
+  // CHECK:           %[[N:.*]] = memref.load %[[TRIPS]][] : memref<i64>
+  // CHECK:           %[[N1:.*]] = arith.addi %[[N]], %{{.*}} : i64
+  // CHECK:           memref.store %[[N1]], %[[TRIPS]][] : memref<i64>
+  // CHECK:           memref.load %[[COUNTERS]][%{{.*}}] : memref<6xi64>
+  // CHECK:           affine.if
+  // CHECK:             memref.load %[[COUNTERS]][%{{.*}}] : memref<6xi64>
+  // CHECK:             affine.load
+  // CHECK:         } {loop_name = "i", op_name = "s"}
+  // CHECK:         %[[TOTAL:.*]] = memref.load %[[TRIPS]][] : memref<i64>
+  // CHECK:         arith.minsi %{{.*}}, %[[TOTAL]] : i64
+  // CHECK:         arith.maxsi %{{.*}}, %[[TOTAL]] : i64
+  func.func @top(%A: memref<16xf32>) {
+    affine.for %i = 0 to 16 {
+      affine.if #set(%i) {
+        %a = affine.load %A[%i] : memref<16xf32>
+        %b = arith.addf %a, %a : f32
+        affine.store %b, %A[%i] : memref<16xf32>
+      }
+    } {loop_name = "i", op_name = "s"}
+    return
+  }
+}
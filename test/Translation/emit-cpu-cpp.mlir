@@ -0,0 +1,129 @@
+// Copyright HeteroCL authors. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+// RUN: hcl-opt --opt --fixed-to-integer %s | hcl-translate --emit-cpu-cpp | FileCheck %s
+
+// CHECK-NOT: ap_int.h
+// CHECK-NOT: hls_stream.h
+module {
+  // CHECK: void gemm(
+  // CHECK-NEXT: float v{{[0-9]+}}[16][16],
+  func.func @gemm(%A: memref<16x16xf32>, %B: memref<16x16xf32>, %C: memref<16x16xf32>) {
+    %s = hcl.create_op_handle "s"
+    %li = hcl.create_loop_handle %s, "i"
+    %lj = hcl.create_loop_handle %s, "j"
+    %lk = hcl.create_loop_handle %s, "k"
+    // CHECK: #pragma omp parallel for
+    // CHECK-NEXT: for (int i = 0; i < 16; i++) {
+    // The reduction loop carries a dependence and is not vectorized.
+    // CHECK-NOT: #pragma
+    // CHECK: for (int k = 0; k < 16; k++) {
+    // CHECK-NEXT: #pragma omp simd
+    // CHECK-NEXT: for (int j = 0; j < 16; j++) {
+    affine.for %i = 0 to 16 {
+      affine.for %j = 0 to 16 {
+        affine.for %k = 0 to 16 {
+          %a = affine.load %A[%i, %k] : memref<16x16xf32>
+          %b = affine.load %B[%k, %j] : memref<16x16xf32>
+          %c = affine.load %C[%i, %j] : memref<16x16xf32>
+          %prod = arith.mulf %a, %b : f32
+          %sum = arith.addf %prod, %c : f32
+          affine.store %sum, %C[%i, %j] : memref<16x16xf32>
+        } {loop_name = "k"}
+      } {loop_name = "j"}
+    } {loop_name = "i", op_name = "s"}
+    hcl.reorder (%lk, %lj)
+    hcl.parallel (%li)
+    return
+  }
+
+  // CHECK: void unrolled(
+  func.func @unrolled(%A: memref<64xi32>, %B: memref<64xi32>) {
+    %s = hcl.create_op_handle "s"
+    %li = hcl.create_loop_handle %s, "i"
+    // CHECK: #pragma GCC unroll 4
+    // CHECK-NEXT: for (int {{i[0-9]*}} = 0; {{i[0-9]*}} < 64; {{i[0-9]*}}++) {
+    // CHECK: [[BIT:v[0-9]+]] = ({{.*}} >> {{.*}}) & 1;
+    affine.for %i = 0 to 64 {
+      %c0 = arith.constant 0 : index
+      %x = affine.load %A[%i] : memref<64xi32>
+      %bit = hcl.get_bit(%x : i32, %c0) -> i1
+      %ext = arith.extui %bit : i1 to i32
+      affine.store %ext, %B[%i] : memref<64xi32>
+    } {loop_name = "i", op_name = "s"}
+    hcl.unroll (%li, 4)
+    return
+  }
+
+  // Non-native widths are wrapped only after operations which may overflow.
+  // CHECK: void odd_width(
+  // CHECK: int16_t [[SUM:v[0-9]+]] = {{v[0-9]+}} + {{v[0-9]+}};
+  // CHECK-NEXT: [[SUM]] = hcl_wrap([[SUM]], 12);
+  // CHECK-NEXT: int16_t [[MAX:v[0-9]+]] = max([[SUM]], {{v[0-9]+}});
+  // CHECK-NOT: hcl_wrap
+  func.func @odd_width(%A: memref<8xi12>, %B: memref<8xi12>) {
+    affine.for %i = 0 to 8 {
+      %a = affine.load %A[%i] : memref<8xi12>
+      %b = affine.load %B[%i] : memref<8xi12>
+      %sum = arith.addi %a, %b : i12
+      %max = arith.maxsi %sum, %a : i12
+      affine.store %max, %B[%i] : memref<8xi12>
+    }
+    return
+  }
+
+  // Signless integers are stored in signed types, so the operands of unsigned
+  // operations are zero-extended from their widths.
+  // CHECK: void odd_width_unsigned(
+  // CHECK: int16_t [[SHR:v[0-9]+]] = hcl_zext([[A:v[0-9]+]], 12) >> hcl_zext([[B:v[0-9]+]], 12);
+  // CHECK-NEXT: [[SHR]] = hcl_wrap([[SHR]], 12);
+  // CHECK-NEXT: int16_t [[DIV:v[0-9]+]] = hcl_zext([[SHR]], 12) / hcl_zext([[B]], 12);
+  // CHECK-NEXT: [[DIV]] = hcl_wrap([[DIV]], 12);
+  // CHECK-NEXT: bool [[LT:v[0-9]+]] = hcl_zext([[DIV]], 12) < hcl_zext([[A]], 12);
+  // CHECK-NOT: hcl_wrap
+  func.func @odd_width_unsigned(%A: memref<8xi12>, %B: memref<8xi12>, %C: memref<8xi1>) {
+    affine.for %i = 0 to 8 {
+      %a = affine.load %A[%i] : memref<8xi12>
+      %b = affine.load %B[%i] : memref<8xi12>
+      %shr = arith.shrui %a, %b : i12
+      %div = arith.divui %shr, %b : i12
+      %lt = arith.cmpi ult, %div, %a : i12
+      affine.store %lt, %C[%i] : memref<8xi1>
+    }
+    return
+  }
+
+  // Unsigned fixed-point numbers are lowered to signless integers with
+  // unsigned operations. The 24-bit product is stored in an int32_t.
+  // CHECK: void ufixed_mul(
+  // CHECK: int32_t [[LHS:v[0-9]+]] = hcl_zext({{v[0-9]+}}, 12);
+  // CHECK: int32_t [[RHS:v[0-9]+]] = hcl_zext({{v[0-9]+}}, 12);
+  // CHECK: int32_t [[PROD:v[0-9]+]] = [[LHS]] * [[RHS]];
+  // CHECK: int32_t [[SHR:v[0-9]+]] = hcl_zext([[PROD]], 24) >> hcl_zext({{.*}}, 24);
+  // CHECK-NEXT: [[SHR]] = hcl_wrap([[SHR]], 24);
+  // CHECK-NEXT: int16_t [[RES:v[0-9]+]] = [[SHR]];
+  // CHECK-NEXT: [[RES]] = hcl_wrap([[RES]], 12);
+  func.func @ufixed_mul(%A: memref<8x!hcl.UFixed<12, 4>>, %B: memref<8x!hcl.UFixed<12, 4>>) {
+    affine.for %i = 0 to 8 {
+      %a = affine.load %A[%i] : memref<8x!hcl.UFixed<12, 4>>
+      %b = affine.load %B[%i] : memref<8x!hcl.UFixed<12, 4>>
+      %prod = "hcl.mul_fixed"(%a, %b) : (!hcl.UFixed<12, 4>, !hcl.UFixed<12, 4>) -> !hcl.UFixed<12, 4>
+      affine.store %prod, %B[%i] : memref<8x!hcl.UFixed<12, 4>>
+    }
+    return
+  }
+
+  // Operands of native widths are cast to the unsigned type of the same width.
+  // CHECK: void native_unsigned(
+  // CHECK: int32_t [[REM:v[0-9]+]] = (uint32_t){{v[0-9]+}} % (uint32_t){{v[0-9]+}};
+  // CHECK: int64_t {{v[0-9]+}} = (uint32_t)[[REM]];
+  func.func @native_unsigned(%A: memref<8xi32>, %B: memref<8xi64>) {
+    affine.for %i = 0 to 8 {
+      %a = affine.load %A[%i] : memref<8xi32>
+      %rem = arith.remui %a, %a : i32
+      %ext = arith.extui %rem : i32 to i64
+      affine.store %ext, %B[%i] : memref<8xi64>
+    }
+    return
+  }
+}
@@ -0,0 +1,28 @@
+// Copyright HeteroCL authors. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+// The emitted HLS C++ must compile against the header-only simulation
+// library in include/hcl/Simulation, without a vendor installation.
+// REQUIRES: host-cxx
+// RUN: hcl-translate -emit-vivado-hls %s -o %t.cpp
+// RUN: %host_cxx -std=c++17 -fsyntax-only -I %hcl_sim_include %t.cpp
+
+module {
+  func.func @top(%A: memref<8x!hcl.Fixed<16, 12>>, %B: memref<8x!hcl.Fixed<16, 12>>, %X: memref<8xi32>, %Y: memref<8xi32>) {
+    affine.for %i = 0 to 8 {
+      %a = affine.load %A[%i] : memref<8x!hcl.Fixed<16, 12>>
+      %b = affine.load %B[%i] : memref<8x!hcl.Fixed<16, 12>>
+      %prod = "hcl.mul_fixed"(%a, %b) : (!hcl.Fixed<16, 12>, !hcl.Fixed<16, 12>) -> !hcl.Fixed<16, 12>
+      %sum = "hcl.add_fixed"(%prod, %a) : (!hcl.Fixed<16, 12>, !hcl.Fixed<16, 12>) -> !hcl.Fixed<16, 12>
+      affine.store %sum, %B[%i] : memref<8x!hcl.Fixed<16, 12>>
+      %x = affine.load %X[%i] : memref<8xi32>
+      %bit = hcl.get_bit(%x : i32, %i) -> i1
+      %hi = arith.constant 5 : index
+      %lo = arith.constant 3 : index
+      %val = arith.extui %bit : i1 to i3
+      %y = hcl.set_slice(%x : i32, %hi, %lo, %val : i3) -> i32
+      affine.store %y, %Y[%i] : memref<8xi32>
+    } {loop_name = "i", op_name = "s"}
+    return
+  }
+}
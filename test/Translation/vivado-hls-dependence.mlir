@@ -0,0 +1,51 @@
+// Copyright HeteroCL authors. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+// RUN: hcl-translate -emit-vivado-hls %s | FileCheck %s
+
+module {
+  // CHECK-LABEL: void independent(
+  // CHECK-NEXT: {{.*}} [[A:v[0-9]+]][16],
+  // CHECK-NEXT: {{.*}} [[B:v[0-9]+]][16]
+  func.func @independent(%A: memref<16xi32>, %B: memref<16xi32>) {
+    // CHECK: #pragma HLS pipeline II=1
+    // CHECK-NEXT: #pragma HLS dependence variable=[[B]] inter false
+    // CHECK-NOT: variable=[[B]] intra
+    // CHECK-NOT: variable=[[A]]
+    affine.for %i = 0 to 16 {
+      %a = affine.load %A[%i] : memref<16xi32>
+      %b = affine.load %B[%i] : memref<16xi32>
+      %c = arith.addi %a, %b : i32
+      affine.store %c, %B[%i] : memref<16xi32>
+    } {loop_name = "i", op_name = "s", pipeline_ii = 1 : i32}
+    return
+  }
+
+  // CHECK-LABEL: void carried(
+  // CHECK-NEXT: {{.*}} [[C:v[0-9]+]][16]
+  func.func @carried(%C: memref<16xi32>) {
+    // CHECK: #pragma HLS pipeline II=1
+    // CHECK-NEXT: #pragma HLS dependence variable=[[C]] intra false
+    // CHECK-NOT: inter false
+    affine.for %i = 1 to 16 {
+      %a = affine.load %C[%i - 1] : memref<16xi32>
+      %b = arith.addi %a, %a : i32
+      affine.store %b, %C[%i] : memref<16xi32>
+    } {loop_name = "i", op_name = "s", pipeline_ii = 1 : i32}
+    return
+  }
+
+  // Indirect indices are left to HLS.
+  // CHECK-LABEL: void indirect(
+  func.func @indirect(%D: memref<16xi32>, %idx: memref<16xindex>) {
+    // CHECK: #pragma HLS pipeline II=1
+    // CHECK-NOT: #pragma HLS dependence
+    affine.for %i = 0 to 16 {
+      %j = affine.load %idx[%i] : memref<16xindex>
+      %a = memref.load %D[%j] : memref<16xi32>
+      %b = arith.addi %a, %a : i32
+      memref.store %b, %D[%j] : memref<16xi32>
+    } {loop_name = "i", op_name = "s", pipeline_ii = 1 : i32}
+    return
+  }
+}
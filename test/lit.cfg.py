@@ -43,7 +43,8 @@ llvm_config.use_default_substitutions()
 # excludes: A list of directories to exclude from the testsuite. The 'Inputs'
 # subdirectories contain auxiliary inputs for various tests in their parent
 # directories.
-config.excludes = ['lit.cfg.py', 'CMakeLists.txt', 'README.txt', 'LICENSE.txt']
+config.excludes = ['Inputs', 'lit.cfg.py', 'CMakeLists.txt', 'README.txt',
+                   'LICENSE.txt']
 
 # Unsupported tests
 config.excludes += ['test_llvm.py']
@@ -62,11 +63,19 @@ tool_dirs = [config.standalone_tools_dir, config.llvm_tools_dir]
 tools = [
     'hcl-opt',
     'hcl-translate',
+    'hcl-compile-bench',
     ToolSubst('%PYTHON', config.python_executable, unresolved='ignore'),
 ]
 
 llvm_config.add_tool_substitutions(tools, tool_dirs)
 
+# Emitted HLS code is compiled against the header-only simulation library.
+config.substitutions.append(('%hcl_sim_include',
+    os.path.join(config.standalone_src_root, 'include', 'hcl', 'Simulation')))
+if config.host_cxx:
+    config.available_features.add('host-cxx')
+    config.substitutions.append(('%host_cxx', config.host_cxx))
+
 llvm_config.with_environment('PYTHONPATH', [
     os.path.join(config.mlir_binary_dir, 'tools/hcl/python_packages/hcl_core'),
 ], append_path=True)
@@ -0,0 +1,581 @@
+/*
+ * Copyright HeteroCL authors. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//===----------------------------------------------------------------------===//
+//
+// Compile-time scaling benchmark for the HeteroCL passes and translations.
+//
+// The tool generates parametric designs (N stages, M schedule primitives per
+// stage, K-deep loop nests, large constant tables), times each pass or
+// translation at increasing N, fits a complexity exponent t ~ N^b, and
+// optionally compares the results against a stored baseline.
+//
+//===----------------------------------------------------------------------===//
+
+#include "mlir/Dialect/Affine/IR/AffineOps.h"
+#include "mlir/Dialect/Arith/IR/Arith.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/Dialect/Math/IR/Math.h"
+#include "mlir/Dialect/MemRef/IR/MemRef.h"
+#include "mlir/Dialect/SCF/IR/SCF.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/Parser/Parser.h"
+#include "mlir/Pass/PassManager.h"
+#include "mlir/Support/FileUtilities.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FormatVariadic.h"
+#include "llvm/Support/InitLLVM.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/ToolOutputFile.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "hcl/Conversion/Passes.h"
+#include "hcl/Dialect/HeteroCLDialect.h"
+#include "hcl/Transforms/Passes.h"
+#include "hcl/Translation/EmitVivadoHLS.h"
+
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <string>
+
+using namespace mlir;
+
+static llvm::cl::list<unsigned>
+    sizes("sizes", llvm::cl::desc("Number of stages (N) to generate"),
+          llvm::cl::CommaSeparated);
+
+static llvm::cl::opt<unsigned>
+    numPrimitives("primitives",
+                  llvm::cl::desc("Schedule primitives per stage (M)"),
+                  llvm::cl::init(4));
+
+static llvm::cl::opt<unsigned>
+    nestDepth("depth", llvm::cl::desc("Depth of each loop nest (K)"),
+              llvm::cl::init(3));
+
+static llvm::cl::opt<unsigned> constSize(
+    "const-size",
+    llvm::cl::desc("Number of elements in the constant table of each stage"),
+    llvm::cl::init(1024));
+
+static llvm::cl::opt<unsigned>
+    repeat("repeat",
+           llvm::cl::desc("Repetitions per measurement (minimum is kept)"),
+           llvm::cl::init(3));
+
+static llvm::cl::list<std::string>
+    workloadFilter("workloads",
+                   llvm::cl::desc("Only run the given workloads"),
+                   llvm::cl::CommaSeparated);
+
+static llvm::cl::opt<std::string>
+    baselineFilename("baseline",
+                     llvm::cl::desc("Compare against a stored baseline"),
+                     llvm::cl::value_desc("filename"), llvm::cl::init(""));
+
+static llvm::cl::opt<std::string> writeBaselineFilename(
+    "write-baseline", llvm::cl::desc("Store the results as a new baseline"),
+    llvm::cl::value_desc("filename"), llvm::cl::init(""));
+
+static llvm::cl::opt<double> exponentSlack(
+    "exponent-slack",
+    llvm::cl::desc("Allowed increase of the complexity exponent over the "
+                   "baseline before reporting a regression"),
+    llvm::cl::init(0.25));
+
+static llvm::cl::opt<double> timeTolerance(
+    "time-tolerance",
+    llvm::cl::desc("Allowed relative slowdown over the baseline times before "
+                   "reporting a regression (0 disables the check)"),
+    llvm::cl::init(0.0));
+
+static llvm::cl::opt<bool> emitJSON("json",
+                                    llvm::cl::desc("Print results as JSON"),
+                                    llvm::cl::init(false));
+
+//===----------------------------------------------------------------------===//
+// Synthetic design generators
+//===----------------------------------------------------------------------===//
+
+namespace {
+
+/// Shape of a K-deep nest: the outermost loop is long enough to be split a few
+/// times, the remaining ones are kept small to bound the memref sizes.
+static SmallVector<int64_t> getNestShape(unsigned depth) {
+  SmallVector<int64_t> shape;
+  for (unsigned d = 0; d < depth; ++d)
+    shape.push_back(d == 0 ? 64 : 16);
+  return shape;
+}
+
+static std::string getMemRefType(ArrayRef<int64_t> shape, StringRef elt) {
+  std::string str = "memref<";
+  for (auto dim : shape)
+    str += std::to_string(dim) + "x";
+  return str + elt.str() + ">";
+}
+
+/// Emit a K-deep affine nest named "s<stage>" whose innermost body is produced
+/// by `body`. The induction variables are passed as a comma-separated list.
+static void
+emitNest(llvm::raw_ostream &os, unsigned stage, unsigned depth,
+         const std::function<void(llvm::raw_ostream &, StringRef)> &body) {
+  auto shape = getNestShape(depth);
+  std::string ivs;
+  for (unsigned d = 0; d < depth; ++d) {
+    os.indent(4 + 2 * d) << "affine.for %s" << stage << "_i" << d << " = 0 to "
+                         << shape[d] << " {\n";
+    ivs += (d ? ", " : "") + llvm::formatv("%s{0}_i{1}", stage, d).str();
+  }
+  body(os, ivs);
+  for (int d = depth - 1; d >= 0; --d) {
+    os.indent(4 + 2 * d) << "} {loop_name = \"l" << d << "\"";
+    if (d == 0)
+      os << ", op_name = \"s" << stage << "\"";
+    os << "}\n";
+  }
+}
+
+/// Elementwise chain of N stages with M schedule primitives each. Stresses the
+/// name-based stage and loop lookups of the LoopTransformation pass.
+static std::string genLoopOpt(unsigned numStages, unsigned prims,
+                              unsigned depth) {
+  std::string str;
+  llvm::raw_string_ostream os(str);
+  auto shape = getNestShape(depth);
+  auto type = getMemRefType(shape, "f32");
+  os << "module {\n";
+  os << "  func.func @top(%in: " << type << ", %out: " << type << ") {\n";
+  os << "    %cst = arith.constant 1.0 : f32\n";
+  for (unsigned s = 0; s < numStages; ++s) {
+    std::string src = s == 0 ? "%in" : "%buf" + std::to_string(s - 1);
+    std::string dst =
+        s + 1 == numStages ? "%out" : "%buf" + std::to_string(s);
+    if (s + 1 != numStages)
+      os << "    " << dst << " = memref.alloc() : " << type << "\n";
+    emitNest(os, s, depth, [&](llvm::raw_ostream &os, StringRef ivs) {
+      auto ind = 4 + 2 * depth;
+      os.indent(ind) << "%v" << s << " = affine.load " << src << "[" << ivs
+                     << "] : " << type << "\n";
+      os.indent(ind) << "%r" << s << " = arith.addf %v" << s << ", %cst : f32\n";
+      os.indent(ind) << "affine.store %r" << s << ", " << dst << "[" << ivs
+                     << "] : " << type << "\n";
+    });
+  }
+
+  // Schedule primitives. Handles are (re)created per stage and the outermost
+  // loop handle is updated after each split.
+  for (unsigned s = 0; s < numStages; ++s) {
+    os << "    %h" << s << " = hcl.create_op_handle \"s" << s << "\"\n";
+    SmallVector<std::string> loops;
+    for (unsigned d = 0; d < depth; ++d) {
+      auto name = llvm::formatv("%h{0}_l{1}", s, d).str();
+      os << "    " << name << " = hcl.create_loop_handle %h" << s << ", \"l"
+         << d << "\"\n";
+      loops.push_back(name);
+    }
+    int64_t outerTrip = shape[0];
+    for (unsigned p = 0; p < prims; ++p) {
+      switch (p % 4) {
+      case 0:
+        os << "    hcl.unroll (" << loops.back() << ", 2)\n";
+        break;
+      case 1:
+        os << "    hcl.pipeline (" << loops.back() << ", 1)\n";
+        break;
+      case 2:
+        if (depth >= 2)
+          os << "    hcl.reorder (" << loops[depth - 1] << ", "
+             << loops[depth - 2] << ")\n";
+        break;
+      case 3:
+        if (outerTrip > 2) {
+          auto outer = llvm::formatv("%h{0}_o{1}", s, p).str();
+          auto inner = llvm::formatv("%h{0}_n{1}", s, p).str();
+          os << "    " << outer << ", " << inner << " = hcl.split ("
+             << loops[0] << ", 2)\n";
+          loops[0] = outer;
+          outerTrip /= 2;
+        }
+        break;
+      }
+    }
+  }
+  os << "    return\n  }\n}\n";
+  return os.str();
+}
+
+/// Chain of fixed-point multiply-accumulate stages.
+static std::string genFixed(unsigned numStages, unsigned depth) {
+  std::string str;
+  llvm::raw_string_ostream os(str);
+  auto shape = getNestShape(depth);
+  auto type = getMemRefType(shape, "!hcl.Fixed<16, 8>");
+  os << "module {\n";
+  os << "  func.func @top(%in: " << type << ", %w: " << type
+     << ", %out: " << type << ") {\n";
+  for (unsigned s = 0; s < numStages; ++s) {
+    std::string src = s == 0 ? "%in" : "%buf" + std::to_string(s - 1);
+    std::string dst =
+        s + 1 == numStages ? "%out" : "%buf" + std::to_string(s);
+    if (s + 1 != numStages)
+      os << "    " << dst << " = memref.alloc() : " << type << "\n";
+    emitNest(os, s, depth, [&](llvm::raw_ostream &os, StringRef ivs) {
+      auto ind = 4 + 2 * depth;
+      os.indent(ind) << "%a" << s << " = affine.load " << src << "[" << ivs
+                     << "] : " << type << "\n";
+      os.indent(ind) << "%b" << s << " = affine.load %w[" << ivs
+                     << "] : " << type << "\n";
+      os.indent(ind) << "%m" << s << " = \"hcl.mul_fixed\"(%a" << s << ", %b"
+                     << s << ") : (!hcl.Fixed<16, 8>, !hcl.Fixed<16, 8>) -> "
+                     << "!hcl.Fixed<16, 8>\n";
+      os.indent(ind) << "%r" << s << " = \"hcl.add_fixed\"(%m" << s << ", %a"
+                     << s << ") : (!hcl.Fixed<16, 8>, !hcl.Fixed<16, 8>) -> "
+                     << "!hcl.Fixed<16, 8>\n";
+      os.indent(ind) << "affine.store %r" << s << ", " << dst << "[" << ivs
+                     << "] : " << type << "\n";
+    });
+  }
+  os << "    return\n  }\n}\n";
+  return os.str();
+}
+
+/// Stages that pack three fields into a struct memref and unpack one of them
+/// in a consumer nest.
+static std::string genComposite(unsigned numStages, unsigned depth) {
+  std::string str;
+  llvm::raw_string_ostream os(str);
+  auto shape = getNestShape(depth);
+  auto type = getMemRefType(shape, "i32");
+  auto sType = getMemRefType(shape, "!hcl.struct<i32, i32, f32>");
+  os << "module {\n";
+  os << "  func.func @top(%in: " << type << ", %out: " << type << ") {\n";
+  os << "    %c1 = arith.constant 1 : i32\n";
+  os << "    %f1 = arith.constant 1.0 : f32\n";
+  for (unsigned s = 0; s < numStages; ++s) {
+    std::string src = s == 0 ? "%in" : "%buf" + std::to_string(s - 1);
+    std::string dst =
+        s + 1 == numStages ? "%out" : "%buf" + std::to_string(s);
+    os << "    %st" << s << " = memref.alloc() : " << sType << "\n";
+    emitNest(os, 2 * s, depth, [&](llvm::raw_ostream &os, StringRef ivs) {
+      auto ind = 4 + 2 * depth;
+      os.indent(ind) << "%v" << s << " = affine.load " << src << "[" << ivs
+                     << "] : " << type << "\n";
+      os.indent(ind) << "%p" << s << " = hcl.struct_construct(%v" << s
+                     << ", %c1, %f1) : i32, i32, f32 -> "
+                     << "!hcl.struct<i32, i32, f32>\n";
+      os.indent(ind) << "affine.store %p" << s << ", %st" << s << "[" << ivs
+                     << "] : " << sType << "\n";
+    });
+    if (s + 1 != numStages)
+      os << "    " << dst << " = memref.alloc() : " << type << "\n";
+    emitNest(os, 2 * s + 1, depth, [&](llvm::raw_ostream &os, StringRef ivs) {
+      auto ind = 4 + 2 * depth;
+      os.indent(ind) << "%q" << s << " = affine.load %st" << s << "[" << ivs
+                     << "] : " << sType << "\n";
+      os.indent(ind) << "%g" << s << " = hcl.struct_get %q" << s
+                     << "[0] : !hcl.struct<i32, i32, f32> -> i32\n";
+      os.indent(ind) << "affine.store %g" << s << ", " << dst << "[" << ivs
+                     << "] : " << type << "\n";
+    });
+  }
+  os << "    return\n  }\n}\n";
+  return os.str();
+}
+
+/// Stages that each look up a large constant table, for the HLS emitter.
+static std::string genEmit(unsigned numStages, unsigned depth,
+                           unsigned tableSize) {
+  std::string str;
+  llvm::raw_string_ostream os(str);
+  auto shape = getNestShape(depth);
+  auto type = getMemRefType(shape, "i32");
+  auto tType = getMemRefType({(int64_t)tableSize}, "i32");
+  os << "module {\n";
+  for (unsigned s = 0; s < numStages; ++s) {
+    os << "  memref.global \"private\" constant @table" << s << " : " << tType
+       << " = dense<[";
+    for (unsigned i = 0; i < tableSize; ++i)
+      os << (i ? ", " : "") << (i * 7 + s) % 251;
+    os << "]>\n";
+  }
+  os << "  func.func @top(%in: " << type << ", %out: " << type << ") {\n";
+  for (unsigned s = 0; s < numStages; ++s) {
+    std::string src = s == 0 ? "%in" : "%buf" + std::to_string(s - 1);
+    std::string dst =
+        s + 1 == numStages ? "%out" : "%buf" + std::to_string(s);
+    os << "    %t" << s << " = memref.get_global @table" << s << " : " << tType
+       << "\n";
+    if (s + 1 != numStages)
+      os << "    " << dst << " = memref.alloc() : " << type << "\n";
+    emitNest(os, s, depth, [&](llvm::raw_ostream &os, StringRef ivs) {
+      auto ind = 4 + 2 * depth;
+      os.indent(ind) << "%v" << s << " = affine.load " << src << "[" << ivs
+                     << "] : " << type << "\n";
+      os.indent(ind) << "%w" << s << " = affine.load %t" << s << "[%s" << s
+                     << "_i0] : " << tType << "\n";
+      os.indent(ind) << "%r" << s << " = arith.addi %v" << s << ", %w" << s
+                     << " : i32\n";
+      os.indent(ind) << "affine.store %r" << s << ", " << dst << "[" << ivs
+                     << "] : " << type << "\n";
+    });
+  }
+  os << "    return\n  }\n}\n";
+  return os.str();
+}
+
+//===----------------------------------------------------------------------===//
+// Measurement
+//===----------------------------------------------------------------------===//
+
+struct Workload {
+  std::string name;
+  std::function<std::string(unsigned)> generate;
+  std::function<LogicalResult(ModuleOp)> run;
+};
+
+struct Sample {
+  unsigned size;
+  double parseMs;
+  double runMs;
+};
+
+struct WorkloadResult {
+  std::string name;
+  SmallVector<Sample> samples;
+  double exponent = 0;
+};
+
+template <typename FnT> static double timeMs(FnT &&fn) {
+  auto start = std::chrono::steady_clock::now();
+  fn();
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+/// Least-squares slope of log(t) over log(N).
+static double fitExponent(ArrayRef<Sample> samples) {
+  double sx = 0, sy = 0, sxx = 0, sxy = 0;
+  unsigned n = 0;
+  for (auto &s : samples) {
+    if (s.size == 0 || s.runMs <= 0)
+      continue;
+    double x = std::log((double)s.size), y = std::log(s.runMs);
+    sx += x, sy += y, sxx += x * x, sxy += x * y, ++n;
+  }
+  double denom = n * sxx - sx * sx;
+  if (n < 2 || denom == 0)
+    return 0;
+  return (n * sxy - sx * sy) / denom;
+}
+
+static SmallVector<Workload> getWorkloads() {
+  SmallVector<Workload> workloads;
+  workloads.push_back(
+      {"loop-opt",
+       [](unsigned n) { return genLoopOpt(n, numPrimitives, nestDepth); },
+       [](ModuleOp m) {
+         PassManager pm(m.getContext());
+         pm.addPass(hcl::createLoopTransformationPass());
+         return pm.run(m);
+       }});
+  workloads.push_back({"fixed-to-integer",
+                       [](unsigned n) { return genFixed(n, nestDepth); },
+                       [](ModuleOp m) {
+                         PassManager pm(m.getContext());
+                         pm.addPass(hcl::createFixedPointToIntegerPass());
+                         return pm.run(m);
+                       }});
+  workloads.push_back({"lower-composite-type",
+                       [](unsigned n) { return genComposite(n, nestDepth); },
+                       [](ModuleOp m) {
+                         PassManager pm(m.getContext());
+                         pm.addPass(hcl::createLowerCompositeTypePass());
+                         return pm.run(m);
+                       }});
+  workloads.push_back(
+      {"emit-vivado-hls",
+       [](unsigned n) { return genEmit(n, nestDepth, constSize); },
+       [](ModuleOp m) { return hcl::emitVivadoHLS(m, llvm::nulls()); }});
+  return workloads;
+}
+
+static LogicalResult measure(const Workload &workload, MLIRContext &context,
+                             WorkloadResult &result) {
+  result.name = workload.name;
+  for (unsigned n : sizes) {
+    auto text = workload.generate(n);
+    Sample sample{n, INFINITY, INFINITY};
+    for (unsigned r = 0; r < std::max(1u, (unsigned)repeat); ++r) {
+      OwningOpRef<ModuleOp> module;
+      sample.parseMs = std::min(sample.parseMs, timeMs([&] {
+                                  module = parseSourceString<ModuleOp>(
+                                      text, &context);
+                                }));
+      if (!module) {
+        llvm::errs() << workload.name << ": failed to parse the generated "
+                     << "design with N=" << n << "\n";
+        return failure();
+      }
+      LogicalResult status = success();
+      sample.runMs = std::min(
+          sample.runMs, timeMs([&] { status = workload.run(*module); }));
+      if (failed(status)) {
+        llvm::errs() << workload.name << ": failed on N=" << n << "\n";
+        return failure();
+      }
+    }
+    result.samples.push_back(sample);
+  }
+  result.exponent = fitExponent(result.samples);
+  return success();
+}
+
+//===----------------------------------------------------------------------===//
+// Reporting and baseline comparison
+//===----------------------------------------------------------------------===//
+
+static llvm::json::Value toJSON(ArrayRef<WorkloadResult> results) {
+  llvm::json::Object workloads;
+  for (auto &res : results) {
+    llvm::json::Object times;
+    for (auto &s : res.samples)
+      times[std::to_string(s.size)] = s.runMs;
+    workloads[res.name] = llvm::json::Object{
+        {"exponent", res.exponent}, {"ms", std::move(times)}};
+  }
+  return llvm::json::Object{
+      {"version", 1},
+      {"config", llvm::json::Object{{"primitives", (int64_t)numPrimitives},
+                                    {"depth", (int64_t)nestDepth},
+                                    {"const-size", (int64_t)constSize}}},
+      {"workloads", std::move(workloads)}};
+}
+
+static void printTable(ArrayRef<WorkloadResult> results) {
+  llvm::outs() << llvm::formatv("{0,-22} {1,8} {2,12} {3,12}\n", "workload",
+                                "N", "parse(ms)", "run(ms)");
+  for (auto &res : results) {
+    for (auto &s : res.samples)
+      llvm::outs() << llvm::formatv("{0,-22} {1,8} {2,12:f3} {3,12:f3}\n",
+                                    res.name, s.size, s.parseMs, s.runMs);
+    llvm::outs() << llvm::formatv("{0,-22} complexity ~ O(N^{1:f2})\n",
+                                  res.name, res.exponent);
+  }
+}
+
+/// Return the number of regressions found against the baseline.
+static int compareBaseline(ArrayRef<WorkloadResult> results,
+                           const llvm::json::Object &baseline) {
+  int regressions = 0;
+  auto *workloads = baseline.getObject("workloads");
+  if (!workloads) {
+    llvm::errs() << "baseline has no \"workloads\" entry\n";
+    return 1;
+  }
+  for (auto &res : results) {
+    auto *base = workloads->getObject(res.name);
+    if (!base)
+      continue;
+    if (auto exp = base->getNumber("exponent")) {
+      if (res.exponent > *exp + exponentSlack) {
+        llvm::outs() << llvm::formatv(
+            "REGRESSION {0}: complexity O(N^{1:f2}) vs baseline O(N^{2:f2})\n",
+            res.name, res.exponent, *exp);
+        ++regressions;
+      }
+    }
+    auto *times = base->getObject("ms");
+    if (!times || timeTolerance <= 0)
+      continue;
+    for (auto &s : res.samples) {
+      auto baseMs = times->getNumber(std::to_string(s.size));
+      if (baseMs && s.runMs > *baseMs * (1 + timeTolerance)) {
+        llvm::outs() << llvm::formatv(
+            "REGRESSION {0}: N={1} took {2:f3} ms vs baseline {3:f3} ms\n",
+            res.name, s.size, s.runMs, *baseMs);
+        ++regressions;
+      }
+    }
+  }
+  return regressions;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  llvm::InitLLVM y(argc, argv);
+  llvm::cl::ParseCommandLineOptions(
+      argc, argv, "HeteroCL compile-time scaling benchmark\n");
+  if (sizes.empty())
+    for (unsigned n : {8, 16, 32, 64})
+      sizes.push_back(n);
+
+  mlir::DialectRegistry registry;
+  // clang-format off
+  registry.insert<
+    mlir::hcl::HeteroCLDialect,
+    mlir::func::FuncDialect,
+    mlir::arith::ArithDialect,
+    mlir::scf::SCFDialect,
+    mlir::affine::AffineDialect,
+    mlir::math::MathDialect,
+    mlir::memref::MemRefDialect
+  >();
+  // clang-format on
+  mlir::MLIRContext context(registry);
+  context.loadAllAvailableDialects();
+
+  SmallVector<WorkloadResult> results;
+  for (auto &workload : getWorkloads()) {
+    if (!workloadFilter.empty() &&
+        llvm::find(workloadFilter, workload.name) == workloadFilter.end())
+      continue;
+    WorkloadResult result;
+    if (failed(measure(workload, context, result)))
+      return 1;
+    results.push_back(std::move(result));
+  }
+
+  if (emitJSON)
+    llvm::outs() << llvm::formatv("{0:2}", toJSON(results)) << "\n";
+  else
+    printTable(results);
+
+  if (!writeBaselineFilename.empty()) {
+    std::string errorMessage;
+    auto output = mlir::openOutputFile(writeBaselineFilename, &errorMessage);
+    if (!output) {
+      llvm::errs() << errorMessage << "\n";
+      return 2;
+    }
+    output->os() << llvm::formatv("{0:2}", toJSON(results)) << "\n";
+    output->keep();
+  }
+
+  if (!baselineFilename.empty()) {
+    auto buffer = llvm::MemoryBuffer::getFile(baselineFilename);
+    if (!buffer) {
+      llvm::errs() << "cannot open baseline " << baselineFilename << "\n";
+      return 2;
+    }
+    auto parsed = llvm::json::parse((*buffer)->getBuffer());
+    if (!parsed || !parsed->getAsObject()) {
+      llvm::consumeError(parsed.takeError());
+      llvm::errs() << "malformed baseline " << baselineFilename << "\n";
+      return 2;
+    }
+    if (int regressions = compareBaseline(results, *parsed->getAsObject())) {
+      llvm::outs() << regressions << " compile-time regression(s) found\n";
+      return 1;
+    }
+    llvm::outs() << "no compile-time regressions against the baseline\n";
+  }
+  return 0;
+}
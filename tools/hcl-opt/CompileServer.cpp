@@ -0,0 +1,464 @@
+/*
+ * Copyright HeteroCL authors. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//===----------------------------------------------------------------------===//
+// Compile server
+// hcl-opt -serve=<socket> keeps a pool of contexts with their dialects loaded
+// and compiles the requests it receives on a UNIX-domain socket. Messages in
+// both directions are JSON objects, each preceded by its size in bytes as an
+// 8-byte little-endian integer. A request
+//
+//   {"module": "<MLIR>", "flags": ["-opt"], "translate": "emit-vivado-hls"}
+//
+// is answered with {"ok", "output", "diagnostics", "cached"}. Successful
+// results are cached by the content of the request. {"stats": true} returns
+// the number of requests and cache hits, and {"shutdown": true} stops the
+// server. A connection may send any number of requests. Contexts are
+// recreated after a number of requests, so that what the requests uniqued in
+// them is freed.
+//===----------------------------------------------------------------------===//
+
+#include "CompileServer.h"
+
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/SHA256.h"
+#include "llvm/Support/Threading.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <thread>
+#include <unordered_map>
+
+using namespace mlir;
+using namespace hcl;
+
+// Larger messages are rejected rather than allocated.
+static constexpr uint64_t kMaxMessageSize = 1ull << 30;
+
+//===----------------------------------------------------------------------===//
+// Messages
+//===----------------------------------------------------------------------===//
+
+static bool readAll(int fd, char *data, size_t size) {
+  while (size > 0) {
+    ssize_t n = ::read(fd, data, size);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return false;
+    data += n;
+    size -= n;
+  }
+  return true;
+}
+
+static bool writeAll(int fd, const char *data, size_t size) {
+  while (size > 0) {
+    // A client that went away must not kill the server with SIGPIPE.
+    ssize_t n = ::send(fd, data, size, MSG_NOSIGNAL);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return false;
+    data += n;
+    size -= n;
+  }
+  return true;
+}
+
+static bool readMessage(int fd, std::string &message) {
+  char header[8];
+  if (!readAll(fd, header, sizeof(header)))
+    return false;
+  uint64_t size = llvm::support::endian::read64le(header);
+  if (size > kMaxMessageSize)
+    return false;
+  message.resize(size);
+  return readAll(fd, message.data(), size);
+}
+
+static bool writeMessage(int fd, llvm::json::Value value) {
+  std::string body;
+  llvm::raw_string_ostream(body) << value;
+  char header[8];
+  llvm::support::endian::write64le(header, body.size());
+  return writeAll(fd, header, sizeof(header)) &&
+         writeAll(fd, body.data(), body.size());
+}
+
+static llvm::json::Object getErrorResponse(const llvm::Twine &error) {
+  return llvm::json::Object{{"ok", false}, {"diagnostics", error.str()}};
+}
+
+static bool parseRequest(const llvm::json::Object &object,
+                         CompileRequest &request, std::string &error) {
+  auto module = object.getString("module");
+  if (!module) {
+    error = "expected a \"module\" string";
+    return false;
+  }
+  request.module = module->str();
+  if (auto *flags = object.getArray("flags")) {
+    for (auto &flag : *flags) {
+      auto str = flag.getAsString();
+      if (!str) {
+        error = "expected \"flags\" to be an array of strings";
+        return false;
+      }
+      request.flags.push_back(str->str());
+    }
+  }
+  if (auto translation = object.getString("translate"))
+    request.translation = translation->str();
+  return true;
+}
+
+/// The cache key of a request, a hash of its content so that the cache does
+/// not hold whole modules. The separators keep e.g. the flags ["-a", "b"] and
+/// ["-ab"] apart.
+static std::string getCacheKey(const CompileRequest &request) {
+  llvm::SHA256 hasher;
+  hasher.update(request.translation);
+  hasher.update(llvm::StringRef("\0", 1));
+  for (auto &flag : request.flags) {
+    hasher.update(flag);
+    hasher.update(llvm::StringRef("\0", 1));
+  }
+  hasher.update(llvm::StringRef("\0", 1));
+  hasher.update(request.module);
+  auto hash = hasher.final();
+  return std::string(hash.begin(), hash.end());
+}
+
+//===----------------------------------------------------------------------===//
+// Server
+//===----------------------------------------------------------------------===//
+
+namespace {
+/// Contexts with their dialects loaded, each used by one request at a time.
+class ContextPool {
+public:
+  struct Slot {
+    std::unique_ptr<MLIRContext> context;
+    unsigned numRequests = 0;
+    size_t numBytes = 0;
+  };
+
+  ContextPool(const DialectRegistry &registry, unsigned size,
+              unsigned maxRequests, size_t maxBytes)
+      : registry(registry), maxRequests(maxRequests), maxBytes(maxBytes) {
+    for (unsigned i = 0; i < size; ++i) {
+      auto slot = std::make_unique<Slot>();
+      slot->context = createContext();
+      available.push_back(slot.get());
+      slots.push_back(std::move(slot));
+    }
+  }
+
+  Slot *acquire() {
+    std::unique_lock<std::mutex> lock(mutex);
+    released.wait(lock, [&] { return !available.empty(); });
+    Slot *slot = available.back();
+    available.pop_back();
+    return slot;
+  }
+
+  /// Returns a context that compiled a module of `moduleSize` bytes, first
+  /// recreating it if it reached its limits.
+  void release(Slot *slot, size_t moduleSize) {
+    ++slot->numRequests;
+    slot->numBytes += moduleSize;
+    if ((maxRequests && slot->numRequests >= maxRequests) ||
+        (maxBytes && slot->numBytes >= maxBytes)) {
+      slot->context = createContext();
+      slot->numRequests = 0;
+      slot->numBytes = 0;
+      ++numRecreated;
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      available.push_back(slot);
+    }
+    released.notify_one();
+  }
+
+  int64_t getNumRecreated() { return numRecreated; }
+
+private:
+  std::unique_ptr<MLIRContext> createContext() {
+    // Requests run in parallel across contexts, not within one.
+    auto context = std::make_unique<MLIRContext>(
+        registry, MLIRContext::Threading::DISABLED);
+    context->allowUnregisteredDialects(true);
+    context->loadAllAvailableDialects();
+    return context;
+  }
+
+  const DialectRegistry &registry;
+  unsigned maxRequests;
+  size_t maxBytes;
+  std::vector<std::unique_ptr<Slot>> slots;
+  std::vector<Slot *> available;
+  std::mutex mutex;
+  std::condition_variable released;
+  std::atomic<int64_t> numRecreated{0};
+};
+
+/// Results of successful requests, evicting the least recently used.
+class ResultCache {
+public:
+  ResultCache(size_t capacity, size_t maxBytes)
+      : capacity(capacity), maxBytes(maxBytes) {}
+
+  std::optional<CompileResult> lookup(const std::string &key) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = entries.find(key);
+    if (it == entries.end())
+      return std::nullopt;
+    order.splice(order.begin(), order, it->second.second);
+    return it->second.first;
+  }
+
+  void insert(const std::string &key, const CompileResult &result) {
+    size_t size = getSize(key, result);
+    std::lock_guard<std::mutex> lock(mutex);
+    if (capacity == 0 || (maxBytes && size > maxBytes) || entries.count(key))
+      return;
+    order.push_front(key);
+    entries.try_emplace(key, result, order.begin());
+    numBytes += size;
+    while (entries.size() > capacity || (maxBytes && numBytes > maxBytes)) {
+      auto last = entries.find(order.back());
+      numBytes -= getSize(last->first, last->second.first);
+      entries.erase(last);
+      order.pop_back();
+    }
+  }
+
+  size_t size() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.size();
+  }
+
+  size_t bytes() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return numBytes;
+  }
+
+private:
+  // The key is held twice, in the order and in the entries.
+  static size_t getSize(const std::string &key, const CompileResult &result) {
+    return 2 * key.size() + result.output.size() + result.diagnostics.size();
+  }
+
+  size_t capacity;
+  size_t maxBytes;
+  size_t numBytes = 0;
+  // Keys from the most to the least recently used.
+  std::list<std::string> order;
+  std::unordered_map<std::string,
+                     std::pair<CompileResult, std::list<std::string>::iterator>>
+      entries;
+  std::mutex mutex;
+};
+
+class CompileServer {
+public:
+  CompileServer(int listenFd, const DialectRegistry &registry,
+                unsigned numContexts, const CompileServerOptions &options,
+                CompileFn compile)
+      : listenFd(listenFd),
+        contexts(registry, numContexts, options.contextRequests,
+                 options.contextBytes),
+        cache(options.cacheSize, options.cacheBytes),
+        compile(std::move(compile)) {}
+
+  /// Accepts connections until stopped, serving each on its own thread.
+  LogicalResult run();
+
+private:
+  void serveConnection(int fd);
+  llvm::json::Value handleMessage(const std::string &message);
+  void stop();
+
+  int listenFd;
+  ContextPool contexts;
+  ResultCache cache;
+  CompileFn compile;
+  std::atomic<int64_t> numRequests{0};
+  std::atomic<int64_t> numHits{0};
+  std::atomic<bool> stopping{false};
+
+  // Open connections, which are shut down when the server stops.
+  std::set<int> connections;
+  std::mutex connectionsMutex;
+  std::condition_variable connectionClosed;
+};
+} // namespace
+
+llvm::json::Value CompileServer::handleMessage(const std::string &message) {
+  auto json = llvm::json::parse(message);
+  if (!json)
+    return getErrorResponse("invalid request: " +
+                            llvm::toString(json.takeError()));
+  auto *object = json->getAsObject();
+  if (!object)
+    return getErrorResponse("expected a JSON object");
+  if (object->getBoolean("shutdown").value_or(false)) {
+    stop();
+    return llvm::json::Object{{"ok", true}};
+  }
+  if (object->getBoolean("stats").value_or(false))
+    return llvm::json::Object{{"ok", true},
+                              {"requests", numRequests.load()},
+                              {"hits", numHits.load()},
+                              {"entries", (int64_t)cache.size()},
+                              {"bytes", (int64_t)cache.bytes()},
+                              {"recreated", contexts.getNumRecreated()}};
+
+  CompileRequest request;
+  std::string error;
+  if (!parseRequest(*object, request, error))
+    return getErrorResponse(error);
+  ++numRequests;
+  std::string key = getCacheKey(request);
+  bool cached = false;
+  CompileResult result;
+  if (auto entry = cache.lookup(key)) {
+    ++numHits;
+    cached = true;
+    result = std::move(*entry);
+  } else {
+    auto *slot = contexts.acquire();
+    result = compile(*slot->context, request);
+    contexts.release(slot, request.module.size());
+    if (result.ok)
+      cache.insert(key, result);
+  }
+  return llvm::json::Object{{"ok", result.ok},
+                            {"output", std::move(result.output)},
+                            {"diagnostics", std::move(result.diagnostics)},
+                            {"cached", cached}};
+}
+
+void CompileServer::serveConnection(int fd) {
+  std::string message;
+  while (!stopping && readMessage(fd, message))
+    if (!writeMessage(fd, handleMessage(message)))
+      break;
+  ::close(fd);
+  // Notifying under the lock keeps the server alive until this thread is done
+  // with it.
+  std::lock_guard<std::mutex> lock(connectionsMutex);
+  connections.erase(fd);
+  connectionClosed.notify_all();
+}
+
+void CompileServer::stop() {
+  stopping = true;
+  // Wakes up accept() in run().
+  ::shutdown(listenFd, SHUT_RDWR);
+}
+
+LogicalResult CompileServer::run() {
+  while (true) {
+    int fd = ::accept(listenFd, nullptr, nullptr);
+    if (fd < 0) {
+      if (errno == EINTR && !stopping)
+        continue;
+      break;
+    }
+    {
+      std::lock_guard<std::mutex> lock(connectionsMutex);
+      connections.insert(fd);
+    }
+    std::thread([this, fd] { serveConnection(fd); }).detach();
+  }
+  bool acceptFailed = !stopping;
+  if (acceptFailed)
+    llvm::errs() << "[hcl-serve] accept failed: " << std::strerror(errno)
+                 << "\n";
+
+  // Idle connections wait for a request; shutting them down ends their
+  // threads, and requests being compiled finish first.
+  stopping = true;
+  std::unique_lock<std::mutex> lock(connectionsMutex);
+  for (int fd : connections)
+    ::shutdown(fd, SHUT_RD);
+  connectionClosed.wait(lock, [&] { return connections.empty(); });
+  return failure(acceptFailed);
+}
+
+int mlir::hcl::runCompileServer(const CompileServerOptions &options,
+                                const DialectRegistry &registry,
+                                CompileFn compile) {
+  const std::string &path = options.socketPath;
+  sockaddr_un addr;
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(addr.sun_path)) {
+    llvm::errs() << "Error: socket path too long: " << path << "\n";
+    return 1;
+  }
+  std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+
+  // A socket left behind by a server that did not shut down is replaced, but
+  // not the socket of a server that still accepts connections.
+  llvm::sys::fs::file_status status;
+  if (!llvm::sys::fs::status(path, status) &&
+      status.type() == llvm::sys::fs::file_type::socket_file) {
+    int probe = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    bool live =
+        probe >= 0 && ::connect(probe, (sockaddr *)&addr, sizeof(addr)) == 0;
+    bool refused = !live && errno == ECONNREFUSED;
+    if (probe >= 0)
+      ::close(probe);
+    if (live) {
+      llvm::errs() << "Error a server is already listening on " << path
+                   << "\n";
+      return 1;
+    }
+    if (refused)
+      ::unlink(path.c_str());
+  }
+
+  int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0 || ::bind(fd, (sockaddr *)&addr, sizeof(addr)) < 0 ||
+      ::listen(fd, SOMAXCONN) < 0) {
+    llvm::errs() << "Error can't listen on " << path << ": "
+                 << std::strerror(errno) << "\n";
+    if (fd >= 0)
+      ::close(fd);
+    return 1;
+  }
+
+  unsigned numContexts = options.numContexts;
+  if (numContexts == 0)
+    numContexts = llvm::hardware_concurrency().compute_thread_count();
+  LogicalResult result = success();
+  {
+    CompileServer server(fd, registry, numContexts, options,
+                         std::move(compile));
+    llvm::errs() << "[hcl-serve] listening on " << path << " with "
+                 << numContexts << " contexts\n";
+    result = server.run();
+  }
+  ::close(fd);
+  ::unlink(path.c_str());
+  return failed(result) ? 1 : 0;
+}
@@ -0,0 +1,62 @@
+/*
+ * Copyright HeteroCL authors. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef HCL_OPT_COMPILESERVER_H
+#define HCL_OPT_COMPILESERVER_H
+
+#include "mlir/IR/DialectRegistry.h"
+#include "mlir/IR/MLIRContext.h"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace mlir {
+namespace hcl {
+
+/// A module to compile, the hcl-opt flags of the pipeline to run on it, and
+/// the translation to emit the result with, if any.
+struct CompileRequest {
+  std::string module;
+  std::vector<std::string> flags;
+  std::string translation;
+};
+
+/// The printed or translated module, or the diagnostics of a failure.
+struct CompileResult {
+  bool ok = false;
+  std::string output;
+  std::string diagnostics;
+};
+
+/// Compiles a request in one of the contexts of the server.
+using CompileFn =
+    std::function<CompileResult(MLIRContext &, const CompileRequest &)>;
+
+struct CompileServerOptions {
+  std::string socketPath;
+  // Number of contexts, and so of requests compiled at once; 0 is one per
+  // hardware thread.
+  unsigned numContexts = 0;
+  // Number of results cached.
+  size_t cacheSize = 256;
+  // Total size in bytes of the cached results; 0 is unlimited.
+  size_t cacheBytes = 256 << 20;
+  // A context keeps every type and attribute its requests uniqued, so it is
+  // recreated after this many requests or this many bytes of modules; 0 is
+  // unlimited.
+  unsigned contextRequests = 64;
+  size_t contextBytes = 256 << 20;
+};
+
+/// Serves compile requests on a UNIX-domain socket until a shutdown request
+/// arrives, and returns the exit code of the process.
+int runCompileServer(const CompileServerOptions &options,
+                     const DialectRegistry &registry, CompileFn compile);
+
+} // namespace hcl
+} // namespace mlir
+
+#endif // HCL_OPT_COMPILESERVER_H
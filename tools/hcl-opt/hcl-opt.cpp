@@ -3,14 +3,36 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include "mlir/Dialect/Affine/IR/AffineOps.h"
+#include "mlir/Dialect/Affine/Passes.h"
+#include "mlir/Dialect/Arith/IR/Arith.h"
+#include "mlir/Dialect/Arith/Transforms/BufferizableOpInterfaceImpl.h"
+#include "mlir/Dialect/Bufferization/IR/Bufferization.h"
+#include "mlir/Dialect/Bufferization/Transforms/FuncBufferizableOpInterfaceImpl.h"
+#include "mlir/Dialect/Bufferization/Transforms/Passes.h"
+#include "mlir/Dialect/ControlFlow/IR/ControlFlow.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/Dialect/LLVMIR/LLVMDialect.h"
+#include "mlir/Dialect/Linalg/IR/Linalg.h"
 #include "mlir/Dialect/Linalg/Passes.h"
+#include "mlir/Dialect/Linalg/TransformOps/DialectExtension.h"
+#include "mlir/Dialect/Linalg/Transforms/BufferizableOpInterfaceImpl.h"
+#include "mlir/Dialect/Math/IR/Math.h"
+#include "mlir/Dialect/MemRef/IR/MemRef.h"
+#include "mlir/Dialect/MemRef/Transforms/Passes.h"
+#include "mlir/Dialect/SCF/IR/SCF.h"
+#include "mlir/Dialect/SCF/Transforms/BufferizableOpInterfaceImpl.h"
+#include "mlir/Dialect/Tensor/IR/Tensor.h"
+#include "mlir/Dialect/Tensor/Transforms/BufferizableOpInterfaceImpl.h"
+#include "mlir/Dialect/Transform/IR/TransformDialect.h"
+#include "mlir/Dialect/Vector/IR/VectorOps.h"
 #include "mlir/ExecutionEngine/ExecutionEngine.h"
 #include "mlir/ExecutionEngine/OptUtils.h"
 #include "mlir/IR/BuiltinOps.h"
 #include "mlir/IR/Dialect.h"
+#include "mlir/IR/Diagnostics.h"
 #include "mlir/IR/MLIRContext.h"
-#include "mlir/InitAllDialects.h"
-#include "mlir/InitAllPasses.h"
+#include "mlir/IR/Threading.h"
 #include "mlir/Parser/Parser.h"
 #include "mlir/Pass/Pass.h"
 #include "mlir/Pass/PassManager.h"
@@ -18,15 +40,22 @@
 #include "mlir/Target/LLVMIR/Dialect/Builtin/BuiltinToLLVMIRTranslation.h"
 #include "mlir/Target/LLVMIR/Dialect/LLVMIR/LLVMToLLVMIRTranslation.h"
 #include "mlir/Target/LLVMIR/Export.h"
+#include "mlir/Transforms/Passes.h"
 #include "mlir/Tools/mlir-opt/MlirOptMain.h"
 #include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/Sequence.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/IR/Module.h"
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FormatVariadic.h"
 #include "llvm/Support/InitLLVM.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/ToolOutputFile.h"
 
 #include "hcl/Dialect/HeteroCLDialect.h"
@@ -35,8 +64,15 @@
 #include "hcl/Conversion/Passes.h"
 #include "hcl/Support/Utils.h"
 #include "hcl/Transforms/Passes.h"
+#include "hcl/Translation/EmitCpuCpp.h"
+#include "hcl/Translation/EmitIntelHLS.h"
+#include "hcl/Translation/EmitVivadoHLS.h"
 
+#include "CompileServer.h"
+
+#include <chrono>
 #include <iostream>
+#include <mutex>
 
 static llvm::cl::opt<std::string> inputFilename(llvm::cl::Positional,
                                                 llvm::cl::desc("<input file>"),
@@ -85,14 +121,34 @@ static llvm::cl::opt<bool>
     lowerComposite("lower-composite", llvm::cl::desc("Lower composite types"),
                    llvm::cl::init(false));
 
+static llvm::cl::opt<bool> lowerCompositePacked(
+    "lower-composite-packed",
+    llvm::cl::desc("Pack the fields of memrefs of structs into words"),
+    llvm::cl::init(false));
+
 static llvm::cl::opt<bool> lowerBitOps("lower-bitops",
                                        llvm::cl::desc("Lower bitops"),
                                        llvm::cl::init(false));
 
+static llvm::cl::opt<bool>
+    lowerLogicOps("lower-logic-ops",
+                  llvm::cl::desc("Lower short-circuit logic ops"),
+                  llvm::cl::init(false));
+
+static llvm::cl::opt<unsigned> lowerLogicOpsMaxSpeculatedOps(
+    "lower-logic-ops-max-speculated-ops",
+    llvm::cl::desc("Maximum number of operations evaluated without branches"),
+    llvm::cl::init(8));
+
 static llvm::cl::opt<bool> legalizeCast("legalize-cast",
                                         llvm::cl::desc("Legalize cast"),
                                         llvm::cl::init(false));
 
+static llvm::cl::opt<bool>
+    castChainElim("cast-chain-elim",
+                  llvm::cl::desc("Collapse chains of casts"),
+                  llvm::cl::init(false));
+
 static llvm::cl::opt<bool> removeStrideMap("remove-stride-map",
                                            llvm::cl::desc("Remove stride map"),
                                            llvm::cl::init(false));
@@ -113,6 +169,36 @@ static llvm::cl::opt<bool> dataPlacement("data-placement",
                                          llvm::cl::desc("Data placement"),
                                          llvm::cl::init(false));
 
+static llvm::cl::opt<double> dataPlacementFpgaCycleCost(
+    "data-placement-fpga-cycle-cost",
+    llvm::cl::desc("Cost of an accelerator cycle, in host cycles"),
+    llvm::cl::init(10.0));
+
+static llvm::cl::opt<double> dataPlacementTransferCost(
+    "data-placement-transfer-cost",
+    llvm::cl::desc("Cost of moving a byte between the devices, in host cycles"),
+    llvm::cl::init(1.0));
+
+static llvm::cl::opt<bool> resourceBudget(
+    "resource-budget",
+    llvm::cl::desc("Fit unroll and partition factors into a resource budget"),
+    llvm::cl::init(false));
+
+static llvm::cl::opt<unsigned>
+    resourceBudgetDSP("resource-budget-dsp",
+                      llvm::cl::desc("Number of DSPs available, 0 for any"),
+                      llvm::cl::init(0));
+
+static llvm::cl::opt<unsigned> resourceBudgetBRAM(
+    "resource-budget-bram",
+    llvm::cl::desc("Number of 18Kb BRAMs available, 0 for any"),
+    llvm::cl::init(0));
+
+static llvm::cl::opt<unsigned>
+    resourceBudgetLUT("resource-budget-lut",
+                      llvm::cl::desc("Number of LUTs available, 0 for any"),
+                      llvm::cl::init(0));
+
 static llvm::cl::opt<bool>
     enableNormalize("normalize",
                     llvm::cl::desc("Enable other common optimizations"),
@@ -121,11 +207,29 @@ static llvm::cl::opt<bool>
 static llvm::cl::opt<bool> runJiT("jit", llvm::cl::desc("Run JiT compiler"),
                                   llvm::cl::init(false));
 
+static llvm::cl::opt<unsigned>
+    jitOptLevel("jit-opt-level",
+                llvm::cl::desc("Optimize the LLVM IR of the JiT compiler "
+                               "at the given level (default: 0, unoptimized)"),
+                llvm::cl::init(0));
+
+static llvm::cl::opt<unsigned> jitBenchIters(
+    "jit-bench-iters",
+    llvm::cl::desc("Time the given number of invocations of the top function "
+                   "after a warm-up run and report the per-iteration time"),
+    llvm::cl::init(0));
+
 static llvm::cl::opt<bool> fixedPointToInteger(
     "fixed-to-integer",
     llvm::cl::desc("Lower fixed-point operations to integer"),
     llvm::cl::init(false));
 
+static llvm::cl::opt<bool> fixedPointToIntegerSimd(
+    "fixed-to-integer-simd",
+    llvm::cl::desc("Lower fixed-point products to multiply-highs in the "
+                   "operand width"),
+    llvm::cl::init(false));
+
 static llvm::cl::opt<bool>
     anyWidthInteger("lower-anywidth-integer",
                     llvm::cl::desc("Lower anywidth integer to 64-bit integer"),
@@ -141,21 +245,118 @@ static llvm::cl::opt<bool>
               llvm::cl::desc("Remove memrefs that are never loaded from"),
               llvm::cl::init(false));
 
+static llvm::cl::opt<bool> canonicalize(
+    "canonicalize",
+    llvm::cl::desc("Fold and canonicalize operations, then remove common "
+                   "subexpressions"),
+    llvm::cl::init(false));
+
+static llvm::cl::opt<bool>
+    kernelDedup("kernel-dedup",
+                llvm::cl::desc("Merge structurally identical kernels"),
+                llvm::cl::init(false));
+
+static llvm::cl::opt<bool> kernelDedupDynamicShapes(
+    "kernel-dedup-dynamic-shapes",
+    llvm::cl::desc("Also merge kernels that differ in memref sizes and "
+                   "constant loop bounds"),
+    llvm::cl::init(false));
+
+static llvm::cl::opt<bool> shapeSpecialize(
+    "shape-specialize",
+    llvm::cl::desc("Create versions of dynamic-shape kernels for hot shapes"),
+    llvm::cl::init(false));
+
+static llvm::cl::opt<bool> profileInstrument(
+    "profile-instrument",
+    llvm::cl::desc("Count loop trip counts and taken branches at run time"),
+    llvm::cl::init(false));
+
+static llvm::cl::opt<std::string> profileAnnotateFile(
+    "profile-annotate",
+    llvm::cl::desc("Attach the loop trip counts and branch rates of a JSON "
+                   "profile"),
+    llvm::cl::value_desc("filename"), llvm::cl::init(""));
+
+static llvm::cl::opt<std::string> batchInputs(
+    "batch",
+    llvm::cl::desc("Run the pipeline on every .mlir file of a directory, or "
+                   "on every file a list names, one per line"),
+    llvm::cl::value_desc("directory or list"), llvm::cl::init(""));
+
+static llvm::cl::opt<std::string> batchOutputDir(
+    "batch-output-dir",
+    llvm::cl::desc("Directory the outputs of -batch are written to, one per "
+                   "input"),
+    llvm::cl::value_desc("directory"), llvm::cl::init("."));
+
+static llvm::cl::opt<unsigned> batchThreads(
+    "batch-threads",
+    llvm::cl::desc("Number of threads compiling the designs of -batch "
+                   "(default: one per hardware thread)"),
+    llvm::cl::init(0));
+
+static llvm::cl::opt<std::string> serveSocket(
+    "serve",
+    llvm::cl::desc("Serve compile requests on a UNIX-domain socket"),
+    llvm::cl::value_desc("socket path"), llvm::cl::init(""));
+
+static llvm::cl::opt<unsigned> serveContexts(
+    "serve-contexts",
+    llvm::cl::desc("Number of contexts of -serve, and so of requests compiled "
+                   "at once (default: one per hardware thread)"),
+    llvm::cl::init(0));
+
+static llvm::cl::opt<unsigned>
+    serveCacheSize("serve-cache-size",
+                   llvm::cl::desc("Number of results -serve caches"),
+                   llvm::cl::init(256));
+
+static llvm::cl::opt<unsigned> serveCacheMB(
+    "serve-cache-mb",
+    llvm::cl::desc("Total size in MB of the results -serve caches (0: any)"),
+    llvm::cl::init(256));
+
+static llvm::cl::opt<unsigned> serveContextRequests(
+    "serve-context-requests",
+    llvm::cl::desc("Number of requests after which -serve recreates a "
+                   "context, freeing what they uniqued (0: never)"),
+    llvm::cl::init(64));
+
+static llvm::cl::opt<unsigned> serveContextMB(
+    "serve-context-mb",
+    llvm::cl::desc("Size in MB of the modules after which -serve recreates a "
+                   "context (0: never)"),
+    llvm::cl::init(256));
+
 static llvm::cl::opt<bool>
     applyTransform("apply-transform",
-                   llvm::cl::desc("Apply pattern-based transformations"),
+                   llvm::cl::desc("Apply the transform ops of the input"),
                    llvm::cl::init(false));
 
-int loadMLIR(mlir::MLIRContext &context,
+int loadMLIR(mlir::MLIRContext &context, llvm::StringRef filename,
              mlir::OwningOpRef<mlir::ModuleOp> &module) {
-  module = parseSourceFile<mlir::ModuleOp>(inputFilename, &context);
+  module = parseSourceFile<mlir::ModuleOp>(filename, &context);
   if (!module) {
-    llvm::errs() << "Error can't load file " << inputFilename << "\n";
+    llvm::errs() << "Error can't load file " << filename << "\n";
     return 3;
   }
   return 0;
 }
 
+int writeMLIR(mlir::ModuleOp module, llvm::StringRef filename) {
+  std::string errorMessage;
+  auto outfile = mlir::openOutputFile(filename, &errorMessage);
+  if (!outfile) {
+    llvm::errs() << errorMessage << "\n";
+    return 2;
+  }
+  module->print(outfile->os());
+  outfile->os() << "\n";
+  outfile->keep();
+  return 0;
+}
+
 int runJiTCompiler(mlir::ModuleOp module) {
 
   std::string LLVM_BUILD_DIR;
@@ -220,12 +421,13 @@ int runJiTCompiler(mlir::ModuleOp module) {
   mlir::registerBuiltinDialectTranslation(*module->getContext());
   mlir::registerLLVMDialectTranslation(*module->getContext());
 
-  // An optimization pipeline to use within the execution engine.
-  auto optPipeline = mlir::makeOptimizingTransformer(
-      /*optLevel=*/1, /*sizeLevel=*/0,
-      /*targetMachine=*/nullptr);
-
   mlir::ExecutionEngineOptions engineOptions;
+  // An optimization pipeline to use within the execution engine, only when
+  // asked for, so that a plain -jit compiles as it always has.
+  if (jitOptLevel)
+    engineOptions.transformer = mlir::makeOptimizingTransformer(
+        /*optLevel=*/std::min(3u, (unsigned)jitOptLevel), /*sizeLevel=*/0,
+        /*targetMachine=*/nullptr);
   engineOptions.sharedLibPaths = executionEngineLibs;
   // Create an MLIR execution engine. The execution engine eagerly JIT-compiles
   // the module.
@@ -240,58 +442,99 @@ int runJiTCompiler(mlir::ModuleOp module) {
     return -1;
   }
 
+  // The first invocation above serves as the warm-up run.
+  if (jitBenchIters > 0) {
+    double totalMs = 0, minMs = INFINITY;
+    for (unsigned i = 0; i < jitBenchIters; ++i) {
+      auto start = std::chrono::steady_clock::now();
+      if (auto err = engine->invokePacked("top")) {
+        llvm::consumeError(std::move(err));
+        llvm::errs() << "JIT invocation failed\n";
+        return -1;
+      }
+      auto end = std::chrono::steady_clock::now();
+      double ms =
+          std::chrono::duration<double, std::milli>(end - start).count();
+      totalMs += ms;
+      minMs = std::min(minMs, ms);
+    }
+    llvm::outs() << llvm::formatv(
+        "[hcl-jit] top: {0:f6} ms/iter (min {1:f6} ms, {2} iters)\n",
+        totalMs / jitBenchIters, minMs, (unsigned)jitBenchIters);
+  }
+
   return 0;
 }
 
-int main(int argc, char **argv) {
-  // Register dialects and passes in current context
-  mlir::DialectRegistry registry;
-  mlir::registerAllDialects(registry);
-  registry.insert<mlir::hcl::HeteroCLDialect>();
+/// Registers the dialects hcl-opt reads and its pipelines produce. Only the
+/// ones an input uses or a pass depends on are loaded.
+void registerDialects(mlir::DialectRegistry &registry) {
+  registry.insert<mlir::hcl::HeteroCLDialect, mlir::affine::AffineDialect,
+                  mlir::arith::ArithDialect, mlir::memref::MemRefDialect,
+                  mlir::func::FuncDialect, mlir::scf::SCFDialect,
+                  mlir::math::MathDialect, mlir::LLVM::LLVMDialect,
+                  mlir::cf::ControlFlowDialect, mlir::vector::VectorDialect,
+                  mlir::transform::TransformDialect>();
   mlir::hcl::registerTransformDialectExtension(registry);
+  // transform.structured.match, to get the first handles of a schedule
+  mlir::linalg::registerTransformDialectExtension(registry);
+
+  // Inputs of -linalg-to-affine and -bufferization
+  registry.insert<mlir::linalg::LinalgDialect, mlir::tensor::TensorDialect,
+                  mlir::bufferization::BufferizationDialect>();
+  mlir::arith::registerBufferizableOpInterfaceExternalModels(registry);
+  mlir::bufferization::func_ext::registerBufferizableOpInterfaceExternalModels(
+      registry);
+  mlir::linalg::registerBufferizableOpInterfaceExternalModels(registry);
+  mlir::scf::registerBufferizableOpInterfaceExternalModels(registry);
+  mlir::tensor::registerBufferizableOpInterfaceExternalModels(registry);
+}
 
-  mlir::MLIRContext context;
-  context.appendDialectRegistry(registry);
-  context.allowUnregisteredDialects(true);
-  context.printOpOnDiagnostic(true);
-  context.loadAllAvailableDialects();
-
-  mlir::registerAllPasses();
-  mlir::hcl::registerHCLPasses();
-  mlir::hcl::registerHCLConversionPasses();
-
-  // Parse pass names in main to ensure static initialization completed
-  llvm::cl::ParseCommandLineOptions(argc, argv,
-                                    "MLIR modular optimizer driver\n");
-
-  mlir::OwningOpRef<mlir::ModuleOp> module;
-  if (int error = loadMLIR(context, module))
-    return error;
-
-  // Initialize a pass manager
-  // https://mlir.llvm.org/docs/PassManagement/
-  // Operation agnostic passes
-  mlir::PassManager pm(&context);
+/// Adds the passes selected on the command line to `pm`.
+void buildPipeline(mlir::PassManager &pm) {
   // Operation specific passes
   mlir::OpPassManager &optPM = pm.nest<mlir::func::FuncOp>();
   if (enableOpt) {
     pm.addPass(mlir::hcl::createLoopTransformationPass());
   }
 
+  if (kernelDedup) {
+    pm.addPass(mlir::hcl::createKernelDedupPass(kernelDedupDynamicShapes));
+  }
+
+  if (shapeSpecialize) {
+    pm.addPass(mlir::hcl::createShapeSpecializationPass());
+  }
+
+  if (!profileAnnotateFile.empty()) {
+    pm.addPass(mlir::hcl::createProfileAnnotationPass(profileAnnotateFile));
+  }
+
+  if (profileInstrument) {
+    pm.addPass(mlir::hcl::createProfileInstrumentationPass());
+  }
+
   if (dataPlacement) {
-    pm.addPass(mlir::hcl::createDataPlacementPass());
+    pm.addPass(mlir::hcl::createDataPlacementPass(dataPlacementFpgaCycleCost,
+                                                  dataPlacementTransferCost));
   }
 
   if (memRefDCE) {
     pm.addPass(mlir::hcl::createMemRefDCEPass());
   }
 
+  if (canonicalize) {
+    pm.addPass(mlir::createCanonicalizerPass());
+    pm.addPass(mlir::createCSEPass());
+  }
+
   if (lowerComposite) {
-    pm.addPass(mlir::hcl::createLowerCompositeTypePass());
+    pm.addPass(mlir::hcl::createLowerCompositeTypePass(lowerCompositePacked));
   }
 
   if (fixedPointToInteger) {
-    pm.addPass(mlir::hcl::createFixedPointToIntegerPass());
+    pm.addPass(
+        mlir::hcl::createFixedPointToIntegerPass(fixedPointToIntegerSimd));
   }
 
   // lowerPrintOps should be run after lowering fixed point to integer
@@ -311,10 +554,19 @@ int main(int argc, char **argv) {
     pm.addPass(mlir::hcl::createLowerBitOpsPass());
   }
 
+  if (lowerLogicOps) {
+    pm.addPass(
+        mlir::hcl::createLowerLogicOpsPass(lowerLogicOpsMaxSpeculatedOps));
+  }
+
   if (legalizeCast) {
     pm.addPass(mlir::hcl::createLegalizeCastPass());
   }
 
+  if (castChainElim) {
+    pm.addPass(mlir::hcl::createCastChainEliminationPass());
+  }
+
   if (removeStrideMap) {
     pm.addPass(mlir::hcl::createRemoveStrideMapPass());
   }
@@ -348,12 +600,256 @@ int main(int argc, char **argv) {
   if (applyTransform)
     pm.addPass(mlir::hcl::createTransformInterpreterPass());
 
+  // after the schedule has set the unroll and partition factors
+  if (resourceBudget) {
+    pm.addPass(mlir::hcl::createResourceBudgetPass(
+        resourceBudgetDSP, resourceBudgetBRAM, resourceBudgetLUT));
+  }
+
   if (runJiT || lowerToLLVM) {
     if (!removeStrideMap) {
       pm.addPass(mlir::hcl::createRemoveStrideMapPass());
     }
     pm.addPass(mlir::hcl::createHCLToLLVMLoweringPass());
   }
+}
+
+/// Collects the inputs of -batch: the .mlir files of a directory, in name
+/// order, or the paths a list file names. Blank lines and lines starting with
+/// '#' in a list are skipped.
+bool getBatchInputs(std::vector<std::string> &inputs) {
+  if (llvm::sys::fs::is_directory(batchInputs)) {
+    std::error_code ec;
+    for (llvm::sys::fs::directory_iterator it(batchInputs, ec), end;
+         it != end && !ec; it.increment(ec))
+      if (llvm::sys::path::extension(it->path()) == ".mlir")
+        inputs.push_back(it->path());
+    if (ec) {
+      llvm::errs() << "Error can't list " << batchInputs << ": "
+                   << ec.message() << "\n";
+      return false;
+    }
+    llvm::sort(inputs);
+    return true;
+  }
+  auto buffer = llvm::MemoryBuffer::getFile(batchInputs);
+  if (!buffer) {
+    llvm::errs() << "Error can't load file " << batchInputs << "\n";
+    return false;
+  }
+  llvm::SmallVector<llvm::StringRef, 64> lines;
+  (*buffer)->getBuffer().split(lines, '\n');
+  for (llvm::StringRef line : lines) {
+    line = line.trim();
+    if (!line.empty() && !line.starts_with("#"))
+      inputs.push_back(line.str());
+  }
+  return true;
+}
+
+/// Parses, transforms and writes one design of -batch.
+mlir::LogicalResult compileDesign(mlir::MLIRContext &context,
+                                  llvm::StringRef input,
+                                  llvm::StringRef output) {
+  mlir::OwningOpRef<mlir::ModuleOp> module;
+  if (loadMLIR(context, input, module))
+    return mlir::failure();
+  mlir::PassManager pm(&context);
+  buildPipeline(pm);
+  if (mlir::failed(pm.run(*module)))
+    return mlir::failure();
+  return mlir::success(writeMLIR(*module, output) == 0);
+}
+
+/// Compiles the designs of -batch concurrently in `context`, whose dialects
+/// are already loaded, so that they share its uniqued types and attributes.
+/// Each design is written to -batch-output-dir under its own file name. A
+/// design that fails is reported and does not stop the others.
+int runBatch(mlir::MLIRContext &context) {
+  if (runJiT) {
+    llvm::errs() << "Error: -jit is not supported with -batch\n";
+    return 1;
+  }
+  std::vector<std::string> inputs;
+  if (!getBatchInputs(inputs))
+    return 3;
+
+  std::vector<std::string> outputs;
+  llvm::StringMap<llvm::StringRef> outputInputs;
+  for (auto &input : inputs) {
+    llvm::SmallString<256> output(batchOutputDir);
+    llvm::sys::path::append(output, llvm::sys::path::filename(input));
+    auto inserted = outputInputs.try_emplace(output, input);
+    if (!inserted.second) {
+      llvm::errs() << "Error: " << inserted.first->second << " and " << input
+                   << " would both be written to " << output << "\n";
+      return 2;
+    }
+    outputs.push_back(output.str().str());
+  }
+  if (auto ec = llvm::sys::fs::create_directories(batchOutputDir)) {
+    llvm::errs() << "Error can't create " << batchOutputDir << ": "
+                 << ec.message() << "\n";
+    return 2;
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  std::vector<char> designFailed(inputs.size(), false);
+  {
+    // Diagnostics are buffered per design and printed in input order.
+    mlir::ParallelDiagnosticHandler diagHandler(&context);
+    mlir::parallelForEach(
+        &context, llvm::seq<size_t>(0, inputs.size()), [&](size_t i) {
+          diagHandler.setOrderIDForThread(i);
+          designFailed[i] =
+              mlir::failed(compileDesign(context, inputs[i], outputs[i]));
+          diagHandler.eraseOrderIDForThread();
+        });
+  }
+  auto end = std::chrono::steady_clock::now();
+
+  unsigned numFailed = 0;
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    if (!designFailed[i])
+      continue;
+    llvm::errs() << "[hcl-batch] FAILED " << inputs[i] << "\n";
+    ++numFailed;
+  }
+  llvm::errs() << llvm::formatv(
+      "[hcl-batch] {0} designs, {1} failed, {2:f3} s\n", inputs.size(),
+      numFailed, std::chrono::duration<double>(end - start).count());
+  return numFailed ? 4 : 0;
+}
+
+// Flags that only make sense on the command line of hcl-opt itself.
+static const llvm::StringRef kCommandLineOnlyFlags[] = {
+    "batch", "batch-output-dir", "batch-threads", "help", "help-hidden",
+    "help-list", "jit", "o", "print-all-options", "print-options", "serve",
+    "serve-cache-mb", "serve-cache-size", "serve-context-mb",
+    "serve-context-requests", "serve-contexts", "version"};
+
+// The pipeline options are global, so the requests of -serve set them in turn.
+static std::mutex requestOptionsMutex;
+
+/// Sets the pipeline options to their defaults, then to the flags of a
+/// request of -serve.
+bool parseRequestFlags(llvm::ArrayRef<std::string> flags,
+                       llvm::raw_ostream &os) {
+  for (auto &flag : flags) {
+    llvm::StringRef name = llvm::StringRef(flag).ltrim('-').split('=').first;
+    if (!llvm::StringRef(flag).starts_with("-") ||
+        llvm::is_contained(kCommandLineOnlyFlags, name)) {
+      os << "error: unsupported flag in a request: " << flag << "\n";
+      return false;
+    }
+  }
+  llvm::SmallVector<const char *, 16> argv = {"hcl-opt"};
+  for (auto &flag : flags)
+    argv.push_back(flag.c_str());
+  llvm::cl::ResetAllOptionOccurrences();
+  return llvm::cl::ParseCommandLineOptions(argv.size(), argv.data(), "", &os);
+}
+
+mlir::LogicalResult emitTranslation(mlir::ModuleOp module,
+                                    llvm::StringRef translation,
+                                    llvm::raw_ostream &os) {
+  if (translation == "emit-vivado-hls")
+    return mlir::hcl::emitVivadoHLS(module, os);
+  if (translation == "emit-intel-hls")
+    return mlir::hcl::emitIntelHLS(module, os);
+  if (translation == "emit-cpu-cpp")
+    return mlir::hcl::emitCpuCpp(module, os);
+  return module.emitError("unknown translation: ") << translation;
+}
+
+/// Compiles a request of -serve: parses its module, runs the pipeline its
+/// flags select, and prints or translates the result.
+mlir::hcl::CompileResult compileRequest(mlir::MLIRContext &context,
+                                        const mlir::hcl::CompileRequest &req) {
+  mlir::hcl::CompileResult result;
+  llvm::raw_string_ostream diagOs(result.diagnostics);
+  mlir::PassManager pm(&context);
+  {
+    std::lock_guard<std::mutex> lock(requestOptionsMutex);
+    if (!parseRequestFlags(req.flags, diagOs))
+      return result;
+    buildPipeline(pm);
+  }
+
+  llvm::SourceMgr sourceMgr;
+  sourceMgr.AddNewSourceBuffer(
+      llvm::MemoryBuffer::getMemBuffer(req.module, "<request>"), llvm::SMLoc());
+  mlir::SourceMgrDiagnosticHandler diagHandler(sourceMgr, &context, diagOs);
+  auto module = mlir::parseSourceFile<mlir::ModuleOp>(
+      sourceMgr, mlir::ParserConfig(&context));
+  if (!module || mlir::failed(pm.run(*module)))
+    return result;
+
+  llvm::raw_string_ostream os(result.output);
+  if (req.translation.empty()) {
+    module->print(os);
+    os << "\n";
+  } else if (mlir::failed(emitTranslation(*module, req.translation, os))) {
+    return result;
+  }
+  result.ok = true;
+  return result;
+}
+
+int main(int argc, char **argv) {
+  // Register dialects and passes in current context
+  mlir::DialectRegistry registry;
+  registerDialects(registry);
+
+  // The thread pool of -batch-threads outlives the context that uses it.
+  std::unique_ptr<llvm::ThreadPool> batchPool;
+  mlir::MLIRContext context;
+  context.appendDialectRegistry(registry);
+  context.allowUnregisteredDialects(true);
+  context.printOpOnDiagnostic(true);
+
+  mlir::hcl::registerHCLPasses();
+  mlir::hcl::registerHCLConversionPasses();
+
+  // Parse pass names in main to ensure static initialization completed
+  llvm::cl::ParseCommandLineOptions(argc, argv,
+                                    "MLIR modular optimizer driver\n");
+
+  if (!serveSocket.empty()) {
+    mlir::hcl::CompileServerOptions options;
+    options.socketPath = serveSocket;
+    options.numContexts = serveContexts;
+    options.cacheSize = serveCacheSize;
+    options.cacheBytes = (size_t)serveCacheMB << 20;
+    options.contextRequests = serveContextRequests;
+    options.contextBytes = (size_t)serveContextMB << 20;
+    return mlir::hcl::runCompileServer(options, registry, compileRequest);
+  }
+
+  // Dialects are otherwise loaded when the parser or a pass first needs them.
+  // The designs of -batch are parsed concurrently, which must not load any.
+  if (preloadDialectsInContext || !batchInputs.empty())
+    context.loadAllAvailableDialects();
+
+  if (!batchInputs.empty()) {
+    if (batchThreads > 0) {
+      batchPool = std::make_unique<llvm::ThreadPool>(
+          llvm::hardware_concurrency(batchThreads));
+      context.disableMultithreading();
+      context.setThreadPool(*batchPool);
+    }
+    return runBatch(context);
+  }
+
+  mlir::OwningOpRef<mlir::ModuleOp> module;
+  if (int error = loadMLIR(context, inputFilename, module))
+    return error;
+
+  // Initialize a pass manager
+  // https://mlir.llvm.org/docs/PassManagement/
+  // Operation agnostic passes
+  mlir::PassManager pm(&context);
+  buildPipeline(pm);
 
   // Run the pass pipeline
   if (mlir::failed(pm.run(*module))) {
@@ -361,14 +857,8 @@ int main(int argc, char **argv) {
   }
 
   // print output
-  std::string errorMessage;
-  auto outfile = mlir::openOutputFile(outputFilename, &errorMessage);
-  if (!outfile) {
-    llvm::errs() << errorMessage << "\n";
-    return 2;
-  }
-  module->print(outfile->os());
-  outfile->os() << "\n";
+  if (int error = writeMLIR(*module, outputFilename))
+    return error;
 
   // run JiT
   if (runJiT)
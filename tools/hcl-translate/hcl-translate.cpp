@@ -10,6 +10,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "hcl/Translation/EmitCpuCpp.h"
 #include "hcl/Translation/EmitIntelHLS.h"
 #include "hcl/Translation/EmitVivadoHLS.h"
 #include "mlir/InitAllTranslations.h"
@@ -25,6 +26,7 @@ int main(int argc, char **argv) {
   mlir::registerAllTranslations();
   mlir::hcl::registerEmitVivadoHLSTranslation();
   mlir::hcl::registerEmitIntelHLSTranslation();
+  mlir::hcl::registerEmitCpuCppTranslation();
 #ifdef OPENSCOP
   mlir::hcl::registerToOpenScopExtractTranslation();
 #endif